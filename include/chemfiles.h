@@ -17,5 +17,6 @@
 #include "chemfiles/capi/frame.h"  // IWYU pragma: export
 #include "chemfiles/capi/trajectory.h"  // IWYU pragma: export
 #include "chemfiles/capi/selection.h"  // IWYU pragma: export
+#include "chemfiles/capi/neighbor_list.h"  // IWYU pragma: export
 
 #endif
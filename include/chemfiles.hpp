@@ -19,5 +19,7 @@
 #include "chemfiles/Trajectory.hpp"  // IWYU pragma: export
 #include "chemfiles/UnitCell.hpp"  // IWYU pragma: export
 #include "chemfiles/Selection.hpp"  // IWYU pragma: export
+#include "chemfiles/NeighborGrid.hpp"  // IWYU pragma: export
+#include "chemfiles/NeighborList.hpp"  // IWYU pragma: export
 
 #endif // CHEMFILES_HPP
@@ -10,6 +10,7 @@
 
 #include "chemfiles/sorted_set.hpp"
 #include "chemfiles/exports.h"
+#include "chemfiles/external/span.hpp"
 
 namespace chemfiles {
 
@@ -293,10 +294,92 @@ inline bool operator>=(const Improper& lhs, const Improper& rhs) {
     return lhs.data_ >= rhs.data_;
 }
 
-/// The connectivity struct store a cache of the bonds, angles and dihedrals
-/// in the system. The `recalculate` function should be called when bonds are
-/// added or removed. The `bonds` set is the main source of information, all the
-/// other data are cached from it.
+/// The `AdjacencyGraph` class stores which atoms are bonded together, in
+/// compressed sparse row format: the neighbors of all atoms are stored one
+/// after the other in a single array, together with the offset of the first
+/// neighbor of each atom in this array.
+///
+/// @example{topology/adjacency.cpp}
+class CHFL_EXPORT AdjacencyGraph final {
+public:
+    AdjacencyGraph() = default;
+
+    /// Get the number of atoms in this graph, i.e. one more than the biggest
+    /// atomic index involved in a bond.
+    size_t size() const {
+        return offsets_.empty() ? 0 : offsets_.size() - 1;
+    }
+
+    /// Get the indexes of all the atoms bonded to the atom `i`, sorted in
+    /// increasing order. This is empty if `i` is not smaller than `size()`.
+    span<const size_t> neighbors(size_t i) const {
+        if (i >= size()) {
+            return {};
+        }
+        return {neighbors_.data() + offsets_[i], offsets_[i + 1] - offsets_[i]};
+    }
+
+private:
+    /// Build the graph from a sorted list of bonds, where no atom index is
+    /// bigger than `biggest_atom`
+    AdjacencyGraph(const std::vector<Bond>& bonds, size_t biggest_atom);
+
+    /// Offset of the first neighbor of each atom in `neighbors_`. This
+    /// contains one more entry than the number of atoms, so that the
+    /// neighbors of atom `i` are between `offsets_[i]` and `offsets_[i + 1]`.
+    std::vector<size_t> offsets_ = {0};
+    /// Neighbors of all the atoms, one after the other
+    std::vector<size_t> neighbors_;
+
+    friend class Connectivity;
+};
+
+/// The `Molecules` class stores the molecules in a system, i.e. the groups of
+/// atoms connected together by bonds. Molecules are numbered in the order of
+/// their first atom, and each atom without bonds is a separate molecule.
+///
+/// @example{topology/molecules.cpp}
+class CHFL_EXPORT Molecules final {
+public:
+    Molecules() = default;
+
+    /// Get the number of molecules
+    size_t size() const {
+        return offsets_.empty() ? 0 : offsets_.size() - 1;
+    }
+
+    /// Get the index of the molecule containing the atom at index `atom`
+    ///
+    /// @throw OutOfBounds if `atom` is not a valid atomic index
+    size_t molecule_for_atom(size_t atom) const;
+
+    /// Get the indexes of all the atoms in the molecule at index `molecule`,
+    /// sorted in increasing order.
+    ///
+    /// @throw OutOfBounds if `molecule` is not a valid molecule index
+    span<const size_t> atoms(size_t molecule) const;
+
+private:
+    /// Find the molecules in a system containing `natoms` atoms, where no
+    /// atom index in `bonds` is bigger than `natoms`.
+    Molecules(const std::vector<Bond>& bonds, size_t natoms);
+
+    /// Index of the molecule containing each atom
+    std::vector<size_t> molecule_ids_;
+    /// Offset of the first atom of each molecule in `atoms_`, with one more
+    /// entry than the number of molecules
+    std::vector<size_t> offsets_ = {0};
+    /// Atoms of all the molecules, one molecule after the other
+    std::vector<size_t> atoms_;
+
+    friend class Connectivity;
+};
+
+/// The connectivity struct store the bonds in the system, and caches of the
+/// adjacency graph, molecules, angles, dihedrals and impropers. The `bonds`
+/// set is the main source of information. Each one of the other data is
+/// computed on demand when it is first requested after the bonds changed,
+/// independently of the others.
 class Connectivity final {
 public:
     Connectivity() = default;
@@ -307,6 +390,13 @@ public:
     /// Get the bond orders in this connectivity
     const std::vector<Bond::BondOrder>& bond_orders() const;
 
+    /// Get the adjacency graph of this connectivity
+    const AdjacencyGraph& adjacency() const;
+
+    /// Get the molecules in a system containing `natoms` atoms with this
+    /// connectivity
+    const Molecules& molecules(size_t natoms) const;
+
     /// Get the angles in this connectivity
     const sorted_set<Angle>& angles() const;
 
@@ -319,34 +409,54 @@ public:
     /// Add a bond between the atoms `i` and `j`
     void add_bond(size_t i, size_t j, Bond::BondOrder bond_order = Bond::UNKNOWN);
 
+    /// Add all the `bonds` at once, with the corresponding `bond_orders`. If
+    /// `bond_orders` is empty, all the bonds are added with an unknown bond
+    /// order. Bonds already in this connectivity or repeated in `bonds` keep
+    /// the first bond order given for them, as with `add_bond`.
+    void add_bonds(span<const Bond> bonds, span<const Bond::BondOrder> bond_orders);
+
     /// Remove any bond between the atoms `i` and `j`
     void remove_bond(size_t i, size_t j);
 
-    /// Update the indexes of the bonds after atom removal
+    /// Update the indexes of the bonds after removing multiple atoms.
     ///
-    /// This function shifts all indexes bigger than `index` in the
-    /// bonds/angles/dihedrals/impropers lists by -1.
-    void atom_removed(size_t index);
+    /// `new_indexes[i]` is the index of the atom `i` after the removal, or
+    /// `SIZE_MAX` if this atom was removed. All bonds involving a removed atom
+    /// are removed as well.
+    void atoms_removed(const std::vector<size_t>& new_indexes);
 
     /// Get the bond order of the bond between i and j
     Bond::BondOrder bond_order(size_t i, size_t j) const;
 private:
-    /// Recalculate the angles and the dihedrals from the bond list
-    void recalculate() const;
+    /// Mark all the cached data as outdated after a change to the bonds
+    void bonds_changed();
 
     /// Biggest index within the atoms we know about. Used to pre-allocate
-    /// memory when recomputing bonds.
+    /// memory when recomputing the adjacency graph.
     size_t biggest_atom_ = 0;
     /// Bonds in the system
     sorted_set<Bond> bonds_;
+    /// Adjacency graph of the system
+    mutable AdjacencyGraph adjacency_;
+    /// Molecules in the system
+    mutable Molecules molecules_;
     /// Angles in the system
     mutable sorted_set<Angle> angles_;
     /// Dihedral angles in the system
     mutable sorted_set<Dihedral> dihedrals_;
     /// Improper dihedral angles in the system
     mutable sorted_set<Improper> impropers_;
-    /// Is the cached content up to date ?
-    mutable bool uptodate_ = false;
+    /// Is the adjacency graph up to date?
+    mutable bool adjacency_uptodate_ = true;
+    /// Are the molecules up to date? They also need to be recomputed if the
+    /// number of atoms changed.
+    mutable bool molecules_uptodate_ = true;
+    /// Are the angles up to date?
+    mutable bool angles_uptodate_ = true;
+    /// Are the dihedral angles up to date?
+    mutable bool dihedrals_uptodate_ = true;
+    /// Are the improper dihedral angles up to date?
+    mutable bool impropers_uptodate_ = true;
     /// Store the bond orders
     std::vector<Bond::BondOrder> bond_orders_;
 };
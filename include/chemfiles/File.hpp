@@ -11,11 +11,14 @@
 #include <utility>
 #include <vector>
 #include <memory>
+#include <functional>
 #include <string_view>
 
 #include <fmt/format.h>
+#include <fmt/compile.h>
 
 #include "chemfiles/exports.h"
+#include "chemfiles/float_formatting.hpp"
 
 namespace chemfiles {
 
@@ -42,6 +45,8 @@ public:
         BZIP2,
         /// lzma compression (.xz)
         LZMA,
+        /// gzip compression, compressing data in multiple threads when writing
+        GZIP_PARALLEL,
     };
 
     virtual ~File() noexcept = default;
@@ -69,6 +74,8 @@ private:
     Compression compression_;
 };
 
+class ThreadPool;
+
 /// Abstract base class for readers used by text files. This is specialized for
 /// compressed files, and might get extended to network or memory mapped files.
 ///
@@ -104,6 +111,25 @@ public:
     /// @throws FileError if it could not write all of the data to the file
     virtual void write(const char* data, size_t count) = 0;
 
+    /// Get the full content of the file, if it is directly available in
+    /// memory (for example using a memory mapped file). This allows
+    /// `TextFile` to return lines pointing directly inside this memory
+    /// instead of copying them to a buffer.
+    ///
+    /// The default implementation returns an empty `string_view` with a
+    /// `nullptr` data, indicating that the content is not available.
+    virtual std::string_view mapped() const {
+        return {};
+    }
+
+    /// Use the given `pool` to run any background work when writing to this
+    /// file, such as compressing data.
+    ///
+    /// The default implementation does nothing.
+    virtual void set_thread_pool(std::shared_ptr<ThreadPool> pool) {
+        (void)pool;
+    }
+
 protected:
     /// Get the string path used to open this file
     std::string_view path() const {
@@ -116,6 +142,34 @@ private:
 
 class MemoryBuffer;
 
+/// Get the number of threads used by `TextFile::print_chunks`, as set by
+/// `set_write_threads`
+size_t write_threads();
+
+/// Buffer used to format data in the functions given to
+/// `TextFile::print_chunks`.
+class FormatBuffer {
+public:
+    /// Format some data in this buffer. This function has the same interface
+    /// and uses the same fast path for compiled format strings as
+    /// `TextFile::print`.
+    template <typename Str, typename... Args>
+    void print(const Str& format, const Args&... args) {
+        if constexpr (detail::is_compiled_format<Str>::value) {
+            fmt::format_to(fmt::appender(buffer_), format, detail::fast_format_arg(args)...);
+        } else {
+            fmt::vformat_to(fmt::appender(buffer_), format, fmt::make_format_args(args...));
+        }
+    }
+
+private:
+    friend class TextFile;
+    fmt::memory_buffer buffer_;
+    /// Warnings sent while formatting data in this buffer in a background
+    /// thread, to be sent when writing the data to the file
+    std::vector<std::string> warnings_;
+};
+
 /// Line-oriented text file reader and writer, using buffered read and fast
 /// lines search.
 ///
@@ -125,7 +179,12 @@ class MemoryBuffer;
 /// `string_view` inside this buffer, removing the need to allocate a new
 /// `std::string` for each line.
 ///
-/// Writing to the files is done without buffering or considering lines.
+/// Writing to the files is done by formatting data in an internal buffer.
+/// Data printed with a runtime format string is written to the file
+/// immediately, while data printed with a compiled format string (see `print`)
+/// is kept in the buffer until it gets large enough, until the next call to
+/// `flush`, `seekpos` or `print` with a runtime format string, or until the
+/// file is closed.
 ///
 ///
 /// This class can read compressed data or in-memory data by using one of the
@@ -146,6 +205,7 @@ public:
     /// compressed file.
     TextFile(std::shared_ptr<MemoryBuffer> memory, File::Mode mode, File::Compression compression);
 
+    ~TextFile() override;
     TextFile(TextFile&&) = default;
     TextFile& operator=(TextFile&&) = default;
     TextFile(const TextFile&) = delete;
@@ -184,11 +244,49 @@ public:
     ///
     /// This function has the same interface as `fmt::print(...)`, writting data
     /// to the file instead of stdout.
+    ///
+    /// Format strings created with `FMT_COMPILE` are parsed at compile time,
+    /// and use faster formatting code for doubles with the `{:<width>g}` and
+    /// `{:<width>.<precision>f}` format specifications. The corresponding
+    /// data is buffered instead of being written to the file immediately. They
+    /// should be preferred when writing a lot of data, e.g. for each atom in a
+    /// frame.
     template <typename Str, typename... Args>
     void print(const Str& format, const Args&... args) {
-        this->vprint(format, fmt::make_format_args(args...));
+        if constexpr (detail::is_compiled_format<Str>::value) {
+            auto initial = write_buffer_.size();
+            fmt::format_to(fmt::appender(write_buffer_), format, detail::fast_format_arg(args)...);
+            this->written(write_buffer_.size() - initial);
+        } else {
+            this->vprint(format, fmt::make_format_args(args...));
+        }
     }
 
+    /// Write all data buffered by `print` to the underlying file.
+    void flush();
+
+    /// Number of items formatted together by `print_chunks`
+    static constexpr size_t PRINT_CHUNK_SIZE = 4096;
+
+    /// Format `count` items by calling `function(buffer, begin, end)` on
+    /// consecutive chunks of `PRINT_CHUNK_SIZE` items (the last one can be
+    /// smaller), and write the formatted data to the file in order.
+    ///
+    /// If multiple threads are enabled with `set_write_threads` or
+    /// `TextFile::set_write_threads`, chunks are formatted concurrently. In
+    /// this case, `function` should only read shared data, and compute any
+    /// state depending on the previous items from `begin`. Exceptions thrown
+    /// by `function` are forwarded to the caller, and warnings sent by
+    /// `function` are sent from the calling thread in the order of the
+    /// chunks.
+    void print_chunks(size_t count, const std::function<void(FormatBuffer&, size_t, size_t)>& function);
+
+    /// Use a new pool of `threads` threads (or one thread per available CPU
+    /// core if `threads` is 0) to format data in `print_chunks` and to
+    /// compress data when writing this file, instead of the number of threads
+    /// set with `set_write_threads` and the pool shared by all files.
+    void set_write_threads(size_t threads);
+
 private:
     /// Fill the buffer, calling `refill` and setting all needed internal values
     void fill_buffer(size_t start);
@@ -196,10 +294,17 @@ private:
     /// Actually format and print data to the file
     void vprint(fmt::string_view format, fmt::format_args args);
 
+    /// Update the position after writing `count` characters in
+    /// `write_buffer_`, and flush the buffer if it is large enough
+    void written(size_t count);
+
     /// Check if the buffer was initialized and contains data from the
     /// underlying  `TextFileImpl`.
     bool buffer_initialized() const;
 
+    /// Implementation of `readline` when the file content is in `mapped_`
+    std::string_view readline_mapped();
+
     /// Pointer to the actual file implementation
     std::unique_ptr<TextFileImpl> file_;
     /// Buffer storing characters read from the `TextFileImpl`. If
@@ -219,6 +324,15 @@ private:
     bool got_impl_eof_ = false;
     /// Did we actually reached the end of file while reading a line?
     bool eof_ = false;
+    /// Full content of the file if the `TextFileImpl` provides it. In this
+    /// case `buffer_` is not used, lines point directly inside this memory
+    /// and `position_` is the position of the next line.
+    std::string_view mapped_;
+    /// Data formatted by `print`, waiting to be written to `file_`
+    fmt::memory_buffer write_buffer_;
+    /// Pool of threads used by `print_chunks` and `file_`, set by
+    /// `set_write_threads`
+    std::shared_ptr<ThreadPool> pool_;
 };
 
 } // namespace chemfiles
@@ -14,6 +14,8 @@
 
 #include "chemfiles/File.hpp"
 #include "chemfiles/Error.hpp"
+#include "chemfiles/types.hpp"
+#include "chemfiles/external/span.hpp"
 #include "chemfiles/external/optional.hpp"
 
 namespace chemfiles {
@@ -83,6 +85,21 @@ public:
     /// @param frame The frame to fill
     virtual void read(Frame& frame);
 
+    /// Read only the positions of the `positions.size()` steps starting at
+    /// `start`, storing the positions of step `start + i` in `positions[i]`.
+    /// Formats can use up to `threads` threads to read the steps in parallel.
+    ///
+    /// The default implementation reads the steps one by one with
+    /// `read_step`.
+    ///
+    /// @throw FormatError if the file does not follow the format
+    /// @throw FileError if their is an OS error while reading the file
+    ///
+    /// @param start The first step to read
+    /// @param positions The arrays to fill with positions
+    /// @param threads The maximal number of threads to use
+    virtual void read_positions_range(size_t start, span<std::vector<Vector3D>> positions, size_t threads);
+
     /// Write a frame to the trajectory file.
     ///
     /// @throw FormatError if the file does not follow the format
@@ -96,6 +113,62 @@ public:
     ///
     /// @return The number of frames
     virtual size_t nsteps() = 0;
+
+    /// Check if this format gives random access to the frames, *i.e.* if
+    /// `read_step` can read any step without depending on previously read
+    /// steps, and multiple instances of this format can read the same file
+    /// concurrently. This is used by `Trajectory::set_read_ahead` to read
+    /// frames in parallel.
+    ///
+    /// The default implementation returns `false`.
+    virtual bool random_access() const {
+        return false;
+    }
+
+    /// Check if this format only reads positions and other per-step data,
+    /// keeping the atoms of the frame it reads into. `read` and `read_step`
+    /// should then only call `Frame::resize` to change the topology. This is
+    /// used by `Trajectory::read(Frame&)` to reuse the topology of the frame
+    /// when it does not change between steps.
+    ///
+    /// The default implementation returns `false`.
+    virtual bool keeps_topology() const {
+        return false;
+    }
+
+    /// Open a new instance of this format, reading the same file in read
+    /// mode and reusing everything this instance already knows about the
+    /// file (such as the offsets of all the steps) instead of scanning the
+    /// file again. This is used by `Trajectory::set_read_ahead` to create
+    /// the instances of the format used by the background threads.
+    ///
+    /// The default implementation returns `nullptr`, and the new instances
+    /// are then opened from scratch.
+    virtual std::unique_ptr<Format> reopen() const {
+        return nullptr;
+    }
+
+    /// Use `threads` threads (or one thread per available CPU core if
+    /// `threads` is 0) to format and compress the data written by this
+    /// format. This is used by `Trajectory::set_write_threads`.
+    ///
+    /// The default implementation does nothing.
+    virtual void set_write_threads(size_t threads) {
+        (void)threads;
+    }
+
+protected:
+    /// Get the metadata this format was registered with in the
+    /// `FormatFactory`, or `nullptr` if this instance was not created by the
+    /// factory.
+    const FormatMetadata* registered_metadata() const {
+        return metadata_;
+    }
+
+private:
+    friend class FormatFactory;
+    /// Metadata of this format, set by the `FormatFactory`
+    const FormatMetadata* metadata_ = nullptr;
 };
 
 /// The `TextFormat` class defines a common, simpler interface for text based
@@ -114,6 +187,7 @@ public:
     void read(Frame& frame) override;
     void write(const Frame& frame) override;
     size_t nsteps() override;
+    void set_write_threads(size_t threads) override;
 
     /// Fast-forward the file for one step, returning a valid position if the
     /// file does contain one more step or `nullopt` if it does not.
@@ -139,6 +213,10 @@ private:
 
     /// Did we found the end of file while scanning or reading?
     bool eof_found_ = false;
+
+    /// Can we use a frame index file for the steps positions? This is only
+    /// the case for files on disk opened in read mode.
+    bool use_frame_index_ = false;
 };
 
 } // namespace chemfiles
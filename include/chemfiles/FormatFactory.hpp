@@ -64,11 +64,15 @@ public:
         const auto& metadata = format_metadata<Format>();
         metadata.validate();
         register_format(metadata,
-            [](const std::string& path, File::Mode mode, File::Compression compression) {
-                return std::make_unique<Format>(path, mode, compression);
+            [&metadata](const std::string& path, File::Mode mode, File::Compression compression) {
+                auto format = std::make_unique<Format>(path, mode, compression);
+                format->metadata_ = &metadata;
+                return format;
             },
-            [](std::shared_ptr<MemoryBuffer> memory, File::Mode mode, File::Compression compression) {
-                return std::make_unique<Format>(std::move(memory), mode, compression);
+            [&metadata](std::shared_ptr<MemoryBuffer> memory, File::Mode mode, File::Compression compression) {
+                auto format = std::make_unique<Format>(std::move(memory), mode, compression);
+                format->metadata_ = &metadata;
+                return format;
             }
         );
     }
@@ -84,8 +88,10 @@ public:
         const auto& metadata = format_metadata<Format>();
         metadata.validate();
         register_format(metadata,
-            [](const std::string& path, File::Mode mode, File::Compression compression) {
-                return std::make_unique<Format>(path, mode, compression);
+            [&metadata](const std::string& path, File::Mode mode, File::Compression compression) {
+                auto format = std::make_unique<Format>(path, mode, compression);
+                format->metadata_ = &metadata;
+                return format;
             }
         );
     }
@@ -4,6 +4,8 @@
 #ifndef CHEMFILES_FRAME_HPP
 #define CHEMFILES_FRAME_HPP
 
+#include <mutex>
+#include <atomic>
 #include <cstddef>
 #include <string>
 #include <utility>
@@ -23,6 +25,74 @@
 namespace chemfiles {
 class Atom;
 
+/// An array of 3D vectors stored as a structure of arrays: the x, y and z
+/// components of all the vectors are stored in separate single precision
+/// arrays.
+struct Vector3DSoA final {
+    Vector3DSoA() = default;
+
+    /// Create an array containing `size` vectors, initialized to 0
+    explicit Vector3DSoA(size_t size): x(size), y(size), z(size) {}
+
+    /// Get the number of vectors in this array
+    size_t size() const {
+        return x.size();
+    }
+
+    /// Get the vector at index `i`, converted to double precision
+    Vector3D operator[](size_t i) const {
+        return {
+            static_cast<double>(x[i]),
+            static_cast<double>(y[i]),
+            static_cast<double>(z[i]),
+        };
+    }
+
+    /// Set the vector at index `i` to `vector`
+    void set(size_t i, const Vector3D& vector) {
+        x[i] = static_cast<float>(vector[0]);
+        y[i] = static_cast<float>(vector[1]);
+        z[i] = static_cast<float>(vector[2]);
+    }
+
+    /// Resize this array to contain `size` vectors, new vectors are
+    /// initialized to 0.
+    void resize(size_t size) {
+        x.resize(size);
+        y.resize(size);
+        z.resize(size);
+    }
+
+    /// Allocate memory for `size` vectors
+    void reserve(size_t size) {
+        x.reserve(size);
+        y.reserve(size);
+        z.reserve(size);
+    }
+
+    /// Add `vector` at the end of this array
+    void push_back(const Vector3D& vector) {
+        x.push_back(static_cast<float>(vector[0]));
+        y.push_back(static_cast<float>(vector[1]));
+        z.push_back(static_cast<float>(vector[2]));
+    }
+
+    /// Remove the vector at index `i`
+    void erase(size_t i) {
+        auto offset = static_cast<std::ptrdiff_t>(i);
+        x.erase(x.begin() + offset);
+        y.erase(y.begin() + offset);
+        z.erase(z.begin() + offset);
+    }
+
+    /// x components of the vectors
+    std::vector<float> x;
+    /// y components of the vectors
+    std::vector<float> y;
+    /// z components of the vectors
+    std::vector<float> z;
+};
+
 /// A frame contains data from one simulation step The Frame class holds data
 /// from one step of a simulation: the current topology, the positions, and the
 /// velocities of the particles in the system. If some information is missing
@@ -42,6 +112,17 @@ class Atom;
 /// @example{frame/iterate.cpp}
 class CHFL_EXPORT Frame final {
 public:
+    /// Layout used to store the positions and velocities of a frame
+    enum Storage {
+        /// Arrays of `Vector3D`, using double precision. This is the default
+        AOS_DOUBLE = 0,
+        /// `Vector3DSoA`, with separate single precision arrays for the x, y
+        /// and z components. This halves the memory used by positions and
+        /// velocities, and matches the precision of most binary trajectory
+        /// formats.
+        SOA_FLOAT = 1,
+    };
+
     /// Create an empty frame with no atoms and the given cell.
     ///
     /// @example{frame/frame.cpp}
@@ -111,21 +192,74 @@ public:
     /// @example{frame/size.cpp}
     size_t size() const;
 
+    /// Get the layout used to store positions and velocities in this frame
+    ///
+    /// @example{frame/storage.cpp}
+    Storage storage() const {
+        return storage_;
+    }
+
+    /// Change the layout used to store positions and velocities in this frame
+    /// to `storage`, converting any existing data.
+    ///
+    /// Converting to `Frame::SOA_FLOAT` rounds positions and velocities to
+    /// single precision.
+    ///
+    /// @example{frame/storage.cpp}
+    void set_storage(Storage storage);
+
     /// Get the positions (in Angstroms) of the atoms in this frame.
     ///
+    /// If this frame uses the `Frame::SOA_FLOAT` storage, it is converted
+    /// back to the `Frame::AOS_DOUBLE` storage.
+    ///
     /// @example{frame/positions.cpp}
     span<Vector3D> positions() {
+        if (storage_ != AOS_DOUBLE) {
+            set_storage(AOS_DOUBLE);
+        }
         return positions_;
     }
 
     /// Get the positions (in Angstroms) of the atoms in this frame as a const
     /// reference
     ///
+    /// If this frame uses the `Frame::SOA_FLOAT` storage, this returns a
+    /// double precision copy of the positions, created on the first call and
+    /// kept until the frame is modified.
+    ///
     /// @example{frame/positions.cpp}
     const std::vector<Vector3D>& positions() const {
+        if (storage_ != AOS_DOUBLE) {
+            update_double_cache();
+            return double_cache_.positions;
+        }
         return positions_;
     }
 
+    /// Get the positions (in Angstroms) of the atoms in this frame stored as
+    /// single precision structure of arrays.
+    ///
+    /// @throw Error if this frame does not use the `Frame::SOA_FLOAT` storage
+    ///
+    /// @example{frame/storage.cpp}
+    Vector3DSoA& positions_soa() {
+        check_soa_storage();
+        double_cache_.valid = false;
+        return positions_soa_;
+    }
+
+    /// Get the positions (in Angstroms) of the atoms in this frame stored as
+    /// single precision structure of arrays, as a const reference.
+    ///
+    /// @throw Error if this frame does not use the `Frame::SOA_FLOAT` storage
+    ///
+    /// @example{frame/storage.cpp}
+    const Vector3DSoA& positions_soa() const {
+        check_soa_storage();
+        return positions_soa_;
+    }
+
     /// Add velocities data storage to this frame.
     ///
     /// If velocities are already defined, this functions does nothing. The new
@@ -137,8 +271,14 @@ public:
     /// Get an velocities (in Angstroms/ps) of the atoms in this frame, if this
     /// frame contains velocity data.
     ///
+    /// If this frame uses the `Frame::SOA_FLOAT` storage, it is converted
+    /// back to the `Frame::AOS_DOUBLE` storage.
+    ///
     /// @example{frame/velocities.cpp}
     optional<span<Vector3D>> velocities() {
+        if (storage_ != AOS_DOUBLE) {
+            set_storage(AOS_DOUBLE);
+        }
         if (velocities_) {
             return {*velocities_};
         } else {
@@ -149,8 +289,20 @@ public:
     /// Get an velocities (in Angstroms/ps) of the atoms in this frame as a
     /// const reference, if this frame contains velocity data.
     ///
+    /// If this frame uses the `Frame::SOA_FLOAT` storage, this returns a
+    /// double precision copy of the velocities, with the same rules as the
+    /// const version of `Frame::positions`.
+    ///
     /// @example{frame/velocities.cpp}
     optional<const std::vector<Vector3D>&> velocities() const {
+        if (storage_ != AOS_DOUBLE) {
+            update_double_cache();
+            if (double_cache_.velocities) {
+                return {*double_cache_.velocities};
+            } else {
+                return nullopt;
+            }
+        }
         if (velocities_) {
             return {*velocities_};
         } else {
@@ -158,6 +310,39 @@ public:
         }
     }
 
+    /// Get the velocities (in Angstroms/ps) of the atoms in this frame stored
+    /// as single precision structure of arrays, if this frame contains
+    /// velocity data.
+    ///
+    /// @throw Error if this frame does not use the `Frame::SOA_FLOAT` storage
+    ///
+    /// @example{frame/storage.cpp}
+    optional<Vector3DSoA&> velocities_soa() {
+        check_soa_storage();
+        double_cache_.valid = false;
+        if (velocities_soa_) {
+            return {*velocities_soa_};
+        } else {
+            return nullopt;
+        }
+    }
+
+    /// Get the velocities (in Angstroms/ps) of the atoms in this frame stored
+    /// as single precision structure of arrays as a const reference, if this
+    /// frame contains velocity data.
+    ///
+    /// @throw Error if this frame does not use the `Frame::SOA_FLOAT` storage
+    ///
+    /// @example{frame/storage.cpp}
+    optional<const Vector3DSoA&> velocities_soa() const {
+        check_soa_storage();
+        if (velocities_soa_) {
+            return {*velocities_soa_};
+        } else {
+            return nullopt;
+        }
+    }
+
     /// Resize the frame to contain `size` atoms.
     ///
     /// If the new number of atoms is bigger than the old one, missing data is
@@ -192,6 +377,19 @@ public:
     /// @example{frame/remove.cpp}
     void remove(size_t i);
 
+    /// Remove all the atoms at the given `indexes` in the system, together
+    /// with their positions, velocities and bonds.
+    ///
+    /// The indexes can be given in any order, and duplicated indexes are
+    /// ignored. The remaining atoms keep their relative order. This is much
+    /// faster than removing the atoms one by one.
+    ///
+    /// @throws chemfiles::OutOfBounds if any index is bigger than the number
+    ///         of atoms in this frame
+    ///
+    /// @example{frame/remove_multiple.cpp}
+    void remove(span<const size_t> indexes);
+
     /// Get the current simulation step.
     ///
     /// The step is set by the `Trajectory` when reading a frame.
@@ -252,6 +450,21 @@ public:
         topology_.add_bond(atom_i, atom_j, bond_order);
     }
 
+    /// Add multiple bonds in the system at once, with the corresponding
+    /// `bond_orders`. If `bond_orders` is empty, all bonds are added with an
+    /// unknown bond order.
+    ///
+    /// @example{frame/add_bonds.cpp}
+    ///
+    /// @param bonds the bonds to add
+    /// @param bond_orders the bond orders of the new bonds
+    /// @throws OutOfBounds if any atom in `bonds` is greater than `size()`
+    /// @throws Error if `bond_orders` is not empty and does not have the same
+    ///         size as `bonds`
+    void add_bonds(span<const Bond> bonds, span<const Bond::BondOrder> bond_orders = {}) {
+        topology_.add_bonds(bonds, bond_orders);
+    }
+
     /// Remove a bond in the system, between the atoms at index `atom_i` and
     /// `atom_j`.
     ///
@@ -383,12 +596,81 @@ private:
     Frame(const Frame&) = default;
     Frame& operator=(const Frame&) = default;
 
+    // `Trajectory` and `FramePrefetcher` use `clear_for_reading` to read in
+    // an existing frame
+    friend class Trajectory;
+    friend class FramePrefetcher;
+
+    /// Remove all data from this frame before reading a new step in it,
+    /// keeping the allocated memory for positions. If `keep_topology` is
+    /// true, the topology and the number of atoms are kept, and all positions
+    /// are set to zero.
+    void clear_for_reading(bool keep_topology);
+
+    /// Get the position of the atom at index `i`, whatever the storage
+    Vector3D position(size_t i) const {
+        if (storage_ == SOA_FLOAT) {
+            return positions_soa_[i];
+        } else {
+            return positions_[i];
+        }
+    }
+
+    /// Throw an error if this frame does not use the `SOA_FLOAT` storage
+    void check_soa_storage() const;
+    /// Update the double precision copy of positions and velocities used by
+    /// the `SOA_FLOAT` storage, if needed
+    void update_double_cache() const;
+
     /// Current simulation step
     size_t step_ = 0;
-    /// Positions of the particles
+    /// Storage used for positions and velocities
+    Storage storage_ = AOS_DOUBLE;
+    /// Positions of the particles, with the `AOS_DOUBLE` storage
     std::vector<Vector3D> positions_;
-    /// Velocities of the particles
+    /// Velocities of the particles, with the `AOS_DOUBLE` storage
     optional<std::vector<Vector3D>> velocities_;
+    /// Positions of the particles, with the `SOA_FLOAT` storage
+    Vector3DSoA positions_soa_;
+    /// Velocities of the particles, with the `SOA_FLOAT` storage
+    optional<Vector3DSoA> velocities_soa_;
+    /// Double precision copy of the positions and velocities used by the
+    /// const versions of `positions()` and `velocities()` with the
+    /// `SOA_FLOAT` storage. It can be created by multiple threads at the same
+    /// time, and is not copied with the frame.
+    struct DoubleCache {
+        DoubleCache() = default;
+        DoubleCache(const DoubleCache&) {}
+        DoubleCache& operator=(const DoubleCache&) {
+            valid = false;
+            return *this;
+        }
+        DoubleCache(DoubleCache&& other) noexcept:
+            positions(std::move(other.positions)),
+            velocities(std::move(other.velocities)),
+            valid(other.valid.load())
+        {
+            other.valid = false;
+        }
+        DoubleCache& operator=(DoubleCache&& other) noexcept {
+            positions = std::move(other.positions);
+            velocities = std::move(other.velocities);
+            valid = other.valid.load();
+            other.valid = false;
+            return *this;
+        }
+        ~DoubleCache() = default;
+
+        /// Double precision copy of `positions_soa_`
+        std::vector<Vector3D> positions;
+        /// Double precision copy of `velocities_soa_`
+        optional<std::vector<Vector3D>> velocities;
+        /// Are `positions` and `velocities` up to date?
+        std::atomic<bool> valid{false};
+        /// Mutex protecting the creation of the copies
+        std::mutex mutex;
+    };
+    mutable DoubleCache double_cache_;
     /// Topology of the described system
     Topology topology_;
     /// Unit cell of the system
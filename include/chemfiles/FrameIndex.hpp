@@ -0,0 +1,38 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#ifndef CHEMFILES_FRAME_INDEX_HPP
+#define CHEMFILES_FRAME_INDEX_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "chemfiles/external/optional.hpp"
+
+namespace chemfiles {
+
+/// Check if frame index files are enabled, see `set_frame_index_files`
+bool frame_index_files_enabled();
+
+/// Get the path of the frame index file associated with the trajectory file
+/// at `path`
+std::string frame_index_path(const std::string& path);
+
+/// Load the offsets of all the steps in the trajectory file at `path`, read
+/// with the given `format`, from the associated frame index file.
+///
+/// This returns `nullopt` if frame index files are disabled, or if the index
+/// file does not exist, is corrupted, was created for another format, or does
+/// not match the current content of the trajectory file.
+optional<std::vector<uint64_t>> load_frame_index(const std::string& path, const std::string& format);
+
+/// Store the `offsets` of all the steps in the trajectory file at `path`,
+/// read with the given `format`, in the associated frame index file. This does
+/// nothing if frame index files are disabled, and failures to write the index
+/// are silently ignored.
+void save_frame_index(const std::string& path, const std::string& format, const std::vector<uint64_t>& offsets);
+
+} // namespace chemfiles
+
+#endif
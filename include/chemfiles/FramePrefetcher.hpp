@@ -0,0 +1,103 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#ifndef CHEMFILES_FRAME_PREFETCHER_HPP
+#define CHEMFILES_FRAME_PREFETCHER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+#include "chemfiles/Frame.hpp"
+
+namespace chemfiles {
+class Format;
+
+/// A `FramePrefetcher` reads the next frames of a trajectory ahead of time,
+/// using a pool of background threads, and gives them back in order.
+///
+/// Each thread uses its own instance of a random access `Format` (see
+/// `Format::random_access`) to read steps with `Format::read_step`. At most
+/// `frames` frames are stored at any time, including the ones being read.
+class FramePrefetcher final {
+public:
+    /// Function creating a new instance of the format to read from
+    using format_opener_t = std::function<std::unique_ptr<Format>()>;
+
+    /// Create a new prefetcher for a file containing `nsteps` steps, keeping
+    /// up to `frames` frames in memory and reading them with `threads`
+    /// threads. All the instances of the format are created by calling `open`
+    /// before this constructor returns.
+    FramePrefetcher(const format_opener_t& open, size_t nsteps, size_t frames, size_t threads);
+    ~FramePrefetcher();
+
+    FramePrefetcher(const FramePrefetcher&) = delete;
+    FramePrefetcher& operator=(const FramePrefetcher&) = delete;
+    FramePrefetcher(FramePrefetcher&&) = delete;
+    FramePrefetcher& operator=(FramePrefetcher&&) = delete;
+
+    /// Put the frame at the given `step` in `frame`, waiting for it to be
+    /// read if needed. If `step` does not follow the step from the previous
+    /// call, all the frames read ahead of time are discarded and reading
+    /// restarts from `step`. The previous content of `frame` is kept, and its
+    /// memory reused to read one of the next steps.
+    ///
+    /// Any error that occurred while reading this step is re-thrown here.
+    void get(size_t step, Frame& frame);
+
+private:
+    /// Storage for a single frame being read
+    struct Slot {
+        /// Is the frame in this slot ready?
+        bool ready = false;
+        /// The frame, valid if `ready` is true and `error` is not set
+        Frame frame;
+        /// Error that occurred while reading the frame
+        std::exception_ptr error;
+    };
+
+    /// Main loop of the worker threads, reading frames with `format`
+    void worker(Format& format);
+    /// Stop and join all the worker threads
+    void stop();
+    /// Discard all frames, and restart reading at `step`. The mutex must be
+    /// held when calling this function.
+    void restart(size_t step);
+
+    /// Total number of steps in the file
+    size_t nsteps_;
+    /// Slots for the frames being read, the frame at step `i` is stored in
+    /// `slots_[i % slots_.size()]`
+    std::vector<Slot> slots_;
+    /// Next step to give back in `get`
+    size_t next_ = 0;
+    /// Next step a worker should read
+    size_t dispatch_ = 0;
+    /// Incremented each time reading restarts, to discard frames read for a
+    /// previous position
+    uint64_t generation_ = 0;
+    /// Frames given back by `get`, reused by the workers to read new steps
+    std::vector<Frame> spares_;
+    /// Should the workers stop?
+    bool stop_ = false;
+    /// Mutex protecting all the data above
+    std::mutex mutex_;
+    /// Signaled when new steps can be read by the workers
+    std::condition_variable work_available_;
+    /// Signaled when a frame has been read
+    std::condition_variable frame_ready_;
+    /// Formats used by each worker
+    std::vector<std::unique_ptr<Format>> formats_;
+    /// Worker threads
+    std::vector<std::thread> workers_;
+};
+
+} // namespace chemfiles
+
+#endif
@@ -0,0 +1,217 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#ifndef CHEMFILES_NEIGHBOR_GRID_HPP
+#define CHEMFILES_NEIGHBOR_GRID_HPP
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "chemfiles/exports.h"
+#include "chemfiles/types.hpp"
+#include "chemfiles/external/span.hpp"
+
+#include "chemfiles/UnitCell.hpp"
+
+namespace chemfiles {
+
+/// A `NeighborGrid` is a spatial search structure (also known as linked cells
+/// or cell list), allowing to find all pairs of points closer than a given
+/// cutoff in linear time.
+///
+/// The points are sorted in a regular grid with cells larger than the cutoff,
+/// so that only points in neighboring cells have to be checked. Periodic
+/// boundary conditions are taken into account for orthorhombic and triclinic
+/// unit cells, and distances are computed using the same minimum image
+/// convention as `UnitCell::wrap`. For infinite unit cells, the grid covers the
+/// bounding box of all the points.
+///
+/// @example{neighbor_grid/neighbor_grid.cpp}
+class CHFL_EXPORT NeighborGrid final {
+public:
+    /// Create a new grid containing the given `positions`, to search for pairs
+    /// closer than `cutoff` (in Angstroms), using the periodic boundary
+    /// conditions of the given unit `cell`.
+    ///
+    /// @throws Error if the `cutoff` is not a strictly positive number
+    ///
+    /// @example{neighbor_grid/neighbor_grid.cpp}
+    NeighborGrid(const UnitCell& cell, span<const Vector3D> positions, double cutoff);
+
+    ~NeighborGrid() = default;
+    NeighborGrid(const NeighborGrid&) = default;
+    NeighborGrid& operator=(const NeighborGrid&) = default;
+    NeighborGrid(NeighborGrid&&) = default;
+    NeighborGrid& operator=(NeighborGrid&&) = default;
+
+    /// Get the cutoff used to create this grid
+    ///
+    /// @example{neighbor_grid/neighbor_grid.cpp}
+    double cutoff() const {
+        return cutoff_;
+    }
+
+    /// Get the number of points in this grid
+    ///
+    /// @example{neighbor_grid/neighbor_grid.cpp}
+    size_t size() const {
+        return positions_.size();
+    }
+
+    /// Call `function(i, j, vector)` for all pairs of points `i < j` closer
+    /// than the cutoff, where `vector` is the minimum image vector going from
+    /// point `i` to point `j`. Each pair is visited exactly once, in an
+    /// unspecified order.
+    ///
+    /// @example{neighbor_grid/foreach_pair.cpp}
+    template <class Function>
+    void foreach_pair(Function&& function) const;
+
+    /// Call `function(j, vector)` for all points `j` closer than the cutoff to
+    /// the given `point`, where `vector` is the minimum image vector going from
+    /// `point` to `j`. The point itself is never included.
+    ///
+    /// @throws OutOfBounds if `point` is not smaller than `size()`
+    ///
+    /// @example{neighbor_grid/foreach_neighbor.cpp}
+    template <class Function>
+    void foreach_neighbor(size_t point, Function&& function) const;
+
+    /// Get all the pairs of points `i < j` closer than the cutoff, sorted in
+    /// lexicographic order.
+    ///
+    /// @example{neighbor_grid/pairs.cpp}
+    std::vector<std::array<size_t, 2>> pairs() const;
+
+private:
+    /// Apply the minimum image convention to `vector`, mirroring
+    /// `UnitCell::wrap` without the dispatch on the cell shape.
+    Vector3D minimum_image(const Vector3D& vector) const {
+        switch (shape_) {
+        case UnitCell::ORTHORHOMBIC:
+            return {
+                vector[0] - std::round(vector[0] / lengths_[0]) * lengths_[0],
+                vector[1] - std::round(vector[1] / lengths_[1]) * lengths_[1],
+                vector[2] - std::round(vector[2] / lengths_[2]) * lengths_[2],
+            };
+        case UnitCell::TRICLINIC: {
+            auto fractional = inverse_ * vector;
+            fractional[0] -= std::round(fractional[0]);
+            fractional[1] -= std::round(fractional[1]);
+            fractional[2] -= std::round(fractional[2]);
+            return matrix_ * fractional;
+        }
+        case UnitCell::INFINITE:
+        default:
+            return vector;
+        }
+    }
+
+    /// Get the linear index of the cell at grid coordinates `a, b, c`
+    size_t linear_index(size_t a, size_t b, size_t c) const {
+        return (a * n_cells_[1] + b) * n_cells_[2] + c;
+    }
+
+    /// Get the list of distinct cells neighboring the cell at grid
+    /// coordinates `a, b, c` (including this cell), in the `neighbors` array.
+    /// The number of neighboring cells is returned.
+    size_t neighbor_cells(size_t a, size_t b, size_t c, std::array<size_t, 27>& neighbors) const;
+
+    /// Check that `point` is a valid point index for this grid
+    void check_point(size_t point) const;
+
+    /// Shape of the unit cell used for periodic boundary conditions
+    UnitCell::CellShape shape_;
+    /// Cell lengths, used for orthorhombic cells
+    Vector3D lengths_;
+    /// Cell matrix and its inverse, used for triclinic cells
+    Matrix3D matrix_;
+    Matrix3D inverse_;
+    /// Is the grid periodic? This is false for infinite and degenerated cells
+    bool periodic_ = false;
+    /// Cutoff for the neighbor search
+    double cutoff_;
+    /// Number of cells along each dimension of the grid
+    std::array<size_t, 3> n_cells_ = {{1, 1, 1}};
+    /// Index of the first point in each cell inside `points_`, with an
+    /// additional final value containing the total number of points. The
+    /// points inside cell `c` are in `points_[offsets_[c]:offsets_[c + 1]]`.
+    std::vector<size_t> offsets_;
+    /// Index of the points, sorted by cell
+    std::vector<size_t> points_;
+    /// Positions of the points, sorted by cell
+    std::vector<Vector3D> positions_;
+    /// Cell containing each point, indexed by the original point index
+    std::vector<size_t> cell_of_point_;
+    /// Index of each point in the sorted arrays, indexed by the original point
+    /// index
+    std::vector<size_t> sorted_index_;
+};
+
+template <class Function>
+void NeighborGrid::foreach_pair(Function&& function) const {
+    auto cutoff2 = cutoff_ * cutoff_;
+    auto neighbors = std::array<size_t, 27>();
+    for (size_t a = 0; a < n_cells_[0]; a++) {
+        for (size_t b = 0; b < n_cells_[1]; b++) {
+            for (size_t c = 0; c < n_cells_[2]; c++) {
+                auto cell = linear_index(a, b, c);
+                auto n_neighbors = neighbor_cells(a, b, c, neighbors);
+                for (size_t n = 0; n < n_neighbors; n++) {
+                    auto other = neighbors[n];
+                    if (other < cell) {
+                        // this pair of cells will be visited from `other`
+                        continue;
+                    }
+
+                    for (auto i = offsets_[cell]; i < offsets_[cell + 1]; i++) {
+                        auto start = (other == cell) ? i + 1 : offsets_[other];
+                        for (auto j = start; j < offsets_[other + 1]; j++) {
+                            auto vector = minimum_image(positions_[j] - positions_[i]);
+                            if (dot(vector, vector) < cutoff2) {
+                                if (points_[i] < points_[j]) {
+                                    function(points_[i], points_[j], vector);
+                                } else {
+                                    function(points_[j], points_[i], -vector);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <class Function>
+void NeighborGrid::foreach_neighbor(size_t point, Function&& function) const {
+    check_point(point);
+
+    auto cutoff2 = cutoff_ * cutoff_;
+    auto cell = cell_of_point_[point];
+    auto c = cell % n_cells_[2];
+    auto b = (cell / n_cells_[2]) % n_cells_[1];
+    auto a = cell / (n_cells_[2] * n_cells_[1]);
+    const auto& position = positions_[sorted_index_[point]];
+
+    auto neighbors = std::array<size_t, 27>();
+    auto n_neighbors = neighbor_cells(a, b, c, neighbors);
+    for (size_t n = 0; n < n_neighbors; n++) {
+        auto other = neighbors[n];
+        for (auto j = offsets_[other]; j < offsets_[other + 1]; j++) {
+            if (points_[j] == point) {
+                continue;
+            }
+            auto vector = minimum_image(positions_[j] - position);
+            if (dot(vector, vector) < cutoff2) {
+                function(points_[j], vector);
+            }
+        }
+    }
+}
+
+} // namespace chemfiles
+
+#endif
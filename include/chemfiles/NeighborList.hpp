@@ -0,0 +1,141 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#ifndef CHEMFILES_NEIGHBOR_LIST_HPP
+#define CHEMFILES_NEIGHBOR_LIST_HPP
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "chemfiles/exports.h"
+#include "chemfiles/types.hpp"
+
+#include "chemfiles/UnitCell.hpp"
+
+namespace chemfiles {
+class Frame;
+
+/// A pair of atoms in a `NeighborList`
+struct NeighborPair {
+    /// Index of the first atom in the pair. This is always smaller than
+    /// `second`.
+    size_t first;
+    /// Index of the second atom in the pair
+    size_t second;
+    /// Distance between the two atoms, in Angstroms
+    double distance;
+    /// Minimum image vector going from the first atom to the second atom
+    Vector3D vector;
+};
+
+/// A `NeighborList` contains all the pairs of atoms in a `Frame` closer than a
+/// given cutoff, accounting for periodic boundary conditions.
+///
+/// The list can be updated with new positions using `NeighborList::update`.
+/// When the list is created with a non-zero `skin`, all the pairs closer than
+/// `cutoff + skin` are stored as candidates (Verlet list), and the grid-based
+/// search only runs again once an atom moved by more than half of the skin
+/// since the last search. Otherwise, only the distances of the candidate
+/// pairs are computed again.
+///
+/// Iterating over a `NeighborList` yields all the `NeighborPair` in the list,
+/// sorted by atomic indexes.
+///
+/// @example{neighbor_list/neighbor_list.cpp}
+class CHFL_EXPORT NeighborList final {
+public:
+    using const_iterator = std::vector<NeighborPair>::const_iterator;
+
+    /// Create a new neighbor list containing all the pairs of atoms in `frame`
+    /// closer than `cutoff` (in Angstroms), with an additional `skin` distance
+    /// (in Angstroms) to use for candidate pairs when updating the list.
+    ///
+    /// @throws Error if `cutoff` is not strictly positive or if `skin` is
+    ///         negative
+    ///
+    /// @example{neighbor_list/neighbor_list.cpp}
+    NeighborList(const Frame& frame, double cutoff, double skin = 0.0);
+
+    ~NeighborList() = default;
+    NeighborList(const NeighborList&) = default;
+    NeighborList& operator=(const NeighborList&) = default;
+    NeighborList(NeighborList&&) = default;
+    NeighborList& operator=(NeighborList&&) = default;
+
+    /// Get the cutoff of this neighbor list
+    ///
+    /// @example{neighbor_list/neighbor_list.cpp}
+    double cutoff() const {
+        return cutoff_;
+    }
+
+    /// Get the skin distance of this neighbor list
+    ///
+    /// @example{neighbor_list/neighbor_list.cpp}
+    double skin() const {
+        return skin_;
+    }
+
+    /// Update this neighbor list to use the positions and unit cell of the
+    /// given `frame`.
+    ///
+    /// The full neighbor search is only performed again if the number of atoms
+    /// or the unit cell changed, or if any atom moved by more than half of the
+    /// skin distance since the last search.
+    ///
+    /// @example{neighbor_list/update.cpp}
+    void update(const Frame& frame);
+
+    /// Get the number of pairs in this neighbor list
+    ///
+    /// @example{neighbor_list/pairs.cpp}
+    size_t size() const {
+        return pairs_.size();
+    }
+
+    /// Get all the pairs in this neighbor list, sorted by atomic indexes
+    ///
+    /// @example{neighbor_list/pairs.cpp}
+    const std::vector<NeighborPair>& pairs() const {
+        return pairs_;
+    }
+
+    /// Get the number of full neighbor searches performed since the creation
+    /// of this list, including the initial one.
+    ///
+    /// @example{neighbor_list/update.cpp}
+    size_t searches() const {
+        return searches_;
+    }
+
+    const_iterator begin() const {return pairs_.begin();}
+    const_iterator end() const {return pairs_.end();}
+    const_iterator cbegin() const {return pairs_.cbegin();}
+    const_iterator cend() const {return pairs_.cend();}
+
+private:
+    /// Run the full grid-based search for candidate pairs
+    void search(const Frame& frame);
+    /// Recompute the pairs from the candidates pairs
+    void refresh(const Frame& frame);
+
+    /// Cutoff of the list
+    double cutoff_;
+    /// Additional skin used for the candidate pairs
+    double skin_;
+    /// Unit cell used during the last search
+    UnitCell cell_;
+    /// Positions used during the last search
+    std::vector<Vector3D> reference_;
+    /// Candidate pairs closer than `cutoff_ + skin_` during the last search
+    std::vector<std::array<size_t, 2>> candidates_;
+    /// Actual pairs closer than `cutoff_`
+    std::vector<NeighborPair> pairs_;
+    /// Number of full searches
+    size_t searches_ = 0;
+};
+
+} // namespace chemfiles
+
+#endif
@@ -8,6 +8,7 @@
 #include <cstdint>
 
 #include <string>
+#include <vector>
 #include <algorithm>
 #include <utility>
 
@@ -137,14 +138,13 @@ private:
     /// Additional properties of this residue
     property_map properties_;
 
-    /// Update the atomic indexes in this residue after an atom has been
-    /// removed from the containing topology.
+    /// Update the atomic indexes in this residue after multiple atoms have
+    /// been removed from the containing topology.
     ///
-    /// This function shifts all the indexes bigger than `i` by -1.
-    void atom_removed(size_t i);
-
-    /// remove the atom at index i from this residue
-    void remove(size_t i);
+    /// `new_indexes[i]` is the index of the atom `i` after the removal, or
+    /// `SIZE_MAX` if this atom was removed. Indexes outside of `new_indexes`
+    /// are shifted by `-removed`.
+    void atoms_removed(const std::vector<size_t>& new_indexes, size_t removed);
 
     friend bool operator==(const Residue& lhs, const Residue& rhs);
 
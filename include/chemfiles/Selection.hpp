@@ -5,6 +5,7 @@
 #define CHEMFILES_SELECTION_HPP
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -18,6 +19,7 @@ class Frame;
 
 namespace selections {
     class Selector;
+    class SubSelection;
     using Ast = std::unique_ptr<Selector>;
 }
 
@@ -92,6 +94,18 @@ enum class Context {
     DIHEDRAL
 };
 
+/// Statistics about the cache of compiled selections
+struct SelectionCacheStats {
+    /// Number of selections created from a cached compiled selection
+    uint64_t hits;
+    /// Number of selections which had to be compiled
+    uint64_t misses;
+    /// Number of compiled selections currently in the cache
+    size_t size;
+    /// Maximal number of compiled selections in the cache
+    size_t capacity;
+};
+
 /// This class allow to select atoms in a `Frame`, from a selection language.
 ///
 /// The selection language is built by combining basic operations. Each basic
@@ -102,6 +116,11 @@ enum class Context {
 /// Refer to the :ref:`selection-language` documentation to know the allowed
 /// selectors and how to use them.
 /// @endverbatim
+///
+/// Compiled selections are stored in a process-wide cache, keyed by the
+/// selection string. Creating a `Selection` from a string already in the cache
+/// skips the parsing of the selection. This cache is thread-safe, and only
+/// keeps the most recently used selections.
 class CHFL_EXPORT Selection final {
 public:
     /// Create a selection using the given string.
@@ -121,6 +140,10 @@ public:
     /// Evaluates the selection on a given `frame`. This function returns the
     /// list of matches in the frame for this selection.
     ///
+    /// If the selection only depends on the topology of the frame (see
+    /// `Selection::topology_only`), the matches are computed once and re-used
+    /// for all the frames sharing the same `Topology::version`.
+    ///
     /// @example{selection/evaluate.cpp}
     std::vector<Match> evaluate(const Frame& frame) const;
 
@@ -145,13 +168,61 @@ public:
         return selection_;
     }
 
+    /// Check if this selection only depends on the topology of the frame
+    /// (atomic names, types, masses, properties, residues and bonds), and not
+    /// on the positions, velocities or unit cell.
+    ///
+    /// @example{selection/topology_only.cpp}
+    bool topology_only() const {
+        return topology_only_;
+    }
+
+    /// Get statistics about the process-wide cache of compiled selections
+    ///
+    /// @example{selection/cache.cpp}
+    static SelectionCacheStats cache_stats();
+
+    /// Set the maximal number of compiled selections to keep in the
+    /// process-wide cache to `capacity`, removing the least recently used
+    /// selections if needed. A `capacity` of 0 disables the cache. The default
+    /// capacity is 128 selections.
+    ///
+    /// @example{selection/cache.cpp}
+    static void set_cache_capacity(size_t capacity);
+
+    /// Remove all compiled selections from the process-wide cache, and reset
+    /// the cache statistics
+    ///
+    /// @example{selection/cache.cpp}
+    static void clear_cache();
+
 private:
+    Selection() = default;
+
+    /// Create a copy of this selection, with a deep copy of the AST and
+    /// without any cached data
+    Selection clone() const;
+
+    /// Evaluate the selection on the given `frame`, without using the cached
+    /// matches
+    std::vector<Match> evaluate_uncached(const Frame& frame) const;
+
     /// Store the selection string that generated this selection
     std::string selection_;
     /// Selection context
     Context context_ = Context::ATOM;
     /// AST for evaluation of the selection
     selections::Ast ast_;
+    /// Does this selection only depend on the topology?
+    bool topology_only_ = false;
+    /// Topology version used to compute `cached_matches_`. The versions start
+    /// at 1, so 0 means that there are no cached matches.
+    mutable uint64_t cached_version_ = 0;
+    /// Cached matches for topology only selections
+    mutable std::vector<Match> cached_matches_;
+
+    // sub-selections are copied with `clone`
+    friend class selections::SubSelection;
 };
 }
 
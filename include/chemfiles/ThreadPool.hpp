@@ -0,0 +1,86 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#ifndef CHEMFILES_THREAD_POOL_HPP
+#define CHEMFILES_THREAD_POOL_HPP
+
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace chemfiles {
+
+/// A fixed pool of worker threads, running tasks in the order they are
+/// submitted. This is used to format and compress data in the background
+/// when writing files.
+class ThreadPool final {
+public:
+    /// Create a new pool with `threads` worker threads, or one thread per
+    /// available CPU core if `threads` is 0
+    explicit ThreadPool(size_t threads);
+    /// Run all the remaining tasks, and stop the worker threads
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    /// Get the pool shared by all files which do not use their own pool,
+    /// with one thread per available CPU core
+    static std::shared_ptr<ThreadPool> shared();
+
+    /// Get the number of worker threads in this pool
+    size_t size() const {
+        return workers_.size();
+    }
+
+    /// Run `function` in one of the worker threads, and get a future for its
+    /// result. Exceptions thrown by `function` are stored in the future.
+    template <typename Function>
+    auto submit(Function function) -> std::future<decltype(function())> {
+        using result_t = decltype(function());
+        auto task = std::make_shared<std::packaged_task<result_t()>>(std::move(function));
+        auto future = task->get_future();
+        this->push([task]() { (*task)(); });
+        return future;
+    }
+
+    /// Run `function(i)` for all `i` in `[0, count)` in the worker threads,
+    /// and wait for all of them to finish. If any call to `function` throws,
+    /// the first exception (in the order of `i`) is re-thrown once all calls
+    /// are done.
+    ///
+    /// When called from one of the worker threads of this pool, the calls to
+    /// `function` run sequentially in the current thread, since waiting for
+    /// other tasks from a worker could deadlock the pool.
+    void run_chunks(size_t count, const std::function<void(size_t)>& function);
+
+private:
+    /// Add a task to the queue, and wake up one worker
+    void push(std::function<void()> task);
+    /// Main loop of the worker threads
+    void run();
+
+    /// Tasks waiting for a worker
+    std::deque<std::function<void()>> tasks_;
+    /// Should the workers stop once all tasks are done?
+    bool stop_ = false;
+    /// Mutex protecting `tasks_` and `stop_`
+    std::mutex mutex_;
+    /// Signaled when a new task is available or the workers should stop
+    std::condition_variable condition_;
+    /// Worker threads
+    std::vector<std::thread> workers_;
+};
+
+} // namespace chemfiles
+
+#endif
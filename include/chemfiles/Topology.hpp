@@ -5,6 +5,10 @@
 #define CHEMFILES_TOPOLOGY_HPP
 
 #include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -16,6 +20,7 @@
 #include "chemfiles/exports.h"
 
 #include "chemfiles/external/optional.hpp"
+#include "chemfiles/external/span.hpp"
 
 namespace chemfiles {
 
@@ -29,6 +34,11 @@ namespace chemfiles {
 /// It is also possible to iterate over a `Topology`, yielding all the atoms in
 /// the system.
 ///
+/// Copies of a topology share the same data until one of them is modified, so
+/// copying a topology (for example with `Frame::set_topology`) is cheap. Once
+/// a non-const reference to an atom has been taken (with `operator[]` or
+/// iterators), the data of this topology is no longer shared with new copies.
+///
 /// @example{topology/iterate.cpp}
 class CHFL_EXPORT Topology final {
 public:
@@ -38,13 +48,13 @@ public:
     /// Construct a new empty topology
     ///
     /// @example{topology/topology.cpp}
-    Topology() = default;
+    Topology();
 
     ~Topology() = default;
-    Topology(const Topology&) = default;
-    Topology& operator=(const Topology&) = default;
-    Topology(Topology&&) = default;
-    Topology& operator=(Topology&&) = default;
+    Topology(const Topology& other);
+    Topology& operator=(const Topology& other);
+    Topology(Topology&& other) noexcept;
+    Topology& operator=(Topology&& other) noexcept;
 
     /// Get a reference to the atom at the position `index`.
     ///
@@ -60,7 +70,9 @@ public:
                 + std::to_string(index)
             );
         }
-        return atoms_[index];
+        auto& data = unshared_data();
+        modified();
+        return data.atoms[index];
     }
 
     /// Get a const reference to the atom at the position `index`.
@@ -77,15 +89,15 @@ public:
                 + std::to_string(index)
             );
         }
-        return atoms_[index];
+        return data_->atoms[index];
     }
 
-    iterator begin() {return atoms_.begin();}
-    const_iterator begin() const {return atoms_.begin();}
-    const_iterator cbegin() const {return atoms_.cbegin();}
-    iterator end() {return atoms_.end();}
-    const_iterator end() const {return atoms_.end();}
-    const_iterator cend() const {return atoms_.cend();}
+    iterator begin() {auto& data = unshared_data(); modified(); return data.atoms.begin();}
+    const_iterator begin() const {return data_->atoms.begin();}
+    const_iterator cbegin() const {return data_->atoms.cbegin();}
+    iterator end() {auto& data = unshared_data(); modified(); return data.atoms.end();}
+    const_iterator end() const {return data_->atoms.end();}
+    const_iterator cend() const {return data_->atoms.cend();}
 
     /// Add an `atom` at the end of this topology.
     ///
@@ -106,6 +118,20 @@ public:
     /// @throws OutOfBounds if `i` is greater than size()
     void remove(size_t i);
 
+    /// Delete all the atoms at the given `indexes` in this topology, as well
+    /// as all the bonds involving these atoms.
+    ///
+    /// The indexes can be given in any order, and duplicated indexes are
+    /// ignored. The remaining atoms keep their relative order, and their
+    /// indexes are updated in a single pass over the topology, which is much
+    /// faster than removing the atoms one by one.
+    ///
+    /// @example{topology/remove_multiple.cpp}
+    ///
+    /// @param indexes the indexes of the atoms to remove
+    /// @throws OutOfBounds if any index is greater than size()
+    void remove(span<const size_t> indexes);
+
     /// Add a bond in the system, between the atoms at index `atom_i` and
     /// `atom_j`.
     ///
@@ -118,6 +144,22 @@ public:
     /// @throws Error if `atom_i == atom_j`, as this is an invalid bond
     void add_bond(size_t atom_i, size_t atom_j, Bond::BondOrder bond_order = Bond::UNKNOWN);
 
+    /// Add multiple bonds in the system at once, with the corresponding
+    /// `bond_orders`. If `bond_orders` is empty, all bonds are added with an
+    /// unknown bond order.
+    ///
+    /// This is faster than calling `add_bond` for each bond when adding a
+    /// lot of bonds.
+    ///
+    /// @example{topology/add_bonds.cpp}
+    ///
+    /// @param bonds the bonds to add
+    /// @param bond_orders the bond orders of the new bonds
+    /// @throws OutOfBounds if any atom in `bonds` is greater than `size()`
+    /// @throws Error if `bond_orders` is not empty and does not have the same
+    ///         size as `bonds`
+    void add_bonds(span<const Bond> bonds, span<const Bond::BondOrder> bond_orders = {});
+
     /// Remove a bond in the system, between the atoms at index `atom_i` and
     /// `atom_j`.
     ///
@@ -146,7 +188,7 @@ public:
     ///
     /// @example{topology/size.cpp}
     size_t size() const {
-        return atoms_.size();
+        return data_->atoms.size();
     }
 
     /// Resize the topology to hold `size` atoms, adding new atoms as needed.
@@ -191,6 +233,27 @@ public:
     /// @example{topology/bond_order.cpp}
     const std::vector<Bond::BondOrder>& bond_orders() const;
 
+    /// Get the adjacency graph of the system, giving for each atom the list of
+    /// atoms bonded to it.
+    ///
+    /// The graph is computed from the bonds when it is first requested, and
+    /// then cached until the bonds change. The returned reference is
+    /// invalidated by any modification of the bonds in this topology.
+    ///
+    /// @example{topology/adjacency.cpp}
+    const AdjacencyGraph& adjacency() const;
+
+    /// Get the molecules in the system, i.e. the groups of atoms connected
+    /// together by bonds.
+    ///
+    /// The molecules are computed from the bonds when they are first
+    /// requested, and then cached until the bonds or the number of atoms
+    /// change. The returned reference is invalidated by any such modification
+    /// of this topology.
+    ///
+    /// @example{topology/molecules.cpp}
+    const Molecules& molecules() const;
+
     /// Get the angles in the system
     ///
     /// The angles are sorted according to `operator<(const Angle&, const
@@ -223,7 +286,8 @@ public:
     ///
     /// @example{topology/clear_bonds.cpp}
     void clear_bonds() {
-        connect_ = Connectivity();
+        modified();
+        mutable_data().connect = Connectivity();
     }
 
     /// Add a `residue` to this topology.
@@ -259,32 +323,91 @@ public:
     ///
     /// @example{topology/residue.cpp}
     const Residue& residue(size_t index) const {
-        if (index >= residues_.size()) {
+        if (index >= data_->residues.size()) {
             throw OutOfBounds(
                 "residue index out of bounds in topology: we have "
-                + std::to_string(residues_.size()) + " residues, "
+                + std::to_string(data_->residues.size()) + " residues, "
                 + "but the index is " + std::to_string(index)
             );
         }
-        return residues_[index];
+        return data_->residues[index];
     }
 
     /// Get all the residues in the topology as a vector
     ///
     /// @example{topology/residues.cpp}
     const std::vector<Residue>& residues() const {
-        return residues_;
+        return data_->residues;
+    }
+
+    /// Get the version of this topology. The version identifies the content
+    /// of the topology: it is kept when copying the topology, and changes
+    /// every time the topology is modified. Two topologies with the same
+    /// version are guaranteed to be identical.
+    ///
+    /// Getting a non-const reference to an atom (with `operator[]` or
+    /// iterators) counts as a modification of the topology. Modifying an atom
+    /// through a reference obtained before the last call to this function
+    /// will not change the version.
+    ///
+    /// @example{topology/version.cpp}
+    uint64_t version() const {
+        return version_;
     }
 
 private:
-    /// Atoms in the system.
-    std::vector<Atom> atoms_;
-    /// Connectivity of the system.
-    Connectivity connect_;
-    /// List of residues in the system.
-    std::vector<Residue> residues_;
-    /// Association between atom indexes and residues indexes.
-    std::unordered_map<size_t, size_t> residue_mapping_;
+    /// Get a new, never used before, topology version
+    static uint64_t next_version();
+
+    /// Mark this topology as modified by updating its version
+    void modified() {
+        version_ = next_version();
+    }
+
+    /// Data of a topology, shared between copies of the topology until one
+    /// of them is modified
+    struct Data {
+        Data() = default;
+        Data(const Data& other);
+        Data& operator=(const Data&) = delete;
+
+        /// Atoms in the system.
+        std::vector<Atom> atoms;
+        /// Connectivity of the system.
+        Connectivity connect;
+        /// List of residues in the system.
+        std::vector<Residue> residues;
+        /// Association between atom indexes and residues indexes.
+        std::unordered_map<size_t, size_t> residue_mapping;
+        /// Can this data be shared with new copies of the topology? This is
+        /// set to false when a non-const reference to an atom is taken, since
+        /// the atom could be modified later through this reference.
+        bool shareable = true;
+        /// Mutex protecting the angles, dihedrals and impropers computed on
+        /// demand in `connect`, which can be used by multiple topologies
+        mutable std::mutex connectivity_mutex;
+    };
+
+    /// Get the data shared by all empty topologies
+    static const std::shared_ptr<Data>& empty_data();
+    /// Get the data of this topology for modification, making a copy of it
+    /// first if it was shared with other topologies
+    Data& mutable_data();
+    /// Get the data to use in a new copy of this topology, marking it as
+    /// shared if possible
+    std::shared_ptr<Data> share_data() const;
+    /// Get the data of this topology for modification, and prevent it from
+    /// being shared with new copies of this topology
+    Data& unshared_data();
+
+    /// Data of this topology, never `nullptr`
+    std::shared_ptr<Data> data_;
+    /// Was `data_` shared with another topology? This is set by copies
+    /// (including copies of a const topology), and cleared when making a
+    /// private copy of the data in `mutable_data`.
+    mutable std::atomic<bool> shared_;
+    /// Version of this topology
+    uint64_t version_ = next_version();
 };
 
 } // namespace chemfiles
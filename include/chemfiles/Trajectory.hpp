@@ -18,6 +18,7 @@ namespace chemfiles {
 class Format;
 class Topology;
 class MemoryBuffer;
+class FramePrefetcher;
 
 /// A `Trajectory` is a chemistry file on the hard drive. It is the entry point
 /// of the chemfiles library.
@@ -31,7 +32,8 @@ public:
     /// empty string. `<compression>` should be `GZ` for gzip files, `BZ2` for
     /// bzip2 files, or `XZ` for lzma/.xz files. If `<compression>` is present,
     /// it will determine which compression method is used to read/write the
-    /// file.
+    /// file. `PGZ` can also be used for gzip files, and will compress the data
+    /// using multiple threads when writing.
     ///
     /// For example, `format = "XYZ"` will force usage of XYZ format regardless
     /// of the file extension; `format = "XYZ / GZ"` will additionally use gzip
@@ -123,6 +125,32 @@ public:
     ///                     the format does not support reading.
     Frame read();
 
+    /// Read the next frame in the trajectory into `frame`, replacing all of
+    /// its content.
+    ///
+    /// This gives the same result as `Trajectory::read`, but reuses the memory
+    /// already allocated in `frame` for the positions. When reading formats
+    /// without topological information (XTC, TRR, DCD, Amber NetCDF) with a
+    /// topology set by `Trajectory::set_topology`, the topology is only copied
+    /// in the frame on the first step, and kept for the next steps.
+    ///
+    /// When reading ahead of time (see `Trajectory::set_read_ahead`), the
+    /// content of `frame` is swapped with a frame read in the background, and
+    /// the memory of `frame` is reused to read one of the next steps.
+    ///
+    /// If an error occurs while reading, the content of `frame` is
+    /// unspecified.
+    ///
+    /// @example{trajectory/read.cpp}
+    ///
+    /// @param frame the frame to read into
+    ///
+    /// @throws FileError for all errors concerning the physical file: can not
+    ///                   open it, can not read/write it, *etc.*
+    /// @throws FormatError if the file is not valid for the used format, or if
+    ///                     the format does not support reading.
+    void read(Frame& frame);
+
     /// Read a single frame at specified `step` from the trajectory.
     ///
     /// The trajectory must have been opened in read mode, and the
@@ -141,6 +169,46 @@ public:
     ///                     the format does not support reading.
     Frame read_step(size_t step);
 
+    /// Read a single frame at specified `step` from the trajectory into
+    /// `frame`, replacing all of its content and reusing its memory as
+    /// described in `Trajectory::read(Frame&)`.
+    ///
+    /// @example{trajectory/read_step.cpp}
+    ///
+    /// @param step step to read from the trajectory
+    /// @param frame the frame to read into
+    ///
+    /// @throws FileError for all errors concerning the physical file: can not
+    ///                   open it, can not read/write it, *etc.*
+    /// @throws FormatError if the file is not valid for the used format, or if
+    ///                     the format does not support reading.
+    void read_step(size_t step, Frame& frame);
+
+    /// Read only the positions of `positions.size()` consecutive steps,
+    /// starting at `start`. The positions of step `start + i` are stored in
+    /// `positions[i]`, which is resized to the number of atoms in this step.
+    ///
+    /// Up to `threads` threads are used to read the steps in parallel if the
+    /// format supports it (currently only XTC). If `threads` is 0, the number
+    /// of threads is determined from the number of available CPU cores. Other
+    /// formats read the steps one by one.
+    ///
+    /// This function does not change the next step read by
+    /// `Trajectory::read`, and ignores the topology and unit cell set with
+    /// `Trajectory::set_topology` and `Trajectory::set_cell`.
+    ///
+    /// @example{trajectory/read_positions.cpp}
+    ///
+    /// @param start first step to read
+    /// @param positions arrays receiving the positions of each step
+    /// @param threads number of threads to use
+    ///
+    /// @throws FileError for all errors concerning the physical file: can not
+    ///                   open it, can not read it, *etc.*
+    /// @throws FormatError if the file is not valid for the used format, or if
+    ///                     the format does not support reading.
+    void read_positions(size_t start, span<std::vector<Vector3D>> positions, size_t threads = 0);
+
     /// Write a single frame to the trajectory.
     ///
     /// The trajectory must have been opened in write or append mode, and the
@@ -209,6 +277,63 @@ public:
     /// @example{trajectory/set_cell.cpp}
     void set_cell(const UnitCell& cell);
 
+    /// Use the given `storage` for the positions and velocities of the frames
+    /// read from this trajectory. By default, frames use the
+    /// `Frame::AOS_DOUBLE` storage.
+    ///
+    /// The XTC, TRR, DCD and Amber NetCDF formats directly fill the
+    /// `Frame::SOA_FLOAT` storage when reading, other formats read the frame
+    /// in double precision and convert it afterward.
+    ///
+    /// @example{trajectory/set_positions_storage.cpp}
+    ///
+    /// @param storage the storage to use for the frames read
+    void set_positions_storage(Frame::Storage storage);
+
+    /// Read up to `frames` frames ahead of time when reading this trajectory
+    /// with `Trajectory::read`, using `threads` background threads to read
+    /// them in parallel. If `threads` is 0, the number of threads is
+    /// determined from the number of available CPU cores. Setting `frames` to
+    /// 0 disables reading ahead of time.
+    ///
+    /// Frames are still returned in order by `Trajectory::read`, and at most
+    /// `frames` frames are kept in memory at any time. Calling
+    /// `Trajectory::read_step` discards all the frames read ahead of time, and
+    /// the next call to `Trajectory::read` will restart reading ahead of time
+    /// from the same step.
+    ///
+    /// This is only supported for formats giving random access to the frames
+    /// (XTC, TRR, DCD and Amber NetCDF) when reading from a file. The file is
+    /// opened once more for each thread.
+    ///
+    /// @example{trajectory/set_read_ahead.cpp}
+    ///
+    /// @param frames maximal number of frames to read ahead of time
+    /// @param threads number of threads to use
+    ///
+    /// @throws FileError if the trajectory was not opened in read mode
+    /// @throws FormatError if the format does not support reading ahead of
+    ///                     time
+    void set_read_ahead(size_t frames, size_t threads = 0);
+
+    /// Use `threads` threads to format and compress the data written to this
+    /// trajectory. If `threads` is 0, the number of threads is determined
+    /// from the number of available CPU cores.
+    ///
+    /// This overrides the number of threads set with
+    /// `chemfiles::set_write_threads` for this trajectory only. The same
+    /// threads are also used to compress data with the parallel gzip
+    /// compression (`"PGZ"`), instead of the threads shared by all
+    /// trajectories.
+    ///
+    /// @example{trajectory/set_write_threads.cpp}
+    ///
+    /// @param threads number of threads to use
+    ///
+    /// @throws FileError if the trajectory was not opened in write or append
+    ///                   mode
+    void set_write_threads(size_t threads);
+
     /// Get the number of steps (the number of frames) in this trajectory.
     ///
     /// @example{trajectory/nsteps.cpp}
@@ -248,6 +373,8 @@ private:
 
     /// Perform a few checks before reading a frame
     void pre_read(size_t step);
+    /// Clear `frame` before reading a new step in it
+    void prepare_frame(Frame& frame);
     /// Set the frame topology and/or cell after reading it
     void post_read(Frame& frame);
     /// Check that the trajectory is still open, and throw a `FileError` is it
@@ -256,6 +383,8 @@ private:
 
     /// Path of the associated file
     std::string path_;
+    /// Format specification used to open the associated file
+    std::string format_name_;
     /// Opening mode of the associated file
     char mode_ = '\0';
     /// Current step
@@ -268,11 +397,22 @@ private:
     /// Topology to use for reading/writing files when no topological data is
     /// present
     optional<Topology> custom_topology_;
+    /// Topology of the last frame read without a custom topology, shared
+    /// with the next frames if they contain the same topology
+    optional<Topology> previous_topology_;
     /// UnitCell to use for reading/writing files when no unit cell information
     /// is present
     optional<UnitCell> custom_cell_;
+    /// Storage used for positions and velocities of the frames read
+    Frame::Storage storage_ = Frame::AOS_DOUBLE;
     /// The internal memory buffer, shared with the MemoryFile implementation
     std::shared_ptr<MemoryBuffer> buffer_;
+    /// Background reader used when reading ahead of time is enabled
+    std::unique_ptr<FramePrefetcher> prefetcher_;
+    /// Does `format_` need to seek to `step_` before the next call to
+    /// `Format::read`? This is the case after reading ahead of time or
+    /// reading positions of multiple steps.
+    bool format_needs_seek_ = false;
 };
 
 } // namespace chemfiles
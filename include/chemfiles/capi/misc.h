@@ -81,6 +81,43 @@ CHFL_EXPORT chfl_status chfl_formats_list(chfl_format_metadata** metadata, uint6
 ///         about the error if the status code is not `CHFL_SUCCESS`.
 CHFL_EXPORT chfl_status chfl_guess_format(const char* path, char* format, uint64_t buffsize);
 
+/// Enable or disable the use of frame index files, storing the position of
+/// all steps of a trajectory in a `<path>.chfl-idx` file next to the
+/// trajectory to open it faster the next time. Frame index files are
+/// disabled by default.
+///
+/// @example{capi/chfl_set_frame_index_files.c}
+/// @return `CHFL_SUCCESS`
+CHFL_EXPORT chfl_status chfl_set_frame_index_files(bool enabled);
+
+/// Enable or disable threaded decompression of compressed text files. When
+/// enabled, a thread is started for each compressed file opened in read mode,
+/// decompressing the next data while the current one is parsed. Threaded
+/// decompression is disabled by default.
+///
+/// @example{capi/chfl_set_threaded_decompression.c}
+/// @return `CHFL_SUCCESS`
+CHFL_EXPORT chfl_status chfl_set_threaded_decompression(bool enabled);
+
+/// Enable or disable memory mapping of plain text files. When enabled,
+/// uncompressed text files opened in read mode are memory mapped on POSIX
+/// systems. Data appended to the files after opening them is then not
+/// visible, and truncating the files can crash the process. Memory mapping is
+/// disabled by default.
+///
+/// @example{capi/chfl_set_memory_mapping.c}
+/// @return `CHFL_SUCCESS`
+CHFL_EXPORT chfl_status chfl_set_memory_mapping(bool enabled);
+
+/// Set the number of threads used to format atoms when writing large frames
+/// with text formats. Chunks of atoms are formatted in parallel and written in
+/// order, producing the same output as with a single thread. Use `0` to use
+/// one thread per CPU core. Only one thread is used by default.
+///
+/// @example{capi/chfl_set_write_threads.c}
+/// @return `CHFL_SUCCESS`
+CHFL_EXPORT chfl_status chfl_set_write_threads(uint64_t threads);
+
 /// Free the memory associated with a chemfiles object.
 ///
 /// This function is NOT equivalent to the standard C function `free`, as memory
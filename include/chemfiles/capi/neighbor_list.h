@@ -0,0 +1,100 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#ifndef CHEMFILES_CHFL_NEIGHBOR_LIST_H
+#define CHEMFILES_CHFL_NEIGHBOR_LIST_H
+
+#include <stdint.h>
+
+#include "chemfiles/capi/types.h"
+#include "chemfiles/exports.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Create a new neighbor list containing all the pairs of atoms in `frame`
+/// closer than `cutoff` (in Angstroms).
+///
+/// The `skin` distance (in Angstroms) is used when updating the list with
+/// `chfl_neighbor_list_update`: the full neighbor search only runs again when
+/// an atom moved by more than half of the skin. Use a skin of 0 to always run
+/// the full neighbor search.
+///
+/// The caller of this function should free the associated memory using
+/// `chfl_free`.
+///
+/// @example{capi/chfl_neighbor_list/chfl_neighbor_list.c}
+/// @return A pointer to the neighbor list, or NULL in case of error.
+///         You can use `chfl_last_error` to learn about the error.
+CHFL_EXPORT CHFL_NEIGHBOR_LIST* chfl_neighbor_list(
+    const CHFL_FRAME* frame, double cutoff, double skin
+);
+
+/// Update the neighbor `list` with the positions and unit cell of the given
+/// `frame`.
+///
+/// @example{capi/chfl_neighbor_list/update.c}
+/// @return The operation status code. You can use `chfl_last_error` to learn
+///         about the error if the status code is not `CHFL_SUCCESS`.
+CHFL_EXPORT chfl_status chfl_neighbor_list_update(
+    CHFL_NEIGHBOR_LIST* list, const CHFL_FRAME* frame
+);
+
+/// Get the number of pairs in the neighbor `list` in `count`.
+///
+/// @example{capi/chfl_neighbor_list/pairs_count.c}
+/// @return The operation status code. You can use `chfl_last_error` to learn
+///         about the error if the status code is not `CHFL_SUCCESS`.
+CHFL_EXPORT chfl_status chfl_neighbor_list_pairs_count(
+    const CHFL_NEIGHBOR_LIST* list, uint64_t* count
+);
+
+/// Get the pairs in the neighbor `list` in the pre-allocated array `pairs` of
+/// size `count`.
+///
+/// `pairs` size must be passed in the `count` parameter, and be equal to the
+/// result of `chfl_neighbor_list_pairs_count`. The pairs are sorted in the
+/// array, and the first atom of each pair is always smaller than the second.
+///
+/// @example{capi/chfl_neighbor_list/pairs.c}
+/// @return The operation status code. You can use `chfl_last_error` to learn
+///         about the error if the status code is not `CHFL_SUCCESS`.
+CHFL_EXPORT chfl_status chfl_neighbor_list_pairs(
+    const CHFL_NEIGHBOR_LIST* list, uint64_t (*pairs)[2], uint64_t count
+);
+
+/// Get the distances (in Angstroms) between the atoms in each pair of the
+/// neighbor `list` in the pre-allocated array `distances` of size `count`.
+///
+/// `distances` size must be passed in the `count` parameter, and be equal to
+/// the result of `chfl_neighbor_list_pairs_count`. The distances are in the
+/// same order as the pairs returned by `chfl_neighbor_list_pairs`.
+///
+/// @example{capi/chfl_neighbor_list/distances.c}
+/// @return The operation status code. You can use `chfl_last_error` to learn
+///         about the error if the status code is not `CHFL_SUCCESS`.
+CHFL_EXPORT chfl_status chfl_neighbor_list_distances(
+    const CHFL_NEIGHBOR_LIST* list, double distances[], uint64_t count
+);
+
+/// Get the minimum image vectors going from the first to the second atom of
+/// each pair of the neighbor `list` in the pre-allocated array `vectors` of
+/// size `count`.
+///
+/// `vectors` size must be passed in the `count` parameter, and be equal to the
+/// result of `chfl_neighbor_list_pairs_count`. The vectors are in the same
+/// order as the pairs returned by `chfl_neighbor_list_pairs`.
+///
+/// @example{capi/chfl_neighbor_list/vectors.c}
+/// @return The operation status code. You can use `chfl_last_error` to learn
+///         about the error if the status code is not `CHFL_SUCCESS`.
+CHFL_EXPORT chfl_status chfl_neighbor_list_vectors(
+    const CHFL_NEIGHBOR_LIST* list, chfl_vector3d vectors[], uint64_t count
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
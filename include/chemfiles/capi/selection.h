@@ -88,6 +88,38 @@ CHFL_EXPORT chfl_status chfl_selection_matches(
     const CHFL_SELECTION* selection, chfl_match matches[], uint64_t n_matches
 );
 
+/// Get statistics about the process-wide cache of compiled selections.
+///
+/// Selections created with `chfl_selection` are compiled once and stored in a
+/// cache keyed by the selection string. `hits` will contain the number of
+/// selections created from the cache, `misses` the number of selections which
+/// had to be compiled, `size` the number of compiled selections currently in
+/// the cache and `capacity` the maximal number of selections in the cache.
+///
+/// @example{capi/chfl_selection/cache_stats.c}
+/// @return The operation status code. You can use `chfl_last_error` to learn
+///         about the error if the status code is not `CHFL_SUCCESS`.
+CHFL_EXPORT chfl_status chfl_selection_cache_stats(
+    uint64_t* hits, uint64_t* misses, uint64_t* size, uint64_t* capacity
+);
+
+/// Set the maximal number of compiled selections to keep in the process-wide
+/// cache to `capacity`, removing the least recently used selections if needed.
+/// A `capacity` of 0 disables the cache.
+///
+/// @example{capi/chfl_selection/cache_resize.c}
+/// @return The operation status code. You can use `chfl_last_error` to learn
+///         about the error if the status code is not `CHFL_SUCCESS`.
+CHFL_EXPORT chfl_status chfl_selection_cache_resize(uint64_t capacity);
+
+/// Remove all compiled selections from the process-wide cache, and reset the
+/// cache statistics.
+///
+/// @example{capi/chfl_selection/cache_clear.c}
+/// @return The operation status code. You can use `chfl_last_error` to learn
+///         about the error if the status code is not `CHFL_SUCCESS`.
+CHFL_EXPORT chfl_status chfl_selection_cache_clear(void);
+
 #ifdef __cplusplus
 }
 #endif
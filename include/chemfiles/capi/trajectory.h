@@ -90,7 +90,9 @@ CHFL_EXPORT chfl_status chfl_trajectory_path(
 /// Read the next step of the `trajectory` into a `frame`.
 ///
 /// If the number of atoms in frame does not correspond to the number of atom
-/// in the next step, the frame is resized.
+/// in the next step, the frame is resized. The memory already allocated in the
+/// `frame` is reused, making it faster to read all the steps of a trajectory
+/// in the same `frame`.
 ///
 /// @example{capi/chfl_trajectory/read.c}
 /// @return The operation status code. You can use `chfl_last_error` to learn
@@ -102,7 +104,8 @@ CHFL_EXPORT chfl_status chfl_trajectory_read(
 /// Read a specific `step` of the `trajectory` into a `frame`.
 ///
 /// If the number of atoms in frame does not correspond to the number of atom
-/// in the step, the frame is resized.
+/// in the step, the frame is resized. The memory already allocated in the
+/// `frame` is reused.
 ///
 /// @example{capi/chfl_trajectory/read_step.c}
 /// @return The operation status code. You can use `chfl_last_error` to learn
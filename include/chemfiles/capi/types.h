@@ -18,6 +18,7 @@ namespace chemfiles {
     class Topology;
     class Residue;
     class Property;
+    class NeighborList;
 }
 struct CAPISelection;
 typedef chemfiles::Trajectory CHFL_TRAJECTORY;
@@ -28,6 +29,7 @@ typedef chemfiles::Topology CHFL_TOPOLOGY;
 typedef chemfiles::Residue CHFL_RESIDUE;
 typedef chemfiles::Property CHFL_PROPERTY;
 typedef CAPISelection CHFL_SELECTION;
+typedef chemfiles::NeighborList CHFL_NEIGHBOR_LIST;
 
 #else
 
@@ -107,6 +109,12 @@ typedef struct CHFL_SELECTION CHFL_SELECTION;
 /// `CHFL_ATOM`. A property can have various types: bool, double, string or
 /// `chfl_vector3d`.
 typedef struct CHFL_PROPERTY CHFL_PROPERTY;
+
+/// An opaque type handling a neighbor list.
+///
+/// A `CHFL_NEIGHBOR_LIST` contains all the pairs of atoms in a `CHFL_FRAME`
+/// closer than a given cutoff, accounting for periodic boundary conditions.
+typedef struct CHFL_NEIGHBOR_LIST CHFL_NEIGHBOR_LIST;
 #endif
 
 #ifdef __cplusplus
@@ -6,18 +6,33 @@
 
 #include <cstdio>
 #include <cstdint>
+#include <deque>
+#include <memory>
 #include <string>
 #include <vector>
-#include <functional>
+#include <future>
+#include <fstream>
 
 #include "chemfiles/File.hpp"
 #include "chemfiles/files/MemoryBuffer.hpp"
+#include "chemfiles/external/optional.hpp"
 
 #include <bzlib.h>
 
 namespace chemfiles {
 
 /// An implementation of TextFile for bzip2 files
+///
+/// When reading, the compressed file is scanned for the bit patterns marking
+/// the start of bzip2 blocks. Each block is then decompressed independently,
+/// allowing seeks to restart decompression from the closest block, and
+/// decompressing the next blocks in a thread pool while reading.
+///
+/// The same bit patterns can also appear by chance inside the compressed
+/// data. Each block is checked against its stored CRC when decompressing it,
+/// and the blocks of each stream against the combined CRC of the stream. If
+/// any of these checks fail, the whole file is decompressed sequentially
+/// instead.
 class Bz2File final: public TextFileImpl {
 public:
     /// Open a text file with name `filename` and mode `mode`.
@@ -33,15 +48,106 @@ public:
 private:
     void compress_and_write(int action);
 
+    /// A single block in the compressed file
+    struct Block {
+        /// Position of the first bit of the block in the compressed file
+        uint64_t start;
+        /// Position of the first bit after the end of the block
+        uint64_t end;
+    };
+
+    /// A block or end of stream marker in the compressed file
+    struct Marker {
+        /// Position of the first bit of the marker
+        uint64_t position;
+        /// Is this the end of stream marker?
+        bool stream_end;
+    };
+
+    /// Make sure `scan_buffer_` contains the `count` bytes of the compressed
+    /// file starting at byte `first`, if possible. Returns the number of
+    /// bytes available in the buffer.
+    size_t fill_scan_buffer(uint64_t first, size_t count);
+    /// Read the 32 bits starting at bit `position` in the compressed file
+    uint32_t read_scan_bits32(uint64_t position);
+    /// Find the next block or end of stream marker at or after
+    /// `scan_position_`, returning `nullopt` if there are none
+    optional<Marker> find_marker();
+    /// Scan the compressed file to find the next block, returning `false` if
+    /// there are no more blocks in the file
+    bool find_next_block();
+    /// Make sure the block at `index` has been found, returning `false` if
+    /// the file contains less blocks
+    bool find_block(size_t index);
+    /// Start decompressing the block at `index` in the thread pool
+    std::future<std::vector<char>> decompress_async(size_t index);
+    /// Make the block at `index` the current block, using data from the
+    /// background threads if possible. Returns `false` if the file contains
+    /// less blocks
+    bool load_block(size_t index);
+
+    /// Stop decompressing single blocks, and decompress the file sequentially
+    /// from the start instead, up to `position` in the uncompressed data
+    void start_sequential(uint64_t position);
+    /// Restart sequential decompression from the start of the file
+    void restart_sequential();
+    /// Read up to `count` bytes of data with sequential decompression
+    size_t read_sequential(char* data, size_t count);
+    /// Seek to `position` with sequential decompression
+    void seek_sequential(uint64_t position);
+
     FILE* file_ = nullptr;
     /// Store the mode used to open this file
     File::Mode mode_;
-    /// Store the right function to close the stream
-    std::function<int(bz_stream*)> stream_end_;
-    /// bzip2 stream used both for reading and writing.
+
+    /// Compressed file used for reading
+    std::ifstream input_;
+    /// Size of the compressed file used for reading
+    uint64_t input_size_ = 0;
+    /// All the blocks found so far in the compressed file
+    std::vector<Block> blocks_;
+    /// Offset in the uncompressed data of the start of the blocks. This
+    /// contains one more entry than the number of blocks decompressed so far.
+    std::vector<uint64_t> offsets_ = {0};
+    /// Position of the next bit to scan in the compressed file
+    uint64_t scan_position_ = 0;
+    /// Start of the block currently being scanned, if any
+    optional<uint64_t> scan_block_start_;
+    /// Combined CRC of the blocks found so far in the current stream
+    uint32_t scan_stream_crc_ = 0;
+    /// Buffer used when scanning the compressed file
+    std::vector<uint8_t> scan_buffer_;
+    /// Offset of the data in `scan_buffer_` in the compressed file
+    uint64_t scan_buffer_offset_ = 0;
+
+    /// Index of the block in `current_`, or `size_t(-1)` if no block has been
+    /// loaded yet
+    size_t block_ = static_cast<size_t>(-1);
+    /// Uncompressed data for the current block
+    std::vector<char> current_;
+    /// Position of the next character to read in `current_`
+    size_t current_offset_ = 0;
+    /// Blocks being decompressed in the background, starting with the block
+    /// at index `prefetch_start_`
+    std::deque<std::future<std::vector<char>>> prefetch_;
+    size_t prefetch_start_ = 0;
+    /// Pool of threads used to decompress blocks in the background. The
+    /// number of threads in the pool is also the maximal number of blocks
+    /// decompressed at the same time.
+    std::shared_ptr<ThreadPool> pool_;
+
+    /// Are we decompressing the file sequentially, after some blocks could
+    /// not be decompressed independently?
+    bool sequential_ = false;
+    /// Did sequential decompression reach the end of the file?
+    bool sequential_eof_ = false;
+    /// Position in the uncompressed data for sequential decompression
+    uint64_t position_ = 0;
+
+    /// bzip2 stream used for writing, or for sequential decompression.
     bz_stream stream_;
-    /// compressed data buffer, straight out from the file when reading, to be
-    /// written to the file when writing.
+    /// compressed data buffer, to be written to the file, or read from the
+    /// file for sequential decompression.
     std::vector<char> buffer_;
 };
 
@@ -6,20 +6,37 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <future>
+#include <memory>
 #include <string>
+#include <vector>
+#include <fstream>
 
 #include "chemfiles/File.hpp"
 #include "chemfiles/files/MemoryBuffer.hpp"
 
 typedef struct gzFile_s *gzFile;
+struct z_stream_s;
 
 namespace chemfiles {
 
 /// An implementation of TextFile for gzip files
+///
+/// Writing uses zlib's `gzFile`, or in parallel mode compresses independent
+/// chunks of data in a thread pool and concatenates them in a single gzip
+/// member, following the `pigz` implementation. Reading inflates the
+/// file directly, and records access points (a copy of the inflate state)
+/// regularly while decompressing, following the `zran.c` example from zlib.
+/// Seeking backward or far ahead in the file restarts decompression from the
+/// closest access point instead of the beginning of the file. Like `gzread`,
+/// files without a gzip header are read as uncompressed data.
 class GzFile final: public TextFileImpl {
 public:
-    /// Open a text file with name `filename` and mode `mode`.
-    GzFile(const std::string& path, File::Mode mode);
+    /// Open a text file with name `filename` and mode `mode`. If `parallel`
+    /// is true, data is compressed in background threads when writing.
+    GzFile(const std::string& path, File::Mode mode, bool parallel = false);
     ~GzFile() override;
 
     size_t read(char* data, size_t count) override;
@@ -27,13 +44,105 @@ public:
 
     void clear() noexcept override;
     void seek(uint64_t position) override;
+    void set_thread_pool(std::shared_ptr<ThreadPool> pool) override;
 
 private:
     /// Check if any error happened while reading/writing the file. Returns the
     /// corresponding error message or `nullptr` if no error occurred.
     const char* check_error() const;
 
+    /// Point in the compressed file where decompression can be restarted
+    struct AccessPoint {
+        /// Offset in the uncompressed data
+        uint64_t uncompressed;
+        /// Offset in the compressed file of the first full byte after this
+        /// point
+        uint64_t compressed;
+        /// Number of bits from the byte before `compressed` that are part of
+        /// the data after this point
+        int bits;
+        /// Last 32 KiB of uncompressed data before this point
+        std::vector<unsigned char> window;
+    };
+
+    /// A chunk of data compressed in parallel mode
+    struct CompressedChunk {
+        /// Raw deflate data, ending on a byte boundary
+        std::vector<unsigned char> data;
+        /// CRC32 of the uncompressed data
+        unsigned long crc;
+        /// Size of the uncompressed data
+        size_t size;
+    };
+
+    /// Compress `input` as raw deflate data, using `dictionary` (the end of
+    /// the previous chunk) to find back-references
+    static CompressedChunk compress_chunk(const std::vector<unsigned char>& input, const std::vector<unsigned char>& dictionary);
+    /// Start compressing the data in `pending_` in the thread pool
+    void compress_pending();
+    /// Write the oldest compressed chunk to the file
+    void write_chunk();
+    /// Write all remaining chunks and the gzip trailer
+    void finish();
+
+    /// Make sure at least `count` bytes of compressed data are available in
+    /// the input buffer, if possible. Returns the number of available bytes.
+    size_t ensure_input(size_t count);
+    /// Inflate up to `count` bytes of data to `data`, without crossing
+    /// deflate blocks boundaries. Returns the number of bytes produced.
+    size_t inflate_block(char* data, size_t count);
+    /// Handle the end of a gzip member, looking for the next one
+    void end_member();
+    /// Record an access point at the current position if needed
+    void add_access_point();
+    /// Restart decompression from the beginning of the file
+    void restart();
+    /// Restart decompression from the given access point
+    void restart(const AccessPoint& point);
+    /// Decompress and discard `count` bytes of data
+    void skip(uint64_t count);
+
+    /// zlib file used for writing
     gzFile file_ = nullptr;
+
+    /// File used for writing in parallel mode
+    FILE* output_ = nullptr;
+    /// Pool of threads used to compress chunks in parallel mode
+    std::shared_ptr<ThreadPool> pool_;
+    /// Data waiting to be compressed
+    std::vector<unsigned char> pending_;
+    /// Last 32 KiB of data sent to compression, used as dictionary for the
+    /// next chunk
+    std::vector<unsigned char> dictionary_;
+    /// Chunks being compressed in the thread pool
+    std::deque<std::future<CompressedChunk>> compressing_;
+    /// CRC32 of all the data written so far
+    unsigned long crc_ = 0;
+    /// Size of all the data written so far
+    uint64_t written_ = 0;
+
+    /// Compressed file used for reading
+    std::ifstream input_;
+    /// Buffer for compressed data read from `input_`
+    std::vector<unsigned char> input_buffer_;
+    /// Offset in the compressed file of the end of the data in `input_buffer_`
+    uint64_t input_end_ = 0;
+    /// Is the file read as uncompressed data, because it does not start
+    /// with a gzip header?
+    bool transparent_ = false;
+    /// Inflate stream used for reading
+    std::unique_ptr<z_stream_s> stream_;
+    /// Is the stream currently reading raw deflate data (after restarting
+    /// from an access point) instead of a full gzip member?
+    bool raw_ = false;
+    /// Did we just start a new gzip member?
+    bool member_start_ = true;
+    /// Did we reach the end of the compressed data?
+    bool eof_ = false;
+    /// Current offset in the uncompressed data
+    uint64_t position_ = 0;
+    /// Access points, sorted by uncompressed offset
+    std::vector<AccessPoint> access_points_;
 };
 
 /// Inflates GZipped data from the `src` buffer
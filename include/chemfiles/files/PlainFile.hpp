@@ -7,12 +7,21 @@
 #include <cstdint>
 #include <cstdio>
 #include <string>
+#include <string_view>
 
 #include "chemfiles/File.hpp"
 
 namespace chemfiles {
 
+/// Is memory mapping of plain text files enabled?
+bool memory_mapping_enabled();
+
 /// Simple TextFileImpl reading plain, uncompressed files using `FILE*`.
+///
+/// On POSIX systems and if `memory_mapping_enabled()`, files opened in read
+/// mode are also memory mapped, allowing `TextFile` to read lines directly
+/// from the mapping without copying them. The mapping covers the file as it
+/// was when opening it, so data appended later is not visible.
 class PlainFile final: public TextFileImpl {
 public:
     /// Open a text file with name `filename` and mode `mode`.
@@ -25,8 +34,21 @@ public:
     void clear() noexcept override;
     void seek(uint64_t position) override;
 
+    std::string_view mapped() const override;
+
 private:
+    /// Try to memory map the file, leaving `mmap_data_` as `nullptr` if this
+    /// is not possible
+    void map_file();
+
     std::FILE* file_;
+    /// Start of the memory mapped file content, or `nullptr` if the file is
+    /// not memory mapped
+    const char* mmap_data_ = nullptr;
+    /// Size of the memory mapped file content
+    size_t mmap_size_ = 0;
+    /// Current position when reading a memory mapped file
+    uint64_t mmap_position_ = 0;
 };
 
 } // namespace chemfiles
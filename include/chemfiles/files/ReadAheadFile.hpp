@@ -0,0 +1,82 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#ifndef CHEMFILES_READ_AHEAD_FILE_HPP
+#define CHEMFILES_READ_AHEAD_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <condition_variable>
+
+#include "chemfiles/File.hpp"
+
+namespace chemfiles {
+
+/// Is threaded decompression of compressed text files enabled?
+bool threaded_decompression_enabled();
+
+/// An implementation of TextFile wrapping another `TextFileImpl` opened for
+/// reading, and reading large chunks of data from it in a background thread.
+///
+/// This is used for compressed files, where the background thread decompresses
+/// the next chunks of the file while the current one is being parsed. The
+/// wrapped file is only accessed from the background thread, which is stopped
+/// before seeking.
+class ReadAheadFile final: public TextFileImpl {
+public:
+    /// Start reading `file` in a background thread
+    ReadAheadFile(const std::string& path, std::unique_ptr<TextFileImpl> file);
+    ~ReadAheadFile() override;
+
+    size_t read(char* data, size_t count) override;
+    void write(const char* data, size_t count) override;
+
+    void clear() noexcept override;
+    void seek(uint64_t position) override;
+
+private:
+    /// Start the background thread
+    void start();
+    /// Stop the background thread and discard all chunks read by it
+    void stop();
+    /// Main loop of the background thread
+    void run();
+
+    /// The wrapped file
+    std::unique_ptr<TextFileImpl> file_;
+    /// Background thread reading from `file_`
+    std::thread thread_;
+
+    /// Mutex protecting all the members below, up to `current_`
+    std::mutex mutex_;
+    /// Condition variable used to wake up the reader or the background thread
+    std::condition_variable condition_;
+    /// Chunks read by the background thread, waiting to be used by `read`
+    std::deque<std::vector<char>> ready_;
+    /// Chunks already used by `read`, that can be re-filled by the background
+    /// thread
+    std::vector<std::vector<char>> free_;
+    /// Did the background thread reach the end of `file_`?
+    bool done_ = false;
+    /// Should the background thread stop?
+    bool stopping_ = false;
+    /// Error raised in the background thread, to be re-thrown by `read`
+    std::exception_ptr error_;
+
+    /// Chunk currently used by `read`
+    std::vector<char> current_;
+    /// Position of the next character to read in `current_`
+    size_t current_offset_ = 0;
+    /// Position of `current_` in the file
+    uint64_t current_start_ = 0;
+};
+
+} // namespace chemfiles
+
+#endif
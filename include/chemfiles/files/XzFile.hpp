@@ -6,8 +6,12 @@
 
 #include <cstdint>
 #include <cstdio>
+#include <deque>
+#include <memory>
 #include <string>
 #include <vector>
+#include <future>
+#include <fstream>
 
 #include <lzma.h>
 
@@ -17,6 +21,13 @@
 namespace chemfiles {
 
 /// An implementation of TextFile for lzma/xz files
+///
+/// Files are written as multiple independent xz blocks, compressed in
+/// parallel in a thread pool. When reading, the xz index at the end of the
+/// file is used to find the blocks: seeking starts decompression at the block
+/// containing the new position, and the next blocks are decompressed in the
+/// thread pool during sequential reads. Files without an index, or
+/// containing very large blocks are decompressed as a single stream.
 class XzFile final: public TextFileImpl {
 public:
     /// Open a text file with name `filename` and mode `mode`.
@@ -28,22 +39,92 @@ public:
 
     void clear() noexcept override;
     void seek(uint64_t position) override;
+    void set_thread_pool(std::shared_ptr<ThreadPool> pool) override;
 
 private:
-    /// Compress data from stream_.next_in, and write the data to the file.
-    /// If action==LZMA_FINISH, continue writing until everything has been
-    /// processed.
-    void compress_and_write(lzma_action action);
+    /// A single block in an xz file
+    struct Block {
+        /// Offset of the block header in the compressed file
+        uint64_t compressed_offset;
+        /// Total size of the block in the compressed file
+        uint64_t compressed_size;
+        /// Offset of the block data in the uncompressed data
+        uint64_t uncompressed_offset;
+        /// Size of the uncompressed block data
+        uint64_t uncompressed_size;
+        /// Integrity check used by the block
+        lzma_check check;
+    };
+
+    /// A block compressed while writing
+    struct CompressedBlock {
+        /// Compressed data, including the block header
+        std::vector<uint8_t> data;
+        /// Unpadded size of the block, as stored in the xz index
+        lzma_vli unpadded_size;
+        /// Size of the uncompressed data
+        lzma_vli uncompressed_size;
+    };
+
+    /// Read the xz index at the end of the file, filling `blocks_`. Returns
+    /// `false` if the blocks can not be used for random access.
+    bool read_index();
+    /// Start decompressing the block at `index` in the thread pool
+    std::future<std::vector<char>> decompress_async(size_t index);
+    /// Make the block at `index` the current block
+    void load_block(size_t index);
+    /// Read data by decompressing the whole file as a single stream
+    size_t read_stream(char* data, size_t count);
+    /// Seek by decompressing the whole file as a single stream from the start
+    void seek_stream(uint64_t position);
+
+    /// Compress `input` as a single xz block
+    static CompressedBlock compress_block(const std::vector<uint8_t>& input);
+    /// Start compressing the data in `pending_` in the thread pool
+    void compress_pending();
+    /// Write the oldest compressed block to the file
+    void write_block();
+    /// Write all remaining blocks, the index and the stream footer
+    void finish();
 
     FILE* file_ = nullptr;
     /// Store opening file mode
     File::Mode mode_;
-    /// lzma stream used both for reading and writing. Reading is done using
-    /// lzma_stream_decoder, and writing using lzma_easy_encoder.
+    /// Pool of threads used to compress or decompress blocks in the
+    /// background. The number of threads in the pool is also the maximal
+    /// number of blocks compressed or decompressed at the same time.
+    std::shared_ptr<ThreadPool> pool_;
+
+    /// Are we reading the file using the blocks from the xz index?
+    bool indexed_ = false;
+    /// Compressed file used when reading with the xz index
+    std::ifstream input_;
+    /// All the blocks in the file
+    std::vector<Block> blocks_;
+    /// Index of the block in `current_`, or `size_t(-1)` if no block has been
+    /// loaded yet
+    size_t block_ = static_cast<size_t>(-1);
+    /// Uncompressed data for the current block
+    std::vector<char> current_;
+    /// Position of the next character to read in `current_`
+    size_t current_offset_ = 0;
+    /// Blocks being decompressed in the background, starting with the block
+    /// at index `prefetch_start_`
+    std::deque<std::future<std::vector<char>>> prefetch_;
+    size_t prefetch_start_ = 0;
+
+    /// lzma stream used when reading the file as a single stream
     lzma_stream stream_ = LZMA_STREAM_INIT;
-    /// compressed data buffer, straight out from the file when reading, to be
-    /// written to the file when writing.
+    /// compressed data buffer, straight out from the file when reading as a
+    /// single stream
     std::vector<uint8_t> buffer_;
+
+    /// Data waiting to be compressed when writing
+    std::vector<uint8_t> pending_;
+    /// Blocks being compressed in the thread pool
+    std::deque<std::future<CompressedBlock>> compressing_;
+    /// Index of the blocks already written to the file
+    lzma_index* index_ = nullptr;
 };
 
 /// Inflates LZMA/XZ data from the `src` buffer
@@ -0,0 +1,148 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#ifndef CHEMFILES_FLOAT_FORMATTING_HPP
+#define CHEMFILES_FLOAT_FORMATTING_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+#include <fmt/format.h>
+
+namespace chemfiles {
+namespace detail {
+    /// Largest precision supported by `format_fixed`
+    constexpr unsigned MAX_FIXED_PRECISION = 9;
+
+    /// Format `value` in `output` with `precision` digits after the decimal
+    /// point, producing the same output as `fmt::format("{:.{}f}", value,
+    /// precision)`. `output` must be able to hold at least 32 characters.
+    ///
+    /// This returns the number of characters written, or 0 if the value can
+    /// not be formatted quickly (too large, not finite, or too close to the
+    /// middle between two representable decimal values), in which case the
+    /// caller should use `fmt` instead.
+    size_t format_fixed(double value, unsigned precision, char* output);
+
+    /// Format `value` in `output`, producing the same output as
+    /// `fmt::format("{:g}", value)`. `output` must be able to hold at least 32
+    /// characters.
+    ///
+    /// This returns the number of characters written, or 0 if the value can
+    /// not be formatted quickly (the output would use the exponent notation, or
+    /// the value is too close to the middle between two representable decimal
+    /// values), in which case the caller should use `fmt` instead.
+    size_t format_general(double value, char* output);
+
+    /// Wrapper around a double, used to select the fast formatting functions
+    /// above when formatting with a compiled format string.
+    struct fast_double {
+        double value;
+    };
+
+    template <typename T>
+    inline const T& fast_format_arg(const T& value) {
+        return value;
+    }
+
+    inline fast_double fast_format_arg(double value) {
+        return {value};
+    }
+
+    /// Check if `Str` is a format string created with `FMT_COMPILE`. Runtime
+    /// format strings are implicitly convertible to `fmt::string_view`, while
+    /// compiled format strings only provide an explicit conversion.
+    template <typename Str>
+    struct is_compiled_format: std::integral_constant<bool,
+        !std::is_convertible<const Str&, fmt::string_view>::value
+    > {};
+}
+}
+
+/// Formatter for `fast_double`, using `format_fixed` and `format_general` for
+/// the `{:<width>.<precision>f}` and `{:<width>g}` format specifications, and
+/// the default `fmt` implementation for everything else.
+template <>
+struct fmt::formatter<chemfiles::detail::fast_double> {
+public:
+    FMT_CONSTEXPR auto parse(format_parse_context& ctx) -> decltype(ctx.begin()) {
+        const auto* it = ctx.begin();
+        const auto* end = ctx.end();
+
+        // a width starting with 0 requests zero-padding, which is not
+        // supported by the fast path
+        if (it != end && *it != '0') {
+            while (it != end && '0' <= *it && *it <= '9') {
+                width_ = width_ * 10 + static_cast<unsigned>(*it - '0');
+                it++;
+            }
+        }
+
+        bool has_precision = false;
+        if (it != end && *it == '.') {
+            it++;
+            has_precision = true;
+            precision_ = 0;
+            while (it != end && '0' <= *it && *it <= '9') {
+                precision_ = precision_ * 10 + static_cast<unsigned>(*it - '0');
+                it++;
+            }
+        }
+
+        if (it != end && *it == 'f' && has_precision && precision_ <= chemfiles::detail::MAX_FIXED_PRECISION) {
+            kind_ = FIXED;
+            it++;
+        } else if (it != end && *it == 'g' && !has_precision) {
+            kind_ = GENERAL;
+            it++;
+        }
+
+        if (it != end && *it != '}') {
+            kind_ = DEFAULT;
+        }
+
+        return default_.parse(ctx);
+    }
+
+    template <typename FormatContext>
+    auto format(chemfiles::detail::fast_double value, FormatContext& ctx) const -> decltype(ctx.out()) {
+        if (kind_ != DEFAULT) {
+            char buffer[32];
+            size_t size = 0;
+            if (kind_ == FIXED) {
+                size = chemfiles::detail::format_fixed(value.value, precision_, buffer);
+            } else {
+                size = chemfiles::detail::format_general(value.value, buffer);
+            }
+
+            if (size != 0) {
+                auto out = ctx.out();
+                for (size_t i = size; i < width_; i++) {
+                    *out++ = ' ';
+                }
+                return std::copy(buffer, buffer + size, out);
+            }
+        }
+
+        return default_.format(value.value, ctx);
+    }
+
+private:
+    enum {
+        /// Use the default formatter for doubles
+        DEFAULT,
+        /// Use `format_fixed`
+        FIXED,
+        /// Use `format_general`
+        GENERAL,
+    } kind_ = DEFAULT;
+    /// Minimal width of the output
+    unsigned width_ = 0;
+    /// Precision for fixed formatting
+    unsigned precision_ = 0;
+    /// Default formatter, used when the fast path is not available
+    fmt::formatter<double> default_;
+};
+
+#endif
@@ -20,6 +20,7 @@ class Frame;
 class UnitCell;
 class Vector3D;
 class FormatMetadata;
+struct Vector3DSoA;
 
 template <class T> class span;
 
@@ -31,6 +32,9 @@ public:
     void read(Frame& frame) final;
     void read_step(size_t step, Frame& frame) final;
     void write(const Frame& frame) override;
+    bool keeps_topology() const final {
+        return true;
+    }
 
 protected:
     struct variable_scale_t {
@@ -42,6 +46,9 @@ protected:
     UnitCell read_cell();
     /// read the values from the variable at the current internal step to the array
     void read_array(variable_scale_t& variable, span<Vector3D> array);
+    /// read the values from the variable at the current internal step to the
+    /// single precision array
+    void read_array(variable_scale_t& variable, Vector3DSoA& array);
 
     /// write the unit cell at the current step
     void write_cell(const UnitCell& cell);
@@ -84,6 +91,9 @@ public:
     AmberTrajectory(std::string path, File::Mode mode, File::Compression compression);
 
     size_t nsteps() override;
+    bool random_access() const override {
+        return true;
+    }
     void initialize(const Frame& frame) override;
 
 private:
@@ -39,6 +39,9 @@ public:
     void read(Frame& frame) override;
     void write(const Frame& frame) override;
     size_t nsteps() override;
+    void set_write_threads(size_t threads) override {
+        file_.set_write_threads(threads);
+    }
 private:
     /// Initialize the document and root objects
     void init_();
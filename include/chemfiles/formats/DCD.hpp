@@ -59,6 +59,12 @@ public:
     DCDFormat(std::string path, File::Mode mode, File::Compression compression);
 
     size_t nsteps() override;
+    bool random_access() const override {
+        return true;
+    }
+    bool keeps_topology() const override {
+        return true;
+    }
     void read(Frame& frame) override;
     void read_step(size_t step, Frame& frame) override;
     void write(const Frame& frame) override;
@@ -17,6 +17,7 @@
 #include "chemfiles/Format.hpp"
 
 #include "chemfiles/UnitCell.hpp"
+#include "chemfiles/Connectivity.hpp"
 #include "chemfiles/external/span.hpp"
 
 namespace chemfiles {
@@ -56,11 +57,12 @@ private:
     /// Called by read_model to create new residues. Uses/updates groupIndex_
     Residue create_residue(const std::string& current_assembly, size_t group_type);
 
-    /// Read a group from the MMTF structure, adding atoms and a residue to frame
+    /// Read a group from the MMTF structure, adding atoms and a residue to
+    /// frame, and the bonds inside the group to `bonds_`
     void read_group(Frame& frame, size_t group_type, Residue& residue, span<Vector3D> positions);
 
-    /// Add inter residue bonds to the structure.
-    void add_inter_residue_bonds(Frame& frame);
+    /// Add inter residue bonds to `bonds_`.
+    void add_inter_residue_bonds();
 
     /// Apply symmetry operations to the frame
     void apply_symmetry(Frame& frame);
@@ -98,6 +100,12 @@ private:
     /// Number of atoms before the current model.
     size_t atomSkip_ = 0;
 
+    /// Bonds in the model being read, added to the frame all at once at the
+    /// end of `read_model`
+    std::vector<Bond> bonds_;
+    /// Bond orders corresponding to `bonds_`
+    std::vector<Bond::BondOrder> bond_orders_;
+
     // Since MMTF uses model->chain->residue->atom as storage model, and
     // chemfiles do not enforce that residues contains contiguous atoms, the
     // atoms can be re-ordered when adding them to a MMTF structure. This vector
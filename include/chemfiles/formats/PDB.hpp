@@ -18,6 +18,7 @@
 #include "chemfiles/Format.hpp"
 
 #include "chemfiles/Residue.hpp"
+#include "chemfiles/Connectivity.hpp"
 #include "chemfiles/external/optional.hpp"
 
 namespace chemfiles {
@@ -87,6 +88,9 @@ private:
     /// List of all atom offsets. This maybe pushed in read_ATOM or if a TER
     /// record is found. It is reset every time a frame is read.
     std::vector<size_t> atom_offsets_;
+    /// Bonds from the CONECT records in the current step, added to the frame
+    /// all at once after reading the step.
+    std::vector<Bond> conect_bonds_;
     /// Did we wrote a frame to the file? This is used to check whether we need
     /// to write a final `END` record in the destructor
     bool written_ = false;
@@ -52,7 +52,7 @@ private:
     void process_property_list(Topology& topology, std::string_view smiles);
 
     /// [for reading] Opens and closes a ring with id `ring_id`
-    void check_ring_(Topology& topology, size_t ring_id);
+    void check_ring_(size_t ring_id);
 
     /// [for reading] Stores location of a branching path
     std::stack<size_t, std::vector<size_t>> branch_point_;
@@ -73,6 +73,13 @@ private:
     /// [for reading] List of groups
     std::vector<Residue> residues_;
 
+    /// [for reading] Bonds in the current molecule, added to the topology
+    /// all at once at the end of the molecule
+    std::vector<Bond> bonds_;
+
+    /// [for reading] Bond orders corresponding to `bonds_`
+    std::vector<Bond::BondOrder> bond_orders_;
+
     /// [for reading] Should we connect the previous atom to the first atom
     /// [for writing] Should we add a '.' after the current molecule
     bool first_atom_;
@@ -7,6 +7,7 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -28,8 +29,19 @@ class TRRFormat final : public Format {
     void read(Frame& frame) override;
     void write(const Frame& frame) override;
     size_t nsteps() override;
+    bool random_access() const override {
+        return true;
+    }
+    bool keeps_topology() const override {
+        return true;
+    }
+    std::unique_ptr<Format> reopen() const override;
 
   private:
+    /// Open the file at `path` in read mode, using already known
+    /// `frame_offsets` and number of atoms
+    TRRFormat(std::string path, std::vector<uint64_t> frame_offsets, size_t natoms);
+
     struct FrameHeader {
         bool use_double;  /* Double precision?                                  */
         size_t ir_size;   /* Backward compatibility                             */
@@ -7,11 +7,14 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "chemfiles/File.hpp"
 #include "chemfiles/Format.hpp"
+#include "chemfiles/types.hpp"
+#include "chemfiles/external/span.hpp"
 
 #include "chemfiles/files/XDRFile.hpp"
 
@@ -29,15 +32,35 @@ class XTCFormat final : public Format {
     void write(const Frame& frame) override;
     size_t nsteps() override;
 
+    /// Read the positions of multiple steps in parallel. Each thread uses
+    /// its own file handle and buffers, and reads a contiguous range of
+    /// steps using the precomputed frame offsets.
+    void read_positions_range(size_t start, span<std::vector<Vector3D>> positions, size_t threads) override;
+
+    bool random_access() const override {
+        return true;
+    }
+    bool keeps_topology() const override {
+        return true;
+    }
+    std::unique_ptr<Format> reopen() const override;
+
   private:
+    /// Open the file at `path` in read mode, using already known
+    /// `frame_offsets` and number of atoms
+    XTCFormat(std::string path, std::vector<uint64_t> frame_offsets, size_t natoms);
+
     struct FrameHeader {
         size_t natoms; /* The total number of atoms */
         size_t step;   /* Current step number       */
         float time;    /* Current time              */
     };
 
-    /// Read header of the Frame at the current position
-    FrameHeader read_frame_header();
+    /// Read header of the Frame at the current position in `file`
+    static FrameHeader read_frame_header(XDRFile& file);
+    /// Read the steps `start` to `start + positions.size()` from `file`,
+    /// storing only their positions
+    void read_positions_chunk(XDRFile& file, size_t start, span<std::vector<Vector3D>> positions) const;
     /// Write header of a Frame
     void write_frame_header(const FrameHeader& header);
     /// Determine the number of frames
@@ -4,6 +4,7 @@
 #ifndef CHEMFILES_MISC_HPP
 #define CHEMFILES_MISC_HPP
 
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <functional>
@@ -58,6 +59,69 @@ std::vector<std::reference_wrapper<const FormatMetadata>> CHFL_EXPORT formats_li
 /// @example{guess_format.cpp}
 std::string CHFL_EXPORT guess_format(std::string path, char mode = 'r');
 
+/// Enable or disable the use of frame index files.
+///
+/// Finding where each step starts in a trajectory requires reading the whole
+/// file for most formats, which can take a long time for large files. When
+/// frame index files are enabled, the position of all steps is stored next to
+/// the trajectory, in a file with the same name and an additional `.chfl-idx`
+/// extension (e.g. `traj.xtc.chfl-idx` for `traj.xtc`) after the first time
+/// the file is read. The next times the trajectory is opened, the positions
+/// are loaded from this index file instead of reading the whole trajectory.
+///
+/// Index files are only used if they match the current size, modification
+/// time and initial content of the trajectory file, and are re-created
+/// otherwise. Failure to write an index file (for example in a read-only
+/// directory) is silently ignored. Frame index files are disabled by default.
+///
+/// @param enabled whether frame index files should be used
+///
+/// @example{set_frame_index_files.cpp}
+void CHFL_EXPORT set_frame_index_files(bool enabled);
+
+/// Enable or disable threaded decompression of compressed text files.
+///
+/// When reading text based formats from a compressed file (gzip, bzip2 or
+/// xz), decompressing the data and parsing it usually happens on the same
+/// thread. When threaded decompression is enabled, an additional thread is
+/// started for each compressed file opened in read mode, decompressing the
+/// next few MiB of data while the current ones are parsed. Threaded
+/// decompression is disabled by default.
+///
+/// @param enabled whether compressed text files should be decompressed in a
+///                background thread
+///
+/// @example{set_threaded_decompression.cpp}
+void CHFL_EXPORT set_threaded_decompression(bool enabled);
+
+/// Enable or disable memory mapping of plain text files.
+///
+/// When memory mapping is enabled, uncompressed text files opened in read mode
+/// are memory mapped on POSIX systems, and lines are read directly from the
+/// mapping without copying them. The mapping only contains the data present
+/// in the file when opening it: data appended to the file later is not
+/// visible, and truncating the file while it is open can crash the process.
+/// Memory mapping is disabled by default.
+///
+/// @param enabled whether plain text files should be memory mapped
+///
+/// @example{set_memory_mapping.cpp}
+void CHFL_EXPORT set_memory_mapping(bool enabled);
+
+/// Set the number of threads used to format atoms when writing text formats.
+///
+/// When writing large frames with the XYZ, PDB, GRO, mmCIF or LAMMPS Data
+/// formats, the lines corresponding to atoms are formatted in chunks of a few
+/// thousand atoms. If more than one thread is used, these chunks are formatted
+/// in parallel, and then written to the file in order. The output is the same
+/// regardless of the number of threads. Only one thread is used by default.
+///
+/// @param threads number of threads to use, or 0 to use one thread per
+///                available CPU core
+///
+/// @example{set_write_threads.cpp}
+void CHFL_EXPORT set_write_threads(size_t threads);
+
 } // namespace chemfiles
 
 #endif
@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <string>
 #include <limits>
+#include <vector>
 #include <string_view>
 #include <type_traits>
 
@@ -183,6 +184,14 @@ inline size_t scan(std::string_view input, Args& ...args) {
     return iterator.read_count();
 }
 
+/// Read all the whitespace separated double values in `input` into `values`.
+/// The vector is cleared before reading, and its capacity is re-used. This is
+/// faster than calling `parse<double>` on each value, and should be preferred
+/// when reading lines with an unknown number of floating point values.
+///
+/// @throw chemfiles::Error if any of the values is not a valid double
+void scan_doubles(std::string_view input, std::vector<double>& values);
+
 /// Encodes an integer using the [hybrid36] encoding scheme. Returns a string
 /// of `*` characters if the integer is out of range.
 ///
@@ -8,6 +8,7 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <array>
 #include <string>
 #include <utility>
 #include <vector>
@@ -26,6 +27,38 @@ namespace selections {
 
 using Variable = uint8_t;
 
+/// Upper bounds on the distance between the atoms in a candidate match,
+/// extracted from the selection AST. Any match where `distance(#i, #j)` is
+/// larger than `get(i, j)` is guaranteed not to be selected, which allows to
+/// only visit candidate matches containing atoms close to one another.
+class DistanceBounds {
+public:
+    /// Create bounds without any constraint on the distances
+    DistanceBounds();
+
+    /// Get the bound on the distance between the atoms `i` and `j` of a
+    /// match. This is infinite if there is no bound, and negative if no
+    /// match can be selected.
+    double get(Variable i, Variable j) const {
+        return bounds_[i][j];
+    }
+
+    /// Restrict the distance between atoms `i` and `j` to be lower than or
+    /// equal to `bound`, if this is tighter than the current bound.
+    void restrict(Variable i, Variable j, double bound);
+
+    /// Keep the tightest bound from `this` and `other` for all pairs of
+    /// atoms. This corresponds to a logical `and` operation.
+    void intersect(const DistanceBounds& other);
+
+    /// Keep the loosest bound from `this` and `other` for all pairs of atoms.
+    /// This corresponds to a logical `or` operation.
+    void unite(const DistanceBounds& other);
+
+private:
+    std::array<std::array<double, 4>, 4> bounds_;
+};
+
 /// Abstract base class for selectors in the selection AST
 class Selector {
 public:
@@ -40,6 +73,23 @@ public:
     /// Optimize the AST corresponding to this Selector. Currently, this only
     /// perform constant propgations in mathematical expressions.
     virtual void optimize() {}
+    /// Get the bounds on the distance between atoms in a match implied by
+    /// this selector. By default, there is no bound.
+    virtual DistanceBounds distance_bounds() const {
+        return DistanceBounds();
+    }
+    /// Evaluate this selector for multiple atoms at once in the `atoms`
+    /// context, only keeping the matching atoms in the sorted list of
+    /// `atoms`. The default implementation calls `is_match` for each atom.
+    virtual void filter(const Frame& frame, std::vector<size_t>& atoms) const;
+    /// Create a deep copy of this selector, without any cached data
+    virtual std::unique_ptr<Selector> clone() const = 0;
+    /// Check if this selector only depends on the topology of the frame
+    /// (atoms, residues and bonds), and not on positions, velocities or unit
+    /// cell. The default implementation conservatively returns `false`.
+    virtual bool topology_only() const {
+        return false;
+    }
 
     Selector() = default;
     virtual ~Selector() = default;
@@ -61,6 +111,10 @@ public:
     std::string print(unsigned delta) const override;
     bool is_match(const Frame& frame, const Match& match) const override;
     void clear() override;
+    Ast clone() const override;
+    bool topology_only() const override;
+    DistanceBounds distance_bounds() const override;
+    void filter(const Frame& frame, std::vector<size_t>& atoms) const override;
 private:
     Ast lhs_;
     Ast rhs_;
@@ -73,6 +127,10 @@ public:
     std::string print(unsigned delta) const override;
     bool is_match(const Frame& frame, const Match& match) const override;
     void clear() override;
+    Ast clone() const override;
+    bool topology_only() const override;
+    DistanceBounds distance_bounds() const override;
+    void filter(const Frame& frame, std::vector<size_t>& atoms) const override;
 private:
     Ast lhs_;
     Ast rhs_;
@@ -85,6 +143,9 @@ public:
     std::string print(unsigned delta) const override;
     bool is_match(const Frame& frame, const Match& match) const override;
     void clear() override;
+    Ast clone() const override;
+    bool topology_only() const override;
+    void filter(const Frame& frame, std::vector<size_t>& atoms) const override;
 private:
     Ast ast_;
 };
@@ -96,6 +157,11 @@ public:
     std::string print(unsigned delta) const override;
     bool is_match(const Frame& frame, const Match& match) const override;
     void clear() override {}
+    Ast clone() const override;
+    bool topology_only() const override {
+        return true;
+    }
+    void filter(const Frame& /*unused*/, std::vector<size_t>& /*unused*/) const override {}
 };
 
 /// Selection matching no atoms
@@ -105,6 +171,13 @@ public:
     std::string print(unsigned delta) const override;
     bool is_match(const Frame& frame, const Match& match) const override;
     void clear() override {}
+    Ast clone() const override;
+    bool topology_only() const override {
+        return true;
+    }
+    void filter(const Frame& /*unused*/, std::vector<size_t>& atoms) const override {
+        atoms.clear();
+    }
 };
 
 /// Selection based on boolean properties
@@ -115,6 +188,10 @@ public:
     std::string print(unsigned delta) const override;
     bool is_match(const Frame& frame, const Match& match) const override;
     void clear() override {}
+    Ast clone() const override;
+    bool topology_only() const override {
+        return true;
+    }
 
 private:
     std::string property_;
@@ -140,12 +217,26 @@ public:
     std::string print() const;
     /// Clear cached data
     void clear();
+    /// Create a deep copy of this sub-selection, without any cached data
+    SubSelection clone() const;
+    /// Check if this sub-selection only depends on the topology of the frame
+    bool topology_only() const;
 
     bool is_variable() const {
         return selection_ == nullptr;
     }
 
+    /// Get the variable of this sub-selection. This is only meaningful if
+    /// `is_variable()` is true.
+    Variable variable() const {
+        assert(is_variable());
+        return variable_;
+    }
+
 private:
+    /// Create a sub-selection from an already compiled selection
+    explicit SubSelection(std::unique_ptr<Selection> selection);
+
     /// Possible selection. If this is nullptr, then the variable_ is set.
     std::unique_ptr<Selection> selection_;
     /// Variable to use if selection_ is nullptr
@@ -163,6 +254,8 @@ public:
     std::string print(unsigned delta) const override;
     bool is_match(const Frame& frame, const Match& match) const override;
     void clear() override;
+    Ast clone() const override;
+    bool topology_only() const override;
 private:
     SubSelection i_;
     SubSelection j_;
@@ -176,6 +269,8 @@ public:
     std::string print(unsigned delta) const override;
     bool is_match(const Frame& frame, const Match& match) const override;
     void clear() override;
+    Ast clone() const override;
+    bool topology_only() const override;
 private:
     SubSelection i_;
     SubSelection j_;
@@ -190,6 +285,8 @@ public:
     std::string print(unsigned delta) const override;
     bool is_match(const Frame& frame, const Match& match) const override;
     void clear() override;
+    Ast clone() const override;
+    bool topology_only() const override;
 private:
     SubSelection i_;
     SubSelection j_;
@@ -205,6 +302,8 @@ public:
     std::string print(unsigned delta) const override;
     bool is_match(const Frame& frame, const Match& match) const override;
     void clear() override;
+    Ast clone() const override;
+    bool topology_only() const override;
 private:
     SubSelection i_;
     SubSelection j_;
@@ -229,8 +328,11 @@ public:
 
     bool is_match(const Frame& frame, const Match& match) const final;
     std::string print(unsigned delta) const final;
+    bool topology_only() const override {
+        return true;
+    }
 
-private:
+protected:
     /// The value to check against
     std::string value_;
     /// Are we checking for equality or inequality?
@@ -249,6 +351,7 @@ public:
     const std::string& value(const Frame& frame, size_t i) const override;
     std::string name() const override;
     void clear() override {}
+    Ast clone() const override;
 
 private:
     std::string property_;
@@ -263,6 +366,7 @@ public:
     std::string name() const override;
     const std::string& value(const Frame& frame, size_t i) const override;
     void clear() override {}
+    Ast clone() const override;
 };
 
 /// Select atoms using their name
@@ -274,6 +378,7 @@ public:
     std::string name() const override;
     const std::string& value(const Frame& frame, size_t i) const override;
     void clear() override {}
+    Ast clone() const override;
 };
 
 /// Select atoms using their residue name
@@ -285,6 +390,7 @@ public:
     std::string name() const override;
     const std::string& value(const Frame& frame, size_t i) const override;
     void clear() override {}
+    Ast clone() const override;
 };
 
 class MathExpr;
@@ -317,6 +423,10 @@ public:
     void optimize() override;
     std::string print(unsigned delta) const override;
     void clear() override;
+    Ast clone() const override;
+    bool topology_only() const override;
+    DistanceBounds distance_bounds() const override;
+    void filter(const Frame& frame, std::vector<size_t>& atoms) const override;
 
 private:
     Operator op_;
@@ -351,6 +461,35 @@ public:
 
     /// Pretty-print the expression
     virtual std::string print() const = 0;
+
+    /// Create a deep copy of this expression, without any cached data
+    virtual std::unique_ptr<MathExpr> clone() const = 0;
+
+    /// Check if this expression only depends on the topology of the frame.
+    /// The default implementation conservatively returns `false`.
+    virtual bool topology_only() const {
+        return false;
+    }
+
+    /// Evaluate the expression for multiple atoms at once in the `atoms`
+    /// context, storing a single value per atom in `values`. This returns
+    /// `false` if the expression can not be evaluated this way (for example
+    /// if it can produce multiple values per atom), in which case `eval`
+    /// should be used instead.
+    virtual bool eval_all(const Frame& /*unused*/, const std::vector<size_t>& /*unused*/, std::vector<double>& /*unused*/) const {
+        return false;
+    }
+
+    /// Get the value of this expression if it is a constant number
+    virtual optional<double> constant() const {
+        return nullopt;
+    }
+
+    /// Get the pair of variables in this expression if it is a distance
+    /// between two variables (as in `distance(#1, #3)`)
+    virtual optional<std::pair<Variable, Variable>> distance_variables() const {
+        return nullopt;
+    }
 };
 
 // Addition
@@ -359,9 +498,12 @@ public:
     Add(MathAst lhs, MathAst rhs): lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
 
     NumericValues eval(const Frame& frame, const Match& match) const override;
+    bool eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const override;
     optional<double> optimize() override;
     std::string print() const override;
     void clear() override;
+    MathAst clone() const override;
+    bool topology_only() const override;
 
 private:
     MathAst lhs_;
@@ -374,9 +516,12 @@ public:
     Sub(MathAst lhs, MathAst rhs): lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
 
     NumericValues eval(const Frame& frame, const Match& match) const override;
+    bool eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const override;
     optional<double> optimize() override;
     std::string print() const override;
     void clear() override;
+    MathAst clone() const override;
+    bool topology_only() const override;
 
 private:
     MathAst lhs_;
@@ -389,9 +534,12 @@ public:
     Mul(MathAst lhs, MathAst rhs): lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
 
     NumericValues eval(const Frame& frame, const Match& match) const override;
+    bool eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const override;
     optional<double> optimize() override;
     std::string print() const override;
     void clear() override;
+    MathAst clone() const override;
+    bool topology_only() const override;
 
 private:
     MathAst lhs_;
@@ -404,9 +552,12 @@ public:
     Div(MathAst lhs, MathAst rhs): lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
 
     NumericValues eval(const Frame& frame, const Match& match) const override;
+    bool eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const override;
     optional<double> optimize() override;
     std::string print() const override;
     void clear() override;
+    MathAst clone() const override;
+    bool topology_only() const override;
 
 private:
     MathAst lhs_;
@@ -419,9 +570,12 @@ public:
     Pow(MathAst lhs, MathAst rhs): lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
 
     NumericValues eval(const Frame& frame, const Match& match) const override;
+    bool eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const override;
     optional<double> optimize() override;
     std::string print() const override;
     void clear() override;
+    MathAst clone() const override;
+    bool topology_only() const override;
 
 private:
     MathAst lhs_;
@@ -434,9 +588,12 @@ public:
     Neg(MathAst ast): ast_(std::move(ast)) {}
 
     NumericValues eval(const Frame& frame, const Match& match) const override;
+    bool eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const override;
     optional<double> optimize() override;
     std::string print() const override;
     void clear() override;
+    MathAst clone() const override;
+    bool topology_only() const override;
 
 private:
     MathAst ast_;
@@ -448,9 +605,12 @@ public:
     Mod(MathAst lhs, MathAst rhs): lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
 
     NumericValues eval(const Frame& frame, const Match& match) const override;
+    bool eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const override;
     optional<double> optimize() override;
     std::string print() const override;
     void clear() override;
+    MathAst clone() const override;
+    bool topology_only() const override;
 
 private:
     MathAst lhs_;
@@ -464,9 +624,12 @@ public:
         fn_(std::move(fn)), name_(std::move(name)), ast_(std::move(ast)) {}
 
     NumericValues eval(const Frame& frame, const Match& match) const override;
+    bool eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const override;
     optional<double> optimize() override;
     std::string print() const override;
     void clear() override;
+    MathAst clone() const override;
+    bool topology_only() const override;
 
 private:
     std::function<double(double)> fn_;
@@ -481,9 +644,17 @@ public:
     Number(double value): value_(value) {}
 
     NumericValues eval(const Frame& frame, const Match& match) const override;
+    bool eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const override;
     optional<double> optimize() override;
     std::string print() const override;
     void clear() override {}
+    MathAst clone() const override;
+    bool topology_only() const override {
+        return true;
+    }
+    optional<double> constant() const override {
+        return value_;
+    }
 
 private:
     double value_;
@@ -499,7 +670,9 @@ public:
         return nullopt;
     }
     std::string print() const override;
-    void clear() override {}
+    void clear() override;
+    MathAst clone() const override;
+    optional<std::pair<Variable, Variable>> distance_variables() const override;
 
 private:
     SubSelection i_;
@@ -517,7 +690,8 @@ public:
         return nullopt;
     }
     std::string print() const override;
-    void clear() override {}
+    void clear() override;
+    MathAst clone() const override;
 
 private:
     SubSelection i_;
@@ -536,7 +710,8 @@ public:
         return nullopt;
     }
     std::string print() const override;
-    void clear() override {}
+    void clear() override;
+    MathAst clone() const override;
 
 private:
     SubSelection i_;
@@ -556,7 +731,8 @@ public:
         return nullopt;
     }
     std::string print() const override;
-    void clear() override {}
+    void clear() override;
+    MathAst clone() const override;
 
 private:
     SubSelection i_;
@@ -572,15 +748,19 @@ public:
     ~NumericSelector() override = default;
 
     NumericValues eval(const Frame& frame, const Match& match) const final;
+    bool eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const override;
     optional<double> optimize() final;
     std::string print() const final;
+    bool topology_only() const override {
+        return true;
+    }
 
     /// Get the value for the atom at index `i` in the `frame`
     virtual double value(const Frame& frame, size_t i) const = 0;
     /// Get the name of the selector
     virtual std::string name() const = 0;
 
-private:
+protected:
     /// Which atom in the candidate match are we checking?
     Variable argument_;
 };
@@ -592,6 +772,7 @@ public:
     std::string name() const override;
     double value(const Frame& frame, size_t i) const override;
     void clear() override {}
+    MathAst clone() const override;
 
 private:
     std::string property_;
@@ -605,6 +786,7 @@ public:
     std::string name() const override;
     double value(const Frame& frame, size_t i) const override;
     void clear() override {}
+    MathAst clone() const override;
 };
 
 /// Select atoms using their residue id (residue number)
@@ -614,6 +796,7 @@ public:
     std::string name() const override;
     double value(const Frame& frame, size_t i) const override;
     void clear() override {}
+    MathAst clone() const override;
 };
 
 /// Select atoms using their mass.
@@ -623,6 +806,7 @@ public:
     std::string name() const override;
     double value(const Frame& frame, size_t i) const override;
     void clear() override {}
+    MathAst clone() const override;
 };
 
 enum class Coordinate {
@@ -639,7 +823,12 @@ public:
     Position(Variable argument, Coordinate coordinate): NumericSelector(argument), coordinate_(coordinate) {}
     std::string name() const override;
     double value(const Frame& frame, size_t i) const override;
+    bool eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const override;
     void clear() override {}
+    MathAst clone() const override;
+    bool topology_only() const override {
+        return false;
+    }
 
 private:
     Coordinate coordinate_;
@@ -653,7 +842,12 @@ public:
     Velocity(Variable argument, Coordinate coordinate): NumericSelector(argument), coordinate_(coordinate) {}
     std::string name() const override;
     double value(const Frame& frame, size_t i) const override;
+    bool eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const override;
     void clear() override {}
+    MathAst clone() const override;
+    bool topology_only() const override {
+        return false;
+    }
 
 private:
     Coordinate coordinate_;
@@ -5,6 +5,7 @@
 #define CHEMFILES_WARNINGS_H
 
 #include <string>
+#include <vector>
 #include <iterator>
 #include <fmt/format.h>
 
@@ -13,6 +14,26 @@ namespace chemfiles {
 /// Send a warning with the given message
 void send_warning(const std::string& message) noexcept;
 
+/// Collect the warnings sent by the current thread in a vector while an
+/// instance of this class is alive, instead of sending them directly. This
+/// allows to send the warnings emitted by background threads later, in a
+/// deterministic order.
+class CollectWarnings final {
+public:
+    /// Start collecting the warnings sent by the current thread in `warnings`
+    explicit CollectWarnings(std::vector<std::string>& warnings) noexcept;
+    /// Stop collecting warnings, going back to the previous collector if any
+    ~CollectWarnings();
+
+    CollectWarnings(const CollectWarnings&) = delete;
+    CollectWarnings& operator=(const CollectWarnings&) = delete;
+    CollectWarnings(CollectWarnings&&) = delete;
+    CollectWarnings& operator=(CollectWarnings&&) = delete;
+
+private:
+    std::vector<std::string>* previous_;
+};
+
 /// Create a message for the given `context` formatting the `message` with the
 /// `arguments`, and send a warning with this message.
 ///
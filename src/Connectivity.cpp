@@ -4,11 +4,15 @@
 #include <cassert>
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <vector>
+#include <utility>
 #include <iterator>
 #include <algorithm>
+#include <memory>
 
 #include "chemfiles/Connectivity.hpp"
+#include "chemfiles/ThreadPool.hpp"
 #include "chemfiles/error_fmt.hpp"
 #include "chemfiles/sorted_set.hpp"
 
@@ -100,62 +104,172 @@ size_t Improper::operator[](size_t i) const {
     return data_[i];
 }
 
-void Connectivity::recalculate() const {
-    angles_.clear();
-    dihedrals_.clear();
-    impropers_.clear();
-
-    // Generate the list of which atom is bonded to which one
-    auto bonded_to = std::vector<std::vector<size_t>>(biggest_atom_ + 1);
-    for (auto const& bond: bonds_) {
-        assert(bond[0] < bonded_to.size());
-        assert(bond[1] < bonded_to.size());
-        bonded_to[bond[0]].push_back(bond[1]);
-        bonded_to[bond[1]].push_back(bond[0]);
-    }
-
-    // Generate the list of angles
-    for (auto const& bond: bonds_) {
-        auto i = bond[0];
-        auto j = bond[1];
-        for (auto k: bonded_to[i]) {
-            if (k != j) {
-                angles_.insert(Angle(k, i, j));
-            }
+AdjacencyGraph::AdjacencyGraph(const std::vector<Bond>& bonds, size_t biggest_atom) {
+    if (bonds.empty()) {
+        return;
+    }
+
+    // count the neighbors of each atom, and transform the counts into offsets
+    offsets_.assign(biggest_atom + 2, 0);
+    for (const auto& bond: bonds) {
+        offsets_[bond[0] + 1] += 1;
+        offsets_[bond[1] + 1] += 1;
+    }
+    for (size_t i = 1; i < offsets_.size(); i++) {
+        offsets_[i] += offsets_[i - 1];
+    }
+
+    // Since the bonds are sorted, the neighbors of each atom are added in
+    // increasing order: first the atoms with a smaller index (for which this
+    // atom is the second one in the bond), then the atoms with a bigger index.
+    neighbors_.resize(offsets_.back());
+    auto next = std::vector<size_t>(offsets_.begin(), offsets_.end() - 1);
+    for (const auto& bond: bonds) {
+        neighbors_[next[bond[0]]++] = bond[1];
+        neighbors_[next[bond[1]]++] = bond[0];
+    }
+}
+
+Molecules::Molecules(const std::vector<Bond>& bonds, size_t natoms) {
+    // union-find structure, with path halving and union by size
+    auto parents = std::vector<size_t>(natoms);
+    auto sizes = std::vector<size_t>(natoms, 1);
+    for (size_t i = 0; i < natoms; i++) {
+        parents[i] = i;
+    }
+
+    auto find = [&parents](size_t i) {
+        while (parents[i] != i) {
+            parents[i] = parents[parents[i]];
+            i = parents[i];
+        }
+        return i;
+    };
+
+    for (const auto& bond: bonds) {
+        assert(bond[1] < natoms);
+        auto root_i = find(bond[0]);
+        auto root_j = find(bond[1]);
+        if (root_i == root_j) {
+            continue;
         }
 
-        for (auto k: bonded_to[j]) {
-            if (k != i) {
-                angles_.insert(Angle(i, j, k));
-            }
+        if (sizes[root_i] < sizes[root_j]) {
+            std::swap(root_i, root_j);
         }
+        parents[root_j] = root_i;
+        sizes[root_i] += sizes[root_j];
     }
 
-    // Generate the list of dihedrals
-    for (auto const& angle: angles_) {
-        auto i = angle[0];
-        auto j = angle[1];
-        auto k = angle[2];
-        for (auto m: bonded_to[i]) {
-            if (m != j && m != k) {
-                dihedrals_.insert(Dihedral(m, i, j, k));
-            }
+    // number the molecules in the order of their first atom, and count the
+    // atoms in each molecule
+    auto root_molecules = std::vector<size_t>(natoms, SIZE_MAX);
+    molecule_ids_.resize(natoms);
+    for (size_t i = 0; i < natoms; i++) {
+        auto& molecule = root_molecules[find(i)];
+        if (molecule == SIZE_MAX) {
+            molecule = offsets_.size() - 1;
+            offsets_.push_back(0);
         }
+        molecule_ids_[i] = molecule;
+        offsets_[molecule + 1] += 1;
+    }
 
-        for (auto m: bonded_to[k]) {
-            if (m != i && m != j) {
-                dihedrals_.insert(Dihedral(i, j, k, m));
-            }
-        }
+    for (size_t i = 1; i < offsets_.size(); i++) {
+        offsets_[i] += offsets_[i - 1];
+    }
 
-        for (auto m: bonded_to[j]) {
-            if (m != i && m != k) {
-                impropers_.insert(Improper(i, j, k, m));
-            }
+    atoms_.resize(natoms);
+    auto next = std::vector<size_t>(offsets_.begin(), offsets_.end() - 1);
+    for (size_t i = 0; i < natoms; i++) {
+        atoms_[next[molecule_ids_[i]]++] = i;
+    }
+}
+
+size_t Molecules::molecule_for_atom(size_t atom) const {
+    if (atom >= molecule_ids_.size()) {
+        throw out_of_bounds(
+            "out of bounds atomic index in `Molecules::molecule_for_atom`: "
+            "we have {} atoms, but the index is {}",
+            molecule_ids_.size(), atom
+        );
+    }
+    return molecule_ids_[atom];
+}
+
+span<const size_t> Molecules::atoms(size_t molecule) const {
+    if (molecule >= size()) {
+        throw out_of_bounds(
+            "out of bounds molecule index in `Molecules::atoms`: "
+            "we have {} molecules, but the index is {}",
+            size(), molecule
+        );
+    }
+    return {atoms_.data() + offsets_[molecule], offsets_[molecule + 1] - offsets_[molecule]};
+}
+
+/// Minimal number of atoms in the adjacency graph to generate angles,
+/// dihedrals and impropers using multiple threads
+static constexpr size_t PARALLEL_ATOMS_THRESHOLD = 50000;
+
+/// Fill `set` with the values created by `generate(begin, end, output)`, which
+/// should push in `output` all the values centered on the atoms in
+/// `[begin, end)`. For large graphs, the atoms are split in chunks processed
+/// in parallel. The values are sorted afterward, and `generate` must not
+/// create the same value twice.
+template<class T, class Function>
+static void generate_sorted(sorted_set<T>& set, const AdjacencyGraph& graph, const Function& generate) {
+    auto natoms = graph.size();
+    auto& values = set.as_mutable_vec();
+    values.clear();
+    if (natoms < PARALLEL_ATOMS_THRESHOLD) {
+        generate(size_t(0), natoms, values);
+    } else {
+        auto pool = ThreadPool::shared();
+        auto chunks = pool->size();
+        auto chunk_size = (natoms + chunks - 1) / chunks;
+        auto outputs = std::vector<std::vector<T>>(chunks);
+        pool->run_chunks(chunks, [&](size_t chunk) {
+            auto begin = std::min(chunk * chunk_size, natoms);
+            auto end = std::min(begin + chunk_size, natoms);
+            generate(begin, end, outputs[chunk]);
+        });
+
+        size_t total = 0;
+        for (const auto& output: outputs) {
+            total += output.size();
+        }
+        values.reserve(total);
+        for (const auto& output: outputs) {
+            values.insert(values.end(), output.begin(), output.end());
         }
     }
 
-    uptodate_ = true;
+    std::sort(values.begin(), values.end());
+}
+
+void Connectivity::bonds_changed() {
+    adjacency_uptodate_ = false;
+    molecules_uptodate_ = false;
+    angles_uptodate_ = false;
+    dihedrals_uptodate_ = false;
+    impropers_uptodate_ = false;
+}
+
+const AdjacencyGraph& Connectivity::adjacency() const {
+    if (!adjacency_uptodate_) {
+        adjacency_ = AdjacencyGraph(bonds_.as_vec(), biggest_atom_);
+        adjacency_uptodate_ = true;
+    }
+    return adjacency_;
+}
+
+const Molecules& Connectivity::molecules(size_t natoms) const {
+    if (!molecules_uptodate_ || molecules_.molecule_ids_.size() != natoms) {
+        molecules_ = Molecules(bonds_.as_vec(), natoms);
+        molecules_uptodate_ = true;
+    }
+    return molecules_;
 }
 
 const sorted_set<Bond>& Connectivity::bonds() const {
@@ -167,28 +281,76 @@ const std::vector<Bond::BondOrder>& Connectivity::bond_orders() const {
 }
 
 const sorted_set<Angle>& Connectivity::angles() const {
-    if (!uptodate_) {
-        recalculate();
+    if (!angles_uptodate_) {
+        // each angle is created once, from its central atom
+        const auto& graph = adjacency();
+        generate_sorted(angles_, graph, [&graph](size_t begin, size_t end, std::vector<Angle>& angles) {
+            for (size_t j = begin; j < end; j++) {
+                auto neighbors = graph.neighbors(j);
+                for (size_t a = 0; a < neighbors.size(); a++) {
+                    for (size_t b = a + 1; b < neighbors.size(); b++) {
+                        angles.emplace_back(neighbors[a], j, neighbors[b]);
+                    }
+                }
+            }
+        });
+        angles_uptodate_ = true;
     }
     return angles_;
 }
 
 const sorted_set<Dihedral>& Connectivity::dihedrals() const {
-    if (!uptodate_) {
-        recalculate();
+    if (!dihedrals_uptodate_) {
+        // each dihedral angle is created once, from its central bond j-k
+        const auto& graph = adjacency();
+        generate_sorted(dihedrals_, graph, [&graph](size_t begin, size_t end, std::vector<Dihedral>& dihedrals) {
+            for (size_t j = begin; j < end; j++) {
+                auto j_neighbors = graph.neighbors(j);
+                for (auto k: j_neighbors) {
+                    if (k < j) {
+                        continue;
+                    }
+                    for (auto i: j_neighbors) {
+                        if (i == k) {
+                            continue;
+                        }
+                        for (auto m: graph.neighbors(k)) {
+                            if (m != j && m != i) {
+                                dihedrals.emplace_back(i, j, k, m);
+                            }
+                        }
+                    }
+                }
+            }
+        });
+        dihedrals_uptodate_ = true;
     }
     return dihedrals_;
 }
 
 const sorted_set<Improper>& Connectivity::impropers() const {
-    if (!uptodate_) {
-        recalculate();
+    if (!impropers_uptodate_) {
+        // each improper dihedral angle is created once, from its central atom
+        const auto& graph = adjacency();
+        generate_sorted(impropers_, graph, [&graph](size_t begin, size_t end, std::vector<Improper>& impropers) {
+            for (size_t j = begin; j < end; j++) {
+                auto neighbors = graph.neighbors(j);
+                for (size_t a = 0; a < neighbors.size(); a++) {
+                    for (size_t b = a + 1; b < neighbors.size(); b++) {
+                        for (size_t c = b + 1; c < neighbors.size(); c++) {
+                            impropers.emplace_back(neighbors[a], j, neighbors[b], neighbors[c]);
+                        }
+                    }
+                }
+            }
+        });
+        impropers_uptodate_ = true;
     }
     return impropers_;
 }
 
 void Connectivity::add_bond(size_t i, size_t j, Bond::BondOrder bond_order) {
-    uptodate_ = false;
+    bonds_changed();
     auto result = bonds_.emplace(i, j);
     if (i > biggest_atom_) {biggest_atom_ = i;}
     if (j > biggest_atom_) {biggest_atom_ = j;}
@@ -199,10 +361,64 @@ void Connectivity::add_bond(size_t i, size_t j, Bond::BondOrder bond_order) {
     }
 }
 
+void Connectivity::add_bonds(span<const Bond> bonds, span<const Bond::BondOrder> bond_orders) {
+    assert(bond_orders.empty() || bond_orders.size() == bonds.size());
+    if (bonds.empty()) {
+        return;
+    }
+    bonds_changed();
+
+    // sort the new bonds, keeping the order of duplicated bonds so that the
+    // first bond order is used for them
+    auto new_bonds = std::vector<size_t>(bonds.size());
+    for (size_t i = 0; i < bonds.size(); i++) {
+        new_bonds[i] = i;
+        biggest_atom_ = std::max(biggest_atom_, bonds[i][1]);
+    }
+    std::stable_sort(new_bonds.begin(), new_bonds.end(), [&](size_t i, size_t j) {
+        return bonds[i] < bonds[j];
+    });
+
+    // merge the existing and new bonds, removing duplicates. Existing bonds
+    // come first and keep their bond order.
+    const auto& old_bonds = bonds_.as_vec();
+    auto merged_bonds = std::vector<Bond>();
+    auto merged_orders = std::vector<Bond::BondOrder>();
+    merged_bonds.reserve(old_bonds.size() + bonds.size());
+    merged_orders.reserve(old_bonds.size() + bonds.size());
+
+    size_t old_i = 0;
+    size_t new_i = 0;
+    while (old_i < old_bonds.size() || new_i < new_bonds.size()) {
+        const Bond* bond = nullptr;
+        auto bond_order = Bond::UNKNOWN;
+        if (new_i == new_bonds.size() || (old_i < old_bonds.size() && old_bonds[old_i] <= bonds[new_bonds[new_i]])) {
+            bond = &old_bonds[old_i];
+            bond_order = bond_orders_[old_i];
+            old_i++;
+        } else {
+            auto index = new_bonds[new_i];
+            bond = &bonds[index];
+            if (!bond_orders.empty()) {
+                bond_order = bond_orders[index];
+            }
+            new_i++;
+        }
+
+        if (merged_bonds.empty() || merged_bonds.back() != *bond) {
+            merged_bonds.push_back(*bond);
+            merged_orders.push_back(bond_order);
+        }
+    }
+
+    bonds_.as_mutable_vec() = std::move(merged_bonds);
+    bond_orders_ = std::move(merged_orders);
+}
+
 void Connectivity::remove_bond(size_t i, size_t j) {
     auto pos = bonds_.find(Bond(i, j));
     if (pos != bonds_.end()) {
-        uptodate_ = false;
+        bonds_changed();
         auto result = bonds_.erase(pos);
 
         auto diff = std::distance(bonds_.cbegin(), result);
@@ -211,36 +427,27 @@ void Connectivity::remove_bond(size_t i, size_t j) {
     }
 }
 
-void Connectivity::atom_removed(size_t index) {
-    auto to_remove = std::vector<Bond>();
-    auto to_add = std::vector<Bond>();
-    auto bo_add = std::vector<Bond::BondOrder>();
-
-    const auto& bonds = bonds_.as_vec();
-    for (size_t idx = 0; idx < bonds_.size(); idx++) {
-        const auto& bond = bonds[idx];
-
-        if (bond[0] == index || bond[1] == index) {
-            throw error("can not shift atomic indexes that still have a bond");
-        }
-        if (bond[0] > index || bond[1] > index) {
-            to_remove.push_back(bond);
-
-            auto i = bond[0] > index ? bond[0] - 1 : bond[0];
-            auto j = bond[1] > index ? bond[1] - 1 : bond[1];
-            to_add.emplace_back(i, j);
-            bo_add.push_back(bond_orders_[idx]);
+void Connectivity::atoms_removed(const std::vector<size_t>& new_indexes) {
+    // atoms keep their relative order, so the bonds stay sorted and can be
+    // updated in place
+    auto& bonds = bonds_.as_mutable_vec();
+    size_t count = 0;
+    biggest_atom_ = 0;
+    for (size_t idx = 0; idx < bonds.size(); idx++) {
+        auto i = new_indexes[bonds[idx][0]];
+        auto j = new_indexes[bonds[idx][1]];
+        if (i == SIZE_MAX || j == SIZE_MAX) {
+            continue;
         }
-    }
-
-    for (auto bond: to_remove) {
-        this->remove_bond(bond[0], bond[1]);
-    }
 
-    for (size_t idx = 0; idx < to_add.size(); idx++) {
-        const auto& bond = to_add[idx];
-        this->add_bond(bond[0], bond[1], bo_add[idx]);
+        bonds[count] = Bond(i, j);
+        bond_orders_[count] = bond_orders_[idx];
+        biggest_atom_ = std::max(biggest_atom_, j);
+        count++;
     }
+    bonds.erase(bonds.begin() + static_cast<std::ptrdiff_t>(count), bonds.end());
+    bond_orders_.resize(count);
+    bonds_changed();
 }
 
 Bond::BondOrder Connectivity::bond_order(size_t i, size_t j) const {
@@ -1,32 +1,60 @@
 // Chemfiles, a modern library for chemistry file reading and writing
 // Copyright (C) Guillaume Fraux and contributors -- BSD license
 
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <cstring>
+#include <deque>
+#include <exception>
+#include <future>
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 #include <iterator>
+#include <algorithm>
+#include <functional>
 #include <string_view>
 
 #include <fmt/core.h>
 #include <fmt/format.h>
 
 #include "chemfiles/File.hpp"
+#include "chemfiles/misc.hpp"
+#include "chemfiles/ThreadPool.hpp"
 #include "chemfiles/files/GzFile.hpp"
 #include "chemfiles/files/XzFile.hpp"
 #include "chemfiles/files/Bz2File.hpp"
 #include "chemfiles/files/PlainFile.hpp"
 #include "chemfiles/files/MemoryFile.hpp"
 #include "chemfiles/files/MemoryBuffer.hpp"
+#include "chemfiles/files/ReadAheadFile.hpp"
 
+#include "chemfiles/warnings.hpp"
 #include "chemfiles/error_fmt.hpp"
 #include "chemfiles/unreachable.hpp"
 
 using namespace chemfiles;
 
+/// Size of the data formatted by `TextFile::print` before writing it to the
+/// underlying file
+static constexpr size_t WRITE_BUFFER_SIZE = 64 * 1024;
+
+static std::atomic<size_t> WRITE_THREADS(1);
+
+void chemfiles::set_write_threads(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    WRITE_THREADS = threads;
+}
+
+size_t chemfiles::write_threads() {
+    return WRITE_THREADS;
+}
+
 TextFile::TextFile(std::string path, File::Mode mode, File::Compression compression):
     File(std::move(path), mode, compression),
     file_(nullptr),
@@ -47,9 +75,20 @@ TextFile::TextFile(std::string path, File::Mode mode, File::Compression compress
     case File::LZMA:
         file_ = std::make_unique<XzFile>(this->path(), this->mode());
         break;
+    case File::GZIP_PARALLEL:
+        file_ = std::make_unique<GzFile>(this->path(), this->mode(), /* parallel */ true);
+        break;
     default:
         unreachable();
     }
+
+    if (mode == File::READ && compression != File::DEFAULT && threaded_decompression_enabled()) {
+        file_ = std::make_unique<ReadAheadFile>(this->path(), std::move(file_));
+    }
+
+    if (mode == File::READ) {
+        mapped_ = file_->mapped();
+    }
 }
 
 TextFile::TextFile(std::shared_ptr<MemoryBuffer> memory, File::Mode mode, File::Compression compression):
@@ -74,6 +113,23 @@ TextFile::TextFile(std::shared_ptr<MemoryBuffer> memory, File::Mode mode, File::
     file_ = std::make_unique<MemoryFile>(std::move(memory), mode);
 }
 
+TextFile::~TextFile() {
+    if (file_ == nullptr) {
+        // this file was moved from
+        return;
+    }
+
+    try {
+        this->flush();
+    } catch (const std::exception& e) {
+        try {
+            warning("", "error while writing to '{}': {}", this->path(), e.what());
+        } catch (...) {
+            // there is nothing else we can do
+        }
+    }
+}
+
 uint64_t TextFile::tellpos() const {
     assert(line_start_ >= buffer_.data());
     auto delta = buffer_initialized() ? static_cast<uint64_t>(line_start_ - buffer_.data()) : 0;
@@ -81,10 +137,15 @@ uint64_t TextFile::tellpos() const {
 }
 
 void TextFile::seekpos(uint64_t position) {
+    this->flush();
+
+    // if the buffer contains the end of the file, data could have been
+    // appended to the file since we filled it, so we can not re-use it
+    auto buffer_contains_eof = got_impl_eof_;
     got_impl_eof_ = false;
     eof_ = false;
 
-    if (buffer_initialized()) {
+    if (buffer_initialized() && !buffer_contains_eof) {
         // use signed int64_t since the requested position can be smaller than
         // position_
         auto delta = static_cast<int64_t>(position) - static_cast<int64_t>(position_);
@@ -110,11 +171,21 @@ void TextFile::rewind() {
 }
 
 void TextFile::clear() {
+    auto buffer_contains_eof = got_impl_eof_ && buffer_initialized();
+    auto position = tellpos();
     // Clear cached variables
     got_impl_eof_ = false;
     eof_ = false;
     // clear the file
     file_->clear();
+
+    if (buffer_contains_eof) {
+        // data could have been appended to the file since we reached its
+        // end, refill the buffer from the current position
+        file_->seek(position);
+        position_ = position;
+        buffer_[0] = '\0';
+    }
 }
 
 bool TextFile::buffer_initialized() const {
@@ -136,7 +207,40 @@ void TextFile::fill_buffer(size_t start) {
     line_start_ = buffer_.data();
 }
 
+std::string_view TextFile::readline_mapped() {
+    if (eof_) {
+        return "";
+    }
+
+    if (position_ >= mapped_.size()) {
+        eof_ = true;
+        return "";
+    }
+
+    const auto* start = mapped_.data() + position_;
+    auto remainder = mapped_.size() - static_cast<size_t>(position_);
+    const auto* newline = static_cast<const char*>(std::memchr(start, '\n', remainder));
+    if (newline == nullptr) {
+        // last line, not terminated by a newline character
+        eof_ = true;
+        position_ = mapped_.size();
+        return std::string_view(start, remainder);
+    }
+
+    auto length = static_cast<size_t>(newline - start);
+    position_ += length + 1;
+    // Check if we have a windows style line ending (\r\n)
+    if (length != 0 && newline[-1] == '\r') {
+        length -= 1;
+    }
+    return std::string_view(start, length);
+}
+
 std::string_view TextFile::readline() {
+    if (mapped_.data() != nullptr) {
+        return readline_mapped();
+    }
+
     // Initialize buffer if needed
     if (!buffer_initialized()) {
         fill_buffer(0);
@@ -202,14 +306,106 @@ std::string_view TextFile::readline() {
 }
 
 void TextFile::vprint(fmt::string_view format, fmt::format_args args) {
-    std::string buffer;
-    buffer.reserve(128);
-    fmt::vformat_to(std::back_inserter(buffer), format, args);
-    if (buffer.size() == 0) {
+    auto initial = write_buffer_.size();
+    fmt::vformat_to(fmt::appender(write_buffer_), format, args);
+    position_ += write_buffer_.size() - initial;
+    this->flush();
+}
+
+void TextFile::written(size_t count) {
+    position_ += count;
+    if (write_buffer_.size() >= WRITE_BUFFER_SIZE) {
+        this->flush();
+    }
+}
+
+void TextFile::flush() {
+    if (write_buffer_.size() == 0) {
         return;
     }
-    file_->write(buffer.data(), buffer.size());
-    position_ += buffer.size();
+    try {
+        file_->write(write_buffer_.data(), write_buffer_.size());
+    } catch (...) {
+        // do not try to write the same data again later
+        write_buffer_.clear();
+        throw;
+    }
+    write_buffer_.clear();
+}
+
+void TextFile::print_chunks(size_t count, const std::function<void(FormatBuffer&, size_t, size_t)>& function) {
+    auto chunks = (count + PRINT_CHUNK_SIZE - 1) / PRINT_CHUNK_SIZE;
+    auto threads = std::min(pool_ ? pool_->size() : write_threads(), chunks);
+    auto chunk_range = [count](size_t chunk) {
+        auto begin = chunk * PRINT_CHUNK_SIZE;
+        return std::make_pair(begin, std::min(begin + PRINT_CHUNK_SIZE, count));
+    };
+
+    if (threads <= 1) {
+        auto buffer = FormatBuffer();
+        for (size_t chunk = 0; chunk < chunks; chunk++) {
+            auto range = chunk_range(chunk);
+            buffer.buffer_.clear();
+            function(buffer, range.first, range.second);
+            write_buffer_.append(buffer.buffer_);
+            this->written(buffer.buffer_.size());
+        }
+        return;
+    }
+
+    // Chunks are formatted by the thread pool, keeping up to `2 * threads`
+    // chunks in flight, and written to the file in order by the current
+    // thread.
+    auto pool = pool_ ? pool_ : ThreadPool::shared();
+    auto pending = std::deque<std::future<FormatBuffer>>();
+    size_t submitted = 0;
+    auto submit = [&]() {
+        auto range = chunk_range(submitted);
+        pending.emplace_back(pool->submit([&function, range]() {
+            auto buffer = FormatBuffer();
+            auto collect = CollectWarnings(buffer.warnings_);
+            function(buffer, range.first, range.second);
+            return buffer;
+        }));
+        submitted++;
+    };
+
+    this->flush();
+    try {
+        while (submitted < chunks && pending.size() < 2 * threads) {
+            submit();
+        }
+
+        while (!pending.empty()) {
+            auto buffer = pending.front().get();
+            pending.pop_front();
+            if (submitted < chunks) {
+                submit();
+            }
+
+            const auto& data = buffer.buffer_;
+            file_->write(data.data(), data.size());
+            position_ += data.size();
+
+            for (const auto& message: buffer.warnings_) {
+                send_warning(message);
+            }
+        }
+    } catch (...) {
+        // the remaining tasks use `function`, which must stay alive until
+        // they are done
+        for (auto& future: pending) {
+            if (future.valid()) {
+                future.wait();
+            }
+        }
+        throw;
+    }
+}
+
+void TextFile::set_write_threads(size_t threads) {
+    pool_ = std::make_shared<ThreadPool>(threads);
+    file_->set_thread_pool(pool_);
 }
 
 std::string TextFile::readall() {
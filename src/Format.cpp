@@ -9,12 +9,16 @@
 #include <typeinfo>
 
 #include "chemfiles/File.hpp"
+#include "chemfiles/Frame.hpp"
 #include "chemfiles/Format.hpp"
+#include "chemfiles/FormatMetadata.hpp"
+#include "chemfiles/FrameIndex.hpp"
+#include "chemfiles/types.hpp"
 #include "chemfiles/error_fmt.hpp"
+#include "chemfiles/external/span.hpp"
 #include "chemfiles/external/optional.hpp"
 
 namespace chemfiles {
-    class Frame;
     class MemoryBuffer;
 }
 
@@ -65,8 +69,17 @@ void TextFormat::write_next(const Frame& /*unused*/) {
 #pragma GCC diagnostic pop
 #endif
 
+void Format::read_positions_range(size_t start, span<std::vector<Vector3D>> positions, size_t /*unused*/) {
+    for (size_t i = 0; i < positions.size(); i++) {
+        auto frame = Frame();
+        this->read_step(start + i, frame);
+        auto frame_positions = frame.positions();
+        positions[i].assign(frame_positions.begin(), frame_positions.end());
+    }
+}
+
 TextFormat::TextFormat(std::string path, File::Mode mode, File::Compression compression) :
-    file_(std::move(path), mode, compression) {}
+    file_(std::move(path), mode, compression), use_frame_index_(mode == File::READ) {}
 
 TextFormat::TextFormat(std::shared_ptr<MemoryBuffer> memory, File::Mode mode, File::Compression compression) :
     file_(std::move(memory), mode, compression) {}
@@ -76,8 +89,26 @@ void TextFormat::scan_all() {
         return;
     }
 
+    // the index is keyed on the registered name of the format, since the
+    // same file could be read with multiple formats. Formats created outside
+    // of the factory do not have a name, and can not use the index.
+    const auto* metadata = this->registered_metadata();
+    auto use_frame_index = use_frame_index_ && metadata != nullptr;
+    if (use_frame_index) {
+        auto positions = load_frame_index(file_.path(), metadata->name);
+        if (positions) {
+            steps_positions_ = std::move(*positions);
+            eof_found_ = true;
+            if (file_.tellpos() == 0 && !steps_positions_.empty()) {
+                file_.seekpos(steps_positions_[0]);
+            }
+            return;
+        }
+    }
+
     optional<TextFile> tmp_read_file = nullopt;
-    if (file_.mode() == File::Mode::APPEND && file_.compression() == File::Compression::GZIP) {
+    auto gzip = file_.compression() == File::Compression::GZIP || file_.compression() == File::Compression::GZIP_PARALLEL;
+    if (file_.mode() == File::Mode::APPEND && gzip) {
         tmp_read_file = TextFile(file_.path(), File::Mode::READ, file_.compression());
         // `forward()` needs a readable file
         std::swap(*tmp_read_file, file_);
@@ -106,6 +137,10 @@ void TextFormat::scan_all() {
     } else {
         file_.seekpos(before);
     }
+
+    if (use_frame_index) {
+        save_frame_index(file_.path(), metadata->name, steps_positions_);
+    }
 }
 
 void TextFormat::read_step(size_t step, Frame& frame) {
@@ -143,6 +178,9 @@ void TextFormat::read(Frame& frame) {
 
 void TextFormat::write(const Frame& frame) {
     write_next(frame);
+    // make sure the data is available to readers of the file (or memory
+    // buffer) after each step
+    file_.flush();
     steps_positions_.push_back(file_.tellpos());
     ++step_;
 }
@@ -151,3 +189,7 @@ size_t TextFormat::nsteps() {
     scan_all();
     return steps_positions_.size();
 }
+
+void TextFormat::set_write_threads(size_t threads) {
+    file_.set_write_threads(threads);
+}
@@ -1,6 +1,8 @@
 // Chemfiles, a modern library for chemistry file reading and writing
 // Copyright (C) Guillaume Fraux and contributors -- BSD license
 
+#include <mutex>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cmath>
@@ -19,6 +21,7 @@
 #include "chemfiles/Topology.hpp"
 #include "chemfiles/UnitCell.hpp"
 #include "chemfiles/Connectivity.hpp"
+#include "chemfiles/NeighborGrid.hpp"
 
 #include "chemfiles/Frame.hpp"
 
@@ -30,6 +33,14 @@ static optional<double> guess_bonds_radius(const Atom& atom);
 Frame::Frame(UnitCell cell): cell_(std::move(cell)) {} // NOLINT: std::move for trivially copyable type
 
 size_t Frame::size() const {
+    if (storage_ == SOA_FLOAT) {
+        assert(positions_soa_.size() == topology_.size());
+        if (velocities_soa_) {
+            assert(positions_soa_.size() == velocities_soa_->size());
+        }
+        return positions_soa_.size();
+    }
+
     assert(positions_.size() == topology_.size());
     if (velocities_) {
         assert(positions_.size() == velocities_->size());
@@ -37,8 +48,119 @@ size_t Frame::size() const {
     return positions_.size();
 }
 
+void Frame::set_storage(Storage storage) {
+    if (storage == storage_) {
+        return;
+    }
+
+    if (storage == SOA_FLOAT) {
+        positions_soa_ = Vector3DSoA(positions_.size());
+        for (size_t i = 0; i < positions_.size(); i++) {
+            positions_soa_.set(i, positions_[i]);
+        }
+        if (velocities_) {
+            velocities_soa_ = Vector3DSoA(velocities_->size());
+            for (size_t i = 0; i < velocities_->size(); i++) {
+                velocities_soa_->set(i, (*velocities_)[i]);
+            }
+        }
+        positions_ = std::vector<Vector3D>();
+        velocities_ = nullopt;
+    } else if (storage == AOS_DOUBLE) {
+        positions_ = std::vector<Vector3D>(positions_soa_.size());
+        for (size_t i = 0; i < positions_soa_.size(); i++) {
+            positions_[i] = positions_soa_[i];
+        }
+        if (velocities_soa_) {
+            velocities_ = std::vector<Vector3D>(velocities_soa_->size());
+            for (size_t i = 0; i < velocities_soa_->size(); i++) {
+                (*velocities_)[i] = (*velocities_soa_)[i];
+            }
+        }
+        positions_soa_ = Vector3DSoA();
+        velocities_soa_ = nullopt;
+    } else {
+        throw error("invalid storage for frame positions: {}", static_cast<int>(storage));
+    }
+
+    storage_ = storage;
+    double_cache_.positions = std::vector<Vector3D>();
+    double_cache_.velocities = nullopt;
+    double_cache_.valid = false;
+}
+
+void Frame::check_soa_storage() const {
+    if (storage_ != SOA_FLOAT) {
+        throw error("this frame does not store positions as single precision structure of arrays");
+    }
+}
+
+void Frame::update_double_cache() const {
+    auto& cache = double_cache_;
+    if (cache.valid.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    // the cache could be created at the same time by another thread using
+    // the same frame
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (cache.valid.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    cache.positions.resize(positions_soa_.size());
+    for (size_t i = 0; i < positions_soa_.size(); i++) {
+        cache.positions[i] = positions_soa_[i];
+    }
+
+    if (velocities_soa_) {
+        if (!cache.velocities) {
+            cache.velocities = std::vector<Vector3D>();
+        }
+        cache.velocities->resize(velocities_soa_->size());
+        for (size_t i = 0; i < velocities_soa_->size(); i++) {
+            (*cache.velocities)[i] = (*velocities_soa_)[i];
+        }
+    } else {
+        cache.velocities = nullopt;
+    }
+
+    cache.valid.store(true, std::memory_order_release);
+}
+
+void Frame::clear_for_reading(bool keep_topology) {
+    step_ = 0;
+    cell_ = UnitCell();
+    properties_ = property_map();
+
+    velocities_ = nullopt;
+    velocities_soa_ = nullopt;
+    double_cache_.valid = false;
+
+    if (keep_topology) {
+        std::fill(positions_.begin(), positions_.end(), Vector3D());
+        std::fill(positions_soa_.x.begin(), positions_soa_.x.end(), 0.0f);
+        std::fill(positions_soa_.y.begin(), positions_soa_.y.end(), 0.0f);
+        std::fill(positions_soa_.z.begin(), positions_soa_.z.end(), 0.0f);
+    } else {
+        topology_ = Topology();
+        // clearing the vectors keeps their capacity
+        positions_.clear();
+        positions_soa_.resize(0);
+    }
+}
+
 void Frame::resize(size_t size) {
     topology_.resize(size);
+    if (storage_ == SOA_FLOAT) {
+        positions_soa_.resize(size);
+        if (velocities_soa_) {
+            velocities_soa_->resize(size);
+        }
+        double_cache_.valid = false;
+        return;
+    }
+
     positions_.resize(size);
     if (velocities_) {
         velocities_->resize(size);
@@ -47,6 +169,14 @@ void Frame::resize(size_t size) {
 
 void Frame::reserve(size_t size) {
     topology_.reserve(size);
+    if (storage_ == SOA_FLOAT) {
+        positions_soa_.reserve(size);
+        if (velocities_soa_) {
+            velocities_soa_->reserve(size);
+        }
+        return;
+    }
+
     positions_.reserve(size);
     if (velocities_) {
         velocities_->reserve(size);
@@ -54,6 +184,14 @@ void Frame::reserve(size_t size) {
 }
 
 void Frame::add_velocities() {
+    if (storage_ == SOA_FLOAT) {
+        if (!velocities_soa_) {
+            velocities_soa_ = Vector3DSoA(size());
+            double_cache_.valid = false;
+        }
+        return;
+    }
+
     if (!velocities_) {
         velocities_ = std::vector<Vector3D>(size());
     }
@@ -61,64 +199,56 @@ void Frame::add_velocities() {
 
 void Frame::guess_bonds() {
     topology_.clear_bonds();
+    // use const access to the atoms, which do not need to be modified
+    const auto& topology = topology_;
     // This bond guessing algorithm comes from VMD
+    auto radii = std::vector<double>(size());
     auto cutoff = 0.833;
     for (size_t i = 0; i < size(); i++) {
-        auto rad = guess_bonds_radius(topology_[i]).value_or(0);
-        cutoff = std::max(cutoff, rad);
-    }
-    cutoff = 1.2 * cutoff;
-
-    for (size_t i = 0; i < size(); i++) {
-        auto i_radius = guess_bonds_radius(topology_[i]);
-        if (!i_radius) {
+        auto radius = guess_bonds_radius(topology[i]);
+        if (!radius) {
             throw error(
-                "missing Van der Waals radius for '{}'", topology_[i].type()
+                "missing Van der Waals radius for '{}'", topology[i].type()
             );
         }
-        for (size_t j = i + 1; j < size(); j++) {
-            auto j_radius = guess_bonds_radius(topology_[j]);
-            if (!j_radius) {
-                throw error(
-                    "missing Van der Waals radius for '{}'", topology_[j].type()
-                );
-            }
-            auto d = distance(i, j);
-            auto radii = i_radius.value() + j_radius.value();
-            if (0.03 < d && d < 0.6 * radii && d < cutoff) {
-                topology_.add_bond(i, j);
-            }
-        }
+        radii[i] = radius.value();
+        cutoff = std::max(cutoff, radii[i]);
     }
+    cutoff = 1.2 * cutoff;
+
+    auto bonds = std::vector<Bond>();
+    const auto& positions = static_cast<const Frame&>(*this).positions();
+    auto grid = NeighborGrid(cell_, positions, cutoff);
+    grid.foreach_pair([&](size_t i, size_t j, const Vector3D& vector) {
+        auto d = vector.norm();
+        if (0.03 < d && d < 0.6 * (radii[i] + radii[j]) && d < cutoff) {
+            bonds.emplace_back(i, j);
+        }
+    });
 
-    auto bonds = topology().bonds();
-    auto to_remove = std::vector<Bond>();
     // We need to remove bonds between hydrogen atoms which are bonded more than
     // once
-    for (auto& bond : bonds) {
+    auto bonds_count = std::vector<size_t>(size(), 0);
+    for (const auto& bond: bonds) {
+        bonds_count[bond[0]] += 1;
+        bonds_count[bond[1]] += 1;
+    }
+
+    auto is_extra_hydrogen_bond = [&](const Bond& bond) {
         auto i = bond[0];
         auto j = bond[1];
-        if (topology_[i].type() != "H") {
-            continue;
-        }
-        if (topology_[j].type() != "H") {
-            continue;
+        if (topology[i].type() == "H" && topology[j].type() == "H") {
+            // number of bonds involving either i or j
+            auto nbonds = bonds_count[i] + bonds_count[j] - 1;
+            return nbonds != 1;
         }
-
-        auto nbonds = std::count_if(
-            std::begin(bonds), std::end(bonds), [=](const Bond& b) {
-                return b[0] == i || b[0] == j || b[1] == i || b[1] == j;
-            });
-        assert(nbonds >= 1);
-
-        if (nbonds != 1) {
-            to_remove.push_back(bond);
-        }
-    }
-
-    for (auto& bond : to_remove) {
-        topology_.remove_bond(bond[0], bond[1]);
-    }
+        return false;
+    };
+    bonds.erase(
+        std::remove_if(bonds.begin(), bonds.end(), is_extra_hydrogen_bond),
+        bonds.end()
+    );
+    topology_.add_bonds(bonds);
 }
 
 void Frame::set_topology(Topology topology) {
@@ -133,9 +263,17 @@ void Frame::set_topology(Topology topology) {
 
 void Frame::add_atom(Atom atom, Vector3D position, Vector3D velocity) {
     topology_.add_atom(std::move(atom));
-    positions_.push_back(position);
-    if (velocities_) {
-        velocities_->push_back(velocity);
+    if (storage_ == SOA_FLOAT) {
+        positions_soa_.push_back(position);
+        if (velocities_soa_) {
+            velocities_soa_->push_back(velocity);
+        }
+        double_cache_.valid = false;
+    } else {
+        positions_.push_back(position);
+        if (velocities_) {
+            velocities_->push_back(velocity);
+        }
     }
     assert(size() == topology_.size());
 }
@@ -148,10 +286,54 @@ void Frame::remove(size_t i) {
             size(), i
         );
     }
-    topology_.remove(i);
-    positions_.erase(positions_.begin() + static_cast<std::ptrdiff_t>(i));
-    if (velocities_) {
-        velocities_->erase(velocities_->begin() + static_cast<std::ptrdiff_t>(i));
+    this->remove(span<const size_t>(i));
+}
+
+/// Remove all the values marked in `removed` from `values`, keeping the other
+/// values in the same order
+template <typename T>
+static void remove_marked(std::vector<T>& values, const std::vector<bool>& removed) {
+    size_t count = 0;
+    for (size_t i = 0; i < values.size(); i++) {
+        if (!removed[i]) {
+            values[count] = values[i];
+            count++;
+        }
+    }
+    values.resize(count);
+}
+
+static void remove_marked(Vector3DSoA& values, const std::vector<bool>& removed) {
+    remove_marked(values.x, removed);
+    remove_marked(values.y, removed);
+    remove_marked(values.z, removed);
+}
+
+void Frame::remove(span<const size_t> indexes) {
+    auto removed = std::vector<bool>(size(), false);
+    for (auto i: indexes) {
+        if (i >= size()) {
+            throw out_of_bounds(
+                "out of bounds atomic index in `Frame::remove`: we have {} atoms, "
+                "but the index is {}",
+                size(), i
+            );
+        }
+        removed[i] = true;
+    }
+
+    topology_.remove(indexes);
+    if (storage_ == SOA_FLOAT) {
+        remove_marked(positions_soa_, removed);
+        if (velocities_soa_) {
+            remove_marked(*velocities_soa_, removed);
+        }
+        double_cache_.valid = false;
+    } else {
+        remove_marked(positions_, removed);
+        if (velocities_) {
+            remove_marked(*velocities_, removed);
+        }
     }
     assert(size() == topology_.size());
 }
@@ -165,7 +347,7 @@ double Frame::distance(size_t i, size_t j) const {
         );
     }
 
-    auto rij = positions_[i] - positions_[j];
+    auto rij = position(i) - position(j);
     return cell_.wrap(rij).norm();
 }
 
@@ -178,8 +360,8 @@ double Frame::angle(size_t i, size_t j, size_t k) const {
         );
     }
 
-    auto rij = cell_.wrap(positions_[i] - positions_[j]);
-    auto rkj = cell_.wrap(positions_[k] - positions_[j]);
+    auto rij = cell_.wrap(position(i) - position(j));
+    auto rkj = cell_.wrap(position(k) - position(j));
 
     auto cos = dot(rij, rkj) / (rij.norm() * rkj.norm());
     cos = std::max(-1.0, std::min(1.0, cos));
@@ -195,9 +377,9 @@ double Frame::dihedral(size_t i, size_t j, size_t k, size_t m) const {
         );
     }
 
-    auto rij = cell_.wrap(positions_[i] - positions_[j]);
-    auto rjk = cell_.wrap(positions_[j] - positions_[k]);
-    auto rkm = cell_.wrap(positions_[k] - positions_[m]);
+    auto rij = cell_.wrap(position(i) - position(j));
+    auto rjk = cell_.wrap(position(j) - position(k));
+    auto rkm = cell_.wrap(position(k) - position(m));
 
     auto a = cross(rij, rjk);
     auto b = cross(rjk, rkm);
@@ -213,9 +395,9 @@ double Frame::out_of_plane(size_t i, size_t j, size_t k, size_t m) const {
         );
     }
 
-    auto rji = cell_.wrap(positions_[j] - positions_[i]);
-    auto rik = cell_.wrap(positions_[i] - positions_[k]);
-    auto rim = cell_.wrap(positions_[i] - positions_[m]);
+    auto rji = cell_.wrap(position(j) - position(i));
+    auto rik = cell_.wrap(position(i) - position(k));
+    auto rim = cell_.wrap(position(i) - position(m));
 
     auto n = cross(rik, rim);
     auto n_norm = n.norm();
@@ -0,0 +1,210 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <system_error>
+
+#include "chemfiles/misc.hpp"
+#include "chemfiles/FrameIndex.hpp"
+#include "chemfiles/external/optional.hpp"
+
+using namespace chemfiles;
+namespace fs = std::filesystem;
+
+/// Magic bytes at the start of all frame index files, including a version
+/// number for the file layout
+static const std::array<char, 8> FRAME_INDEX_MAGIC = {{'C', 'H', 'F', 'L', 'I', 'D', 'X', '\x01'}};
+/// Number of bytes at the start of the trajectory file included in the
+/// trajectory fingerprint
+static constexpr size_t FINGERPRINT_SIZE = 4096;
+
+static std::atomic<bool> FRAME_INDEX_FILES_ENABLED(false);
+
+void chemfiles::set_frame_index_files(bool enabled) {
+    FRAME_INDEX_FILES_ENABLED = enabled;
+}
+
+bool chemfiles::frame_index_files_enabled() {
+    return FRAME_INDEX_FILES_ENABLED;
+}
+
+std::string chemfiles::frame_index_path(const std::string& path) {
+    return path + ".chfl-idx";
+}
+
+/// 64-bit FNV-1a hash, used both for the trajectory fingerprint and the
+/// checksum of the index file
+static uint64_t fnv1a(const std::vector<char>& data) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (auto byte: data) {
+        hash ^= static_cast<uint8_t>(byte);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+namespace {
+/// Data used to check that an index file matches the trajectory file
+struct TrajectoryFingerprint {
+    /// size of the trajectory file in bytes
+    uint64_t size;
+    /// last modification time of the trajectory file
+    int64_t mtime;
+    /// hash of the first `FINGERPRINT_SIZE` bytes of the trajectory file
+    uint64_t hash;
+};
+}
+
+static optional<TrajectoryFingerprint> fingerprint(const std::string& path) {
+    auto error = std::error_code();
+    auto size = fs::file_size(path, error);
+    if (error) {
+        return nullopt;
+    }
+
+    auto mtime = fs::last_write_time(path, error);
+    if (error) {
+        return nullopt;
+    }
+
+    auto file = std::ifstream(path, std::ios::binary);
+    if (!file) {
+        return nullopt;
+    }
+    auto start = std::vector<char>(FINGERPRINT_SIZE);
+    file.read(start.data(), static_cast<std::streamsize>(start.size()));
+    start.resize(static_cast<size_t>(file.gcount()));
+
+    return TrajectoryFingerprint{
+        static_cast<uint64_t>(size),
+        static_cast<int64_t>(mtime.time_since_epoch().count()),
+        fnv1a(start),
+    };
+}
+
+/// Append `value` to `buffer` in little-endian order
+static void push_u64(std::vector<char>& buffer, uint64_t value) {
+    for (size_t i = 0; i < 8; i++) {
+        buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+/// Read a little-endian `uint64_t` from `buffer` at `position`, and advance
+/// the position. Returns `nullopt` if there is not enough data left.
+static optional<uint64_t> read_u64(const std::vector<char>& buffer, size_t& position) {
+    if (buffer.size() < 8 || position > buffer.size() - 8) {
+        return nullopt;
+    }
+    uint64_t value = 0;
+    for (size_t i = 0; i < 8; i++) {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(buffer[position + i])) << (8 * i);
+    }
+    position += 8;
+    return value;
+}
+
+/// Create the header of an index file, containing everything but the offsets
+static std::vector<char> index_header(const TrajectoryFingerprint& fingerprint, const std::string& format) {
+    auto buffer = std::vector<char>(FRAME_INDEX_MAGIC.begin(), FRAME_INDEX_MAGIC.end());
+    push_u64(buffer, fingerprint.size);
+    push_u64(buffer, static_cast<uint64_t>(fingerprint.mtime));
+    push_u64(buffer, fingerprint.hash);
+    push_u64(buffer, format.size());
+    buffer.insert(buffer.end(), format.begin(), format.end());
+    return buffer;
+}
+
+optional<std::vector<uint64_t>> chemfiles::load_frame_index(const std::string& path, const std::string& format) {
+    if (!frame_index_files_enabled() || path.empty()) {
+        return nullopt;
+    }
+
+    auto file = std::ifstream(frame_index_path(path), std::ios::binary);
+    if (!file) {
+        return nullopt;
+    }
+    auto content = std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    auto current = fingerprint(path);
+    if (!current) {
+        return nullopt;
+    }
+
+    // the header must match exactly the one we would write now
+    auto header = index_header(*current, format);
+    if (content.size() < header.size() || std::memcmp(content.data(), header.data(), header.size()) != 0) {
+        return nullopt;
+    }
+
+    // the checksum covers everything before it
+    if (content.size() < header.size() + 16) {
+        return nullopt;
+    }
+    auto checksum_position = content.size() - 8;
+    auto checksum = read_u64(content, checksum_position);
+    content.resize(content.size() - 8);
+    if (!checksum || *checksum != fnv1a(content)) {
+        return nullopt;
+    }
+
+    auto position = header.size();
+    auto count = read_u64(content, position);
+    if (!count || *count != (content.size() - position) / 8 || (content.size() - position) % 8 != 0) {
+        return nullopt;
+    }
+
+    auto offsets = std::vector<uint64_t>();
+    offsets.reserve(static_cast<size_t>(*count));
+    for (uint64_t i = 0; i < *count; i++) {
+        offsets.push_back(*read_u64(content, position));
+    }
+    return offsets;
+}
+
+void chemfiles::save_frame_index(const std::string& path, const std::string& format, const std::vector<uint64_t>& offsets) {
+    if (!frame_index_files_enabled() || path.empty()) {
+        return;
+    }
+
+    auto current = fingerprint(path);
+    if (!current) {
+        return;
+    }
+
+    auto content = index_header(*current, format);
+    push_u64(content, offsets.size());
+    for (auto offset: offsets) {
+        push_u64(content, offset);
+    }
+    push_u64(content, fnv1a(content));
+
+    // write to a temporary file first, so that other processes never see a
+    // partially written index file
+    auto index_path = frame_index_path(path);
+    auto tmp_path = index_path + ".tmp";
+    {
+        auto file = std::ofstream(tmp_path, std::ios::binary | std::ios::trunc);
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+        if (!file) {
+            // writing the index file is an optimization, and failures are
+            // expected e.g. for trajectories in read-only directories
+            auto error = std::error_code();
+            fs::remove(tmp_path, error);
+            return;
+        }
+    }
+
+    auto error = std::error_code();
+    fs::rename(tmp_path, index_path, error);
+    if (error) {
+        fs::remove(tmp_path, error);
+    }
+}
@@ -0,0 +1,145 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <cassert>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <condition_variable>
+
+#include "chemfiles/Format.hpp"
+#include "chemfiles/Frame.hpp"
+#include "chemfiles/FramePrefetcher.hpp"
+
+using namespace chemfiles;
+
+#define SENTINEL_VALUE (static_cast<size_t>(-1))
+
+FramePrefetcher::FramePrefetcher(const format_opener_t& open, size_t nsteps, size_t frames, size_t threads):
+    nsteps_(nsteps), slots_(frames)
+{
+    assert(frames > 0 && threads > 0);
+    for (size_t i = 0; i < threads; i++) {
+        formats_.emplace_back(open());
+    }
+
+    try {
+        for (auto& format: formats_) {
+            auto* format_ptr = format.get();
+            workers_.emplace_back([this, format_ptr]() {
+                this->worker(*format_ptr);
+            });
+        }
+    } catch (...) {
+        // the destructor will not run, stop the already started threads
+        this->stop();
+        throw;
+    }
+}
+
+FramePrefetcher::~FramePrefetcher() {
+    this->stop();
+}
+
+void FramePrefetcher::stop() {
+    {
+        auto lock = std::unique_lock<std::mutex>(mutex_);
+        stop_ = true;
+    }
+    work_available_.notify_all();
+    for (auto& worker: workers_) {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+void FramePrefetcher::worker(Format& format) {
+    auto lock = std::unique_lock<std::mutex>(mutex_);
+    while (true) {
+        work_available_.wait(lock, [this]() {
+            return stop_ || (dispatch_ < nsteps_ && dispatch_ < next_ + slots_.size());
+        });
+        if (stop_) {
+            return;
+        }
+
+        auto step = dispatch_;
+        auto generation = generation_;
+        dispatch_++;
+        auto frame = Frame();
+        if (!spares_.empty()) {
+            frame = std::move(spares_.back());
+            spares_.pop_back();
+        }
+        lock.unlock();
+
+        auto error = std::exception_ptr();
+        try {
+            frame.clear_for_reading(false);
+            frame.set_step(SENTINEL_VALUE);
+            format.read_step(step, frame);
+            // Don't override the step set by a format
+            if (frame.step() == SENTINEL_VALUE) {
+                frame.set_step(step);
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        if (generation == generation_) {
+            auto& slot = slots_[step % slots_.size()];
+            slot.frame = std::move(frame);
+            slot.error = std::move(error);
+            slot.ready = true;
+            frame_ready_.notify_all();
+        }
+    }
+}
+
+void FramePrefetcher::restart(size_t step) {
+    generation_++;
+    next_ = step;
+    dispatch_ = step;
+    for (auto& slot: slots_) {
+        slot.ready = false;
+        slot.frame = Frame();
+        slot.error = nullptr;
+    }
+}
+
+void FramePrefetcher::get(size_t step, Frame& frame) {
+    auto lock = std::unique_lock<std::mutex>(mutex_);
+    if (step != next_) {
+        restart(step);
+        work_available_.notify_all();
+    }
+
+    auto& slot = slots_[step % slots_.size()];
+    frame_ready_.wait(lock, [&slot]() {
+        return slot.ready;
+    });
+    slot.ready = false;
+
+    if (slot.error) {
+        auto error = std::move(slot.error);
+        // try to read this step again on the next call
+        restart(step);
+        lock.unlock();
+        work_available_.notify_all();
+        std::rethrow_exception(error);
+    }
+
+    std::swap(frame, slot.frame);
+    spares_.emplace_back(std::move(slot.frame));
+    slot.frame = Frame();
+    next_ = step + 1;
+    lock.unlock();
+
+    // a slot is now free for the workers
+    work_available_.notify_all();
+}
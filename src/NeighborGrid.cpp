@@ -0,0 +1,219 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <cmath>
+#include <array>
+#include <limits>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+#include "chemfiles/types.hpp"
+#include "chemfiles/error_fmt.hpp"
+#include "chemfiles/external/span.hpp"
+
+#include "chemfiles/UnitCell.hpp"
+#include "chemfiles/NeighborGrid.hpp"
+
+using namespace chemfiles;
+
+/// Get the index of the grid cell containing the fractional coordinate `x`,
+/// for a grid with `n` cells along this dimension.
+static size_t cell_index(double x, size_t n) {
+    auto index = std::floor(x * static_cast<double>(n));
+    // this also handles NaN values, putting them in the first cell
+    if (!(index >= 0.0)) {
+        return 0;
+    } else if (index >= static_cast<double>(n)) {
+        return n - 1;
+    } else {
+        return static_cast<size_t>(index);
+    }
+}
+
+NeighborGrid::NeighborGrid(const UnitCell& cell, span<const Vector3D> positions, double cutoff):
+    shape_(cell.shape()),
+    lengths_(cell.lengths()),
+    matrix_(cell.matrix()),
+    inverse_(Matrix3D::unit()),
+    cutoff_(cutoff)
+{
+    if (!(cutoff > 0.0) || !std::isfinite(cutoff)) {
+        throw error("the cutoff for neighbor search must be a positive number, got {}", cutoff);
+    }
+
+    auto n_points = positions.size();
+    auto fractional = std::vector<Vector3D>(n_points);
+    auto widths = Vector3D();
+
+    periodic_ = shape_ != UnitCell::INFINITE && !private_details::is_roughly_zero(cell.volume());
+    if (periodic_) {
+        // use fractional coordinates inside the cell, wrapped to [0, 1)
+        inverse_ = matrix_.invert();
+        for (size_t i = 0; i < n_points; i++) {
+            auto s = inverse_ * positions[i];
+            s[0] -= std::floor(s[0]);
+            s[1] -= std::floor(s[1]);
+            s[2] -= std::floor(s[2]);
+            fractional[i] = s;
+        }
+
+        // distance between the two opposite faces of the cell along each
+        // direction, i.e. the volume divided by the area of the face
+        auto a = Vector3D(matrix_[0][0], matrix_[1][0], matrix_[2][0]);
+        auto b = Vector3D(matrix_[0][1], matrix_[1][1], matrix_[2][1]);
+        auto c = Vector3D(matrix_[0][2], matrix_[1][2], matrix_[2][2]);
+        auto volume = cell.volume();
+        widths[0] = volume / cross(b, c).norm();
+        widths[1] = volume / cross(c, a).norm();
+        widths[2] = volume / cross(a, b).norm();
+    } else {
+        // use the bounding box of the points
+        auto min = Vector3D(
+            std::numeric_limits<double>::max(),
+            std::numeric_limits<double>::max(),
+            std::numeric_limits<double>::max()
+        );
+        auto max = -min;
+        for (const auto& position: positions) {
+            for (size_t k = 0; k < 3; k++) {
+                if (std::isfinite(position[k])) {
+                    min[k] = std::min(min[k], position[k]);
+                    max[k] = std::max(max[k], position[k]);
+                }
+            }
+        }
+
+        for (size_t k = 0; k < 3; k++) {
+            widths[k] = max[k] > min[k] ? max[k] - min[k] : 0.0;
+        }
+
+        for (size_t i = 0; i < n_points; i++) {
+            for (size_t k = 0; k < 3; k++) {
+                if (widths[k] != 0.0) {
+                    fractional[i][k] = (positions[i][k] - min[k]) / widths[k];
+                } else {
+                    fractional[i][k] = 0.0;
+                }
+            }
+        }
+    }
+
+    // Each cell must be at least as large as the cutoff, and we limit the
+    // total number of cells to keep the memory usage proportional to the
+    // number of points for sparse systems.
+    auto n_cells = std::array<double, 3>();
+    for (size_t k = 0; k < 3; k++) {
+        n_cells[k] = std::max(1.0, std::floor(widths[k] / cutoff_));
+    }
+
+    auto max_cells = std::max(27.0, 2.0 * static_cast<double>(n_points));
+    auto total = n_cells[0] * n_cells[1] * n_cells[2];
+    while (total > max_cells) {
+        auto factor = std::cbrt(total / max_cells);
+        for (size_t k = 0; k < 3; k++) {
+            n_cells[k] = std::max(1.0, std::floor(n_cells[k] / factor));
+        }
+
+        auto new_total = n_cells[0] * n_cells[1] * n_cells[2];
+        if (new_total == total) {
+            // make sure we always progress
+            auto largest = std::max_element(n_cells.begin(), n_cells.end());
+            *largest = std::max(1.0, *largest - 1.0);
+            new_total = n_cells[0] * n_cells[1] * n_cells[2];
+        }
+        total = new_total;
+    }
+
+    for (size_t k = 0; k < 3; k++) {
+        n_cells_[k] = static_cast<size_t>(n_cells[k]);
+    }
+
+    // sort the points by cells, using a counting sort
+    cell_of_point_.resize(n_points);
+    offsets_.assign(n_cells_[0] * n_cells_[1] * n_cells_[2] + 1, 0);
+    for (size_t i = 0; i < n_points; i++) {
+        auto cell_id = linear_index(
+            cell_index(fractional[i][0], n_cells_[0]),
+            cell_index(fractional[i][1], n_cells_[1]),
+            cell_index(fractional[i][2], n_cells_[2])
+        );
+        cell_of_point_[i] = cell_id;
+        offsets_[cell_id + 1] += 1;
+    }
+
+    for (size_t cell_id = 1; cell_id < offsets_.size(); cell_id++) {
+        offsets_[cell_id] += offsets_[cell_id - 1];
+    }
+
+    auto next = std::vector<size_t>(offsets_.begin(), offsets_.end() - 1);
+    points_.resize(n_points);
+    positions_.resize(n_points);
+    sorted_index_.resize(n_points);
+    for (size_t i = 0; i < n_points; i++) {
+        auto sorted = next[cell_of_point_[i]]++;
+        points_[sorted] = i;
+        positions_[sorted] = positions[i];
+        sorted_index_[i] = sorted;
+    }
+}
+
+size_t NeighborGrid::neighbor_cells(size_t a, size_t b, size_t c, std::array<size_t, 27>& neighbors) const {
+    // list the distinct neighboring indexes along each dimension. For periodic
+    // grids with less than 3 cells, the same cell can be reached multiple times
+    // and must only be counted once.
+    auto indexes = std::array<std::array<size_t, 3>, 3>();
+    auto counts = std::array<size_t, 3>{{0, 0, 0}};
+    auto current = std::array<size_t, 3>{{a, b, c}};
+    for (size_t k = 0; k < 3; k++) {
+        auto n = n_cells_[k];
+        auto x = current[k];
+        auto& count = counts[k];
+
+        indexes[k][count++] = x;
+        if (periodic_) {
+            if (n >= 2) {
+                indexes[k][count++] = (x + 1) % n;
+            }
+            if (n >= 3) {
+                indexes[k][count++] = (x + n - 1) % n;
+            }
+        } else {
+            if (x + 1 < n) {
+                indexes[k][count++] = x + 1;
+            }
+            if (x > 0) {
+                indexes[k][count++] = x - 1;
+            }
+        }
+    }
+
+    size_t n_neighbors = 0;
+    for (size_t i = 0; i < counts[0]; i++) {
+        for (size_t j = 0; j < counts[1]; j++) {
+            for (size_t k = 0; k < counts[2]; k++) {
+                neighbors[n_neighbors++] = linear_index(indexes[0][i], indexes[1][j], indexes[2][k]);
+            }
+        }
+    }
+    return n_neighbors;
+}
+
+void NeighborGrid::check_point(size_t point) const {
+    if (point >= cell_of_point_.size()) {
+        throw out_of_bounds(
+            "out of bounds point index in `NeighborGrid::foreach_neighbor`: "
+            "we have {} points, but the index is {}",
+            cell_of_point_.size(), point
+        );
+    }
+}
+
+std::vector<std::array<size_t, 2>> NeighborGrid::pairs() const {
+    auto result = std::vector<std::array<size_t, 2>>();
+    this->foreach_pair([&](size_t i, size_t j, const Vector3D&) {
+        result.push_back({{i, j}});
+    });
+    std::sort(result.begin(), result.end());
+    return result;
+}
@@ -0,0 +1,121 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <cmath>
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+#include "chemfiles/types.hpp"
+#include "chemfiles/error_fmt.hpp"
+#include "chemfiles/unreachable.hpp"
+
+#include "chemfiles/Frame.hpp"
+#include "chemfiles/UnitCell.hpp"
+#include "chemfiles/NeighborGrid.hpp"
+#include "chemfiles/NeighborList.hpp"
+
+using namespace chemfiles;
+
+/// Compute the pairs closer than `cutoff` in `candidates`, using `wrap` to
+/// apply the minimum image convention. The cell shape dispatch happens once,
+/// outside of the loop over pairs.
+template <class Wrap>
+static void compute_pairs(
+    const std::vector<std::array<size_t, 2>>& candidates,
+    const std::vector<Vector3D>& positions,
+    double cutoff,
+    std::vector<NeighborPair>& pairs,
+    Wrap wrap
+) {
+    pairs.clear();
+    auto cutoff2 = cutoff * cutoff;
+    for (const auto& candidate: candidates) {
+        auto i = candidate[0];
+        auto j = candidate[1];
+        auto vector = wrap(positions[j] - positions[i]);
+        auto distance2 = dot(vector, vector);
+        if (distance2 < cutoff2) {
+            pairs.push_back({i, j, std::sqrt(distance2), vector});
+        }
+    }
+}
+
+NeighborList::NeighborList(const Frame& frame, double cutoff, double skin): cutoff_(cutoff), skin_(skin) {
+    if (!(cutoff > 0.0) || !std::isfinite(cutoff)) {
+        throw error("the cutoff for neighbor search must be a positive number, got {}", cutoff);
+    }
+
+    if (!(skin >= 0.0) || !std::isfinite(skin)) {
+        throw error("the skin for neighbor list must be a positive number or zero, got {}", skin);
+    }
+
+    this->search(frame);
+    this->refresh(frame);
+}
+
+void NeighborList::update(const Frame& frame) {
+    const auto& positions = frame.positions();
+    auto needs_search = positions.size() != reference_.size() || frame.cell() != cell_;
+
+    if (!needs_search) {
+        // check if any atom moved by more than half of the skin
+        auto max_displacement2 = 0.25 * skin_ * skin_;
+        for (size_t i = 0; i < positions.size(); i++) {
+            auto displacement = cell_.wrap(positions[i] - reference_[i]);
+            if (!(dot(displacement, displacement) <= max_displacement2)) {
+                needs_search = true;
+                break;
+            }
+        }
+    }
+
+    if (needs_search) {
+        this->search(frame);
+    }
+    this->refresh(frame);
+}
+
+void NeighborList::search(const Frame& frame) {
+    cell_ = frame.cell();
+    reference_ = frame.positions();
+
+    candidates_.clear();
+    auto grid = NeighborGrid(cell_, reference_, cutoff_ + skin_);
+    grid.foreach_pair([&](size_t i, size_t j, const Vector3D&) {
+        candidates_.push_back({{i, j}});
+    });
+    std::sort(candidates_.begin(), candidates_.end());
+
+    searches_ += 1;
+}
+
+void NeighborList::refresh(const Frame& frame) {
+    const auto& positions = frame.positions();
+    switch (cell_.shape()) {
+    case UnitCell::INFINITE:
+        compute_pairs(candidates_, positions, cutoff_, pairs_, [](const Vector3D& vector) {
+            return vector;
+        });
+        break;
+    case UnitCell::ORTHORHOMBIC: {
+        auto lengths = cell_.lengths();
+        compute_pairs(candidates_, positions, cutoff_, pairs_, [&](const Vector3D& vector) {
+            return Vector3D(
+                vector[0] - std::round(vector[0] / lengths[0]) * lengths[0],
+                vector[1] - std::round(vector[1] / lengths[1]) * lengths[1],
+                vector[2] - std::round(vector[2] / lengths[2]) * lengths[2]
+            );
+        });
+        break;
+    }
+    case UnitCell::TRICLINIC:
+        compute_pairs(candidates_, positions, cutoff_, pairs_, [&](const Vector3D& vector) {
+            return cell_.wrap(vector);
+        });
+        break;
+    default:
+        unreachable();
+    }
+}
@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <string>
+#include <vector>
 #include <utility>
 
 #include "chemfiles/Residue.hpp"
@@ -24,19 +25,17 @@ bool Residue::contains(size_t i) const {
     return atoms_.find(i) != atoms_.end();
 }
 
-void Residue::remove(size_t i) {
-    auto iter = atoms_.find(i);
-    if (iter == atoms_.end()) {
-        // we should only remove an atom if we know it exists in the residue
-        throw error("invalid call to Residue::remove, this is a bug");
-    }
-    atoms_.erase(iter);
-}
-
-void Residue::atom_removed(size_t i) {
-    for (auto& atom: atoms_.as_mutable_vec()) {
-        if (atom > i) {
-            atom -= 1;
+void Residue::atoms_removed(const std::vector<size_t>& new_indexes, size_t removed) {
+    // the new indexes are sorted in the same order as the old ones, so we can
+    // update them in place
+    auto& atoms = atoms_.as_mutable_vec();
+    size_t count = 0;
+    for (auto atom: atoms) {
+        if (atom >= new_indexes.size()) {
+            atoms[count++] = atom - removed;
+        } else if (new_indexes[atom] != SIZE_MAX) {
+            atoms[count++] = new_indexes[atom];
         }
     }
+    atoms.resize(count);
 }
@@ -1,20 +1,31 @@
 // Chemfiles, a modern library for chemistry file reading and writing
 // Copyright (C) Guillaume Fraux and contributors -- BSD license
 
+#include <cmath>
+#include <array>
+#include <list>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
+#include <unordered_map>
+#include <numeric>
+#include <algorithm>
 
 #include "chemfiles/Frame.hpp"
 #include "chemfiles/Selection.hpp"
 #include "chemfiles/Connectivity.hpp"
 #include "chemfiles/Topology.hpp"
+#include "chemfiles/NeighborGrid.hpp"
 
 #include "chemfiles/utils.hpp"
+#include "chemfiles/mutex.hpp"
 #include "chemfiles/error_fmt.hpp"
 #include "chemfiles/unreachable.hpp"
+#include "chemfiles/external/optional.hpp"
 
 #include "chemfiles/selections/lexer.hpp"
 #include "chemfiles/selections/parser.hpp"
@@ -81,22 +92,141 @@ Selection::~Selection() = default;
 Selection::Selection(Selection&&) noexcept = default;
 Selection& Selection::operator=(Selection&&) noexcept = default;
 
-Selection::Selection(std::string selection): selection_(std::move(selection)), ast_(nullptr) {
+namespace {
+/// A selection after parsing and optimization
+struct CompiledSelection {
+    Context context;
+    std::shared_ptr<const selections::Selector> ast;
+};
+
+/// Cache of compiled selections, keeping the most recently used ones
+class SelectionCache {
+public:
+    /// Get the compiled selection for `selection`, if it is in the cache
+    optional<CompiledSelection> get(const std::string& selection) {
+        auto it = index_.find(selection);
+        if (it == index_.end()) {
+            misses_ += 1;
+            return nullopt;
+        }
+        hits_ += 1;
+        // mark this entry as the most recently used one
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->second;
+    }
+
+    /// Add a compiled selection to the cache
+    void insert(const std::string& selection, CompiledSelection compiled) {
+        if (capacity_ == 0 || index_.find(selection) != index_.end()) {
+            return;
+        }
+        entries_.emplace_front(selection, std::move(compiled));
+        index_.emplace(selection, entries_.begin());
+        this->shrink();
+    }
+
+    void set_capacity(size_t capacity) {
+        capacity_ = capacity;
+        this->shrink();
+    }
+
+    void clear() {
+        entries_.clear();
+        index_.clear();
+        hits_ = 0;
+        misses_ = 0;
+    }
+
+    SelectionCacheStats stats() const {
+        return {hits_, misses_, entries_.size(), capacity_};
+    }
+
+private:
+    using entries_t = std::list<std::pair<std::string, CompiledSelection>>;
+
+    /// Remove the least recently used entries until the cache fits in the
+    /// capacity
+    void shrink() {
+        while (entries_.size() > capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+    }
+
+    /// Maximal number of entries
+    size_t capacity_ = 128;
+    /// Entries in the cache, the most recently used first
+    entries_t entries_;
+    /// Position of the entries in `entries_`, indexed by selection string
+    std::unordered_map<std::string, entries_t::iterator> index_;
+    /// Statistics
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
+}
+
+static mutex<SelectionCache>& selection_cache() {
+    static mutex<SelectionCache> cache;
+    return cache;
+}
+
+/// Parse and optimize the given `selection` string, storing the selection
+/// context in `context`
+static selections::Ast compile(const std::string& selection, Context& context) {
     std::string selection_string;
-    context_ = get_context(selection_, selection_string);
+    context = get_context(selection, selection_string);
     auto tokens = selections::Tokenizer(selection_string).tokenize();
     for (auto& token: tokens) {
         if (token.type() == selections::Token::VARIABLE) {
-            if (token.variable() > max_variable(context_)) {
+            if (token.variable() > max_variable(context)) {
                 throw selection_error(
                     "variable index {} is too big for the current context (should be <= {})",
-                    token.variable() + 1, max_variable(context_) + 1
+                    token.variable() + 1, max_variable(context) + 1
                 );
             }
         }
     }
-    ast_ = selections::Parser(tokens).parse();
-    ast_->optimize();
+    auto ast = selections::Parser(tokens).parse();
+    ast->optimize();
+    return ast;
+}
+
+Selection::Selection(std::string selection): selection_(std::move(selection)), ast_(nullptr) {
+    auto compiled = selection_cache().lock()->get(selection_);
+    if (compiled) {
+        context_ = compiled->context;
+        // each selection needs its own copy of the AST, since the AST
+        // stores cached data during evaluation
+        ast_ = compiled->ast->clone();
+    } else {
+        ast_ = compile(selection_, context_);
+        // cloning can create new selections for sub-selections, so it must
+        // happen before locking the cache
+        auto cached = CompiledSelection{context_, ast_->clone()};
+        selection_cache().lock()->insert(selection_, std::move(cached));
+    }
+    topology_only_ = ast_->topology_only();
+}
+
+Selection Selection::clone() const {
+    auto copy = Selection();
+    copy.selection_ = selection_;
+    copy.context_ = context_;
+    copy.ast_ = ast_->clone();
+    copy.topology_only_ = topology_only_;
+    return copy;
+}
+
+SelectionCacheStats Selection::cache_stats() {
+    return selection_cache().lock()->stats();
+}
+
+void Selection::set_cache_capacity(size_t capacity) {
+    selection_cache().lock()->set_capacity(capacity);
+}
+
+void Selection::clear_cache() {
+    selection_cache().lock()->clear();
 }
 
 size_t Selection::size() const {
@@ -129,19 +259,22 @@ std::vector<size_t> Selection::list(const Frame& frame) const {
     return res;
 }
 
-// Using a template to prevent putting the `is_match` function behind a pointer
-template <typename match_checker>
-std::vector<Match> evaluate_atoms(const Frame& frame, match_checker is_match) {
+/// Evaluate a selection in the `atoms` context, using the vectorized
+/// evaluation of the AST on all the atoms at once
+static std::vector<Match> evaluate_atoms(const Frame& frame, const selections::Selector& ast) {
+    auto atoms = std::vector<size_t>(frame.size());
+    std::iota(atoms.begin(), atoms.end(), 0);
+    ast.filter(frame, atoms);
+
     auto matches = std::vector<Match>();
-    for (size_t i=0; i<frame.size(); i++) {
-        auto match = Match(i);
-        if (is_match(frame, match)) {
-            matches.emplace_back(match);
-        }
+    matches.reserve(atoms.size());
+    for (auto i: atoms) {
+        matches.emplace_back(i);
     }
     return matches;
 }
 
+// Using a template to prevent putting the `is_match` function behind a pointer
 template <typename match_checker>
 std::vector<Match> evaluate_pairs(const Frame& frame, match_checker is_match) {
     auto matches = std::vector<Match>();
@@ -256,15 +389,183 @@ std::vector<Match> evaluate_dihedrals(const Frame& frame, match_checker is_match
     return matches;
 }
 
+/// Add a small tolerance to a distance `bound`, to make sure rounding errors
+/// in the neighbor search never remove a valid candidate. The exact comparison
+/// is still performed by the selection AST.
+static double with_tolerance(double bound) {
+    return bound + 1e-9 * std::max(1.0, bound);
+}
+
+/// Search for matches satisfying some distance bounds. Each atom in the
+/// match is taken from the neighbors of a previous atom in the match when
+/// the distance between the two is bounded, and from all atoms otherwise.
+class BoundedSearch {
+public:
+    BoundedSearch(const Frame& frame, const selections::DistanceBounds& bounds, size_t size): size_(size) {
+        auto cutoff = 0.0;
+        for (size_t i = 1; i < size_; i++) {
+            reference_[i] = NONE;
+            bound_[i] = std::numeric_limits<double>::infinity();
+            for (size_t j = 0; j < i; j++) {
+                auto bound = bounds.get(static_cast<selections::Variable>(j), static_cast<selections::Variable>(i));
+                if (bound < 0) {
+                    // no match can satisfy this bound
+                    impossible_ = true;
+                    return;
+                }
+
+                bound = with_tolerance(bound);
+                if (bound < bound_[i]) {
+                    bound_[i] = bound;
+                    reference_[i] = j;
+                }
+            }
+
+            if (reference_[i] != NONE) {
+                cutoff = std::max(cutoff, bound_[i]);
+            }
+        }
+
+        // the neighbors of each atom are found when visiting it, which only
+        // requires memory for the grid itself
+        grid_ = NeighborGrid(frame.cell(), frame.positions(), cutoff);
+    }
+
+    /// Call `is_match` on all the candidate matches, and collect the ones
+    /// which are selected. The matches are visited in lexicographic order.
+    template <typename match_checker>
+    std::vector<Match> evaluate(const Frame& frame, match_checker is_match) const {
+        auto matches = std::vector<Match>();
+        if (!impossible_) {
+            auto current = std::array<size_t, 4>();
+            auto candidates = std::array<std::vector<size_t>, 4>();
+            visit(frame, is_match, current, candidates, 0, matches);
+        }
+        return matches;
+    }
+
+private:
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+
+    template <typename match_checker>
+    void visit(const Frame& frame, match_checker& is_match, std::array<size_t, 4>& current, std::array<std::vector<size_t>, 4>& candidates, size_t depth, std::vector<Match>& matches) const {
+        auto candidate = [&](size_t atom) {
+            for (size_t i = 0; i < depth; i++) {
+                if (current[i] == atom) {
+                    return;
+                }
+            }
+            current[depth] = atom;
+
+            if (depth + 1 < size_) {
+                visit(frame, is_match, current, candidates, depth + 1, matches);
+                return;
+            }
+
+            auto match = Match();
+            switch (size_) {
+            case 2:
+                match = Match(current[0], current[1]);
+                break;
+            case 3:
+                match = Match(current[0], current[1], current[2]);
+                break;
+            case 4:
+                match = Match(current[0], current[1], current[2], current[3]);
+                break;
+            default:
+                unreachable();
+            }
+
+            if (is_match(frame, match)) {
+                matches.emplace_back(match);
+            }
+        };
+
+        auto reference = depth == 0 ? NONE : reference_[depth];
+        if (reference == NONE) {
+            for (size_t atom = 0; atom < frame.size(); atom++) {
+                candidate(atom);
+            }
+        } else {
+            // neighbors are found in an unspecified order, and sorted to
+            // visit the matches in lexicographic order. Each depth uses its
+            // own vector, since deeper levels are visited inside the loop.
+            auto& neighbors = candidates[depth];
+            neighbors.clear();
+            auto bound = bound_[depth];
+            grid_->foreach_neighbor(current[reference], [&](size_t atom, const Vector3D& vector) {
+                if (vector.norm() <= bound) {
+                    neighbors.push_back(atom);
+                }
+            });
+            std::sort(neighbors.begin(), neighbors.end());
+            for (auto atom: neighbors) {
+                candidate(atom);
+            }
+        }
+    }
+
+    /// Number of atoms in the matches
+    size_t size_;
+    /// Is there any bound impossible to satisfy?
+    bool impossible_ = false;
+    /// For each atom in the match, index of the previous atom in the match
+    /// with the tightest distance bound, or NONE
+    std::array<size_t, 4> reference_ = {{NONE, NONE, NONE, NONE}};
+    /// Bounds on the distance to the reference atom, including tolerance
+    std::array<double, 4> bound_ = {{0, 0, 0, 0}};
+    /// Grid used to find the neighbors of the reference atoms
+    optional<NeighborGrid> grid_;
+};
+
+/// Check if there is at least one bounded distance between the first `size`
+/// atoms of the matches
+static bool has_bounds(const selections::DistanceBounds& bounds, size_t size) {
+    for (selections::Variable i = 0; i < size; i++) {
+        for (selections::Variable j = 0; j < i; j++) {
+            if (!std::isinf(bounds.get(i, j)) || bounds.get(i, j) < 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 std::vector<Match> Selection::evaluate(const Frame& frame) const {
+    if (!topology_only_) {
+        return evaluate_uncached(frame);
+    }
+
+    // the matches of this selection only depend on the topology, so we can
+    // re-use them as long as the topology did not change
+    auto version = frame.topology().version();
+    if (version != cached_version_) {
+        cached_matches_ = evaluate_uncached(frame);
+        cached_version_ = version;
+    }
+    return cached_matches_;
+}
+
+std::vector<Match> Selection::evaluate_uncached(const Frame& frame) const {
     auto is_match = [this](const Frame& f, const Match& match) {
         return ast_->is_match(f, match);
     };
 
     ast_->clear();
+
+    if (context_ == Context::PAIR || context_ == Context::THREE || context_ == Context::FOUR) {
+        // use a neighbor search instead of visiting all the possible matches
+        // if the selection contains constraints like `distance(#1, #2) < 3`
+        auto bounds = ast_->distance_bounds();
+        if (has_bounds(bounds, size())) {
+            return BoundedSearch(frame, bounds, size()).evaluate(frame, is_match);
+        }
+    }
+
     switch (context_) {
     case Context::ATOM:
-        return evaluate_atoms(frame, is_match);
+        return evaluate_atoms(frame, *ast_);
     case Context::PAIR:
         return evaluate_pairs(frame, is_match);
     case Context::BOND:
@@ -0,0 +1,121 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+#include "chemfiles/ThreadPool.hpp"
+
+using namespace chemfiles;
+
+/// Pool owning the current thread, if the current thread is a worker thread
+static thread_local const ThreadPool* CURRENT_POOL = nullptr;
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    workers_.reserve(threads);
+    try {
+        for (size_t i = 0; i < threads; i++) {
+            workers_.emplace_back([this]() { this->run(); });
+        }
+    } catch (...) {
+        // the threads already started must be joined before their
+        // std::thread is destroyed
+        {
+            auto lock = std::unique_lock<std::mutex>(mutex_);
+            stop_ = true;
+        }
+        condition_.notify_all();
+        for (auto& worker: workers_) {
+            worker.join();
+        }
+        throw;
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        auto lock = std::unique_lock<std::mutex>(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_all();
+    for (auto& worker: workers_) {
+        worker.join();
+    }
+}
+
+std::shared_ptr<ThreadPool> ThreadPool::shared() {
+    static auto POOL = std::make_shared<ThreadPool>(0);
+    return POOL;
+}
+
+void ThreadPool::run_chunks(size_t count, const std::function<void(size_t)>& function) {
+    if (CURRENT_POOL == this) {
+        for (size_t i = 0; i < count; i++) {
+            function(i);
+        }
+        return;
+    }
+
+    auto pending = std::vector<std::future<void>>();
+    pending.reserve(count);
+
+    // all tasks use `function`, and must be done before returning, even if
+    // submitting one of them or running them failed
+    auto wait_all = [&]() {
+        for (auto& future: pending) {
+            future.wait();
+        }
+    };
+
+    try {
+        for (size_t i = 0; i < count; i++) {
+            pending.emplace_back(this->submit([&function, i]() { function(i); }));
+        }
+    } catch (...) {
+        wait_all();
+        throw;
+    }
+    wait_all();
+
+    for (auto& future: pending) {
+        future.get();
+    }
+}
+
+void ThreadPool::push(std::function<void()> task) {
+    {
+        auto lock = std::unique_lock<std::mutex>(mutex_);
+        tasks_.emplace_back(std::move(task));
+    }
+    condition_.notify_one();
+}
+
+void ThreadPool::run() {
+    CURRENT_POOL = this;
+    while (true) {
+        auto task = std::function<void()>();
+        {
+            auto lock = std::unique_lock<std::mutex>(mutex_);
+            condition_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                // stop_ is set and all tasks are done
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        // exceptions are stored in the future by std::packaged_task
+        task();
+    }
+}
@@ -1,7 +1,11 @@
 // Chemfiles, a modern library for chemistry file reading and writing
 // Copyright (C) Guillaume Fraux and contributors -- BSD license
 
+#include <mutex>
+#include <atomic>
+#include <memory>
 #include <cstddef>
+#include <cstdint>
 #include <utility>
 #include <vector>
 #include <unordered_map>
@@ -13,11 +17,104 @@
 #include "chemfiles/Topology.hpp"
 #include "chemfiles/sorted_set.hpp"
 #include "chemfiles/external/optional.hpp"
+#include "chemfiles/external/span.hpp"
 
 using namespace chemfiles;
 
+uint64_t Topology::next_version() {
+    static std::atomic<uint64_t> NEXT_VERSION(1);
+    return NEXT_VERSION.fetch_add(1, std::memory_order_relaxed);
+}
+
+Topology::Data::Data(const Data& other):
+    atoms(other.atoms),
+    residues(other.residues),
+    residue_mapping(other.residue_mapping)
+{
+    // angles, dihedrals and impropers could be computed at the same time by
+    // another thread using the same data
+    std::lock_guard<std::mutex> lock(other.connectivity_mutex);
+    connect = other.connect;
+}
+
+const std::shared_ptr<Topology::Data>& Topology::empty_data() {
+    static const auto EMPTY = std::make_shared<Data>();
+    return EMPTY;
+}
+
+Topology::Data& Topology::mutable_data() {
+    // `shared_` is set on both topologies when copying, so data which has
+    // been shared once is always copied before the first modification, even
+    // if the other copies have been destroyed since. Using the reference
+    // count instead would not be reliable with copies in other threads.
+    if (shared_.load(std::memory_order_acquire)) {
+        data_ = std::make_shared<Data>(*data_);
+        shared_.store(false, std::memory_order_relaxed);
+    }
+    return *data_;
+}
+
+std::shared_ptr<Topology::Data> Topology::share_data() const {
+    if (data_->shareable) {
+        shared_.store(true, std::memory_order_release);
+        return data_;
+    } else {
+        return std::make_shared<Data>(*data_);
+    }
+}
+
+Topology::Data& Topology::unshared_data() {
+    auto& data = mutable_data();
+    data.shareable = false;
+    return data;
+}
+
+Topology::Topology(): data_(empty_data()), shared_(true) {}
+
+Topology::Topology(const Topology& other):
+    data_(other.share_data()),
+    shared_(data_ == other.data_),
+    version_(other.version_)
+{}
+
+Topology& Topology::operator=(const Topology& other) {
+    if (this != &other) {
+        data_ = other.share_data();
+        shared_.store(data_ == other.data_, std::memory_order_relaxed);
+        version_ = other.version_;
+    }
+    return *this;
+}
+
+Topology::Topology(Topology&& other) noexcept:
+    data_(std::move(other.data_)),
+    shared_(other.shared_.load(std::memory_order_relaxed)),
+    version_(other.version_)
+{
+    // the moved-from topology no longer has the same content
+    other.data_ = empty_data();
+    other.shared_.store(true, std::memory_order_relaxed);
+    other.modified();
+}
+
+Topology& Topology::operator=(Topology&& other) noexcept {
+    if (this != &other) {
+        data_ = std::move(other.data_);
+        shared_.store(other.shared_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        version_ = other.version_;
+        other.data_ = empty_data();
+        other.shared_.store(true, std::memory_order_relaxed);
+        other.modified();
+    }
+    return *this;
+}
+
 void Topology::resize(size_t size) {
-    for (const auto& bond: connect_.bonds()) {
+    if (size == data_->atoms.size()) {
+        return;
+    }
+
+    for (const auto& bond: data_->connect.bonds()) {
         if (bond[0] >= size || bond[1] >= size) {
             throw error(
                 "can not resize the topology to contains {} atoms as there "
@@ -26,15 +123,17 @@ void Topology::resize(size_t size) {
             );
         }
     }
-    atoms_.resize(size, Atom());
+    modified();
+    mutable_data().atoms.resize(size, Atom());
 }
 
 void Topology::add_atom(Atom atom) {
-    atoms_.emplace_back(std::move(atom));
+    modified();
+    mutable_data().atoms.emplace_back(std::move(atom));
 }
 
 void Topology::reserve(size_t size) {
-    atoms_.reserve(size);
+    mutable_data().atoms.reserve(size);
 }
 
 void Topology::add_bond(size_t atom_i, size_t atom_j, Bond::BondOrder bond_order) {
@@ -45,7 +144,34 @@ void Topology::add_bond(size_t atom_i, size_t atom_j, Bond::BondOrder bond_order
             size(), atom_i, atom_j
         );
     }
-    connect_.add_bond(atom_i, atom_j, bond_order);
+    modified();
+    mutable_data().connect.add_bond(atom_i, atom_j, bond_order);
+}
+
+void Topology::add_bonds(span<const Bond> bonds, span<const Bond::BondOrder> bond_orders) {
+    if (!bond_orders.empty() && bond_orders.size() != bonds.size()) {
+        throw error(
+            "mismatched sizes in `Topology::add_bonds`: got {} bonds but {} bond orders",
+            bonds.size(), bond_orders.size()
+        );
+    }
+
+    for (const auto& bond: bonds) {
+        // bond[0] < bond[1], so we only need to check the second index
+        if (bond[1] >= size()) {
+            throw out_of_bounds(
+                "out of bounds atomic index in `Topology::add_bonds`: "
+                "we have {} atoms, but the bond indexes are {} and {}",
+                size(), bond[0], bond[1]
+            );
+        }
+    }
+
+    if (bonds.empty()) {
+        return;
+    }
+    modified();
+    mutable_data().connect.add_bonds(bonds, bond_orders);
 }
 
 void Topology::remove_bond(size_t atom_i, size_t atom_j) {
@@ -56,7 +182,8 @@ void Topology::remove_bond(size_t atom_i, size_t atom_j) {
             size(), atom_i, atom_j
         );
     }
-    connect_.remove_bond(atom_i, atom_j);
+    modified();
+    mutable_data().connect.remove_bond(atom_i, atom_j);
 }
 
 Bond::BondOrder Topology::bond_order(size_t atom_i, size_t atom_j) const {
@@ -68,7 +195,7 @@ Bond::BondOrder Topology::bond_order(size_t atom_i, size_t atom_j) const {
         );
     }
 
-    return connect_.bond_order(atom_i, atom_j);
+    return data_->connect.bond_order(atom_i, atom_j);
 }
 
 void Topology::remove(size_t i) {
@@ -79,63 +206,104 @@ void Topology::remove(size_t i) {
             size(), i
         );
     }
-    atoms_.erase(atoms_.begin() + static_cast<std::ptrdiff_t>(i));
+    this->remove(span<const size_t>(i));
+}
 
-    // Remove all bonds with the removed atom
-    auto bonds = connect_.bonds();
-    for (const auto& bond : bonds) {
-        if (bond[0] == i || bond[1] == i) {
-            connect_.remove_bond(bond[0], bond[1]);
+void Topology::remove(span<const size_t> indexes) {
+    auto natoms = size();
+    // new index of all the atoms after the removal, SIZE_MAX for removed atoms
+    auto new_indexes = std::vector<size_t>(natoms, 0);
+    for (auto i: indexes) {
+        if (i >= natoms) {
+            throw out_of_bounds(
+                "out of bounds atomic index in `Topology::remove`: we have {} "
+                "atoms, but the index is {}",
+                natoms, i
+            );
         }
+        new_indexes[i] = SIZE_MAX;
     }
-    // remove the atom from the corresponding residue
-    auto it = residue_mapping_.find(i);
-    if (it != residue_mapping_.end()) {
-        residues_[it->second].remove(i);
+
+    if (indexes.empty()) {
+        return;
+    }
+    modified();
+    auto& data = mutable_data();
+
+    size_t count = 0;
+    for (size_t i = 0; i < natoms; i++) {
+        if (new_indexes[i] == SIZE_MAX) {
+            continue;
+        }
+        if (count != i) {
+            data.atoms[count] = std::move(data.atoms[i]);
+        }
+        new_indexes[i] = count;
+        count++;
     }
+    data.atoms.erase(data.atoms.begin() + static_cast<std::ptrdiff_t>(count), data.atoms.end());
+
+    data.connect.atoms_removed(new_indexes);
 
-    // shift all bonds indexes
-    connect_.atom_removed(i);
-    // shift all residue atoms
-    for (auto& res : residues_) {
-        res.atom_removed(i);
+    data.residue_mapping.clear();
+    for (size_t residue_i = 0; residue_i < data.residues.size(); residue_i++) {
+        auto& residue = data.residues[residue_i];
+        residue.atoms_removed(new_indexes, natoms - count);
+        for (auto i: residue) {
+            data.residue_mapping.insert({i, residue_i});
+        }
     }
 }
 
 const std::vector<Bond>& Topology::bonds() const {
-    return connect_.bonds().as_vec();
+    return data_->connect.bonds().as_vec();
 }
 
 const std::vector<Bond::BondOrder>& Topology::bond_orders() const {
-    return connect_.bond_orders();
+    return data_->connect.bond_orders();
+}
+
+const AdjacencyGraph& Topology::adjacency() const {
+    std::lock_guard<std::mutex> lock(data_->connectivity_mutex);
+    return data_->connect.adjacency();
+}
+
+const Molecules& Topology::molecules() const {
+    std::lock_guard<std::mutex> lock(data_->connectivity_mutex);
+    return data_->connect.molecules(data_->atoms.size());
 }
 
 const std::vector<Angle>& Topology::angles() const {
-    return connect_.angles().as_vec();
+    std::lock_guard<std::mutex> lock(data_->connectivity_mutex);
+    return data_->connect.angles().as_vec();
 }
 
 const std::vector<Dihedral>& Topology::dihedrals() const {
-    return connect_.dihedrals().as_vec();
+    std::lock_guard<std::mutex> lock(data_->connectivity_mutex);
+    return data_->connect.dihedrals().as_vec();
 }
 
 const std::vector<Improper>& Topology::impropers() const {
-    return connect_.impropers().as_vec();
+    std::lock_guard<std::mutex> lock(data_->connectivity_mutex);
+    return data_->connect.impropers().as_vec();
 }
 
 void Topology::add_residue(Residue residue) {
     for (auto i: residue) {
-        auto it = residue_mapping_.find(i);
-        if (it != residue_mapping_.end()) {
+        auto it = data_->residue_mapping.find(i);
+        if (it != data_->residue_mapping.end()) {
             throw error(
                 "can not add this residue: atom {} is already in another residue",
                 i
             );
         }
     }
-    auto res_index = residues_.size();
-    residues_.emplace_back(std::move(residue));
-    for (auto i: residues_.back()) {
-        residue_mapping_.insert({i, res_index});
+    modified();
+    auto& data = mutable_data();
+    auto res_index = data.residues.size();
+    data.residues.emplace_back(std::move(residue));
+    for (auto i: data.residues.back()) {
+        data.residue_mapping.insert({i, res_index});
     }
 }
 
@@ -143,10 +311,14 @@ bool Topology::are_linked(const Residue& first, const Residue& second) const {
     if (first == second) {
         return true;
     }
-    auto bonds = connect_.bonds();
-    for (auto i: first) {
-        for (auto j: second) {
-            if (bonds.find({i, j}) != bonds.end()) {
+
+    // look for a bond starting in the smallest residue
+    const auto& smallest = first.size() < second.size() ? first : second;
+    const auto& other = first.size() < second.size() ? second : first;
+    const auto& graph = this->adjacency();
+    for (auto i: smallest) {
+        for (auto j: graph.neighbors(i)) {
+            if (other.contains(j)) {
                 return true;
             }
         }
@@ -155,11 +327,11 @@ bool Topology::are_linked(const Residue& first, const Residue& second) const {
 }
 
 optional<const Residue&> Topology::residue_for_atom(size_t index) const {
-    auto it = residue_mapping_.find(index);
-    if (it == residue_mapping_.end()) {
+    auto it = data_->residue_mapping.find(index);
+    if (it == data_->residue_mapping.end()) {
         // This atom is not in a residue
         return nullopt;
     } else {
-        return residues_[it->second];
+        return data_->residues[it->second];
     }
 }
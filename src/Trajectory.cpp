@@ -3,6 +3,8 @@
 
 #include <cassert>
 #include <cstddef>
+#include <algorithm>
+#include <thread>
 
 #include <functional>
 #include <memory>
@@ -17,6 +19,7 @@
 #include "chemfiles/UnitCell.hpp"
 #include "chemfiles/Topology.hpp"
 #include "chemfiles/FormatFactory.hpp"
+#include "chemfiles/FramePrefetcher.hpp"
 #include "chemfiles/files/MemoryBuffer.hpp"
 
 #include "chemfiles/misc.hpp"
@@ -52,6 +55,8 @@ file_open_info file_open_info::parse(const std::string& path, std::string format
             info.compression = File::BZIP2;
         } else if (compression == "XZ") {
             info.compression = File::LZMA;
+        } else if (compression == "PGZ") {
+            info.compression = File::GZIP_PARALLEL;
         } else {
             throw file_error("unknown compression method '{}'", compression);
         }
@@ -80,7 +85,7 @@ static File::Mode char_to_file_mode(char mode) {
 }
 
 Trajectory::Trajectory(std::string path, char mode, const std::string& format)
-    : path_(std::move(path)), mode_(mode), format_(nullptr) {
+    : path_(std::move(path)), format_name_(format), mode_(mode), format_(nullptr) {
 
     auto info = file_open_info::parse(path_, format);
     auto format_creator = FormatFactory::get().by_name(info.format).creator;
@@ -154,9 +159,54 @@ void Trajectory::pre_read(size_t step) {
     }
 }
 
+void Trajectory::prepare_frame(Frame& frame) {
+    // keep the custom topology if the frame already contains it, and the
+    // format will not modify it
+    auto keep_topology = format_->keeps_topology() && custom_topology_ &&
+        frame.topology().version() == custom_topology_->version();
+    frame.clear_for_reading(keep_topology);
+    frame.set_storage(storage_);
+    frame.set_step(SENTINEL_VALUE);
+}
+
+/// Check if two topologies contain the same atoms, bonds and residues
+static bool same_topology(const Topology& lhs, const Topology& rhs) {
+    if (lhs.version() == rhs.version()) {
+        // copies of the same unmodified topology
+        return true;
+    }
+
+    if (lhs.size() != rhs.size() || lhs.bonds() != rhs.bonds() ||
+        lhs.bond_orders() != rhs.bond_orders() || lhs.residues() != rhs.residues()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < lhs.size(); i++) {
+        if (lhs[i] != rhs[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void Trajectory::post_read(Frame& frame) {
+    // formats without direct support for the requested storage convert the
+    // frame back to the default storage
+    frame.set_storage(storage_);
+
+    // the frame already contains the custom topology if it was kept by
+    // `prepare_frame`
     if (custom_topology_) {
-        frame.set_topology(*custom_topology_);
+        if (frame.topology().version() != custom_topology_->version()) {
+            frame.set_topology(*custom_topology_);
+        }
+    } else if (previous_topology_ && same_topology(*previous_topology_, frame.topology())) {
+        // most formats build a new topology for each step, even when it does
+        // not change. Using the previous one instead shares its data between
+        // all the frames, and keeps the same topology version.
+        frame.set_topology(*previous_topology_);
+    } else {
+        previous_topology_ = frame.topology();
     }
 
     if (custom_cell_) {
@@ -176,12 +226,30 @@ size_t Trajectory::nsteps() const  {
 }
 
 Frame Trajectory::read() {
+    auto frame = Frame();
+    this->read(frame);
+    return frame;
+}
+
+void Trajectory::read(Frame& frame) {
     check_opened();
     pre_read(step_);
 
-    Frame frame;
-    frame.set_step(SENTINEL_VALUE);
-    format_->read(frame);
+    if (prefetcher_) {
+        prefetcher_->get(step_, frame);
+        post_read(frame);
+        step_++;
+        return;
+    }
+
+    prepare_frame(frame);
+    if (format_needs_seek_) {
+        // frames were read ahead of time by other instances of the format
+        format_->read_step(step_, frame);
+        format_needs_seek_ = false;
+    } else {
+        format_->read(frame);
+    }
     post_read(frame);
 
     // Don't override the step set by a format
@@ -190,17 +258,22 @@ Frame Trajectory::read() {
     }
 
     step_++;
-    return frame;
 }
 
 Frame Trajectory::read_step(const size_t step) {
+    auto frame = Frame();
+    this->read_step(step, frame);
+    return frame;
+}
+
+void Trajectory::read_step(const size_t step, Frame& frame) {
     check_opened();
     pre_read(step);
 
-    Frame frame;
-    frame.set_step(SENTINEL_VALUE);
+    prepare_frame(frame);
     step_ = step;
     format_->read_step(step_, frame);
+    format_needs_seek_ = false;
 
     // Don't override the step set by a format
     if (frame.step() == SENTINEL_VALUE) {
@@ -208,7 +281,23 @@ Frame Trajectory::read_step(const size_t step) {
     }
 
     post_read(frame);
-    return frame;
+}
+
+void Trajectory::read_positions(size_t start, span<std::vector<Vector3D>> positions, size_t threads) {
+    check_opened();
+    if (positions.empty()) {
+        return;
+    }
+    // check both the first and last step
+    pre_read(start);
+    pre_read(start + positions.size() - 1);
+
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    format_->read_positions_range(start, positions, threads);
+    // make sure the next call to `read` returns the right step
+    format_needs_seek_ = true;
 }
 
 void Trajectory::write(const Frame& frame) {
@@ -250,6 +339,65 @@ void Trajectory::set_topology(const std::string& filename, const std::string& fo
     set_topology(frame.topology());
 }
 
+void Trajectory::set_positions_storage(Frame::Storage storage) {
+    check_opened();
+    if (storage != Frame::AOS_DOUBLE && storage != Frame::SOA_FLOAT) {
+        throw error("invalid storage for frame positions: {}", static_cast<int>(storage));
+    }
+    storage_ = storage;
+}
+
+void Trajectory::set_read_ahead(size_t frames, size_t threads) {
+    check_opened();
+    if (prefetcher_) {
+        prefetcher_.reset();
+        format_needs_seek_ = true;
+    }
+
+    if (frames == 0) {
+        return;
+    }
+
+    if (mode_ != File::READ) {
+        throw file_error(
+            "the file at '{}' was not opened in read mode", path_
+        );
+    }
+
+    if (!format_->random_access() || buffer_ != nullptr) {
+        throw format_error(
+            "reading ahead of time is not supported for the file at '{}'", path_
+        );
+    }
+
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    threads = std::min(threads, frames);
+
+    auto info = file_open_info::parse(path_, format_name_);
+    auto format_creator = FormatFactory::get().by_name(info.format).creator;
+    auto open = [&]() {
+        // reuse what the main format already knows about the file if possible
+        auto format = format_->reopen();
+        if (!format) {
+            format = format_creator(path_, File::READ, info.compression);
+        }
+        return format;
+    };
+    prefetcher_ = std::make_unique<FramePrefetcher>(open, nsteps_, frames, threads);
+}
+
+void Trajectory::set_write_threads(size_t threads) {
+    check_opened();
+    if (mode_ != File::WRITE && mode_ != File::APPEND) {
+        throw file_error(
+            "the file at '{}' was not opened in write or append mode", path_
+        );
+    }
+    format_->set_write_threads(threads);
+}
+
 void Trajectory::set_cell(const UnitCell& cell) {
     check_opened();
     custom_cell_ = cell;
@@ -262,7 +410,9 @@ bool Trajectory::done() const {
 
 void Trajectory::close() {
     check_opened();
-    // delete the format and set the pointer to nullptr
+    // stop reading ahead of time, then delete the format and set the pointer
+    // to nullptr
+    prefetcher_.reset();
     format_.reset();
 }
 
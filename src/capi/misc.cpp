@@ -55,6 +55,30 @@ extern "C" chfl_status chfl_set_warning_callback(chfl_warning_callback callback)
     )
 }
 
+extern "C" chfl_status chfl_set_frame_index_files(bool enabled) {
+    CHFL_ERROR_CATCH(
+        set_frame_index_files(enabled);
+    )
+}
+
+extern "C" chfl_status chfl_set_threaded_decompression(bool enabled) {
+    CHFL_ERROR_CATCH(
+        set_threaded_decompression(enabled);
+    )
+}
+
+extern "C" chfl_status chfl_set_memory_mapping(bool enabled) {
+    CHFL_ERROR_CATCH(
+        set_memory_mapping(enabled);
+    )
+}
+
+extern "C" chfl_status chfl_set_write_threads(uint64_t threads) {
+    CHFL_ERROR_CATCH(
+        set_write_threads(checked_cast(threads));
+    )
+}
+
 extern "C" chfl_status chfl_formats_list(chfl_format_metadata** metadata, uint64_t* count) {
     CHECK_POINTER(metadata);
     CHECK_POINTER(count);
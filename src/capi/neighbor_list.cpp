@@ -0,0 +1,95 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <cstdint>
+
+#include "chemfiles/capi/types.h"
+#include "chemfiles/capi/misc.h"
+#include "chemfiles/capi/utils.hpp"
+#include "chemfiles/capi/shared_allocator.hpp"
+
+#include "chemfiles/capi/neighbor_list.h"
+
+#include "chemfiles/Frame.hpp"
+#include "chemfiles/NeighborList.hpp"
+
+using namespace chemfiles;
+
+extern "C" CHFL_NEIGHBOR_LIST* chfl_neighbor_list(const CHFL_FRAME* const frame, double cutoff, double skin) {
+    CHFL_NEIGHBOR_LIST* list = nullptr;
+    CHECK_POINTER_GOTO(frame);
+    CHFL_ERROR_GOTO(
+        list = shared_allocator::make_shared<NeighborList>(*frame, cutoff, skin);
+    )
+    return list;
+error:
+    chfl_free(list);
+    return nullptr;
+}
+
+extern "C" chfl_status chfl_neighbor_list_update(CHFL_NEIGHBOR_LIST* const list, const CHFL_FRAME* const frame) {
+    CHECK_POINTER(list);
+    CHECK_POINTER(frame);
+    CHFL_ERROR_CATCH(
+        list->update(*frame);
+    )
+}
+
+extern "C" chfl_status chfl_neighbor_list_pairs_count(const CHFL_NEIGHBOR_LIST* const list, uint64_t* count) {
+    CHECK_POINTER(list);
+    CHECK_POINTER(count);
+    CHFL_ERROR_CATCH(
+        *count = static_cast<uint64_t>(list->size());
+    )
+}
+
+extern "C" chfl_status chfl_neighbor_list_pairs(const CHFL_NEIGHBOR_LIST* const list, uint64_t (*pairs)[2], uint64_t count) {
+    CHECK_POINTER(list);
+    CHECK_POINTER(pairs);
+    CHFL_ERROR_CATCH(
+        if (checked_cast(count) != list->size()) {
+            set_last_error("wrong data size in function 'chfl_neighbor_list_pairs'.");
+            return CHFL_MEMORY_ERROR;
+        }
+
+        const auto& all_pairs = list->pairs();
+        for (size_t i=0; i<all_pairs.size(); i++) {
+            pairs[i][0] = static_cast<uint64_t>(all_pairs[i].first);
+            pairs[i][1] = static_cast<uint64_t>(all_pairs[i].second);
+        }
+    )
+}
+
+extern "C" chfl_status chfl_neighbor_list_distances(const CHFL_NEIGHBOR_LIST* const list, double distances[], uint64_t count) {
+    CHECK_POINTER(list);
+    CHECK_POINTER(distances);
+    CHFL_ERROR_CATCH(
+        if (checked_cast(count) != list->size()) {
+            set_last_error("wrong data size in function 'chfl_neighbor_list_distances'.");
+            return CHFL_MEMORY_ERROR;
+        }
+
+        const auto& all_pairs = list->pairs();
+        for (size_t i=0; i<all_pairs.size(); i++) {
+            distances[i] = all_pairs[i].distance;
+        }
+    )
+}
+
+extern "C" chfl_status chfl_neighbor_list_vectors(const CHFL_NEIGHBOR_LIST* const list, chfl_vector3d vectors[], uint64_t count) {
+    CHECK_POINTER(list);
+    CHECK_POINTER(vectors);
+    CHFL_ERROR_CATCH(
+        if (checked_cast(count) != list->size()) {
+            set_last_error("wrong data size in function 'chfl_neighbor_list_vectors'.");
+            return CHFL_MEMORY_ERROR;
+        }
+
+        const auto& all_pairs = list->pairs();
+        for (size_t i=0; i<all_pairs.size(); i++) {
+            vectors[i][0] = all_pairs[i].vector[0];
+            vectors[i][1] = all_pairs[i].vector[1];
+            vectors[i][2] = all_pairs[i].vector[2];
+        }
+    )
+}
@@ -95,3 +95,29 @@ extern "C" chfl_status chfl_selection_matches(const CHFL_SELECTION* const select
         }
     )
 }
+
+extern "C" chfl_status chfl_selection_cache_stats(uint64_t* const hits, uint64_t* const misses, uint64_t* const size, uint64_t* const capacity) {
+    CHECK_POINTER(hits);
+    CHECK_POINTER(misses);
+    CHECK_POINTER(size);
+    CHECK_POINTER(capacity);
+    CHFL_ERROR_CATCH(
+        auto stats = Selection::cache_stats();
+        *hits = stats.hits;
+        *misses = stats.misses;
+        *size = stats.size;
+        *capacity = stats.capacity;
+    )
+}
+
+extern "C" chfl_status chfl_selection_cache_resize(uint64_t capacity) {
+    CHFL_ERROR_CATCH(
+        Selection::set_cache_capacity(checked_cast(capacity));
+    )
+}
+
+extern "C" chfl_status chfl_selection_cache_clear(void) {
+    CHFL_ERROR_CATCH(
+        Selection::clear_cache();
+    )
+}
@@ -86,7 +86,7 @@ extern "C" chfl_status chfl_trajectory_read_step(CHFL_TRAJECTORY* const trajecto
     CHECK_POINTER(trajectory);
     CHECK_POINTER(frame);
     CHFL_ERROR_CATCH(
-        *frame = trajectory->read_step(checked_cast(step));
+        trajectory->read_step(checked_cast(step), *frame);
     )
 }
 
@@ -94,7 +94,7 @@ extern "C" chfl_status chfl_trajectory_read(CHFL_TRAJECTORY* const trajectory, C
     CHECK_POINTER(trajectory);
     CHECK_POINTER(frame);
     CHFL_ERROR_CATCH(
-        *frame = trajectory->read();
+        trajectory->read(*frame);
     )
 }
 
@@ -5,16 +5,24 @@
 #include <cstring>
 #include <cstdint>
 #include <cassert>
+#include <array>
 #include <limits>
+#include <memory>
 #include <string>
 #include <vector>
+#include <future>
+#include <iterator>
+#include <algorithm>
 #include <functional>
 
 #include <bzlib.h>
 
 #include "chemfiles/File.hpp"
+#include "chemfiles/ThreadPool.hpp"
 #include "chemfiles/error_fmt.hpp"
 
+#include "chemfiles/external/optional.hpp"
+
 #include "chemfiles/files/MemoryBuffer.hpp"
 #include "chemfiles/files/Bz2File.hpp"
 
@@ -57,28 +65,199 @@ static void check(int status) {
     }
 }
 
-Bz2File::Bz2File(const std::string& path, File::Mode mode): TextFileImpl(path), mode_(mode), buffer_(8192) {
+/// Bit pattern at the start of each bzip2 block (BCD encoding of pi)
+static constexpr uint64_t BLOCK_MAGIC = 0x314159265359;
+/// Bit pattern at the end of each bzip2 stream (BCD encoding of sqrt(pi))
+static constexpr uint64_t STREAM_END_MAGIC = 0x177245385090;
+/// Mask for the 48 bits of the block and end of stream magic
+static constexpr uint64_t MAGIC_MASK = 0xffffffffffff;
+/// Size of the buffer used when scanning the compressed file
+static constexpr size_t SCAN_BUFFER_SIZE = 64 * 1024;
+/// Size of the buffer used for sequential decompression
+static constexpr size_t SEQUENTIAL_BUFFER_SIZE = 64 * 1024;
+
+namespace {
+/// Tables used to scan the compressed data one byte at a time for the block
+/// and end of stream magic, which can start at any bit in a byte.
+///
+/// When a magic starts at bit `shift` of a byte, it fully covers the next
+/// five bytes, giving 16 five-bytes patterns (two magic values times eight
+/// shifts). The scan looks at the byte which would be the last of these five
+/// bytes, and moves forward using the same shift table as the
+/// Boyer-Moore-Horspool algorithm.
+struct MagicTables {
+    /// Number of bytes the scan can move forward after a given byte
+    std::array<uint8_t, 256> skip;
+    /// For a given byte, bit mask of the patterns ending with this byte. Bit
+    /// `2 * shift` is used for the block magic and bit `2 * shift + 1` for
+    /// the end of stream magic.
+    std::array<uint16_t, 256> last;
+};
+}
+
+static const MagicTables& magic_tables() {
+    static const MagicTables TABLES = []() {
+        auto tables = MagicTables();
+        tables.skip.fill(5);
+        tables.last.fill(0);
+        for (unsigned shift = 0; shift < 8; shift++) {
+            for (unsigned kind = 0; kind < 2; kind++) {
+                auto magic = kind == 0 ? BLOCK_MAGIC : STREAM_END_MAGIC;
+                for (unsigned i = 0; i < 5; i++) {
+                    auto byte = static_cast<uint8_t>((magic >> (32 - 8 * i + shift)) & 0xff);
+                    if (i == 4) {
+                        tables.last[byte] = static_cast<uint16_t>(tables.last[byte] | (1u << (2 * shift + kind)));
+                    } else {
+                        tables.skip[byte] = std::min(tables.skip[byte], static_cast<uint8_t>(4 - i));
+                    }
+                }
+            }
+        }
+        return tables;
+    }();
+    return TABLES;
+}
+
+/// Get the bit at position `i` in `data`, bzip2 using most significant bit
+/// first ordering
+static unsigned get_bit(const std::vector<uint8_t>& data, uint64_t i) {
+    return (data[static_cast<size_t>(i / 8)] >> (7 - i % 8)) & 1;
+}
+
+/// Minimal bit writer, using the same bit ordering as bzip2
+class BitWriter {
+public:
+    void write(uint64_t value, unsigned count) {
+        for (unsigned i = 0; i < count; i++) {
+            auto bit = (value >> (count - 1 - i)) & 1;
+            if (size_ % 8 == 0) {
+                data_.push_back(0);
+            }
+            data_.back() = static_cast<char>(data_.back() | static_cast<char>(bit << (7 - size_ % 8)));
+            size_++;
+        }
+    }
+
+    /// Write the `count` bits starting at bit `start` in `data`. The writer
+    /// must be aligned on a byte boundary.
+    void copy(const std::vector<uint8_t>& data, uint64_t start, uint64_t count) {
+        assert(size_ % 8 == 0);
+        auto shift = static_cast<unsigned>(start % 8);
+        auto first = static_cast<size_t>(start / 8);
+        auto bytes = static_cast<size_t>(count / 8);
+        data_.reserve(data_.size() + bytes + 16);
+        for (size_t i = 0; i < bytes; i++) {
+            auto value = static_cast<unsigned>(data[first + i]) << shift;
+            if (shift != 0) {
+                value |= static_cast<unsigned>(data[first + i + 1]) >> (8 - shift);
+            }
+            data_.push_back(static_cast<char>(value & 0xff));
+        }
+        size_ += 8 * bytes;
+
+        for (uint64_t i = start + 8 * bytes; i < start + count; i++) {
+            this->write(get_bit(data, i), 1);
+        }
+    }
+
+    std::vector<char>& data() {
+        return data_;
+    }
+
+private:
+    std::vector<char> data_;
+    uint64_t size_ = 0;
+};
+
+/// Decompress a single bzip2 block, stored in the `count` bits of `data`
+/// starting at bit `start`.
+///
+/// This creates a new bzip2 stream containing only this block, which can then
+/// be decompressed with libbzip2. The CRC of the full stream is the same as
+/// the CRC of the block, stored just after the block magic. libbzip2 checks
+/// the decompressed data against this CRC, so blocks with a wrong start or
+/// end give an error instead of invalid data.
+static std::vector<char> decompress_block(const std::vector<uint8_t>& data, uint64_t start, uint64_t count) {
+    auto writer = BitWriter();
+    // stream header, using the largest block size
+    writer.write('B', 8);
+    writer.write('Z', 8);
+    writer.write('h', 8);
+    writer.write('9', 8);
+
+    writer.copy(data, start, count);
+
+    uint64_t crc = 0;
+    for (uint64_t i = start + 48; i < start + 80; i++) {
+        crc = (crc << 1) | get_bit(data, i);
+    }
+    writer.write(STREAM_END_MAGIC, 48);
+    writer.write(crc, 32);
+
+    auto& input = writer.data();
+    auto output = std::vector<char>(std::max<size_t>(4 * input.size(), 1024 * 1024));
+
+    bz_stream stream;
+    std::memset(&stream, 0, sizeof(bz_stream));
+    check(BZ2_bzDecompressInit(&stream, 0, 0));
+    stream.next_in = input.data();
+    stream.avail_in = checked_cast(input.size());
+
+    auto status = BZ_OK;
+    size_t total_out = 0;
+    do {
+        if (total_out == output.size()) {
+            output.resize(2 * output.size());
+        }
+        stream.next_out = output.data() + total_out;
+        stream.avail_out = checked_cast(output.size() - total_out);
+
+        status = BZ2_bzDecompress(&stream);
+        total_out = output.size() - stream.avail_out;
+
+        if (status == BZ_OK && stream.avail_in == 0 && stream.avail_out != 0) {
+            // we gave all the data to bzlib and did not get the end of stream
+            status = BZ_UNEXPECTED_EOF;
+        }
+
+        if (status != BZ_OK && status != BZ_STREAM_END) {
+            BZ2_bzDecompressEnd(&stream);
+            check(status);
+        }
+    } while (status != BZ_STREAM_END);
+
+    BZ2_bzDecompressEnd(&stream);
+    output.resize(total_out);
+    return output;
+}
+
+Bz2File::Bz2File(const std::string& path, File::Mode mode): TextFileImpl(path), mode_(mode) {
     std::memset(&stream_, 0, sizeof(bz_stream));
 
-    const char* openmode = nullptr;
     if (mode == File::READ) {
-        openmode = "rb";
-        stream_end_ = BZ2_bzDecompressEnd;
-        check(BZ2_bzDecompressInit(&stream_, 0, 0));
-    } else if (mode == File::WRITE) {
-        openmode = "wb";
-        stream_end_ = BZ2_bzCompressEnd;
-        check(BZ2_bzCompressInit(&stream_, 6, 0, 0));
-
-        stream_.next_out = buffer_.data();
-        stream_.avail_out = checked_cast(buffer_.size());
+        input_.open(path, std::ios::binary);
+        if (!input_) {
+            throw file_error("could not open the file at '{}'", path);
+        }
+        input_.seekg(0, std::ios::end);
+        input_size_ = static_cast<uint64_t>(input_.tellg());
+        input_.seekg(0);
+        // decompress blocks in the background with the shared pool
+        pool_ = ThreadPool::shared();
+        return;
     } else if (mode == File::APPEND) {
         throw file_error("appending (open mode 'a') is not supported with bzip2 files");
     }
 
-    file_ = std::fopen(path.c_str(), openmode);
+    assert(mode == File::WRITE);
+    buffer_.resize(8192);
+    check(BZ2_bzCompressInit(&stream_, 6, 0, 0));
+    stream_.next_out = buffer_.data();
+    stream_.avail_out = checked_cast(buffer_.size());
+
+    file_ = std::fopen(path.c_str(), "wb");
     if (file_ == nullptr) {
-        stream_end_(&stream_);
+        BZ2_bzCompressEnd(&stream_);
         throw file_error("could not open the file at '{}'", path);
     }
 }
@@ -90,67 +269,372 @@ Bz2File::~Bz2File() {
         } catch (...) {
             // not much we can do here
         }
-    }
 
-    stream_end_(&stream_);
-    if (file_ != nullptr) {
+        BZ2_bzCompressEnd(&stream_);
         std::fclose(file_);
     }
+
+    // tasks still running in the thread pool own a copy of their data, so
+    // they can finish after this file is closed
+    prefetch_.clear();
+
+    if (sequential_) {
+        BZ2_bzDecompressEnd(&stream_);
+    }
 }
 
-size_t Bz2File::read(char* data, size_t count) {
-    stream_.next_out = data;
-    stream_.avail_out = checked_cast(count);
+size_t Bz2File::fill_scan_buffer(uint64_t first, size_t count) {
+    auto available = first < input_size_ ? std::min<uint64_t>(count, input_size_ - first) : 0;
+    auto buffer_end = scan_buffer_offset_ + scan_buffer_.size();
+    if (first < scan_buffer_offset_ || first + available > buffer_end) {
+        scan_buffer_.resize(SCAN_BUFFER_SIZE);
+        input_.clear();
+        input_.seekg(static_cast<std::streamoff>(first));
+        input_.read(reinterpret_cast<char*>(scan_buffer_.data()), static_cast<std::streamsize>(scan_buffer_.size()));
+        if (input_.bad()) {
+            throw file_error("IO error while reading bzip2 file");
+        }
+        scan_buffer_.resize(static_cast<size_t>(input_.gcount()));
+        scan_buffer_offset_ = first;
+        available = std::min<uint64_t>(available, scan_buffer_.size());
+    }
+    return static_cast<size_t>(available);
+}
 
-    while (stream_.avail_out != 0) {
-        // read more compressed data from the file
-        if (stream_.avail_in == 0 && (std::feof(file_) == 0)) {
-            stream_.next_in = buffer_.data();
-            stream_.avail_in = checked_cast(std::fread(buffer_.data(), 1, buffer_.size(), file_));
+uint32_t Bz2File::read_scan_bits32(uint64_t position) {
+    auto first = position / 8;
+    auto shift = static_cast<unsigned>(position % 8);
+    auto needed = shift == 0 ? size_t(4) : size_t(5);
+    if (fill_scan_buffer(first, needed) < needed) {
+        throw file_error("bzip2: unexpected end of file");
+    }
 
-            if (std::ferror(file_) != 0) {
-                throw file_error("IO error while reading bzip2 file");
+    uint64_t bits = 0;
+    for (size_t i = 0; i < 5; i++) {
+        auto byte = i < needed ? scan_buffer_[static_cast<size_t>(first - scan_buffer_offset_) + i] : uint8_t(0);
+        bits = (bits << 8) | byte;
+    }
+    return static_cast<uint32_t>((bits >> (8 - shift)) & 0xffffffff);
+}
+
+optional<Bz2File::Marker> Bz2File::find_marker() {
+    const auto& tables = magic_tables();
+    // `last` is the byte fully covered by the end of a magic starting in
+    // byte `last - 5`
+    auto last = scan_position_ / 8 + 5;
+    while (true) {
+        auto available = fill_scan_buffer(last - 5, 7);
+        if (available < 6) {
+            return nullopt;
+        }
+
+        const auto* bytes = scan_buffer_.data() + static_cast<size_t>(last - 5 - scan_buffer_offset_);
+        auto patterns = tables.last[bytes[5]];
+        if (patterns != 0) {
+            uint64_t bits = 0;
+            for (size_t i = 0; i < 7; i++) {
+                bits = (bits << 8) | (i < available ? bytes[i] : 0);
+            }
+
+            for (unsigned shift = 0; shift < 8; shift++) {
+                if (((patterns >> (2 * shift)) & 3) == 0) {
+                    continue;
+                }
+                if (shift != 0 && available < 7) {
+                    // the magic would continue after the end of the file
+                    break;
+                }
+                auto position = 8 * (last - 5) + shift;
+                if (position < scan_position_) {
+                    continue;
+                }
+                auto magic = (bits >> (8 - shift)) & MAGIC_MASK;
+                if (magic == BLOCK_MAGIC || magic == STREAM_END_MAGIC) {
+                    return Marker{position, magic == STREAM_END_MAGIC};
+                }
             }
         }
+        last += tables.skip[bytes[5]];
+    }
+}
 
-        auto status = BZ2_bzDecompress(&stream_);
+bool Bz2File::find_next_block() {
+    if (scan_position_ == 0) {
+        auto size = fill_scan_buffer(0, 4);
+        if (size == 0) {
+            return false;
+        }
+        // all bzip2 files should start with 'BZh' and the block size
+        if (size < 4 || scan_buffer_[0] != 'B' || scan_buffer_[1] != 'Z' || scan_buffer_[2] != 'h') {
+            check(BZ_DATA_ERROR_MAGIC);
+        }
+    }
 
-        if (status == BZ_STREAM_END) {
-            return count - stream_.avail_out;
+    auto found = blocks_.size();
+    while (blocks_.size() == found) {
+        auto marker = find_marker();
+        if (!marker) {
+            if (scan_block_start_) {
+                throw file_error("bzip2: unexpected end of file in the middle of a block");
+            }
+            return false;
+        }
+
+        // both block and end of stream magic are followed by a CRC
+        auto crc = read_scan_bits32(marker->position + 48);
+        if (marker->stream_end && crc != scan_stream_crc_) {
+            // a magic found by chance inside a block would add a block with
+            // an invalid CRC to this stream
+            throw file_error("bzip2: the combined CRC of the blocks does not match the stream CRC");
+        }
+
+        if (scan_block_start_) {
+            blocks_.push_back({*scan_block_start_, marker->position});
+        }
+
+        if (marker->stream_end) {
+            scan_block_start_ = nullopt;
+            scan_stream_crc_ = 0;
         } else {
-            // Check for error
-            check(status);
+            scan_block_start_ = marker->position;
+            scan_stream_crc_ = ((scan_stream_crc_ << 1) | (scan_stream_crc_ >> 31)) ^ crc;
+        }
+        scan_position_ = marker->position + 48;
+    }
+    return true;
+}
+
+bool Bz2File::find_block(size_t index) {
+    while (blocks_.size() <= index) {
+        if (!find_next_block()) {
+            return false;
         }
     }
-    return count;
+    return true;
 }
 
-void Bz2File::clear() noexcept {
-    std::clearerr(file_);
+std::future<std::vector<char>> Bz2File::decompress_async(size_t index) {
+    auto block = blocks_[index];
+    auto first = block.start / 8;
+    auto last = (block.end + 7) / 8;
+
+    // read the compressed data for this block from the current thread
+    auto data = std::vector<uint8_t>(static_cast<size_t>(last - first) + 1, 0);
+    input_.clear();
+    input_.seekg(static_cast<std::streamoff>(first));
+    input_.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(last - first));
+    if (!input_) {
+        throw file_error("IO error while reading bzip2 file");
+    }
+
+    return pool_->submit([compressed = std::move(data), start = block.start % 8, count = block.end - block.start]() {
+        return decompress_block(compressed, start, count);
+    });
 }
 
+bool Bz2File::load_block(size_t index) {
+    auto sequential = index == block_ + 1;
+    try {
+        if (!prefetch_.empty() && prefetch_start_ == index) {
+            auto future = std::move(prefetch_.front());
+            prefetch_.pop_front();
+            prefetch_start_++;
+            current_ = future.get();
+        } else {
+            prefetch_.clear();
+            if (!find_block(index)) {
+                return false;
+            }
+            current_ = decompress_async(index).get();
+            prefetch_start_ = index + 1;
+        }
+    } catch (const FileError&) {
+        // this block could not be found or decompressed on its own, either
+        // because the file is corrupted, or because a magic was found by
+        // chance inside the compressed data. Sequential decompression will
+        // give an error in the first case.
+        start_sequential(offsets_[index]);
+        return false;
+    }
+
+    block_ = index;
+    current_offset_ = 0;
+    if (offsets_.size() == index + 1) {
+        offsets_.push_back(offsets_.back() + current_.size());
+    }
+
+    // when reading sequentially, start decompressing the next blocks. This is
+    // not done for random access, since the work would be wasted
+    while (sequential && pool_->size() > 1 && prefetch_.size() < pool_->size()) {
+        auto next = prefetch_start_ + prefetch_.size();
+        try {
+            if (!find_block(next)) {
+                break;
+            }
+            prefetch_.emplace_back(decompress_async(next));
+        } catch (const FileError&) {
+            // the same error will happen again when loading this block
+            break;
+        }
+    }
+
+    return true;
+}
+
+size_t Bz2File::read(char* data, size_t count) {
+    size_t done = 0;
+    while (done < count && !sequential_) {
+        if (block_ == static_cast<size_t>(-1) || current_offset_ == current_.size()) {
+            if (!load_block(block_ + 1)) {
+                break;
+            }
+            continue;
+        }
+
+        auto size = std::min(count - done, current_.size() - current_offset_);
+        std::memcpy(data + done, current_.data() + current_offset_, size);
+        current_offset_ += size;
+        done += size;
+    }
+
+    if (sequential_) {
+        done += read_sequential(data + done, count - done);
+    }
+    return done;
+}
+
+void Bz2File::clear() noexcept {}
+
 void Bz2File::seek(uint64_t position) {
     assert(mode_ == File::READ);
-    // Reset stream state
-    stream_end_(&stream_);
+    if (sequential_) {
+        seek_sequential(position);
+        return;
+    }
+
+    // find the last block with a known offset starting before `position`
+    auto it = std::upper_bound(offsets_.begin(), offsets_.end(), position);
+    auto index = static_cast<size_t>(std::distance(offsets_.begin(), it)) - 1;
+    if (index != block_ || current_.empty()) {
+        if (!load_block(index)) {
+            if (sequential_) {
+                seek_sequential(position);
+                return;
+            }
+            // seeking past the end of the file, the next call to `read` will
+            // try to load this block again and return 0
+            block_ = index - 1;
+            current_.clear();
+            current_offset_ = 0;
+            return;
+        }
+    }
+
+    // skip forward to the requested position
+    while (position >= offsets_[block_] + current_.size()) {
+        if (!load_block(block_ + 1)) {
+            if (sequential_) {
+                seek_sequential(position);
+                return;
+            }
+            // seeking past the end of the file
+            current_offset_ = current_.size();
+            return;
+        }
+    }
+    current_offset_ = static_cast<size_t>(position - offsets_[block_]);
+}
+
+void Bz2File::start_sequential(uint64_t position) {
+    // the results of the blocks decompressed in the background are no longer
+    // needed
+    prefetch_.clear();
+    current_.clear();
+    current_offset_ = 0;
+
+    buffer_.resize(SEQUENTIAL_BUFFER_SIZE);
+    restart_sequential();
+    seek_sequential(position);
+}
+
+void Bz2File::restart_sequential() {
+    if (sequential_) {
+        BZ2_bzDecompressEnd(&stream_);
+    }
     std::memset(&stream_, 0, sizeof(bz_stream));
     check(BZ2_bzDecompressInit(&stream_, 0, 0));
+    sequential_ = true;
+    sequential_eof_ = false;
+    position_ = 0;
 
-    // Dumb implementation, re-decompressing the file from the begining
-    std::fseek(file_, 0, SEEK_SET);
-    constexpr size_t BUFFSIZE = 4096;
-    char buffer[BUFFSIZE];
+    input_.clear();
+    input_.seekg(0);
+}
 
-    while (position > BUFFSIZE) {
-        auto count = this->read(buffer, BUFFSIZE);
-        assert(count == BUFFSIZE);
-        position -= count;
+size_t Bz2File::read_sequential(char* data, size_t count) {
+    size_t done = 0;
+    while (done < count && !sequential_eof_) {
+        if (stream_.avail_in == 0) {
+            input_.clear();
+            input_.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+            if (input_.bad()) {
+                throw file_error("IO error while reading bzip2 file");
+            }
+            stream_.next_in = buffer_.data();
+            stream_.avail_in = static_cast<unsigned>(input_.gcount());
+            if (stream_.avail_in == 0) {
+                if (position_ == 0 && stream_.total_in_lo32 == 0) {
+                    // empty file
+                    sequential_eof_ = true;
+                    break;
+                }
+                throw file_error("bzip2: unexpected end of file");
+            }
+        }
+
+        stream_.next_out = data + done;
+        stream_.avail_out = checked_cast(count - done);
+        auto status = BZ2_bzDecompress(&stream_);
+        auto produced = count - done - stream_.avail_out;
+        done += produced;
+        position_ += produced;
+
+        if (status == BZ_STREAM_END) {
+            // look for another stream after this one
+            auto* next_in = stream_.next_in;
+            auto avail_in = stream_.avail_in;
+            BZ2_bzDecompressEnd(&stream_);
+            std::memset(&stream_, 0, sizeof(bz_stream));
+            check(BZ2_bzDecompressInit(&stream_, 0, 0));
+            stream_.next_in = next_in;
+            stream_.avail_in = avail_in;
+
+            if (stream_.avail_in == 0) {
+                input_.clear();
+                input_.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+                stream_.next_in = buffer_.data();
+                stream_.avail_in = static_cast<unsigned>(input_.gcount());
+            }
+            if (stream_.avail_in == 0 || stream_.next_in[0] != 'B') {
+                sequential_eof_ = true;
+            }
+        } else if (status != BZ_OK) {
+            check(status);
+        }
+    }
+    return done;
+}
+
+void Bz2File::seek_sequential(uint64_t position) {
+    if (position < position_) {
+        restart_sequential();
     }
 
-    auto count = this->read(buffer, static_cast<size_t>(position));
-    assert(count == position);
-    // silent "unused variable" when compiling without assertions
-    (void)count;
+    auto buffer = std::vector<char>(static_cast<size_t>(std::min<uint64_t>(position - position_, SEQUENTIAL_BUFFER_SIZE)));
+    while (position_ < position && !sequential_eof_) {
+        auto size = static_cast<size_t>(std::min<uint64_t>(position - position_, buffer.size()));
+        read_sequential(buffer.data(), size);
+    }
 }
 
 void Bz2File::write(const char* data, size_t count) {
@@ -2,8 +2,16 @@
 // Copyright (C) Guillaume Fraux and contributors -- BSD license
 #include <cstdio>
 #include <cstdint>
+#include <cstring>
+#include <deque>
 #include <limits>
+#include <memory>
 #include <string>
+#include <vector>
+#include <future>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
 
 #define ZLIB_CONST
 #include <zconf.h>
@@ -12,6 +20,7 @@
 #include "chemfiles/File.hpp"
 #include "chemfiles/error_fmt.hpp"
 #include "chemfiles/unreachable.hpp"
+#include "chemfiles/ThreadPool.hpp"
 
 #include "chemfiles/files/MemoryBuffer.hpp"
 #include "chemfiles/files/GzFile.hpp"
@@ -26,44 +35,297 @@ static unsigned checked_cast(size_t value) {
     }
 }
 
-GzFile::GzFile(const std::string& path, File::Mode mode): TextFileImpl(path) {
+/// Minimal distance between two access points in the uncompressed data
+static constexpr uint64_t ACCESS_POINT_SPAN = 1024 * 1024;
+/// Size of the buffer for compressed data
+static constexpr size_t INPUT_BUFFER_SIZE = 64 * 1024;
+/// Size of the deflate window, i.e. maximal distance of back-references
+static constexpr size_t WINDOW_SIZE = 32 * 1024;
+/// Window bits for inflateInit2 to read raw deflate data
+static constexpr int RAW_DEFLATE = -15;
+/// Window bits for inflateInit2 to read gzip data
+static constexpr int GZIP_DEFLATE = 15 + 16;
+/// Compression level used when writing files
+static constexpr int COMPRESSION_LEVEL = 7;
+/// Size of the uncompressed chunks compressed in parallel when writing
+static constexpr size_t WRITE_CHUNK_SIZE = 256 * 1024;
+
+GzFile::GzFile(const std::string& path, File::Mode mode, bool parallel): TextFileImpl(path) {
     const char* openmode;
     switch (mode) {
     case File::READ:
-        openmode = "rb";
+        openmode = nullptr;
         break;
     case File::WRITE:
-        openmode = "wb7";
+        openmode = parallel ? "wb" : "wb7";
         break;
     case File::APPEND:
-        openmode = "ab7";
+        openmode = parallel ? "ab" : "ab7";
         break;
     default:
         unreachable();
     }
 
-    file_ = gzopen64(path.c_str(), openmode);
-    if (file_ == nullptr) {
+    if (openmode != nullptr && parallel) {
+        output_ = std::fopen(path.c_str(), openmode);
+        if (output_ == nullptr) {
+            throw file_error("could not open the file at '{}'", path);
+        }
+        pool_ = ThreadPool::shared();
+        crc_ = crc32(0, nullptr, 0);
+
+        // minimal gzip header, with no file name and no modification time.
+        // When appending, this starts a new gzip member.
+        const unsigned char header[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3};
+        if (std::fwrite(header, 1, sizeof(header), output_) != sizeof(header)) {
+            std::fclose(output_);
+            throw file_error("error while writting to gziped file");
+        }
+        return;
+    }
+
+    if (openmode != nullptr) {
+        file_ = gzopen64(path.c_str(), openmode);
+        if (file_ == nullptr) {
+            throw file_error("could not open the file at '{}'", path);
+        }
+        return;
+    }
+
+    input_.open(path, std::ios::binary);
+    if (!input_) {
         throw file_error("could not open the file at '{}'", path);
     }
+
+    // like zlib's gzread, files which do not start with the gzip magic bytes
+    // are read as uncompressed data
+    unsigned char magic[2] = {0, 0};
+    input_.read(reinterpret_cast<char*>(magic), sizeof(magic));
+    auto magic_size = input_.gcount();
+    input_.clear();
+    input_.seekg(0);
+    if (magic_size != 0 && (magic_size != 2 || magic[0] != 0x1f || magic[1] != 0x8b)) {
+        transparent_ = true;
+        return;
+    }
+
+    input_buffer_.resize(INPUT_BUFFER_SIZE);
+    stream_ = std::make_unique<z_stream>();
+    stream_->zalloc = nullptr;
+    stream_->zfree = nullptr;
+    stream_->opaque = nullptr;
+    stream_->next_in = nullptr;
+    stream_->avail_in = 0;
+    auto status = inflateInit2(stream_.get(), GZIP_DEFLATE);
+    if (status != Z_OK) {
+        stream_.reset();
+        throw file_error("error creating gz stream: {}", zError(status));
+    }
 }
 
 GzFile::~GzFile() {
     if (file_ != nullptr) {
         gzclose(file_);
     }
+
+    if (output_ != nullptr) {
+        try {
+            finish();
+        } catch (...) {
+            // not much we can do here ...
+        }
+        // the remaining compression tasks (if any) only use their own
+        // copy of the data, and do not need to finish before this
+        compressing_.clear();
+        std::fclose(output_);
+    }
+
+    if (stream_) {
+        inflateEnd(stream_.get());
+    }
 }
 
 size_t GzFile::read(char* data, size_t count) {
-    auto read = gzread(file_, data, checked_cast(count));
-    const auto* error = check_error();
-    if (read == -1 || error != nullptr) {
-        throw file_error("error while reading gziped file: {}", error);
+    if (transparent_) {
+        input_.read(data, static_cast<std::streamsize>(count));
+        if (input_.bad()) {
+            throw file_error("IO error while reading gziped file");
+        }
+        auto read = static_cast<size_t>(input_.gcount());
+        position_ += read;
+        return read;
+    }
+
+    size_t done = 0;
+    while (done < count && !eof_) {
+        done += inflate_block(data + done, count - done);
+    }
+    return done;
+}
+
+size_t GzFile::ensure_input(size_t count) {
+    auto available = static_cast<size_t>(stream_->avail_in);
+    if (available >= count) {
+        return available;
+    }
+
+    // move the remaining data to the start of the buffer, and fill the rest
+    if (available != 0) {
+        std::memmove(input_buffer_.data(), stream_->next_in, available);
+    }
+    input_.read(
+        reinterpret_cast<char*>(input_buffer_.data() + available),
+        static_cast<std::streamsize>(input_buffer_.size() - available)
+    );
+    if (input_.bad()) {
+        throw file_error("IO error while reading gziped file");
+    }
+    auto read = static_cast<size_t>(input_.gcount());
+    input_end_ += read;
+
+    stream_->next_in = input_buffer_.data();
+    stream_->avail_in = static_cast<unsigned>(available + read);
+    return available + read;
+}
+
+size_t GzFile::inflate_block(char* data, size_t count) {
+    if (ensure_input(1) == 0) {
+        if (member_start_) {
+            eof_ = true;
+            return 0;
+        } else {
+            throw file_error("error while reading gziped file: unexpected end of file");
+        }
+    }
+
+    stream_->next_out = reinterpret_cast<Bytef*>(data);
+    stream_->avail_out = checked_cast(count);
+
+    auto status = inflate(stream_.get(), Z_BLOCK);
+    if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+        const auto* message = stream_->msg != nullptr ? stream_->msg : zError(status);
+        throw file_error("error while reading gziped file: {}", message);
+    }
+    member_start_ = false;
+
+    auto produced = count - stream_->avail_out;
+    position_ += produced;
+
+    if (status == Z_STREAM_END) {
+        end_member();
+    } else {
+        add_access_point();
+    }
+    return produced;
+}
+
+void GzFile::end_member() {
+    if (raw_) {
+        // raw deflate streams do not include the gzip trailer (CRC32 and size)
+        if (ensure_input(8) < 8) {
+            throw file_error("error while reading gziped file: unexpected end of file");
+        }
+        stream_->next_in += 8;
+        stream_->avail_in -= 8;
+    }
+
+    // look for another gzip member, ignoring any trailing garbage like gzip
+    // and zlib's gzread do
+    if (ensure_input(2) < 2 || stream_->next_in[0] != 0x1f || stream_->next_in[1] != 0x8b) {
+        eof_ = true;
+        return;
+    }
+
+    inflateReset2(stream_.get(), GZIP_DEFLATE);
+    raw_ = false;
+    member_start_ = true;
+}
+
+void GzFile::add_access_point() {
+    // we can only restart decompression at the end of a deflate block, which
+    // is not the last block in the gzip member
+    auto data_type = stream_->data_type;
+    if ((data_type & 128) == 0 || (data_type & 64) != 0) {
+        return;
+    }
+
+    auto last = access_points_.empty() ? 0 : access_points_.back().uncompressed;
+    if (position_ < last + ACCESS_POINT_SPAN) {
+        return;
+    }
+
+    auto point = AccessPoint();
+    point.uncompressed = position_;
+    point.compressed = input_end_ - stream_->avail_in;
+    point.bits = data_type & 7;
+    point.window.resize(WINDOW_SIZE);
+    auto size = static_cast<uInt>(WINDOW_SIZE);
+    auto status = inflateGetDictionary(stream_.get(), point.window.data(), &size);
+    if (status != Z_OK) {
+        return;
+    }
+    point.window.resize(size);
+    access_points_.emplace_back(std::move(point));
+}
+
+void GzFile::restart() {
+    input_.clear();
+    input_.seekg(0);
+    input_end_ = 0;
+    stream_->next_in = nullptr;
+    stream_->avail_in = 0;
+    inflateReset2(stream_.get(), GZIP_DEFLATE);
+
+    raw_ = false;
+    member_start_ = true;
+    eof_ = false;
+    position_ = 0;
+}
+
+void GzFile::restart(const AccessPoint& point) {
+    auto offset = point.compressed - (point.bits != 0 ? 1 : 0);
+    input_.clear();
+    input_.seekg(static_cast<std::streamoff>(offset));
+    input_end_ = offset;
+    stream_->next_in = nullptr;
+    stream_->avail_in = 0;
+    inflateReset2(stream_.get(), RAW_DEFLATE);
+
+    if (point.bits != 0) {
+        if (ensure_input(1) == 0) {
+            throw file_error("error while seeking gziped file: unexpected end of file");
+        }
+        auto byte = static_cast<int>(stream_->next_in[0]);
+        stream_->next_in += 1;
+        stream_->avail_in -= 1;
+        inflatePrime(stream_.get(), point.bits, byte >> (8 - point.bits));
+    }
+    inflateSetDictionary(stream_.get(), point.window.data(), static_cast<uInt>(point.window.size()));
+
+    raw_ = true;
+    member_start_ = false;
+    eof_ = false;
+    position_ = point.uncompressed;
+}
+
+void GzFile::skip(uint64_t count) {
+    auto buffer = std::vector<char>(std::min<uint64_t>(count, INPUT_BUFFER_SIZE));
+    while (count != 0 && !eof_) {
+        auto size = static_cast<size_t>(std::min<uint64_t>(count, buffer.size()));
+        count -= inflate_block(buffer.data(), size);
     }
-    return static_cast<size_t>(read);
 }
 
 void GzFile::write(const char* data, size_t count) {
+    if (output_ != nullptr) {
+        pending_.insert(pending_.end(), data, data + count);
+        position_ += count;
+        while (pending_.size() >= WRITE_CHUNK_SIZE) {
+            compress_pending();
+        }
+        return;
+    }
+
     auto actual = gzwrite(file_, data, checked_cast(count));
     const auto* error = check_error();
     if (actual == 0 || error != nullptr) {
@@ -74,6 +336,125 @@ void GzFile::write(const char* data, size_t count) {
     }
 }
 
+void GzFile::compress_pending() {
+    // wait for the oldest chunk if all threads are busy
+    while (compressing_.size() >= pool_->size()) {
+        write_chunk();
+    }
+
+    auto size = std::min(pending_.size(), WRITE_CHUNK_SIZE);
+    auto end = pending_.begin() + static_cast<std::ptrdiff_t>(size);
+    auto input = std::vector<unsigned char>(pending_.begin(), end);
+    pending_.erase(pending_.begin(), end);
+
+    compressing_.emplace_back(pool_->submit([input, dictionary = dictionary_]() {
+        return compress_chunk(input, dictionary);
+    }));
+
+    // the end of this chunk is the dictionary for the next one
+    auto dictionary_size = std::min(input.size(), WINDOW_SIZE);
+    if (dictionary_size < WINDOW_SIZE) {
+        dictionary_.insert(dictionary_.end(), input.begin(), input.end());
+        if (dictionary_.size() > WINDOW_SIZE) {
+            dictionary_.erase(dictionary_.begin(), dictionary_.end() - static_cast<std::ptrdiff_t>(WINDOW_SIZE));
+        }
+    } else {
+        dictionary_.assign(input.end() - static_cast<std::ptrdiff_t>(dictionary_size), input.end());
+    }
+}
+
+void GzFile::write_chunk() {
+    auto future = std::move(compressing_.front());
+    compressing_.pop_front();
+    auto chunk = future.get();
+
+    auto written = std::fwrite(chunk.data.data(), 1, chunk.data.size(), output_);
+    if (written != chunk.data.size()) {
+        throw file_error("error while writting to gziped file");
+    }
+    crc_ = crc32_combine64(crc_, chunk.crc, static_cast<z_off64_t>(chunk.size));
+    written_ += chunk.size;
+}
+
+void GzFile::set_thread_pool(std::shared_ptr<ThreadPool> pool) {
+    if (output_ == nullptr) {
+        return;
+    }
+
+    // finish the chunks already sent to the previous pool
+    while (!compressing_.empty()) {
+        write_chunk();
+    }
+    pool_ = std::move(pool);
+}
+
+void GzFile::finish() {
+    if (!pending_.empty()) {
+        compress_pending();
+    }
+    while (!compressing_.empty()) {
+        write_chunk();
+    }
+
+    // all chunks end on a byte boundary, so we can add an empty final block
+    // with fixed Huffman codes, followed by the gzip trailer: CRC32 and size
+    // of the data modulo 2^32, both in little endian
+    unsigned char trailer[10] = {3, 0};
+    for (size_t i = 0; i < 4; i++) {
+        trailer[2 + i] = static_cast<unsigned char>((crc_ >> (8 * i)) & 0xff);
+        trailer[6 + i] = static_cast<unsigned char>((written_ >> (8 * i)) & 0xff);
+    }
+    if (std::fwrite(trailer, 1, sizeof(trailer), output_) != sizeof(trailer)) {
+        throw file_error("error while writting to gziped file");
+    }
+}
+
+GzFile::CompressedChunk GzFile::compress_chunk(const std::vector<unsigned char>& input, const std::vector<unsigned char>& dictionary) {
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    auto status = deflateInit2(&stream, COMPRESSION_LEVEL, Z_DEFLATED, RAW_DEFLATE, 8, Z_DEFAULT_STRATEGY);
+    if (status != Z_OK) {
+        throw file_error("error creating gz stream: {}", zError(status));
+    }
+
+    if (!dictionary.empty()) {
+        deflateSetDictionary(&stream, dictionary.data(), static_cast<uInt>(dictionary.size()));
+    }
+
+    auto chunk = CompressedChunk();
+    // Z_SYNC_FLUSH adds an empty stored block of 5 bytes to align the output
+    // on a byte boundary
+    chunk.data.resize(deflateBound(&stream, checked_cast(input.size())) + 5);
+    stream.next_in = input.data();
+    stream.avail_in = checked_cast(input.size());
+
+    // deflateBound is only guaranteed for Z_FINISH. If the output buffer is
+    // full, the flush might not be complete, and deflate must be called
+    // again with more output space.
+    size_t used = 0;
+    while (true) {
+        stream.next_out = chunk.data.data() + used;
+        stream.avail_out = checked_cast(chunk.data.size() - used);
+        status = deflate(&stream, Z_SYNC_FLUSH);
+        used = chunk.data.size() - stream.avail_out;
+        if (status != Z_OK || stream.avail_out != 0) {
+            break;
+        }
+        chunk.data.resize(2 * chunk.data.size());
+    }
+
+    auto remaining = stream.avail_in;
+    deflateEnd(&stream);
+    if (status != Z_OK || remaining != 0) {
+        throw file_error("error while compressing data for gziped file");
+    }
+
+    chunk.data.resize(used);
+    chunk.crc = crc32(0, input.data(), checked_cast(input.size()));
+    chunk.size = input.size();
+    return chunk;
+}
+
 const char* GzFile::check_error() const {
     int status = Z_OK;
     const auto* message = gzerror(file_, &status);
@@ -81,19 +462,66 @@ const char* GzFile::check_error() const {
 }
 
 void GzFile::clear() noexcept {
-    gzclearerr(file_);
+    if (file_ != nullptr) {
+        gzclearerr(file_);
+    }
 }
 
 void GzFile::seek(uint64_t position) {
-    static_assert(
-        sizeof(uint64_t) == sizeof(z_off64_t),
-        "uint64_t and z_off64_t do not have the same size"
+    if (output_ != nullptr) {
+        // data is compressed in background threads, seeking is only
+        // possible to the current position
+        if (position != position_) {
+            throw file_error("can not seek in gziped file opened for parallel writing");
+        }
+        return;
+    }
+
+    if (file_ != nullptr) {
+        static_assert(
+            sizeof(uint64_t) == sizeof(z_off64_t),
+            "uint64_t and z_off64_t do not have the same size"
+        );
+        auto status = gzseek64(file_, static_cast<z_off64_t>(position), SEEK_SET);
+        if (status == -1) {
+            const auto* message = check_error();
+            throw file_error("error while seeking gziped file: {}", message);
+        }
+        return;
+    }
+
+    if (transparent_) {
+        input_.clear();
+        input_.seekg(static_cast<std::streamoff>(position));
+        if (input_.fail()) {
+            throw file_error("error while seeking gziped file");
+        }
+        position_ = position;
+        return;
+    }
+
+    // find the last access point before `position`
+    auto it = std::upper_bound(access_points_.begin(), access_points_.end(), position,
+        [](uint64_t value, const AccessPoint& point) {
+            return value < point.uncompressed;
+        }
     );
-    auto status = gzseek64(file_, static_cast<z_off64_t>(position), SEEK_SET);
-    if (status == -1) {
-        const auto* message = check_error();
-        throw file_error("error while seeking gziped file: {}", message);
+    const AccessPoint* point = nullptr;
+    if (it != access_points_.begin()) {
+        point = &*std::prev(it);
     }
+
+    // continue from the current position if it is the closest one
+    auto closest = point != nullptr ? point->uncompressed : 0;
+    if (position < position_ || closest > position_) {
+        if (point != nullptr) {
+            restart(*point);
+        } else {
+            restart();
+        }
+    }
+
+    skip(position - position_);
 }
 
 MemoryBuffer chemfiles::decompress_gz(const char* src, size_t size) {
@@ -110,6 +110,7 @@ void MemoryBuffer::set_size(size_t len) {
 void MemoryBuffer::decompress(File::Compression compression) {
     switch(compression) {
     case File::GZIP:
+    case File::GZIP_PARALLEL:
         *this = decompress_gz(this->data(), this->size());
         break;
     case File::LZMA:
@@ -4,10 +4,14 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <atomic>
 #include <string>
+#include <algorithm>
+#include <string_view>
 
 #include "chemfiles/unreachable.hpp"
 #include "chemfiles/error_fmt.hpp"
+#include "chemfiles/misc.hpp"
 
 #include "chemfiles/File.hpp"
 #include "chemfiles/files/PlainFile.hpp"
@@ -29,6 +33,28 @@ using namespace chemfiles;
     static_assert(_FILE_OFFSET_BITS == 64, "_FILE_OFFSET_BITS must be 64");
 #endif
 
+#if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+    #define CHEMFILES_PLAIN_FILE_USE_MMAP 1
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#else
+    #define CHEMFILES_PLAIN_FILE_USE_MMAP 0
+#endif
+
+/// Size of the data at the start of memory mapped files that the OS is asked
+/// to load immediately
+static constexpr size_t MMAP_WILLNEED_SIZE = 4 * 1024 * 1024;
+
+static std::atomic<bool> MEMORY_MAPPING_ENABLED(false);
+
+void chemfiles::set_memory_mapping(bool enabled) {
+    MEMORY_MAPPING_ENABLED = enabled;
+}
+
+bool chemfiles::memory_mapping_enabled() {
+    return MEMORY_MAPPING_ENABLED;
+}
+
 PlainFile::PlainFile(const std::string& path, File::Mode mode): TextFileImpl(path) {
     // We need to use binary mode when opening the file because we are storing
     // positions in the files relative to line ending positions. Using text
@@ -56,19 +82,68 @@ PlainFile::PlainFile(const std::string& path, File::Mode mode): TextFileImpl(pat
     if (file_ == nullptr){
         throw file_error("could not open the file at '{}'", path);
     }
+
+    if (mode == File::READ && memory_mapping_enabled()) {
+        map_file();
+    }
 }
 
 PlainFile::~PlainFile() {
+#if CHEMFILES_PLAIN_FILE_USE_MMAP
+    if (mmap_data_ != nullptr) {
+        munmap(const_cast<char*>(mmap_data_), mmap_size_);
+    }
+#endif
+
     if (file_ != nullptr) {
         std::fclose(file_);
     }
 }
 
+void PlainFile::map_file() {
+#if CHEMFILES_PLAIN_FILE_USE_MMAP
+    struct stat file_stat;
+    auto status = fstat(fileno(file_), &file_stat);
+    // empty files can not be mapped, and the size of special files (pipes,
+    // character devices, ...) is not known in advance
+    if (status != 0 || !S_ISREG(file_stat.st_mode) || file_stat.st_size <= 0) {
+        return;
+    }
+
+    if (static_cast<uint64_t>(file_stat.st_size) > static_cast<uint64_t>(SIZE_MAX)) {
+        return;
+    }
+    auto size = static_cast<size_t>(file_stat.st_size);
+
+    auto* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileno(file_), 0);
+    if (data == MAP_FAILED) {
+        // fallback to reading with the FILE*
+        return;
+    }
+
+    // these are only hints, errors can be ignored
+    madvise(data, size, MADV_SEQUENTIAL);
+    madvise(data, std::min(size, MMAP_WILLNEED_SIZE), MADV_WILLNEED);
+
+    mmap_data_ = static_cast<const char*>(data);
+    mmap_size_ = size;
+#endif
+}
+
+std::string_view PlainFile::mapped() const {
+    return std::string_view(mmap_data_, mmap_size_);
+}
+
 void PlainFile::clear() noexcept {
     std::clearerr(file_);
 }
 
 void PlainFile::seek(uint64_t position) {
+    if (mmap_data_ != nullptr) {
+        mmap_position_ = position;
+        return;
+    }
+
     static_assert(
         sizeof(uint64_t) == sizeof(off64_t),
         "uint64_t and off64_t do not have the same size"
@@ -81,6 +156,16 @@ void PlainFile::seek(uint64_t position) {
 }
 
 size_t PlainFile::read(char* data, size_t count) {
+    if (mmap_data_ != nullptr) {
+        if (mmap_position_ >= mmap_size_) {
+            return 0;
+        }
+        auto size = std::min(count, mmap_size_ - static_cast<size_t>(mmap_position_));
+        std::memcpy(data, mmap_data_ + mmap_position_, size);
+        mmap_position_ += size;
+        return size;
+    }
+
     auto result = std::fread(data, 1, count, file_);
 
     if (std::ferror(file_) != 0) {
@@ -0,0 +1,233 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <exception>
+#include <condition_variable>
+
+#include "chemfiles/File.hpp"
+#include "chemfiles/misc.hpp"
+#include "chemfiles/error_fmt.hpp"
+
+#include "chemfiles/files/ReadAheadFile.hpp"
+
+using namespace chemfiles;
+
+/// Size of the chunks read by the background thread
+static constexpr size_t CHUNK_SIZE = 1024 * 1024;
+/// Maximal number of chunks read ahead of the current one
+static constexpr size_t READ_AHEAD_CHUNKS = 4;
+
+static std::atomic<bool> THREADED_DECOMPRESSION_ENABLED(false);
+
+void chemfiles::set_threaded_decompression(bool enabled) {
+    THREADED_DECOMPRESSION_ENABLED = enabled;
+}
+
+bool chemfiles::threaded_decompression_enabled() {
+    return THREADED_DECOMPRESSION_ENABLED;
+}
+
+ReadAheadFile::ReadAheadFile(const std::string& path, std::unique_ptr<TextFileImpl> file):
+    TextFileImpl(path), file_(std::move(file))
+{
+    start();
+}
+
+ReadAheadFile::~ReadAheadFile() {
+    stop();
+}
+
+void ReadAheadFile::start() {
+    thread_ = std::thread([this]() { this->run(); });
+}
+
+void ReadAheadFile::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    // the background thread is stopped, no need to lock the mutex anymore
+    for (auto& chunk: ready_) {
+        free_.emplace_back(std::move(chunk));
+    }
+    ready_.clear();
+    done_ = false;
+    stopping_ = false;
+    error_ = nullptr;
+}
+
+void ReadAheadFile::run() {
+    while (true) {
+        auto chunk = std::vector<char>();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() {
+                return stopping_ || ready_.size() < READ_AHEAD_CHUNKS;
+            });
+            if (stopping_) {
+                return;
+            }
+            if (!free_.empty()) {
+                chunk = std::move(free_.back());
+                free_.pop_back();
+            }
+        }
+
+        chunk.resize(CHUNK_SIZE);
+        size_t size = 0;
+        std::exception_ptr error = nullptr;
+        try {
+            while (size < chunk.size()) {
+                auto read = file_->read(chunk.data() + size, chunk.size() - size);
+                if (read == 0) {
+                    break;
+                }
+                size += read;
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+        chunk.resize(size);
+
+        auto finished = error != nullptr || size < CHUNK_SIZE;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (size != 0) {
+                ready_.emplace_back(std::move(chunk));
+            }
+            error_ = error;
+            done_ = finished;
+        }
+        condition_.notify_all();
+
+        if (finished) {
+            return;
+        }
+    }
+}
+
+size_t ReadAheadFile::read(char* data, size_t count) {
+    size_t done = 0;
+    while (done < count) {
+        if (current_offset_ == current_.size()) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!current_.empty()) {
+                current_start_ += current_.size();
+                free_.emplace_back(std::move(current_));
+                current_.clear();
+                current_offset_ = 0;
+            }
+
+            condition_.wait(lock, [this]() {
+                return !ready_.empty() || done_;
+            });
+
+            if (ready_.empty()) {
+                if (error_ != nullptr) {
+                    auto error = error_;
+                    error_ = nullptr;
+                    std::rethrow_exception(error);
+                }
+                break;
+            }
+
+            current_ = std::move(ready_.front());
+            ready_.pop_front();
+            lock.unlock();
+            // let the background thread read the next chunk
+            condition_.notify_all();
+            continue;
+        }
+
+        auto size = std::min(count - done, current_.size() - current_offset_);
+        std::memcpy(data + done, current_.data() + current_offset_, size);
+        current_offset_ += size;
+        done += size;
+    }
+    return done;
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsuggest-attribute=noreturn"
+#endif
+
+void ReadAheadFile::write(const char* /*data*/, size_t /*count*/) {
+    throw file_error("can not write to a file opened for reading");
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+void ReadAheadFile::clear() noexcept {
+    // nothing to do: the wrapped file is only used by the background thread,
+    // and compressed files can not grow after reaching the end of file
+}
+
+void ReadAheadFile::seek(uint64_t position) {
+    if (position >= current_start_ && position <= current_start_ + current_.size()) {
+        current_offset_ = static_cast<size_t>(position - current_start_);
+        return;
+    }
+
+    if (position > current_start_) {
+        // look for the position in the chunks already read
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto start = current_start_ + current_.size();
+        size_t skipped = 0;
+        for (const auto& chunk: ready_) {
+            if (position < start + chunk.size()) {
+                break;
+            }
+            start += chunk.size();
+            skipped++;
+        }
+
+        if (skipped < ready_.size()) {
+            free_.emplace_back(std::move(current_));
+            for (size_t i = 0; i < skipped; i++) {
+                free_.emplace_back(std::move(ready_.front()));
+                ready_.pop_front();
+            }
+            current_ = std::move(ready_.front());
+            ready_.pop_front();
+            current_start_ = start;
+            current_offset_ = static_cast<size_t>(position - start);
+            lock.unlock();
+            condition_.notify_all();
+            return;
+        }
+    }
+
+    stop();
+    current_.clear();
+    current_offset_ = 0;
+    current_start_ = position;
+
+    try {
+        file_->seek(position);
+    } catch (...) {
+        // the background thread is not running, mark the file as finished
+        // to prevent `read` from waiting forever
+        done_ = true;
+        throw;
+    }
+
+    start();
+}
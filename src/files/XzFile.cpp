@@ -4,13 +4,23 @@
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <utility>
 #include <string>
 #include <vector>
+#include <future>
 #include <limits>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
 
 #include <lzma.h>
 
 #include "chemfiles/File.hpp"
+#include "chemfiles/ThreadPool.hpp"
 #include "chemfiles/error_fmt.hpp"
 
 #include "chemfiles/files/XzFile.hpp"
@@ -60,44 +70,306 @@ static void open_stream_read(lzma_stream* stream) {
     check(lzma_stream_decoder(stream, memory_limit, flags));
 }
 
-XzFile::XzFile(const std::string& path, File::Mode mode): TextFileImpl(path), mode_(mode), buffer_(8192) {
-    const char* openmode = nullptr;
+/// Size of the uncompressed data in each block when writing. Smaller blocks
+/// give faster random access, larger blocks give better compression.
+static constexpr size_t WRITE_BLOCK_SIZE = 4 * 1024 * 1024;
+/// Blocks larger than this are not decompressed in memory, the file is read
+/// as a single stream instead.
+static constexpr uint64_t MAX_INDEXED_BLOCK_SIZE = 64 * 1024 * 1024;
+
+XzFile::XzFile(const std::string& path, File::Mode mode): TextFileImpl(path), mode_(mode), pool_(ThreadPool::shared()) {
     if (mode == File::READ) {
-        openmode = "rb";
+        input_.open(path, std::ios::binary);
+        if (!input_) {
+            throw file_error("could not open the file at '{}'", path);
+        }
+
+        try {
+            indexed_ = read_index();
+        } catch (const FileError&) {
+            // the index is missing or invalid, decompress the file as a
+            // single stream instead, which will report the error if needed
+            indexed_ = false;
+        }
+
+        if (indexed_) {
+            return;
+        }
+        input_.close();
+        blocks_.clear();
+
+        buffer_.resize(8192);
         open_stream_read(&stream_);
+        file_ = std::fopen(path.c_str(), "rb");
     } else if (mode == File::WRITE) {
-        openmode = "wb";
-        check(lzma_easy_encoder(&stream_, 6, LZMA_CHECK_CRC64));
-
-        stream_.next_out = buffer_.data();
-        stream_.avail_out = buffer_.size();
+        index_ = lzma_index_init(nullptr);
+        if (index_ == nullptr) {
+            throw file_error("lzma: memory allocation failed");
+        }
+        file_ = std::fopen(path.c_str(), "wb");
     } else if (mode == File::APPEND) {
         throw file_error("appending (open mode 'a') is not supported with xz files");
     }
 
-    file_ = std::fopen(path.c_str(), openmode);
     if (file_ == nullptr) {
         lzma_end(&stream_);
+        lzma_index_end(index_, nullptr);
         throw file_error("could not open the file at '{}'", path);
     }
+
+    if (mode == File::WRITE) {
+        lzma_stream_flags flags;
+        std::memset(&flags, 0, sizeof(flags));
+        flags.version = 0;
+        flags.check = LZMA_CHECK_CRC64;
+
+        uint8_t header[LZMA_STREAM_HEADER_SIZE];
+        check(lzma_stream_header_encode(&flags, header));
+        if (std::fwrite(header, 1, LZMA_STREAM_HEADER_SIZE, file_) != LZMA_STREAM_HEADER_SIZE) {
+            std::fclose(file_);
+            lzma_index_end(index_, nullptr);
+            throw file_error("error while writting data to xz file");
+        }
+    }
 }
 
 XzFile::~XzFile() {
     if (mode_ == File::WRITE) {
         try {
-            compress_and_write(LZMA_FINISH);
+            finish();
         } catch (...) {
             // not much we can do here ...
         }
+        lzma_index_end(index_, nullptr);
     }
 
+    // tasks still running in the thread pool own a copy of their data, so
+    // they can finish after this file is closed
+    prefetch_.clear();
+    compressing_.clear();
+
     lzma_end(&stream_);
     if (file_ != nullptr) {
         std::fclose(file_);
     }
 }
 
+/// Read exactly `size` bytes at `offset` in `file`
+static void read_at(std::ifstream& file, uint64_t offset, uint8_t* data, size_t size) {
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(offset));
+    file.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(size));
+    if (!file) {
+        throw file_error("IO error while reading xz file");
+    }
+}
+
+/// Deleter for `lzma_index` pointers, to use them with `std::unique_ptr`
+struct lzma_index_deleter {
+    void operator()(lzma_index* index) const {
+        lzma_index_end(index, nullptr);
+    }
+};
+using lzma_index_ptr = std::unique_ptr<lzma_index, lzma_index_deleter>;
+
+bool XzFile::read_index() {
+    input_.seekg(0, std::ios::end);
+    auto position = static_cast<uint64_t>(input_.tellg());
+
+    // Go through all the streams in the file, starting from the end. This
+    // follows the implementation of `xz --list`.
+    auto index = lzma_index_ptr();
+    while (position > 0) {
+        if (position < 2 * LZMA_STREAM_HEADER_SIZE) {
+            throw file_error("lzma: file is too small");
+        }
+
+        // skip stream padding, made of null bytes
+        uint8_t footer[LZMA_STREAM_HEADER_SIZE];
+        lzma_vli padding = 0;
+        while (true) {
+            read_at(input_, position - LZMA_STREAM_HEADER_SIZE, footer, LZMA_STREAM_HEADER_SIZE);
+            if (footer[8] != 0 || footer[9] != 0 || footer[10] != 0 || footer[11] != 0) {
+                break;
+            }
+            position -= 4;
+            padding += 4;
+            if (position < 2 * LZMA_STREAM_HEADER_SIZE) {
+                throw file_error("lzma: file is too small");
+            }
+        }
+        position -= LZMA_STREAM_HEADER_SIZE;
+
+        lzma_stream_flags footer_flags;
+        auto status = lzma_stream_footer_decode(&footer_flags, footer);
+        if (status != LZMA_OK || footer_flags.backward_size > position) {
+            throw file_error("lzma: invalid stream footer");
+        }
+
+        // decode the index of this stream
+        position -= footer_flags.backward_size;
+        auto buffer = std::vector<uint8_t>(static_cast<size_t>(footer_flags.backward_size));
+        read_at(input_, position, buffer.data(), buffer.size());
+
+        lzma_index* decoded = nullptr;
+        uint64_t memlimit = std::numeric_limits<uint64_t>::max();
+        size_t in_position = 0;
+        status = lzma_index_buffer_decode(&decoded, &memlimit, nullptr, buffer.data(), &in_position, buffer.size());
+        auto stream_index = lzma_index_ptr(decoded);
+        if (status != LZMA_OK) {
+            throw file_error("lzma: invalid index");
+        }
+
+        // check the stream header
+        auto blocks_size = lzma_index_total_size(stream_index.get());
+        if (position < blocks_size + LZMA_STREAM_HEADER_SIZE) {
+            throw file_error("lzma: invalid index");
+        }
+        position -= blocks_size + LZMA_STREAM_HEADER_SIZE;
+
+        uint8_t header[LZMA_STREAM_HEADER_SIZE];
+        read_at(input_, position, header, LZMA_STREAM_HEADER_SIZE);
+        lzma_stream_flags header_flags;
+        status = lzma_stream_header_decode(&header_flags, header);
+        if (status != LZMA_OK || lzma_stream_flags_compare(&header_flags, &footer_flags) != LZMA_OK) {
+            throw file_error("lzma: invalid stream header");
+        }
+
+        status = lzma_index_stream_flags(stream_index.get(), &footer_flags);
+        if (status == LZMA_OK) {
+            status = lzma_index_stream_padding(stream_index.get(), padding);
+        }
+        if (status == LZMA_OK && index) {
+            // on success, `lzma_index_cat` takes ownership of the memory
+            // used by `index`
+            status = lzma_index_cat(stream_index.get(), index.get(), nullptr);
+            if (status == LZMA_OK) {
+                index.release();
+            }
+        }
+        if (status != LZMA_OK) {
+            throw file_error("lzma: invalid index");
+        }
+        index = std::move(stream_index);
+    }
+
+    if (!index) {
+        return true;
+    }
+
+    lzma_index_iter iter;
+    lzma_index_iter_init(&iter, index.get());
+    while (!lzma_index_iter_next(&iter, LZMA_INDEX_ITER_NONEMPTY_BLOCK)) {
+        if (iter.block.uncompressed_size > MAX_INDEXED_BLOCK_SIZE) {
+            return false;
+        }
+
+        blocks_.push_back({
+            iter.block.compressed_file_offset,
+            iter.block.total_size,
+            iter.block.uncompressed_file_offset,
+            iter.block.uncompressed_size,
+            iter.stream.flags->check,
+        });
+    }
+
+    return true;
+}
+
+/// Decompress a single xz block, using the `check` for the stream containing
+/// it and the expected `uncompressed_size`.
+static std::vector<char> decompress_block(const std::vector<uint8_t>& input, lzma_check check_type, uint64_t uncompressed_size) {
+    lzma_filter filters[LZMA_FILTERS_MAX + 1];
+    lzma_block block;
+    std::memset(&block, 0, sizeof(block));
+    block.version = 0;
+    block.check = check_type;
+    block.filters = filters;
+    block.header_size = lzma_block_header_size_decode(input[0]);
+    if (block.header_size > input.size()) {
+        throw file_error("lzma: compressed file is corrupted");
+    }
+    check(lzma_block_header_decode(&block, nullptr, input.data()));
+
+    auto output = std::vector<char>(checked_cast(uncompressed_size));
+    size_t in_position = block.header_size;
+    size_t out_position = 0;
+    auto status = lzma_block_buffer_decode(
+        &block, nullptr,
+        input.data(), &in_position, input.size(),
+        reinterpret_cast<uint8_t*>(output.data()), &out_position, output.size()
+    );
+
+    for (size_t i = 0; filters[i].id != LZMA_VLI_UNKNOWN; i++) {
+        std::free(filters[i].options);
+    }
+    check(status);
+
+    if (out_position != output.size()) {
+        throw file_error("lzma: compressed file is corrupted");
+    }
+    return output;
+}
+
+std::future<std::vector<char>> XzFile::decompress_async(size_t index) {
+    const auto& block = blocks_[index];
+    auto data = std::vector<uint8_t>(checked_cast(block.compressed_size));
+    read_at(input_, block.compressed_offset, data.data(), data.size());
+
+    return pool_->submit([compressed = std::move(data), check_type = block.check, size = block.uncompressed_size]() {
+        return decompress_block(compressed, check_type, size);
+    });
+}
+
+void XzFile::load_block(size_t index) {
+    auto sequential = index == block_ + 1;
+    if (!prefetch_.empty() && prefetch_start_ == index) {
+        auto future = std::move(prefetch_.front());
+        prefetch_.pop_front();
+        prefetch_start_++;
+        current_ = future.get();
+    } else {
+        prefetch_.clear();
+        current_ = decompress_async(index).get();
+        prefetch_start_ = index + 1;
+    }
+    block_ = index;
+    current_offset_ = 0;
+
+    // when reading sequentially, start decompressing the next blocks
+    while (sequential && pool_->size() > 1 && prefetch_.size() < pool_->size()) {
+        auto next = prefetch_start_ + prefetch_.size();
+        if (next >= blocks_.size()) {
+            break;
+        }
+        prefetch_.emplace_back(decompress_async(next));
+    }
+}
+
 size_t XzFile::read(char* data, size_t count) {
+    if (!indexed_) {
+        return read_stream(data, count);
+    }
+
+    size_t done = 0;
+    while (done < count) {
+        if (block_ == static_cast<size_t>(-1) || current_offset_ == current_.size()) {
+            if (block_ + 1 >= blocks_.size()) {
+                break;
+            }
+            load_block(block_ + 1);
+            continue;
+        }
+
+        auto size = std::min(count - done, current_.size() - current_offset_);
+        std::memcpy(data + done, current_.data() + current_offset_, size);
+        current_offset_ += size;
+        done += size;
+    }
+    return done;
+}
+
+size_t XzFile::read_stream(char* data, size_t count) {
     auto action = LZMA_RUN;
 
     stream_.next_out = reinterpret_cast<uint8_t*>(data);
@@ -131,11 +403,44 @@ size_t XzFile::read(char* data, size_t count) {
 }
 
 void XzFile::clear() noexcept {
-    std::clearerr(file_);
+    if (file_ != nullptr) {
+        std::clearerr(file_);
+    }
 }
 
 void XzFile::seek(uint64_t position) {
     assert(mode_ == File::READ);
+    if (!indexed_) {
+        seek_stream(position);
+        return;
+    }
+
+    // find the block containing `position`
+    auto it = std::upper_bound(blocks_.begin(), blocks_.end(), position, [](uint64_t value, const Block& block) {
+        return value < block.uncompressed_offset;
+    });
+    if (it == blocks_.begin()) {
+        // the file does not contain any data
+        return;
+    }
+    auto index = static_cast<size_t>(std::distance(blocks_.begin(), it)) - 1;
+    const auto& block = blocks_[index];
+    if (position >= block.uncompressed_offset + block.uncompressed_size) {
+        // seeking past the end of the file, the next call to `read` will
+        // return 0
+        block_ = blocks_.size() - 1;
+        current_.clear();
+        current_offset_ = 0;
+        return;
+    }
+
+    if (index != block_ || current_.empty()) {
+        load_block(index);
+    }
+    current_offset_ = static_cast<size_t>(position - block.uncompressed_offset);
+}
+
+void XzFile::seek_stream(uint64_t position) {
     // Reset stream state
     lzma_end(&stream_);
     stream_ = LZMA_STREAM_INIT;
@@ -147,47 +452,118 @@ void XzFile::seek(uint64_t position) {
     char buffer[BUFFSIZE];
 
     while (position > BUFFSIZE) {
-        auto count = this->read(buffer, BUFFSIZE);
+        auto count = this->read_stream(buffer, BUFFSIZE);
         assert(count == BUFFSIZE);
         position -= count;
     }
 
-    auto count = this->read(buffer, static_cast<size_t>(position));
+    auto count = this->read_stream(buffer, static_cast<size_t>(position));
     assert(count == position);
     // silent "unused variable" when compiling without assertions
     (void)count;
 }
 
 void XzFile::write(const char* data, size_t count) {
-    stream_.next_in = reinterpret_cast<const uint8_t*>(data);
-    stream_.avail_in = count;
-    compress_and_write(LZMA_RUN);
+    pending_.insert(pending_.end(), data, data + count);
+    while (pending_.size() >= WRITE_BLOCK_SIZE) {
+        compress_pending();
+    }
+}
 
-    auto actual = count - stream_.avail_in;
-    if (actual != count) {
-        throw file_error("could not write data to the file at '{}'", this->path());
+void XzFile::compress_pending() {
+    // wait for the oldest block if all threads are busy
+    while (compressing_.size() >= pool_->size()) {
+        write_block();
     }
+
+    auto size = std::min(pending_.size(), WRITE_BLOCK_SIZE);
+    auto data = std::vector<uint8_t>(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(size));
+    pending_.erase(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(size));
+
+    compressing_.emplace_back(pool_->submit([input = std::move(data)]() {
+        return compress_block(input);
+    }));
 }
 
-void XzFile::compress_and_write(lzma_action action) {
-    lzma_ret status = LZMA_OK;
-    do {
-        status = lzma_code(&stream_, action);
+void XzFile::write_block() {
+    auto future = std::move(compressing_.front());
+    compressing_.pop_front();
+    auto block = future.get();
 
-        if (stream_.avail_out == 0 || status == LZMA_STREAM_END) {
-            auto size = buffer_.size() - stream_.avail_out;
-            auto written = std::fwrite(buffer_.data(), sizeof(uint8_t), size, file_);
-            if (written != size) {
-                throw file_error("error while writting data to xz file");
-            }
+    auto written = std::fwrite(block.data.data(), sizeof(uint8_t), block.data.size(), file_);
+    if (written != block.data.size()) {
+        throw file_error("error while writting data to xz file");
+    }
+    check(lzma_index_append(index_, nullptr, block.unpadded_size, block.uncompressed_size));
+}
 
-            stream_.next_out = buffer_.data();
-            stream_.avail_out = buffer_.size();
-        }
+void XzFile::set_thread_pool(std::shared_ptr<ThreadPool> pool) {
+    if (mode_ != File::WRITE) {
+        return;
+    }
+
+    // finish the blocks already sent to the previous pool
+    while (!compressing_.empty()) {
+        write_block();
+    }
+    pool_ = std::move(pool);
+}
 
-        check(status);
+void XzFile::finish() {
+    if (!pending_.empty()) {
+        compress_pending();
+    }
+    while (!compressing_.empty()) {
+        write_block();
+    }
+
+    auto index_size = lzma_index_size(index_);
+    auto buffer = std::vector<uint8_t>(checked_cast(index_size) + LZMA_STREAM_HEADER_SIZE);
+    size_t position = 0;
+    check(lzma_index_buffer_encode(index_, buffer.data(), &position, buffer.size()));
+
+    lzma_stream_flags flags;
+    std::memset(&flags, 0, sizeof(flags));
+    flags.version = 0;
+    flags.check = LZMA_CHECK_CRC64;
+    flags.backward_size = index_size;
+    check(lzma_stream_footer_encode(&flags, buffer.data() + position));
+
+    auto written = std::fwrite(buffer.data(), sizeof(uint8_t), buffer.size(), file_);
+    if (written != buffer.size()) {
+        throw file_error("error while writting data to xz file");
+    }
+}
 
-    } while (stream_.avail_in != 0 || (action == LZMA_FINISH && status != LZMA_STREAM_END));
+XzFile::CompressedBlock XzFile::compress_block(const std::vector<uint8_t>& input) {
+    lzma_options_lzma options;
+    if (lzma_lzma_preset(&options, 6)) {
+        throw file_error("lzma: unsupported compression options");
+    }
+    // the dictionary does not need to be larger than a block
+    options.dict_size = std::max<uint32_t>(
+        std::min<uint32_t>(options.dict_size, static_cast<uint32_t>(input.size())),
+        LZMA_DICT_SIZE_MIN
+    );
+
+    lzma_filter filters[2];
+    filters[0].id = LZMA_FILTER_LZMA2;
+    filters[0].options = &options;
+    filters[1].id = LZMA_VLI_UNKNOWN;
+    filters[1].options = nullptr;
+
+    lzma_block block;
+    std::memset(&block, 0, sizeof(block));
+    block.version = 0;
+    block.check = LZMA_CHECK_CRC64;
+    block.filters = filters;
+
+    auto output = std::vector<uint8_t>(lzma_block_buffer_bound(input.size()));
+    size_t position = 0;
+    check(lzma_block_buffer_encode(&block, nullptr, input.data(), input.size(), output.data(), &position, output.size()));
+    output.resize(position);
+
+    return {std::move(output), lzma_block_unpadded_size(&block), block.uncompressed_size};
 }
 
 MemoryBuffer chemfiles::decompress_xz(const char* src, size_t size) {
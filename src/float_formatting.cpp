@@ -0,0 +1,188 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "chemfiles/float_formatting.hpp"
+
+using namespace chemfiles;
+
+/// Powers of ten, all exactly representable as doubles
+static const double POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+};
+
+static const uint64_t INTEGER_POWERS_OF_TEN[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+
+/// Largest double such that all integers up to it are exactly representable
+static constexpr double MAX_EXACT_INTEGER = 9007199254740992.0;
+
+/// Round `value * 10^precision` to the closest integer in `rounded`. This
+/// returns false if the result can not be computed exactly, i.e. if the value
+/// is too large or too close to the middle between two integers.
+///
+/// The product is computed with a single floating point multiplication by an
+/// exact power of ten, and is thus within half an ULP of the exact product. If
+/// the fractional part is further than one ULP from 0.5, we know on which
+/// side of the middle point the exact product lies.
+static bool round_scaled(double value, unsigned precision, uint64_t& rounded) {
+    auto scaled = value * POWERS_OF_TEN[precision];
+    if (!(scaled < MAX_EXACT_INTEGER)) {
+        return false;
+    }
+
+    auto integer = std::floor(scaled);
+    auto fraction = scaled - integer;
+    auto ulp = scaled * std::numeric_limits<double>::epsilon();
+    if (std::abs(fraction - 0.5) <= ulp) {
+        return false;
+    }
+
+    rounded = static_cast<uint64_t>(integer);
+    if (fraction > 0.5) {
+        rounded += 1;
+    }
+    return true;
+}
+
+/// Write the decimal representation of `value` in `output`, returning a
+/// pointer to the end of the written data
+static char* write_integer(uint64_t value, char* output) {
+    char digits[20];
+    size_t count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    while (count != 0) {
+        *output++ = digits[--count];
+    }
+    return output;
+}
+
+/// Write exactly `count` digits of `value` (including leading zeros) in
+/// `output`, returning a pointer to the end of the written data
+static char* write_digits(uint64_t value, unsigned count, char* output) {
+    for (unsigned i = count; i > 0; i--) {
+        output[i - 1] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return output + count;
+}
+
+size_t detail::format_fixed(double value, unsigned precision, char* output) {
+    if (!std::isfinite(value) || precision > MAX_FIXED_PRECISION) {
+        return 0;
+    }
+
+    uint64_t rounded = 0;
+    if (!round_scaled(std::abs(value), precision, rounded)) {
+        return 0;
+    }
+
+    auto* out = output;
+    if (std::signbit(value)) {
+        *out++ = '-';
+    }
+
+    auto scale = INTEGER_POWERS_OF_TEN[precision];
+    out = write_integer(rounded / scale, out);
+    if (precision != 0) {
+        *out++ = '.';
+        out = write_digits(rounded % scale, precision, out);
+    }
+
+    return static_cast<size_t>(out - output);
+}
+
+size_t detail::format_general(double value, char* output) {
+    // This uses 6 significant digits, and only handles values which would not
+    // use the exponent notation, i.e. values between 1e-4 and 1e6.
+    constexpr unsigned SIGNIFICANT_DIGITS = 6;
+    if (!std::isfinite(value)) {
+        return 0;
+    }
+
+    auto* out = output;
+    if (std::signbit(value)) {
+        *out++ = '-';
+    }
+
+    auto absolute = std::abs(value);
+    if (absolute == 0) {
+        *out++ = '0';
+        return static_cast<size_t>(out - output);
+    }
+
+    if (absolute < 1e-4 || absolute >= 1e6) {
+        return 0;
+    }
+
+    // find the decimal exponent of the value, such that
+    // 10^exponent <= absolute < 10^(exponent + 1)
+    int exponent = -4;
+    while (exponent < 5 && absolute >= POWERS_OF_TEN[exponent + 5] / 1e4) {
+        exponent++;
+    }
+
+    // the exponent can be off by one around powers of ten, or after rounding
+    uint64_t rounded = 0;
+    const auto min = INTEGER_POWERS_OF_TEN[SIGNIFICANT_DIGITS - 1];
+    const auto max = INTEGER_POWERS_OF_TEN[SIGNIFICANT_DIGITS];
+    while (true) {
+        auto precision = static_cast<int>(SIGNIFICANT_DIGITS) - 1 - exponent;
+        if (precision < 0 || precision > static_cast<int>(MAX_FIXED_PRECISION)) {
+            return 0;
+        }
+
+        if (!round_scaled(absolute, static_cast<unsigned>(precision), rounded)) {
+            return 0;
+        }
+
+        if (rounded >= max) {
+            exponent++;
+        } else if (rounded < min) {
+            exponent--;
+        } else {
+            break;
+        }
+    }
+
+    if (exponent < -4 || exponent >= static_cast<int>(SIGNIFICANT_DIGITS)) {
+        return 0;
+    }
+
+    // remove trailing zeros
+    unsigned digits = SIGNIFICANT_DIGITS;
+    while (rounded % 10 == 0) {
+        rounded /= 10;
+        digits--;
+    }
+
+    if (exponent >= 0) {
+        auto integer_digits = static_cast<unsigned>(exponent) + 1;
+        if (digits <= integer_digits) {
+            out = write_integer(rounded * INTEGER_POWERS_OF_TEN[integer_digits - digits], out);
+        } else {
+            auto scale = INTEGER_POWERS_OF_TEN[digits - integer_digits];
+            out = write_integer(rounded / scale, out);
+            *out++ = '.';
+            out = write_digits(rounded % scale, digits - integer_digits, out);
+        }
+    } else {
+        *out++ = '0';
+        *out++ = '.';
+        for (int i = -1; i > exponent; i--) {
+            *out++ = '0';
+        }
+        out = write_integer(rounded, out);
+    }
+
+    return static_cast<size_t>(out - output);
+}
@@ -224,13 +224,24 @@ void AmberNetCDFBase::read_step(const size_t step, Frame& frame) {
 
     frame.resize(n_atoms_);
 
-    if (variables_.coordinates.var != nullptr) {
-        this->read_array(variables_.coordinates, frame.positions());
-    }
+    if (frame.storage() == Frame::SOA_FLOAT) {
+        if (variables_.coordinates.var != nullptr) {
+            this->read_array(variables_.coordinates, frame.positions_soa());
+        }
 
-    if (variables_.velocities.var != nullptr) {
-        frame.add_velocities();
-        this->read_array(variables_.velocities, *frame.velocities());
+        if (variables_.velocities.var != nullptr) {
+            frame.add_velocities();
+            this->read_array(variables_.velocities, *frame.velocities_soa());
+        }
+    } else {
+        if (variables_.coordinates.var != nullptr) {
+            this->read_array(variables_.coordinates, frame.positions());
+        }
+
+        if (variables_.velocities.var != nullptr) {
+            frame.add_velocities();
+            this->read_array(variables_.velocities, *frame.velocities());
+        }
     }
 
     if (variables_.time.var != nullptr) {
@@ -390,6 +401,26 @@ void AmberNetCDFBase::read_array(variable_scale_t& variable, span<Vector3D> arra
     }
 }
 
+void AmberNetCDFBase::read_array(variable_scale_t& variable, Vector3DSoA& array) {
+    if (variable.var->type() == netcdf3::constants::NC_FLOAT) {
+        variable.var->read(step_, buffer_f32_);
+        for (size_t i=0; i<n_atoms_; i++) {
+            array.x[i] = static_cast<float>(variable.scale * static_cast<double>(buffer_f32_[3 * i + 0]));
+            array.y[i] = static_cast<float>(variable.scale * static_cast<double>(buffer_f32_[3 * i + 1]));
+            array.z[i] = static_cast<float>(variable.scale * static_cast<double>(buffer_f32_[3 * i + 2]));
+        }
+    } else if (variable.var->type() == netcdf3::constants::NC_DOUBLE) {
+        variable.var->read(step_, buffer_f64_);
+        for (size_t i=0; i<n_atoms_; i++) {
+            array.x[i] = static_cast<float>(variable.scale * buffer_f64_[3 * i + 0]);
+            array.y[i] = static_cast<float>(variable.scale * buffer_f64_[3 * i + 1]);
+            array.z[i] = static_cast<float>(variable.scale * buffer_f64_[3 * i + 2]);
+        }
+    } else {
+        throw format_error("invalid type for variable, expected floating point");
+    }
+}
+
 /******************************************************************************/
 
 void AmberNetCDFBase::write_cell(const UnitCell& cell) {
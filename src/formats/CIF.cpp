@@ -187,12 +187,13 @@ void CIFFormat::write(const Frame& frame) {
     for (size_t i = 0; i < frame.size(); ++i) {
         const auto& atom = frame[i];
         auto fract = invmat * positions[i];
-        file_.print("{} {} 1.0 {:10.7f} {:10.7f} {:10.7f} {:8.5f} {:8.5f} {:8.5f}\n",
+        file_.print(FMT_COMPILE("{} {} 1.0 {:10.7f} {:10.7f} {:10.7f} {:8.5f} {:8.5f} {:8.5f}\n"),
             atom.name(), atom.type(), fract[0], fract[1], fract[2],
             positions[i][0], positions[i][1], positions[i][2]
         );
     }
 
+    file_.flush();
     current_step_++;
 }
 
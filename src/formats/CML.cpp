@@ -320,6 +320,8 @@ void CMLFormat::read_atoms(Frame& frame, const pugi::xml_node& atoms) {
 }
 
 void CMLFormat::read_bonds(Frame& frame, const pugi::xml_node& bonds) {
+    auto new_bonds = std::vector<Bond>();
+    auto bond_orders = std::vector<Bond::BondOrder>();
     for (const auto& bond: bonds.children("bond")) {
         auto atomref = bond.attribute("atomRefs2");
         auto order = bond.attribute("order");
@@ -373,8 +375,10 @@ void CMLFormat::read_bonds(Frame& frame, const pugi::xml_node& bonds) {
             }
         }
 
-        frame.add_bond(id1->second, id2->second, bond_order);
+        new_bonds.emplace_back(id1->second, id2->second);
+        bond_orders.push_back(bond_order);
     }
+    frame.add_bonds(new_bonds, bond_orders);
 }
 
 void CMLFormat::read(Frame& frame) {
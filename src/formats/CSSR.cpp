@@ -137,11 +137,13 @@ void CSSRFormat::read_next(Frame& frame) {
         }
     }
 
+    auto bonds = std::vector<Bond>();
     for (size_t i=0; i<natoms; i++) {
         for (auto j: connectivity[i]) {
-            frame.add_bond(i, j);
+            bonds.emplace_back(i, j);
         }
     }
+    frame.add_bonds(bonds);
 }
 
 void CSSRFormat::write_next(const Frame& frame) {
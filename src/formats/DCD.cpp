@@ -18,6 +18,7 @@
 #include "chemfiles/types.hpp"
 #include "chemfiles/warnings.hpp"
 #include "chemfiles/error_fmt.hpp"
+#include "chemfiles/external/span.hpp"
 
 #include "chemfiles/Frame.hpp"
 #include "chemfiles/UnitCell.hpp"
@@ -404,7 +405,16 @@ UnitCell DCDFormat::read_cell() {
 
 void DCDFormat::read_positions(Frame& frame) {
     frame.resize(n_atoms_);
-    auto positions = frame.positions();
+
+    // DCD files store each coordinate in a separate block, which maps
+    // directly to the single precision structure of arrays storage
+    auto positions = span<Vector3D>();
+    Vector3DSoA* positions_soa = nullptr;
+    if (frame.storage() == Frame::SOA_FLOAT) {
+        positions_soa = &frame.positions_soa();
+    } else {
+        positions = frame.positions();
+    }
 
     auto n_atoms_to_read = n_atoms_;
     if (!fixed_atoms_.empty()) {
@@ -412,7 +422,11 @@ void DCDFormat::read_positions(Frame& frame) {
             n_atoms_to_read = n_free_atoms_;
             for (size_t i=0; i<frame.size(); i++) {
                 if (fixed_atoms_[i].fixed) {
-                    positions[i] = fixed_atoms_[i].fixed_coord;
+                    if (positions_soa != nullptr) {
+                        positions_soa->set(i, fixed_atoms_[i].fixed_coord);
+                    } else {
+                        positions[i] = fixed_atoms_[i].fixed_coord;
+                    }
                 }
             }
         }
@@ -420,53 +434,36 @@ void DCDFormat::read_positions(Frame& frame) {
 
     buffer_.resize(n_atoms_to_read);
 
-    // read the X coordinate
-    this->expect_marker(sizeof(float) * n_atoms_to_read);
-    file_->read_f32(buffer_);
-    this->expect_marker(sizeof(float) * n_atoms_to_read);
-
-    if (n_atoms_to_read == n_atoms_) {
-        for (size_t i=0; i<n_atoms_; i++) {
-            positions[i][0] = static_cast<double>(buffer_[i]);
+    // read the X, Y and Z coordinates
+    for (size_t dim=0; dim<3; dim++) {
+        std::vector<float>* component = nullptr;
+        if (positions_soa != nullptr) {
+            component = dim == 0 ? &positions_soa->x : (dim == 1 ? &positions_soa->y : &positions_soa->z);
         }
-    } else {
-        for (size_t i=0; i<frame.size(); i++) {
-            if (!fixed_atoms_[i].fixed) {
-                positions[i][0] = static_cast<double>(buffer_[fixed_atoms_[i].free_index]);
-            }
+
+        this->expect_marker(sizeof(float) * n_atoms_to_read);
+        if (component != nullptr && n_atoms_to_read == n_atoms_) {
+            file_->read_f32(*component);
+            this->expect_marker(sizeof(float) * n_atoms_to_read);
+            continue;
         }
-    }
 
-    // read the Y coordinate
-    this->expect_marker(sizeof(float) * n_atoms_to_read);
-    file_->read_f32(buffer_);
-    this->expect_marker(sizeof(float) * n_atoms_to_read);
+        file_->read_f32(buffer_);
+        this->expect_marker(sizeof(float) * n_atoms_to_read);
 
-    if (n_atoms_to_read == n_atoms_) {
         for (size_t i=0; i<n_atoms_; i++) {
-            positions[i][1] = static_cast<double>(buffer_[i]);
-        }
-    } else {
-        for (size_t i=0; i<frame.size(); i++) {
-            if (!fixed_atoms_[i].fixed) {
-                positions[i][1] = static_cast<double>(buffer_[fixed_atoms_[i].free_index]);
+            auto index = i;
+            if (n_atoms_to_read != n_atoms_) {
+                if (fixed_atoms_[i].fixed) {
+                    continue;
+                }
+                index = fixed_atoms_[i].free_index;
             }
-        }
-    }
 
-    // read the Z coordinate
-    this->expect_marker(sizeof(float) * n_atoms_to_read);
-    file_->read_f32(buffer_);
-    this->expect_marker(sizeof(float) * n_atoms_to_read);
-
-    if (n_atoms_to_read == n_atoms_) {
-        for (size_t i=0; i<n_atoms_; i++) {
-            positions[i][2] = static_cast<double>(buffer_[i]);
-        }
-    } else {
-        for (size_t i=0; i<frame.size(); i++) {
-            if (!fixed_atoms_[i].fixed) {
-                positions[i][2] = static_cast<double>(buffer_[fixed_atoms_[i].free_index]);
+            if (component != nullptr) {
+                (*component)[i] = buffer_[index];
+            } else {
+                positions[i][dim] = static_cast<double>(buffer_[index]);
             }
         }
     }
@@ -126,30 +126,32 @@ void GROFormat::read_next(Frame& frame) {
     }
 
     auto box = file_.readline();
-    auto box_values = split(box, ' ');
+    auto box_values = std::vector<double>();
+    box_values.reserve(9);
+    scan_doubles(box, box_values);
 
     if (box_values.size() == 3) {
         auto lengths = Vector3D(
-            parse<double>(box_values[0]) * 10,
-            parse<double>(box_values[1]) * 10,
-            parse<double>(box_values[2]) * 10
+            box_values[0] * 10,
+            box_values[1] * 10,
+            box_values[2] * 10
         );
 
         frame.set_cell({lengths});
     } else if (box_values.size() == 9) {
-        auto v1_x = parse<double>(box_values[0]) * 10;
-        auto v2_y = parse<double>(box_values[1]) * 10;
-        auto v3_z = parse<double>(box_values[2]) * 10;
+        auto v1_x = box_values[0] * 10;
+        auto v2_y = box_values[1] * 10;
+        auto v3_z = box_values[2] * 10;
 
-        assert(parse<double>(box_values[3]) == 0);
-        assert(parse<double>(box_values[4]) == 0);
+        assert(box_values[3] == 0);
+        assert(box_values[4] == 0);
 
-        auto v2_x = parse<double>(box_values[5]) * 10;
+        auto v2_x = box_values[5] * 10;
 
-        assert(parse<double>(box_values[6]) == 0);
+        assert(box_values[6] == 0);
 
-        auto v3_x = parse<double>(box_values[7]) * 10;
-        auto v3_y = parse<double>(box_values[8]) * 10;
+        auto v3_x = box_values[7] * 10;
+        auto v3_y = box_values[8] * 10;
 
         auto cell = UnitCell({
             v1_x, v2_x, v3_x,
@@ -191,20 +193,16 @@ void GROFormat::write_next(const Frame& frame) {
         }
     }
 
-    const auto& positions = frame.positions();
+    // Residue ids depend on the previous atoms, compute them before
+    // formatting the atoms. -1 is used for atoms without residue id.
+    auto resids = std::vector<int64_t>(frame.size(), -1);
     for (size_t i = 0; i < frame.size(); i++) {
-        std::string resname = "XXXXX";
-        std::string resid = "-1";
         auto residue = frame.topology().residue_for_atom(i);
-        if (residue) {
-            resname = residue->name();
-            if (resname.length() > 5) {
-                warning("GRO writer",
-                    "residue '{}' name is too long, it will be truncated",
-                    resname
-                );
-                resname = resname.substr(0, 5);
-            }
+        if (residue && residue->name().length() > 5) {
+            warning("GRO writer",
+                "residue '{}' name is too long, it will be truncated",
+                residue->name()
+            );
         }
 
         if (residue && residue->id()) {
@@ -213,10 +211,10 @@ void GROFormat::write_next(const Frame& frame) {
                 warning("GRO writer", "the residue id '{}' should not be negative or zero, treating it as blank", value);
                 value = max_resid++;
                 if (value <= 99999) {
-                    resid = std::to_string(value);
+                    resids[i] = value;
                 }
             } else if (value <= 99999) {
-                resid = std::to_string(value);
+                resids[i] = value;
             } else {
                 warning("GRO writer", "too many residues, removing residue id");
             }
@@ -224,28 +222,40 @@ void GROFormat::write_next(const Frame& frame) {
             // We need to manually assign a residue ID
             auto value = max_resid++;
             if (value <= 99999) {
-                resid = std::to_string(value);
+                resids[i] = value;
             }
         }
+    }
 
-        assert(resname.length() <= 5);
-        auto pos = positions[i] / 10;
-        check_values_size(pos, 8, "atomic position");
+    const auto& positions = frame.positions();
+    auto velocities = frame.velocities();
+    file_.print_chunks(frame.size(), [&](FormatBuffer& buffer, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            std::string resname = "XXXXX";
+            auto residue = frame.topology().residue_for_atom(i);
+            if (residue) {
+                resname = residue->name().substr(0, 5);
+            }
 
-        if (frame.velocities()) {
-            auto vel = (*frame.velocities())[i] / 10;
-            check_values_size(vel, 8, "atomic velocity");
-            file_.print(
-                "{: >5}{: <5}{: >5}{: >5}{:8.3f}{:8.3f}{:8.3f}{:8.4f}{:8.4f}{:8.4f}\n",
-                resid, resname, frame[i].name(), to_gro_index(i), pos[0], pos[1], pos[2], vel[0], vel[1], vel[2]
-            );
-        } else {
-            file_.print(
-                "{: >5}{: <5}{: >5}{: >5}{:8.3f}{:8.3f}{:8.3f}\n",
-                resid, resname, frame[i].name(), to_gro_index(i), pos[0], pos[1], pos[2]
-            );
+            assert(resname.length() <= 5);
+            auto pos = positions[i] / 10;
+            check_values_size(pos, 8, "atomic position");
+
+            if (velocities) {
+                auto vel = (*velocities)[i] / 10;
+                check_values_size(vel, 8, "atomic velocity");
+                buffer.print(FMT_COMPILE(
+                    "{: >5}{: <5}{: >5}{: >5}{:8.3f}{:8.3f}{:8.3f}{:8.4f}{:8.4f}{:8.4f}\n"),
+                    resids[i], resname, frame[i].name(), to_gro_index(i), pos[0], pos[1], pos[2], vel[0], vel[1], vel[2]
+                );
+            } else {
+                buffer.print(FMT_COMPILE(
+                    "{: >5}{: <5}{: >5}{: >5}{:8.3f}{:8.3f}{:8.3f}\n"),
+                    resids[i], resname, frame[i].name(), to_gro_index(i), pos[0], pos[1], pos[2]
+                );
+            }
         }
-    }
+    });
 
     const auto& cell = frame.cell();
     // While this line is free form, we should try to print it in a pretty way that most gro parsers expect
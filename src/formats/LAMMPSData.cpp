@@ -40,10 +40,6 @@
 
 using namespace chemfiles;
 
-/// Guess molecules id from the bonds. This function return a vector containing
-/// the molecule id for each atom in the frame
-static std::vector<size_t> guess_molecules(const Frame& frame);
-
 /// Make sure the tilt factor matrix[i][j] is contained between -matrix[i][i] / 2
 /// and matrix[i][i] / 2.
 static double tilt_factor(const Matrix3D& matrix, size_t i, size_t j);
@@ -466,8 +462,9 @@ void LAMMPSDataFormat::read_bonds(Frame& frame) {
     if (nbonds_ == 0) {
         throw format_error("missing bonds count in header");
     }
-    size_t n = 0;
-    while (n < nbonds_ && !file_.eof()) {
+    auto bonds = std::vector<Bond>();
+    bonds.reserve(nbonds_);
+    while (bonds.size() < nbonds_ && !file_.eof()) {
         auto line = file_.readline();
         split_comment(line);
         if (line.empty()) {
@@ -481,13 +478,13 @@ void LAMMPSDataFormat::read_bonds(Frame& frame) {
         // LAMMPS use 1-based indexing
         auto i = parse<size_t>(splitted[2]) - 1;
         auto j = parse<size_t>(splitted[3]) - 1;
-        frame.add_bond(i, j);
-        n++;
+        bonds.emplace_back(i, j);
     }
 
-    if (file_.eof() && n < nbonds_) {
+    if (file_.eof() && bonds.size() < nbonds_) {
         throw format_error("end of file found before getting all bonds");
     }
+    frame.add_bonds(bonds);
 
     get_next_section();
 }
@@ -835,28 +832,32 @@ void LAMMPSDataFormat::write_masses(const DataTypes& types) {
 void LAMMPSDataFormat::write_atoms(const DataTypes& types, const Frame& frame) {
     file_.print("\nAtoms # full\n\n");
     const auto& positions = frame.positions();
-    auto molids = guess_molecules(frame);
-    for (size_t i=0; i<frame.size(); i++) {
-        const auto& atom = frame.topology()[i];
-        auto molid = molids[i];
-        file_.print("{} {} {} {:#g} {:#g} {:#g} {:#g} # {}\n",
-            i + 1, molid + 1, types.atom_type_id(atom) + 1, atom.charge(),
-            positions[i][0], positions[i][1], positions[i][2],
-            atom.type()
-        );
-    }
+    const auto& molecules = frame.topology().molecules();
+    file_.print_chunks(frame.size(), [&](FormatBuffer& buffer, size_t begin, size_t end) {
+        for (size_t i=begin; i<end; i++) {
+            const auto& atom = frame.topology()[i];
+            auto molid = molecules.molecule_for_atom(i);
+            buffer.print(FMT_COMPILE("{} {} {} {:#g} {:#g} {:#g} {:#g} # {}\n"),
+                i + 1, molid + 1, types.atom_type_id(atom) + 1, atom.charge(),
+                positions[i][0], positions[i][1], positions[i][2],
+                atom.type()
+            );
+        }
+    });
 }
 
 void LAMMPSDataFormat::write_velocities(const Frame& frame) {
     if (!frame.velocities()) { return; }
 
     file_.print("\nVelocities\n\n");
-    auto velocities = *frame.velocities();
-    for (size_t i=0; i<frame.size(); i++) {
-        file_.print("{} {} {} {}\n",
-            i + 1, velocities[i][0], velocities[i][1], velocities[i][2]
-        );
-    }
+    const auto& velocities = *frame.velocities();
+    file_.print_chunks(frame.size(), [&](FormatBuffer& buffer, size_t begin, size_t end) {
+        for (size_t i=begin; i<end; i++) {
+            buffer.print(FMT_COMPILE("{} {} {} {}\n"),
+                i + 1, velocities[i][0], velocities[i][1], velocities[i][2]
+            );
+        }
+    });
 }
 
 void LAMMPSDataFormat::write_bonds(const DataTypes& types, const Topology& topology) {
@@ -962,50 +963,6 @@ bool is_unused_header(std::string_view line) {
            (line.find("bodies") != std::string::npos);
 }
 
-std::vector<size_t> guess_molecules(const Frame& frame) {
-    // Initialize the molids vector with each atom in its own molecule
-    auto molids = std::vector<size_t>();
-    molids.reserve(frame.size());
-    for (size_t i=0; i<frame.size(); i++) {
-        molids.push_back(i);
-    }
-
-    for (auto bond: frame.topology().bonds()) {
-        auto i = bond[0];
-        auto j = bond[1];
-
-        // Merge the bigger molid in the smaller one
-        size_t new_id = molids[i];
-        size_t old_id = molids[j];
-        if (molids[i] > molids[j]) {
-            new_id = molids[j];
-            old_id = molids[i];
-        }
-
-        for (auto& molid: molids) {
-            if (molid == old_id) {
-                molid = new_id;
-            }
-        }
-    }
-
-    // Make sure the molids are consecutive
-    std::unordered_map<size_t, size_t> molids_mapping;
-    for (auto& molid: molids) {
-        auto it = molids_mapping.find(molid);
-        if (it != molids_mapping.end()) {
-            molid = it->second;
-        } else {
-            // We've not found this id yet
-            auto new_id = molids_mapping.size();
-            molids_mapping.insert({molid, new_id});
-            molid = new_id;
-        }
-    }
-
-    return molids;
-}
-
 double tilt_factor(const Matrix3D& matrix, size_t i, size_t j) {
     assert(i != j);
     auto factor = matrix[i][j];
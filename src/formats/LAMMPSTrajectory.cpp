@@ -633,12 +633,12 @@ void LAMMPSTrajectoryFormat::write_next(const Frame& frame) {
     for (size_t i = 0; i < frame.size(); ++i) {
         const auto& atom = frame[i];
         // LAMMPS uses atom IDs that start with 1
-        file_.print("{:d} {:g} {:g} {:g}", i + 1, positions[i][0], positions[i][1],
+        file_.print(FMT_COMPILE("{:d} {:g} {:g} {:g}"), i + 1, positions[i][0], positions[i][1],
                     positions[i][2]);
         auto type = parse_lammps_type(atom.type());
         if (type && (min_numeric_type_ == 0 || *type <= min_numeric_type_)) {
             // a valid numeric type and no other invalid types encountered previously
-            file_.print(" {:d}", *type);
+            file_.print(FMT_COMPILE(" {:d}"), *type);
             if (*type > max_numeric_type_) {
                 max_numeric_type_ = *type;
             }
@@ -647,27 +647,27 @@ void LAMMPSTrajectoryFormat::write_next(const Frame& frame) {
             auto search = type_list_.find(atom.type());
             if (search != type_list_.end()) {
                 // type has already a numeric type
-                file_.print(" {:d}", search->second);
+                file_.print(FMT_COMPILE(" {:d}"), search->second);
             } else {
                 // a new type to generate a numeric type for
                 min_numeric_type_ = max_numeric_type_;
                 ++max_numeric_type_;
                 type_list_.emplace(atom.type(), max_numeric_type_);
-                file_.print(" {:d}", max_numeric_type_);
+                file_.print(FMT_COMPILE(" {:d}"), max_numeric_type_);
                 warning("LAMMPS writer",
                         "trajectory with invalid types: generated type for '{}' is {}", atom.type(),
                         max_numeric_type_);
             }
         }
         if (has_names) {
-            file_.print(" {:s}", atom.name());
+            file_.print(FMT_COMPILE(" {:s}"), atom.name());
         }
-        file_.print(" {:g} {:g}", atom.mass(), atom.charge());
+        file_.print(FMT_COMPILE(" {:g} {:g}"), atom.mass(), atom.charge());
         if (velocities) {
             const auto& v = (*velocities)[i];
-            file_.print(" {:g} {:g} {:g}", v[0], v[1], v[2]);
+            file_.print(FMT_COMPILE(" {:g} {:g} {:g}"), v[0], v[1], v[2]);
         }
-        file_.print("\n");
+        file_.print(FMT_COMPILE("\n"));
     }
 }
 
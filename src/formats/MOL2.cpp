@@ -174,6 +174,10 @@ void MOL2Format::read_atoms(Frame& frame, size_t natoms, bool charges) {
 }
 
 void MOL2Format::read_bonds(Frame& frame, size_t nbonds) {
+    auto bonds = std::vector<Bond>();
+    auto bond_orders = std::vector<Bond::BondOrder>();
+    bonds.reserve(nbonds);
+    bond_orders.reserve(nbonds);
     for (size_t i=0; i<nbonds; i++) {
         auto line = file_.readline();
 
@@ -211,8 +215,10 @@ void MOL2Format::read_bonds(Frame& frame, size_t nbonds) {
             order = Bond::UNKNOWN;
         }
 
-        frame.add_bond(id_1, id_2, order);
+        bonds.emplace_back(id_1, id_2);
+        bond_orders.push_back(order);
     }
+    frame.add_bonds(bonds, bond_orders);
 }
 
 uint64_t read_until(TextFile& file, std::string_view tag) {
@@ -29,6 +29,7 @@ extern "C" {
 #include "chemfiles/Frame.hpp"
 #include "chemfiles/Residue.hpp"
 #include "chemfiles/Topology.hpp"
+#include "chemfiles/Connectivity.hpp"
 #include "chemfiles/Format.hpp"
 #include "chemfiles/FormatMetadata.hpp"
 
@@ -374,11 +375,14 @@ template <MolfileFormat F> void Molfile<F>::read_topology() {
         );
     }
 
+    auto bonds = std::vector<Bond>();
+    bonds.reserve(static_cast<size_t>(nbonds));
     for (size_t i = 0; i < static_cast<size_t>(nbonds); i++) {
         // Indexes are 1-based in Molfile
-        topology_->add_bond(static_cast<size_t>(from[i] - 1),
-                            static_cast<size_t>(to[i]) - 1);
+        bonds.emplace_back(static_cast<size_t>(from[i] - 1),
+                           static_cast<size_t>(to[i]) - 1);
     }
+    topology_->add_bonds(bonds);
 }
 
 // Instantiate all the templates
@@ -123,6 +123,7 @@ static Record get_record(std::string_view line);
 void PDBFormat::read_next(Frame& frame) {
     residues_.clear();
     atom_offsets_.clear();
+    conect_bonds_.clear();
 
     uint64_t position;
     bool got_end = false;
@@ -221,6 +222,7 @@ void PDBFormat::read_next(Frame& frame) {
     }
 
     chain_ended(frame);
+    frame.add_bonds(conect_bonds_);
     link_standard_residue_bonds(frame);
 }
 
@@ -472,7 +474,7 @@ void PDBFormat::read_CONECT(Frame& frame, std::string_view line) {
     auto line_length = trim(line).length();
 
     // Helper lambdas
-    auto add_bond = [&frame, &line](size_t i, size_t j) {
+    auto add_bond = [&frame, &line, this](size_t i, size_t j) {
         if (i >= frame.size() || j >= frame.size()) {
             warning("PDB reader",
                 "ignoring CONECT ('{}') with atomic indexes bigger than frame size ({})",
@@ -480,7 +482,7 @@ void PDBFormat::read_CONECT(Frame& frame, std::string_view line) {
             );
             return;
         }
-        frame.add_bond(i, j);
+        conect_bonds_.emplace_back(i, j);
     };
 
     auto read_index = [&line,this](size_t initial) -> size_t {
@@ -543,6 +545,7 @@ void PDBFormat::link_standard_residue_bonds(Frame& frame) {
     bool link_previous_nucleic = false;
     int64_t previous_residue_id = 0;
     size_t previous_carboxylic_id = 0;
+    auto bonds = std::vector<Bond>();
 
     for (const auto& residue: frame.topology().residues()) {
         auto residue_table = PDBConnectivity::find(residue.name());
@@ -569,7 +572,7 @@ void PDBFormat::link_standard_residue_bonds(Frame& frame) {
             resid == previous_residue_id + 1 )
         {
             link_previous_peptide = false;
-            frame.add_bond(previous_carboxylic_id, amide_nitrogen->second);
+            bonds.emplace_back(previous_carboxylic_id, amide_nitrogen->second);
         }
 
         if (amide_carbon != atom_name_to_index.end() ) {
@@ -586,7 +589,7 @@ void PDBFormat::link_standard_residue_bonds(Frame& frame) {
             resid == previous_residue_id + 1 )
         {
             link_previous_nucleic = false;
-            frame.add_bond(previous_carboxylic_id, three_prime_oxygen->second);
+            bonds.emplace_back(previous_carboxylic_id, three_prime_oxygen->second);
         }
 
         if (three_prime_oxygen != atom_name_to_index.end() ) {
@@ -597,7 +600,7 @@ void PDBFormat::link_standard_residue_bonds(Frame& frame) {
 
         // A special case missed by the standards committee????
         if (atom_name_to_index.count("HO5'") != 0) {
-            frame.add_bond(atom_name_to_index["HO5'"], atom_name_to_index["O5'"]);
+            bonds.emplace_back(atom_name_to_index["HO5'"], atom_name_to_index["O5'"]);
         }
 
         for (const auto& link: *residue_table) {
@@ -628,9 +631,10 @@ void PDBFormat::link_standard_residue_bonds(Frame& frame) {
                 continue;
             }
 
-            frame.add_bond(first_atom->second, second_atom->second);
+            bonds.emplace_back(first_atom->second, second_atom->second);
         }
     }
+    frame.add_bonds(bonds);
 }
 
 Record get_record(std::string_view line) {
@@ -703,7 +707,9 @@ struct ResidueInformation {
     std::string segment;
 };
 
-static ResidueInformation get_residue_information(optional<const Residue&> residue_opt, int64_t& max_resid) {
+/// Get the information to write for the given residue. If `warnings` is
+/// true, this sends a warning for each value that needs to be truncated.
+static ResidueInformation get_residue_information(optional<const Residue&> residue_opt, int64_t& max_resid, bool warnings = true) {
     ResidueInformation info;
 
     if (!residue_opt) {
@@ -721,7 +727,9 @@ static ResidueInformation get_residue_information(optional<const Residue&> resid
 
     info.resname = residue.name();
     if (info.resname.length() > 3) {
-        warning("PDB writer", "residue '{}' name is too long, it will be truncated", info.resname);
+        if (warnings) {
+            warning("PDB writer", "residue '{}' name is too long, it will be truncated", info.resname);
+        }
         info.resname = info.resname.substr(0, 3);
     }
 
@@ -731,29 +739,35 @@ static ResidueInformation get_residue_information(optional<const Residue&> resid
 
     info.chainid = residue.get<Property::STRING>("chainid").value_or(" ");
     if (info.chainid.length() > 1) {
-        warning("PDB writer",
-            "residue's chain id '{}' is too long, it will be truncated",
-            info.chainid
-        );
+        if (warnings) {
+            warning("PDB writer",
+                "residue's chain id '{}' is too long, it will be truncated",
+                info.chainid
+            );
+        }
         info.chainid = info.chainid[0];
     }
 
 
     info.insertion_code = residue.get<Property::STRING>("insertion_code").value_or("");
     if (info.insertion_code.length() > 1) {
-        warning("PDB writer",
-            "residue's insertion code '{}' is too long, it will be truncated",
-            info.insertion_code
-        );
+        if (warnings) {
+            warning("PDB writer",
+                "residue's insertion code '{}' is too long, it will be truncated",
+                info.insertion_code
+            );
+        }
         info.insertion_code = info.insertion_code[0];
     }
 
     info.segment = residue.get<Property::STRING>("segname").value_or("");
     if (info.segment.length() > 4) {
-        warning("PDB writer",
-            "residue's segment name '{}' is too long, it will be truncated",
-            info.segment
-        );
+        if (warnings) {
+            warning("PDB writer",
+                "residue's segment name '{}' is too long, it will be truncated",
+                info.segment
+            );
+        }
         info.segment = info.segment.substr(0, 4);
     }
 
@@ -812,51 +826,100 @@ void PDBFormat::write_next(const Frame& frame) {
     auto is_atom_record = std::deque<bool>(frame.size(), false);
 
     // Used for writing TER records.
-    size_t ter_count = 0;
-    optional<ResidueInformation> last_residue = nullopt;
+    struct ChunkState {
+        int64_t max_resid;
+        size_t ter_count;
+        optional<ResidueInformation> last_residue;
+    };
+
+    // The residue ids of atoms without residue and the position of TER
+    // records depend on the previous atoms. Compute them first, and store
+    // the corresponding state at the start of each chunk of atoms formatted
+    // by `print_chunks`.
+    auto chunk_states = std::vector<ChunkState>();
     std::vector<size_t> ter_serial_numbers;
+    {
+        size_t ter_count = 0;
+        optional<ResidueInformation> last_residue = nullopt;
+        const Residue* last_residue_ref = nullptr;
+        for (size_t i = 0; i < frame.size(); i++) {
+            if (i % TextFile::PRINT_CHUNK_SIZE == 0) {
+                chunk_states.push_back({max_resid, ter_count, last_residue});
+            }
 
-    const auto& positions = frame.positions();
-    for (size_t i = 0; i < frame.size(); i++) {
+            auto residue = frame.topology().residue_for_atom(i);
+            if (residue && last_residue_ref == &*residue) {
+                // same residue as the previous atom, nothing to do
+                continue;
+            }
 
-        auto altloc = frame[i].get<Property::STRING>("altloc").value_or(" ");
-        if (altloc.length() > 1) {
-            warning("PDB writer", "altloc '{}' is too long, it will be truncated", altloc);
-            altloc = altloc[0];
-        }
+            ResidueInformation resinfo;
+            if (residue) {
+                auto unused = max_resid;
+                resinfo = get_residue_information(residue, unused, false);
+            } else {
+                max_resid++;
+            }
+
+            if (last_residue && last_residue->chainid != resinfo.chainid && needs_ter_record(*last_residue)) {
+                ter_serial_numbers.push_back(i + ter_count);
+                ++ter_count;
+            }
 
-        auto residue = frame.topology().residue_for_atom(i);
-        auto resinfo = get_residue_information(residue, max_resid);
-        if (resinfo.atom_hetatm == "ATOM  ") {
-            is_atom_record[i] = true;
+            if (residue) {
+                last_residue = std::move(resinfo);
+            } else {
+                last_residue = nullopt;
+            }
+            last_residue_ref = residue ? &*residue : nullptr;
         }
+    }
 
-        assert(resinfo.resname.length() <= 3);
+    const auto& positions = frame.positions();
+    file_.print_chunks(frame.size(), [&](FormatBuffer& buffer, size_t begin, size_t end) {
+        auto state = chunk_states[begin / TextFile::PRINT_CHUNK_SIZE];
+        auto chunk_max_resid = state.max_resid;
+        auto ter_count = state.ter_count;
+        auto last_residue = std::move(state.last_residue);
+
+        for (size_t i = begin; i < end; i++) {
+            auto altloc = frame[i].get<Property::STRING>("altloc").value_or(" ");
+            if (altloc.length() > 1) {
+                warning("PDB writer", "altloc '{}' is too long, it will be truncated", altloc);
+                altloc = altloc[0];
+            }
 
-        if (last_residue && last_residue->chainid != resinfo.chainid && needs_ter_record(*last_residue)) {
-            file_.print("TER   {: >5}      {:3} {:1}{: >4s}{:1}\n",
-                to_pdb_index(static_cast<int64_t>(i + ter_count), 5),
-                last_residue->resname, last_residue->chainid, last_residue->resid, last_residue->insertion_code);
-            ter_serial_numbers.push_back(i + ter_count);
-            ++ter_count;
-        }
+            auto residue = frame.topology().residue_for_atom(i);
+            auto resinfo = get_residue_information(residue, chunk_max_resid);
+            if (resinfo.atom_hetatm == "ATOM  ") {
+                is_atom_record[i] = true;
+            }
 
-        const auto& pos = positions[i];
-        check_values_size(pos, 8, "atomic position");
-        file_.print(
-            "{: <6}{: >5} {: <4s}{:1}{:3} {:1}{: >4s}{:1}   {:8.3f}{:8.3f}{:8.3f}{:6.2f}{:6.2f}      {: <4s}{: >2s}\n",
-            resinfo.atom_hetatm, to_pdb_index(static_cast<int64_t>(i + ter_count), 5), frame[i].name(), altloc,
-            resinfo.resname, resinfo.chainid, resinfo.resid, resinfo.insertion_code,
-            pos[0], pos[1], pos[2], 1.0, 0.0, resinfo.segment, frame[i].type()
-        );
+            assert(resinfo.resname.length() <= 3);
 
-        if (residue) {
-            last_residue = std::move(resinfo);
-        } else {
-            last_residue = nullopt;
-        }
+            if (last_residue && last_residue->chainid != resinfo.chainid && needs_ter_record(*last_residue)) {
+                buffer.print(FMT_COMPILE("TER   {: >5}      {:3} {:1}{: >4s}{:1}\n"),
+                    to_pdb_index(static_cast<int64_t>(i + ter_count), 5),
+                    last_residue->resname, last_residue->chainid, last_residue->resid, last_residue->insertion_code);
+                ++ter_count;
+            }
 
-    }
+            const auto& pos = positions[i];
+            check_values_size(pos, 8, "atomic position");
+            buffer.print(FMT_COMPILE(
+                "{: <6}{: >5} {: <4s}{:1}{:3} {:1}{: >4s}{:1}   {:8.3f}{:8.3f}{:8.3f}{:6.2f}{:6.2f}      {: <4s}{: >2s}\n"),
+                resinfo.atom_hetatm, to_pdb_index(static_cast<int64_t>(i + ter_count), 5), frame[i].name(), altloc,
+                resinfo.resname, resinfo.chainid, resinfo.resid, resinfo.insertion_code,
+                pos[0], pos[1], pos[2], 1.0, 0.0, resinfo.segment, frame[i].type()
+            );
+
+            if (residue) {
+                last_residue = std::move(resinfo);
+            } else {
+                last_residue = nullopt;
+            }
+        }
+    });
 
     auto connect = std::vector<std::vector<int64_t>>(frame.size());
     for (const auto& bond : frame.topology().bonds()) {
@@ -882,13 +945,13 @@ void PDBFormat::write_next(const Frame& frame) {
         auto correction = adjust_for_ter_residues(i, ter_serial_numbers);
 
         for (size_t conect_line = 0; conect_line < lines; conect_line++) {
-            file_.print("CONECT{: >5}", to_pdb_index(correction, 5));
+            file_.print(FMT_COMPILE("CONECT{: >5}"), to_pdb_index(correction, 5));
 
             auto last = std::min(connections, 4 * (conect_line + 1));
             for (size_t j = 4 * conect_line; j < last; j++) {
-                file_.print("{: >5}", to_pdb_index(connect[i][j], 5));
+                file_.print(FMT_COMPILE("{: >5}"), to_pdb_index(connect[i][j], 5));
             }
-            file_.print("\n");
+            file_.print(FMT_COMPILE("\n"));
         }
     }
 
@@ -119,6 +119,10 @@ void SDFFormat::read_next(Frame& frame) {
         frame.add_atom(std::move(atom), Vector3D(x, y, z));
     }
 
+    auto bonds = std::vector<Bond>();
+    auto bond_orders = std::vector<Bond::BondOrder>();
+    bonds.reserve(nbonds);
+    bond_orders.reserve(nbonds);
     for (size_t i=0; i<nbonds; i++) {
         line = file_.readline();
         auto atom_1 = parse<size_t>(line.substr(0, 3));
@@ -145,8 +149,10 @@ void SDFFormat::read_next(Frame& frame) {
                 break;
         }
 
-        frame.add_bond(atom_1 - 1, atom_2 - 1, bond_order);
+        bonds.emplace_back(atom_1 - 1, atom_2 - 1);
+        bond_orders.push_back(bond_order);
     }
+    frame.add_bonds(bonds, bond_orders);
 
     // Parsing the file is more or less complete now, but atom properties can
     // still be read (until 'M  END' is reached).
@@ -126,7 +126,8 @@ Atom& SMIFormat::add_atom(Topology& topology, std::string_view atom_name) {
     topology.add_atom(Atom(std::string(atom_name)));
 
     if (!first_atom_) {
-        topology.add_bond(previous_atom_, ++current_atom_, current_bond_order_);
+        bonds_.emplace_back(previous_atom_, ++current_atom_);
+        bond_orders_.push_back(current_bond_order_);
     }
 
     first_atom_ = false;
@@ -200,7 +201,7 @@ void SMIFormat::process_property_list(Topology& topology, std::string_view smile
     }
 }
 
-void SMIFormat::check_ring_(Topology& topology, size_t ring_id) {
+void SMIFormat::check_ring_(size_t ring_id) {
     auto ring_lookup = rings_ids_.find(ring_id);
 
     if (ring_lookup == rings_ids_.end()) {
@@ -212,8 +213,8 @@ void SMIFormat::check_ring_(Topology& topology, size_t ring_id) {
     // Deviation from the standard, technically bond orders need to be equal,
     // but we will accept the stored order if the current order is single.
     // This is common practice
-    topology.add_bond(previous_atom_,
-        ring_lookup->second.first,
+    bonds_.emplace_back(previous_atom_, ring_lookup->second.first);
+    bond_orders_.push_back(
         current_bond_order_ == Bond::SINGLE ?
         ring_lookup->second.second :
         current_bond_order_
@@ -228,6 +229,8 @@ void SMIFormat::read_next(Frame& frame) {
     branch_point_ = std::stack<size_t, std::vector<size_t>>();
     rings_ids_.clear();
     residues_.clear();
+    bonds_.clear();
+    bond_orders_.clear();
     current_atom_ = 0;
     previous_atom_ = 0;
     current_bond_order_ = Bond::SINGLE;
@@ -320,7 +323,7 @@ void SMIFormat::read_next(Frame& frame) {
 
         if (is_ascii_digit(smiles[i])) {
             auto ring_id = static_cast<size_t>(smiles[i] - '0');
-            check_ring_(topology, ring_id);
+            check_ring_(ring_id);
             continue;
         }
 
@@ -371,7 +374,7 @@ void SMIFormat::read_next(Frame& frame) {
             if (i + 2 >= smiles.size()) {
                 throw format_error("SMI Reader: rings defined with '%' must be double digits");
             }
-            check_ring_(topology, parse<size_t>(smiles.substr(i + 1, 2)));
+            check_ring_(parse<size_t>(smiles.substr(i + 1, 2)));
             i += 2; // this line alone fixes most of issue 303 :)
             break;
         case '*':
@@ -386,6 +389,7 @@ void SMIFormat::read_next(Frame& frame) {
         }
     }
 
+    topology.add_bonds(bonds_, bond_orders_);
     for (auto residue: std::move(residues_)) {
         topology.add_residue(std::move(residue));
     }
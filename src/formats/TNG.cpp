@@ -23,6 +23,7 @@
 #include "chemfiles/Frame.hpp"
 #include "chemfiles/Residue.hpp"
 #include "chemfiles/Topology.hpp"
+#include "chemfiles/Connectivity.hpp"
 #include "chemfiles/UnitCell.hpp"
 #include "chemfiles/Format.hpp"
 #include "chemfiles/FormatMetadata.hpp"
@@ -296,12 +297,15 @@ void TNGFormat::read_topology(Frame& frame) {
     int64_t n_bonds = 0;
     CHECK(tng_molsystem_bonds_get(tng_, &n_bonds, from_atoms.ptr(), to_atoms.ptr()));
 
+    auto bonds = std::vector<Bond>();
+    bonds.reserve(static_cast<size_t>(n_bonds));
     for (size_t i=0; i<static_cast<size_t>(n_bonds); i++) {
-        topology.add_bond(
+        bonds.emplace_back(
             static_cast<size_t>(from_atoms[i]),
             static_cast<size_t>(to_atoms[i])
         );
     }
+    topology.add_bonds(bonds);
 
     frame.set_topology(topology);
 }
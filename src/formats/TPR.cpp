@@ -19,6 +19,7 @@
 #include "chemfiles/warnings.hpp"
 
 #include "chemfiles/Atom.hpp"
+#include "chemfiles/Connectivity.hpp"
 #include "chemfiles/File.hpp"
 #include "chemfiles/Frame.hpp"
 #include "chemfiles/Residue.hpp"
@@ -700,9 +701,9 @@ static InteractionLists read_interaction_lists(XDRFile& file, int file_version)
     return interaction_lists;
 }
 
-// Add connectivity elements i.e. bonds to the frame.
+// Add connectivity elements i.e. bonds to the list of bonds.
 // Use the atom index offset to correct for molecule-internal numbering.
-static void add_conectivity(Frame& frame, const InteractionLists& interaction_lists,
+static void add_conectivity(std::vector<Bond>& bonds, const InteractionLists& interaction_lists,
                             size_t atom_idx_offset = 0) {
     auto contains = [](const std::vector<FunctionType>& types_set,
                        FunctionType function_type) -> bool {
@@ -716,14 +717,14 @@ static void add_conectivity(Frame& frame, const InteractionLists& interaction_li
             for (size_t i = 0; i < ilist.value().size(); ++i) {
                 auto iatoms = ilist.value()[i];
                 assert(iatoms.size() == 2);
-                frame.add_bond(atom_idx_offset + iatoms[0], atom_idx_offset + iatoms[1]);
+                bonds.emplace_back(atom_idx_offset + iatoms[0], atom_idx_offset + iatoms[1]);
             }
         } else if (ilist.value().function_type == FunctionType::SETTLE) {
             for (size_t i = 0; i < ilist.value().size(); ++i) {
                 auto iatoms = ilist.value()[i];
                 assert(iatoms.size() == 3);
-                frame.add_bond(atom_idx_offset + iatoms[0], atom_idx_offset + iatoms[1]);
-                frame.add_bond(atom_idx_offset + iatoms[0], atom_idx_offset + iatoms[2]);
+                bonds.emplace_back(atom_idx_offset + iatoms[0], atom_idx_offset + iatoms[1]);
+                bonds.emplace_back(atom_idx_offset + iatoms[0], atom_idx_offset + iatoms[2]);
             }
         }
     }
@@ -1053,6 +1054,8 @@ void TPRFormat::read_topology(Frame& frame) {
     // one row are aggregated in molecule blocks.
     // see `do_molblock` but most of the code is chemfiles specific
     size_t global_atom_idx = 0; // Number of atoms in the previous molecules
+    // All the bonds in the system, added to the frame at once at the end
+    auto bonds = std::vector<Bond>();
     const size_t nmolblocks = file_.read_single_size_as_i32();
     for (size_t i = 0; i < nmolblocks; ++i) {
         // Index of the molecule type read previously
@@ -1087,9 +1090,8 @@ void TPRFormat::read_topology(Frame& frame) {
                         "residue index out of bounds, there are {} residues, got index {}",
                         moltype.atoms.residue_infos.size(), props.residue_idx);
                 }
-
-                add_conectivity(frame, moltype.interaction_lists, global_atom_idx);
             }
+            add_conectivity(bonds, moltype.interaction_lists, global_atom_idx);
             global_atom_idx += atoms.size();
             for (const auto& residue : residues_of_mol) {
                 frame.add_residue(residue);
@@ -1112,9 +1114,10 @@ void TPRFormat::read_topology(Frame& frame) {
         if (has_intermolecular_bonds) {
             InteractionLists interaction_lists =
                 read_interaction_lists(file_, header_.file_version);
-            add_conectivity(frame, interaction_lists);
+            add_conectivity(bonds, interaction_lists);
         }
     }
+    frame.add_bonds(bonds);
 
     // Skip atom types for old formats
     // see `do_atomtypes`
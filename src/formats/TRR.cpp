@@ -6,6 +6,7 @@
 #include <cstdint>
 
 #include <array>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -21,6 +22,7 @@
 #include "chemfiles/UnitCell.hpp"
 #include "chemfiles/Format.hpp"
 #include "chemfiles/FormatMetadata.hpp"
+#include "chemfiles/FrameIndex.hpp"
 
 #include "chemfiles/files/XDRFile.hpp"
 #include "chemfiles/formats/TRR.hpp"
@@ -67,6 +69,62 @@ template <> const FormatMetadata& chemfiles::format_metadata<TRRFormat>() {
     return metadata;
 }
 
+/// Convert the vectors in `buffer` from nanometers to Angstroms, and store
+/// them in `array`
+template <typename T>
+static void store_vectors(const std::vector<T>& buffer, span<Vector3D> array) {
+    assert(buffer.size() == 3 * array.size());
+    for (size_t i = 0; i < array.size(); i++) {
+        array[i][0] = static_cast<double>(buffer[i * 3]) * 10.0;
+        array[i][1] = static_cast<double>(buffer[i * 3 + 1]) * 10.0;
+        array[i][2] = static_cast<double>(buffer[i * 3 + 2]) * 10.0;
+    }
+}
+
+/// Convert the vectors in `buffer` from nanometers to Angstroms, and store
+/// them in single precision in `array`
+template <typename T>
+static void store_vectors(const std::vector<T>& buffer, Vector3DSoA& array) {
+    assert(buffer.size() == 3 * array.size());
+    for (size_t i = 0; i < array.size(); i++) {
+        array.x[i] = static_cast<float>(static_cast<double>(buffer[i * 3]) * 10.0);
+        array.y[i] = static_cast<float>(static_cast<double>(buffer[i * 3 + 1]) * 10.0);
+        array.z[i] = static_cast<float>(static_cast<double>(buffer[i * 3 + 2]) * 10.0);
+    }
+}
+
+static void read_array(XDRFile& file, std::vector<float>& buffer) {
+    file.read_f32(buffer);
+}
+
+static void read_array(XDRFile& file, std::vector<double>& buffer) {
+    file.read_f64(buffer);
+}
+
+/// Read positions and/or velocities of `frame` from `file`, using `buffer`
+/// (which must contain 3 values per atom) to store the data before converting
+/// it to the storage used by the frame
+template <typename T>
+static void read_vectors(XDRFile& file, Frame& frame, std::vector<T>& buffer, bool has_positions, bool has_velocities) {
+    if (has_positions) {
+        read_array(file, buffer);
+        if (frame.storage() == Frame::SOA_FLOAT) {
+            store_vectors(buffer, frame.positions_soa());
+        } else {
+            store_vectors(buffer, frame.positions());
+        }
+    }
+    if (has_velocities) {
+        read_array(file, buffer);
+        frame.add_velocities();
+        if (frame.storage() == Frame::SOA_FLOAT) {
+            store_vectors(buffer, *frame.velocities_soa());
+        } else {
+            store_vectors(buffer, *frame.velocities());
+        }
+    }
+}
+
 static void get_cell(std::vector<float>& box, const Frame& frame);
 static void get_positions(std::vector<float>& x, const Frame& frame);
 static void get_velocities(std::vector<float>& v, const Frame& frame);
@@ -78,7 +136,16 @@ TRRFormat::TRRFormat(std::string path, File::Mode mode, File::Compression compre
     }
 
     if (mode == File::READ) {
-        determine_frame_offsets();
+        auto offsets = load_frame_index(file_.path(), format_metadata<TRRFormat>().name);
+        if (offsets && !offsets->empty()) {
+            frame_offsets_ = std::move(*offsets);
+            // the number of atoms is still needed to read the frames
+            natoms_ = read_frame_header().natoms;
+            file_.seek(0);
+        } else {
+            determine_frame_offsets();
+            save_frame_index(file_.path(), format_metadata<TRRFormat>().name, frame_offsets_);
+        }
     } else if (mode == File::APPEND) {
         try {
             determine_frame_offsets();
@@ -89,6 +156,17 @@ TRRFormat::TRRFormat(std::string path, File::Mode mode, File::Compression compre
     }
 }
 
+TRRFormat::TRRFormat(std::string path, std::vector<uint64_t> frame_offsets, size_t natoms)
+    : file_(std::move(path), File::READ), frame_offsets_(std::move(frame_offsets)), natoms_(natoms) {}
+
+std::unique_ptr<Format> TRRFormat::reopen() const {
+    if (file_.mode() != File::READ) {
+        return nullptr;
+    }
+    // the constructor is private, so std::make_unique can not be used here
+    return std::unique_ptr<Format>(new TRRFormat(file_.path(), frame_offsets_, natoms_));
+}
+
 size_t TRRFormat::nsteps() { return frame_offsets_.size(); }
 
 void TRRFormat::read_step(size_t step, Frame& frame) {
@@ -122,54 +200,10 @@ void TRRFormat::read(Frame& frame) {
 
     if (header.use_double) {
         std::vector<double> dx(header.natoms * 3);
-        if (has_positions) {
-            file_.read_f64(dx);
-            auto positions = frame.positions();
-            assert(dx.size() == 3 * positions.size());
-            for (size_t i = 0; i < frame.size(); i++) {
-                // Factor 10 because the cell lengths are in nm in the TRR format
-                positions[i][0] = dx[i * 3] * 10.0;
-                positions[i][1] = dx[i * 3 + 1] * 10.0;
-                positions[i][2] = dx[i * 3 + 2] * 10.0;
-            }
-        }
-        if (has_velocities) {
-            file_.read_f64(dx);
-            frame.add_velocities();
-            auto velocities = *frame.velocities();
-            assert(dx.size() == 3 * velocities.size());
-            for (size_t i = 0; i < frame.size(); i++) {
-                // Factor 10 because the lengths are in nm in the TRR format
-                velocities[i][0] = dx[i * 3] * 10.0;
-                velocities[i][1] = dx[i * 3 + 1] * 10.0;
-                velocities[i][2] = dx[i * 3 + 2] * 10.0;
-            }
-        }
+        read_vectors(file_, frame, dx, has_positions, has_velocities);
     } else {
         std::vector<float> dx(header.natoms * 3);
-        if (has_positions) {
-            file_.read_f32(dx);
-            auto positions = frame.positions();
-            assert(dx.size() == 3 * positions.size());
-            for (size_t i = 0; i < frame.size(); i++) {
-                // Factor 10 because the cell lengths are in nm in the TRR format
-                positions[i][0] = static_cast<double>(dx[i * 3]) * 10.0;
-                positions[i][1] = static_cast<double>(dx[i * 3 + 1]) * 10.0;
-                positions[i][2] = static_cast<double>(dx[i * 3 + 2]) * 10.0;
-            }
-        }
-        if (has_velocities) {
-            file_.read_f32(dx);
-            frame.add_velocities();
-            auto velocities = *frame.velocities();
-            assert(dx.size() == 3 * velocities.size());
-            for (size_t i = 0; i < frame.size(); i++) {
-                // Factor 10 because the lengths are in nm in the TRR format
-                velocities[i][0] = static_cast<double>(dx[i * 3]) * 10.0;
-                velocities[i][1] = static_cast<double>(dx[i * 3 + 1]) * 10.0;
-                velocities[i][2] = static_cast<double>(dx[i * 3 + 2]) * 10.0;
-            }
-        }
+        read_vectors(file_, frame, dx, has_positions, has_velocities);
     }
 
     if (header.f_size > 0) {
@@ -92,11 +92,13 @@ void TinkerFormat::read_next(Frame& frame) {
         }
     }
 
+    auto all_bonds = std::vector<Bond>();
     for (size_t i = 0; i < n_atoms; i++) {
         for (size_t j: bonds[i]) {
-            frame.add_bond(i, j);
+            all_bonds.emplace_back(i, j);
         }
     }
+    frame.add_bonds(all_bonds);
 }
 
 void TinkerFormat::write_next(const Frame& frame) {
@@ -6,9 +6,11 @@
 #include <cstdint>
 
 #include <array>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
+#include <algorithm>
 
 #include "chemfiles/error_fmt.hpp"
 #include "chemfiles/external/optional.hpp"
@@ -21,6 +23,8 @@
 
 #include "chemfiles/Format.hpp"
 #include "chemfiles/FormatMetadata.hpp"
+#include "chemfiles/FrameIndex.hpp"
+#include "chemfiles/ThreadPool.hpp"
 
 #include "chemfiles/files/XDRFile.hpp"
 #include "chemfiles/formats/XTC.hpp"
@@ -85,7 +89,16 @@ XTCFormat::XTCFormat(std::string path, File::Mode mode, File::Compression compre
     }
 
     if (mode == File::READ) {
-        determine_frame_offsets();
+        auto offsets = load_frame_index(file_.path(), format_metadata<XTCFormat>().name);
+        if (offsets && !offsets->empty()) {
+            frame_offsets_ = std::move(*offsets);
+            // the number of atoms is still needed to read the frames
+            natoms_ = read_frame_header(file_).natoms;
+            file_.seek(0);
+        } else {
+            determine_frame_offsets();
+            save_frame_index(file_.path(), format_metadata<XTCFormat>().name, frame_offsets_);
+        }
     } else if (mode == File::APPEND) {
         try {
             determine_frame_offsets();
@@ -96,6 +109,17 @@ XTCFormat::XTCFormat(std::string path, File::Mode mode, File::Compression compre
     }
 }
 
+XTCFormat::XTCFormat(std::string path, std::vector<uint64_t> frame_offsets, size_t natoms)
+    : file_(std::move(path), File::READ), frame_offsets_(std::move(frame_offsets)), natoms_(natoms) {}
+
+std::unique_ptr<Format> XTCFormat::reopen() const {
+    if (file_.mode() != File::READ) {
+        return nullptr;
+    }
+    // the constructor is private, so std::make_unique can not be used here
+    return std::unique_ptr<Format>(new XTCFormat(file_.path(), frame_offsets_, natoms_));
+}
+
 size_t XTCFormat::nsteps() { return frame_offsets_.size(); }
 
 void XTCFormat::read_step(size_t step, Frame& frame) {
@@ -104,8 +128,55 @@ void XTCFormat::read_step(size_t step, Frame& frame) {
     read(frame);
 }
 
+/// Read the coordinates of a frame with `natoms` atoms from `file`, starting
+/// after the unit cell, and store them (in nanometers) in `buffer`. This
+/// returns the precision of compressed coordinates, or `nullopt` for
+/// uncompressed ones.
+static optional<float> read_coordinates(XDRFile& file, size_t natoms, std::vector<float>& buffer) {
+    size_t natoms_again = file.read_single_size_as_i32();
+    if (natoms_again != natoms) {
+        throw format_error("contradictory number of atoms in XTC file at '{}': expected {}, got {}",
+                           file.path(), natoms, natoms_again);
+    }
+
+    auto precision = optional<float>();
+    buffer.resize(natoms * 3);
+    if (natoms <= 9) {
+        file.read_f32(buffer);
+    } else {
+        precision = file.read_gmx_compressed_floats(buffer);
+    }
+
+    return precision;
+}
+
+/// Convert the coordinates in `buffer` to Angstroms and store them in
+/// `positions`
+static void store_positions(const std::vector<float>& buffer, span<Vector3D> positions) {
+    assert(buffer.size() == 3 * positions.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+        // Factor 10 because the cell lengths are in nm in the XTC format
+        positions[i][0] = static_cast<double>(buffer[i * 3]) * 10.0;
+        positions[i][1] = static_cast<double>(buffer[i * 3 + 1]) * 10.0;
+        positions[i][2] = static_cast<double>(buffer[i * 3 + 2]) * 10.0;
+    }
+}
+
+/// Convert the coordinates in `buffer` to Angstroms and store them in
+/// `positions`, keeping single precision
+static void store_positions(const std::vector<float>& buffer, Vector3DSoA& positions) {
+    assert(buffer.size() == 3 * positions.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+        // the product of a float by 10 is exact in double precision, so
+        // this gives the same result as rounding the double positions
+        positions.x[i] = buffer[i * 3] * 10.0f;
+        positions.y[i] = buffer[i * 3 + 1] * 10.0f;
+        positions.z[i] = buffer[i * 3 + 2] * 10.0f;
+    }
+}
+
 void XTCFormat::read(Frame& frame) {
-    FrameHeader header = read_frame_header();
+    FrameHeader header = read_frame_header(file_);
 
     frame.set_step(header.step);                         // actual step of MD Simulation
     frame.set("time", static_cast<double>(header.time)); // time in pico seconds
@@ -114,49 +185,72 @@ void XTCFormat::read(Frame& frame) {
     const auto box = file_.read_gmx_box();
     frame.set_cell(box);
 
-    size_t natoms_again = file_.read_single_size_as_i32();
-    if (natoms_again != header.natoms) {
-        throw format_error("contradictory number of atoms in XTC file at '{}': expected {}, got {}",
-                           file_.path(), header.natoms, natoms_again);
-    }
-
-    std::vector<float> x(header.natoms * 3);
-    if (header.natoms <= 9) {
-        file_.read_f32(x);
+    std::vector<float> x;
+    auto precision = read_coordinates(file_, header.natoms, x);
+    if (frame.storage() == Frame::SOA_FLOAT) {
+        store_positions(x, frame.positions_soa());
     } else {
-        float precision = file_.read_gmx_compressed_floats(x);
-        frame.set("xtc_precision", static_cast<double>(precision));
+        store_positions(x, frame.positions());
     }
-    auto positions = frame.positions();
-    assert(x.size() == 3 * positions.size());
-    for (size_t i = 0; i < frame.size(); i++) {
-        // Factor 10 because the cell lengths are in nm in the XTC format
-        positions[i][0] = static_cast<double>(x[i * 3]) * 10.0;
-        positions[i][1] = static_cast<double>(x[i * 3 + 1]) * 10.0;
-        positions[i][2] = static_cast<double>(x[i * 3 + 2]) * 10.0;
+    if (precision) {
+        frame.set("xtc_precision", static_cast<double>(*precision));
     }
 
     step_++;
 }
 
-XTCFormat::FrameHeader XTCFormat::read_frame_header() {
+void XTCFormat::read_positions_range(size_t start, span<std::vector<Vector3D>> positions, size_t threads) {
+    assert(start + positions.size() <= frame_offsets_.size());
+    threads = std::max<size_t>(std::min(threads, positions.size()), 1);
+    if (threads == 1) {
+        auto file = XDRFile(file_.path(), File::READ);
+        read_positions_chunk(file, start, positions);
+        return;
+    }
+
+    // split the steps in contiguous chunks, one for each thread
+    auto chunk_size = (positions.size() + threads - 1) / threads;
+    ThreadPool::shared()->run_chunks(threads, [&](size_t thread) {
+        auto begin = std::min(thread * chunk_size, positions.size());
+        auto count = std::min(chunk_size, positions.size() - begin);
+        // each thread needs its own file and decompression buffers
+        auto file = XDRFile(file_.path(), File::READ);
+        read_positions_chunk(file, start + begin, span<std::vector<Vector3D>>(positions.data() + begin, count));
+    });
+}
+
+void XTCFormat::read_positions_chunk(XDRFile& file, size_t start, span<std::vector<Vector3D>> positions) const {
+    std::vector<float> buffer;
+    for (size_t i = 0; i < positions.size(); i++) {
+        file.seek(frame_offsets_[start + i]);
+        auto header = read_frame_header(file);
+        // skip the unit cell
+        file.read_gmx_box();
+
+        positions[i].resize(header.natoms);
+        read_coordinates(file, header.natoms, buffer);
+        store_positions(buffer, positions[i]);
+    }
+}
+
+XTCFormat::FrameHeader XTCFormat::read_frame_header(XDRFile& file) {
     try {
-        const int32_t magic = file_.read_single_i32();
+        const int32_t magic = file.read_single_i32();
         if (magic != XTC_MAGIC) {
             throw format_error("invalid XTC file at '{}': "
                                "expected XTC_MAGIC '{}', got '{}'",
-                               file_.path(), XTC_MAGIC, magic);
+                               file.path(), XTC_MAGIC, magic);
         }
 
         FrameHeader header = {
-            file_.read_single_size_as_i32(), // natoms
-            file_.read_single_size_as_i32(), // step
-            file_.read_single_f32(),         // time
+            file.read_single_size_as_i32(), // natoms
+            file.read_single_size_as_i32(), // step
+            file.read_single_f32(),         // time
         };
 
         return header;
     } catch (const Error& e) {
-        throw format_error("could not read XTC header from '{}': {}", file_.path(), e.what());
+        throw format_error("could not read XTC header from '{}': {}", file.path(), e.what());
     }
 }
 
@@ -168,7 +262,7 @@ static int32_t round_to_int_boundary(int32_t x) {
 void XTCFormat::determine_frame_offsets() {
     uint64_t cur_pos = file_.tell();
     file_.seek(0L);
-    FrameHeader header = read_frame_header();
+    FrameHeader header = read_frame_header(file_);
 
     natoms_ = header.natoms;
 
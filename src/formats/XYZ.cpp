@@ -109,39 +109,41 @@ void XYZFormat::write_next(const Frame& frame) {
     file_.print("{}\n", frame.size());
     file_.print("{}\n", write_extended_comment_line(frame, properties));
 
-    for (size_t i = 0; i < frame.size(); i++) {
-        const auto& atom = frame[i];
+    file_.print_chunks(frame.size(), [&](FormatBuffer& buffer, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const auto& atom = frame[i];
 
-        auto name = atom.name();
-        if (name.empty()) {
-            name = "X";
-        }
+            auto name = atom.name();
+            if (name.empty()) {
+                name = "X";
+            }
 
-        file_.print("{} {:g} {:g} {:g}",
-            name, positions[i][0], positions[i][1], positions[i][2]
-        );
+            buffer.print(FMT_COMPILE("{} {:g} {:g} {:g}"),
+                name, positions[i][0], positions[i][1], positions[i][2]
+            );
 
-        for (const auto& property: properties) {
-            const auto& value = atom.get(property.name).value();
+            for (const auto& property: properties) {
+                const auto& value = atom.get(property.name).value();
 
-            if (property.type == Property::STRING) {
-                file_.print(" {}", value.as_string());
-            } else if (property.type == Property::BOOL) {
-                if (value.as_bool()) {
-                    file_.print(" T");
-                } else {
-                    file_.print(" F");
+                if (property.type == Property::STRING) {
+                    buffer.print(FMT_COMPILE(" {}"), value.as_string());
+                } else if (property.type == Property::BOOL) {
+                    if (value.as_bool()) {
+                        buffer.print(FMT_COMPILE(" T"));
+                    } else {
+                        buffer.print(FMT_COMPILE(" F"));
+                    }
+                } else if (property.type == Property::DOUBLE) {
+                    buffer.print(FMT_COMPILE(" {:g}"), value.as_double());
+                } else if (property.type == Property::VECTOR3D) {
+                    const auto& vector = value.as_vector3d();
+                    buffer.print(FMT_COMPILE(" {:g} {:g} {:g}"), vector[0], vector[1], vector[2]);
                 }
-            } else if (property.type == Property::DOUBLE) {
-                file_.print(" {:g}", value.as_double());
-            } else if (property.type == Property::VECTOR3D) {
-                const auto& vector = value.as_vector3d();
-                file_.print(" {:g} {:g} {:g}", vector[0], vector[1], vector[2]);
             }
-        }
 
-        file_.print("\n");
-    }
+            buffer.print(FMT_COMPILE("\n"));
+        }
+    });
 }
 
 optional<uint64_t> XYZFormat::forward() {
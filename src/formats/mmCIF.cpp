@@ -401,41 +401,44 @@ void mmCIFFormat::write(const Frame& frame) {
 
     const auto& topology = frame.topology();
     const auto& positions = frame.positions();
-    for (size_t i = 0; i < frame.size(); ++i) {
-        ++atoms_;
-
-        std::string compid = ".";
-        std::string asymid = ".";
-        std::string seq_id = ".";
-        std::string auth_asymid = ".";
-        std::string pdbgroup = "HETATM";
-
-        const auto& residue = topology.residue_for_atom(i);
-        if (residue) {
-            compid = residue->name();
-
-            if (residue->id()) {
-                seq_id = std::to_string(*residue->id());
-            } else {
-                seq_id = "?";
+    auto first_atom = atoms_;
+    file_.print_chunks(frame.size(), [&](FormatBuffer& buffer, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            std::string compid = ".";
+            std::string asymid = ".";
+            std::string seq_id = ".";
+            std::string auth_asymid = ".";
+            std::string pdbgroup = "HETATM";
+
+            const auto& residue = topology.residue_for_atom(i);
+            if (residue) {
+                compid = residue->name();
+
+                if (residue->id()) {
+                    seq_id = std::to_string(*residue->id());
+                } else {
+                    seq_id = "?";
+                }
+
+                asymid = residue->get<Property::STRING>("chainid").value_or("?");
+                auth_asymid = residue->get<Property::STRING>("chainname").value_or(".");
+                if (residue->get<Property::BOOL>("is_standard_pdb").value_or(false)) {
+                    pdbgroup = "ATOM  ";
+                }
             }
 
-            asymid = residue->get<Property::STRING>("chainid").value_or("?");
-            auth_asymid = residue->get<Property::STRING>("chainname").value_or(".");
-            if (residue->get<Property::BOOL>("is_standard_pdb").value_or(false)) {
-                pdbgroup = "ATOM  ";
-            }
-        }
+            const auto& atom = frame[i];
 
-        const auto& atom = frame[i];
-
-        file_.print("{} {: <5} {: <2} {: <4} {} {: >3} {} {: >4} {:8.3f} {:8.3f} {:8.3f} {:8.3f} {} {}\n",
-                pdbgroup, atoms_, atom.type(), atom.name(), ".", compid,
-                asymid, seq_id, positions[i][0], positions[i][1], positions[i][2],
-                atom.charge(), auth_asymid, models_
-        );
-    }
+            buffer.print(FMT_COMPILE("{} {: <5} {: <2} {: <4} {} {: >3} {} {: >4} {:8.3f} {:8.3f} {:8.3f} {:8.3f} {} {}\n"),
+                    pdbgroup, first_atom + i + 1, atom.type(), atom.name(), ".", compid,
+                    asymid, seq_id, positions[i][0], positions[i][1], positions[i][2],
+                    atom.charge(), auth_asymid, models_
+            );
+        }
+    });
+    atoms_ += frame.size();
 
+    file_.flush();
 }
 
 double cif_to_double(std::string_view line) {
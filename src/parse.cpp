@@ -122,104 +122,6 @@ template <> uint64_t chemfiles::parse(std::string_view input) {
 }
 
 
-template <> double chemfiles::parse(std::string_view input) {
-    if (input.empty()) {
-        throw error("can not parse a double from an empty string");
-    }
-
-    auto it = input.begin();  // NOLINT(readability-qualified-auto)
-    auto end = input.end();   // NOLINT(readability-qualified-auto)
-
-    // skip whitespaces before number
-    while (it != end && is_ascii_whitespace(*it)) {
-        it++;
-    }
-
-    // Get sign, if any.
-    int sign = 1.0;
-    if (it != end && *it == '-') {
-        sign = -1.0;
-        it++;
-    } else if (it != end && *it == '+') {
-        it++;
-    }
-
-    auto digit_start = it;  // NOLINT(readability-qualified-auto)
-    // Get digits before decimal point or exponent, if any.
-    double value = 0.0;
-    while (it != end && is_ascii_digit(*it)) {
-        value = value * 10.0 + static_cast<double>(*it - '0');
-        it++;
-    }
-    bool got_digits = (digit_start != it);
-
-    // Get digits after decimal point, if any.
-    if (it != end && *it == '.') {
-        it++;
-        auto frac_start = it;  // NOLINT(readability-qualified-auto)
-        double pow10 = 10.0;
-        while (it != end && is_ascii_digit(*it)) {
-            value += static_cast<double>(*it - '0') / pow10;
-            pow10 *= 10.0;
-            it++;
-        }
-
-        got_digits = got_digits || (frac_start != it);
-    }
-
-    // Handle exponent, if any.
-    bool frac = false;
-    double scale = 1.0;
-    if (it != end && (*it == 'e' || *it == 'E')) {
-        it++;
-        auto exponent_start = it;  // NOLINT(readability-qualified-auto)
-
-        // Get sign of exponent, if any.
-        if (it != end && *it == '-') {
-            frac = true;
-            it++;
-        } else if (it != end && *it == '+') {
-            it++;
-        }
-
-        // Get digits of exponent, if any.
-        unsigned exponent = 0;
-        while (it != end && is_ascii_digit(*it)) {
-            auto digit = static_cast<unsigned>(*it - '0');
-            if (exponent <= ((std::numeric_limits<unsigned>::max() - digit) / 10)) {
-                exponent = exponent * 10 + digit;
-            } else {
-                throw error("float exponent in {} is out of range for unsigned integer", input);
-            }
-
-            it++;
-        }
-
-        if (it == exponent_start) {
-            throw error("missing exponent in '{}' to read a double", input);
-        } else if (exponent > 308) {
-            throw error("{} is out of range for double", input);
-        }
-
-        // Calculate scaling factor.
-        while (exponent >= 50) { scale *= 1e50; exponent -= 50; }
-        while (exponent >=  8) { scale *= 1e8;  exponent -=  8; }
-        while (exponent >   0) { scale *= 1e1;  exponent -=  1; }
-    }
-
-    // skip whitespaces after number if any
-    while (it != end && is_ascii_whitespace(*it)) {
-        it++;
-    }
-
-    if (it != end || !got_digits) {
-        throw error("can not parse '{}' as a double", input);
-    }
-
-    // Return signed and scaled floating point result.
-    return sign * (frac ? (value / scale) : (value * scale));
-}
-
 static const auto digits_upper = std::string("0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ");
 static const auto digits_lower = std::string("0123456789abcdefghijklmnopqrstuvwxyz");
 
@@ -11,6 +11,8 @@
 #include <utility>
 #include <vector>
 #include <memory>
+#include <limits>
+#include <iterator>
 #include <algorithm>
 #include <functional>
 
@@ -79,6 +81,29 @@ const std::vector<size_t>& SubSelection::eval(const Frame& frame, const Match& m
     return matches_;
 }
 
+SubSelection::SubSelection(std::unique_ptr<Selection> selection):
+    selection_(std::move(selection)), variable_(UINT8_MAX)
+{
+    assert(selection_->size() == 1);
+}
+
+SubSelection SubSelection::clone() const {
+    if (is_variable()) {
+        return SubSelection(variable_);
+    } else {
+        // copy the AST directly instead of parsing the selection string again
+        return SubSelection(std::make_unique<Selection>(selection_->clone()));
+    }
+}
+
+bool SubSelection::topology_only() const {
+    if (is_variable()) {
+        return true;
+    } else {
+        return selection_->topology_only();
+    }
+}
+
 std::string SubSelection::print() const {
     if (is_variable()) {
         return fmt::format("#{}", variable_ + 1);
@@ -94,6 +119,52 @@ void SubSelection::clear() {
     }
 }
 
+void Selector::filter(const Frame& frame, std::vector<size_t>& atoms) const {
+    auto end = std::remove_if(atoms.begin(), atoms.end(), [&](size_t i) {
+        return !this->is_match(frame, Match(i));
+    });
+    atoms.erase(end, atoms.end());
+}
+
+DistanceBounds::DistanceBounds() {
+    for (auto& row: bounds_) {
+        row.fill(std::numeric_limits<double>::infinity());
+    }
+}
+
+void DistanceBounds::restrict(Variable i, Variable j, double bound) {
+    if (i == j) {
+        // the distance between an atom and itself is always 0
+        return;
+    }
+    bounds_[i][j] = std::min(bounds_[i][j], bound);
+    bounds_[j][i] = bounds_[i][j];
+}
+
+void DistanceBounds::intersect(const DistanceBounds& other) {
+    for (size_t i = 0; i < bounds_.size(); i++) {
+        for (size_t j = 0; j < bounds_[i].size(); j++) {
+            bounds_[i][j] = std::min(bounds_[i][j], other.bounds_[i][j]);
+        }
+    }
+}
+
+void DistanceBounds::unite(const DistanceBounds& other) {
+    for (size_t i = 0; i < bounds_.size(); i++) {
+        for (size_t j = 0; j < bounds_[i].size(); j++) {
+            bounds_[i][j] = std::max(bounds_[i][j], other.bounds_[i][j]);
+        }
+    }
+}
+
+Ast And::clone() const {
+    return std::make_unique<And>(lhs_->clone(), rhs_->clone());
+}
+
+bool And::topology_only() const {
+    return lhs_->topology_only() && rhs_->topology_only();
+}
+
 std::string And::print(unsigned delta) const {
     auto lhs = lhs_->print(7);
     auto rhs = rhs_->print(7);
@@ -109,6 +180,25 @@ void And::clear() {
     rhs_->clear();
 }
 
+void And::filter(const Frame& frame, std::vector<size_t>& atoms) const {
+    lhs_->filter(frame, atoms);
+    rhs_->filter(frame, atoms);
+}
+
+DistanceBounds And::distance_bounds() const {
+    auto bounds = lhs_->distance_bounds();
+    bounds.intersect(rhs_->distance_bounds());
+    return bounds;
+}
+
+Ast Or::clone() const {
+    return std::make_unique<Or>(lhs_->clone(), rhs_->clone());
+}
+
+bool Or::topology_only() const {
+    return lhs_->topology_only() && rhs_->topology_only();
+}
+
 std::string Or::print(unsigned delta) const {
     auto lhs = lhs_->print(6);
     auto rhs = rhs_->print(6);
@@ -124,6 +214,34 @@ void Or::clear() {
     rhs_->clear();
 }
 
+void Or::filter(const Frame& frame, std::vector<size_t>& atoms) const {
+    auto lhs = atoms;
+    lhs_->filter(frame, lhs);
+
+    // only check the atoms not already selected by lhs
+    auto rhs = std::vector<size_t>();
+    rhs.reserve(atoms.size() - lhs.size());
+    std::set_difference(atoms.begin(), atoms.end(), lhs.begin(), lhs.end(), std::back_inserter(rhs));
+    rhs_->filter(frame, rhs);
+
+    atoms.clear();
+    std::merge(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), std::back_inserter(atoms));
+}
+
+DistanceBounds Or::distance_bounds() const {
+    auto bounds = lhs_->distance_bounds();
+    bounds.unite(rhs_->distance_bounds());
+    return bounds;
+}
+
+Ast Not::clone() const {
+    return std::make_unique<Not>(ast_->clone());
+}
+
+bool Not::topology_only() const {
+    return ast_->topology_only();
+}
+
 std::string Not::print(unsigned /*unused*/) const {
     return "not " + ast_->print(4);
 }
@@ -136,6 +254,20 @@ void Not::clear() {
     ast_->clear();
 }
 
+void Not::filter(const Frame& frame, std::vector<size_t>& atoms) const {
+    auto selected = atoms;
+    ast_->filter(frame, selected);
+
+    auto remaining = std::vector<size_t>();
+    remaining.reserve(atoms.size() - selected.size());
+    std::set_difference(atoms.begin(), atoms.end(), selected.begin(), selected.end(), std::back_inserter(remaining));
+    atoms.swap(remaining);
+}
+
+Ast All::clone() const {
+    return std::make_unique<All>();
+}
+
 std::string All::print(unsigned /*unused*/) const {
     return "all";
 }
@@ -144,6 +276,10 @@ bool All::is_match(const Frame& /*unused*/, const Match& /*unused*/) const {
     return true;
 }
 
+Ast None::clone() const {
+    return std::make_unique<None>();
+}
+
 std::string None::print(unsigned /*unused*/) const {
     return "none";
 }
@@ -152,6 +288,10 @@ bool None::is_match(const Frame& /*unused*/, const Match& /*unused*/) const {
     return false;
 }
 
+Ast BoolProperty::clone() const {
+    return std::make_unique<BoolProperty>(property_, argument_);
+}
+
 std::string BoolProperty::print(unsigned /*unused*/) const {
     if (is_ident(property_)) {
         return fmt::format("[{}](#{})", property_, argument_ + 1);
@@ -192,6 +332,14 @@ bool BoolProperty::is_match(const Frame& frame, const Match& match) const {
     }
 }
 
+Ast IsBonded::clone() const {
+    return std::make_unique<IsBonded>(i_.clone(), j_.clone());
+}
+
+bool IsBonded::topology_only() const {
+    return i_.topology_only() && j_.topology_only();
+}
+
 std::string IsBonded::print(unsigned /*unused*/) const {
     return fmt::format("is_bonded({}, {})", i_.print(), j_ .print());
 }
@@ -220,6 +368,14 @@ void IsBonded::clear() {
     j_.clear();
 }
 
+Ast IsAngle::clone() const {
+    return std::make_unique<IsAngle>(i_.clone(), j_.clone(), k_.clone());
+}
+
+bool IsAngle::topology_only() const {
+    return i_.topology_only() && j_.topology_only() && k_.topology_only();
+}
+
 std::string IsAngle::print(unsigned /*unused*/) const {
     return fmt::format("is_angle({}, {}, {})", i_.print(), j_.print(), k_.print());
 }
@@ -251,6 +407,14 @@ void IsAngle::clear() {
     k_.clear();
 }
 
+Ast IsDihedral::clone() const {
+    return std::make_unique<IsDihedral>(i_.clone(), j_.clone(), k_.clone(), m_.clone());
+}
+
+bool IsDihedral::topology_only() const {
+    return i_.topology_only() && j_.topology_only() && k_.topology_only() && m_.topology_only();
+}
+
 std::string IsDihedral::print(unsigned /*unused*/) const {
     return fmt::format("is_dihedral({}, {}, {}, {})", i_.print(), j_.print(), k_.print(), m_.print());
 }
@@ -285,6 +449,14 @@ void IsDihedral::clear() {
     m_.clear();
 }
 
+Ast IsImproper::clone() const {
+    return std::make_unique<IsImproper>(i_.clone(), j_.clone(), k_.clone(), m_.clone());
+}
+
+bool IsImproper::topology_only() const {
+    return i_.topology_only() && j_.topology_only() && k_.topology_only() && m_.topology_only();
+}
+
 std::string IsImproper::print(unsigned /*unused*/) const {
     return fmt::format("is_improper({}, {}, {}, {})", i_.print(), j_.print(), k_.print(), m_.print());
 }
@@ -332,6 +504,10 @@ bool StringSelector::is_match(const Frame& frame, const Match& match) const {
     return (this->value(frame, match[argument_]) == value_) == equals_;
 }
 
+Ast StringProperty::clone() const {
+    return std::make_unique<StringProperty>(property_, value_, equals_, argument_);
+}
+
 std::string StringProperty::name() const {
     if (is_ident(property_)) {
         return "[" + property_ + "]";
@@ -372,6 +548,10 @@ const std::string& StringProperty::value(const Frame& frame, size_t i) const {
     }
 }
 
+Ast Type::clone() const {
+    return std::make_unique<Type>(value_, equals_, argument_);
+}
+
 std::string Type::name() const {
     return "type";
 }
@@ -380,6 +560,10 @@ const std::string& Type::value(const Frame& frame, size_t i) const {
     return frame[i].type();
 }
 
+Ast Name::clone() const {
+    return std::make_unique<Name>(value_, equals_, argument_);
+}
+
 std::string Name::name() const {
     return "name";
 }
@@ -388,6 +572,10 @@ const std::string& Name::value(const Frame& frame, size_t i) const {
     return frame[i].name();
 }
 
+Ast Resname::clone() const {
+    return std::make_unique<Resname>(value_, equals_, argument_);
+}
+
 std::string Resname::name() const {
     return "resname";
 }
@@ -438,6 +626,14 @@ bool Math::is_match(const Frame& frame, const Match& match) const {
     return false;
 }
 
+Ast Math::clone() const {
+    return std::make_unique<Math>(op_, lhs_->clone(), rhs_->clone());
+}
+
+bool Math::topology_only() const {
+    return lhs_->topology_only() && rhs_->topology_only();
+}
+
 std::string Math::print(unsigned /*unused*/) const {
     std::string op;
     switch (op_) {
@@ -483,6 +679,102 @@ void Math::clear() {
     rhs_->clear();
 }
 
+/// Only keep the atoms for which `compare(lhs[i], rhs[i])` is true
+template <class Compare>
+static void filter_values(std::vector<size_t>& atoms, const std::vector<double>& lhs, const std::vector<double>& rhs, Compare compare) {
+    size_t count = 0;
+    for (size_t i = 0; i < atoms.size(); i++) {
+        if (compare(lhs[i], rhs[i])) {
+            atoms[count] = atoms[i];
+            count++;
+        }
+    }
+    atoms.resize(count);
+}
+
+void Math::filter(const Frame& frame, std::vector<size_t>& atoms) const {
+    auto lhs = std::vector<double>();
+    auto rhs = std::vector<double>();
+    if (!lhs_->eval_all(frame, atoms, lhs) || !rhs_->eval_all(frame, atoms, rhs)) {
+        Selector::filter(frame, atoms);
+        return;
+    }
+
+    switch (op_) {
+    case Math::Operator::EQUAL:
+        filter_values(atoms, lhs, rhs, std::equal_to<double>());
+        break;
+    case Math::Operator::NOT_EQUAL:
+        filter_values(atoms, lhs, rhs, std::not_equal_to<double>());
+        break;
+    case Math::Operator::LESS:
+        filter_values(atoms, lhs, rhs, std::less<double>());
+        break;
+    case Math::Operator::LESS_EQUAL:
+        filter_values(atoms, lhs, rhs, std::less_equal<double>());
+        break;
+    case Math::Operator::GREATER:
+        filter_values(atoms, lhs, rhs, std::greater<double>());
+        break;
+    case Math::Operator::GREATER_EQUAL:
+        filter_values(atoms, lhs, rhs, std::greater_equal<double>());
+        break;
+    default:
+        unreachable();
+    }
+}
+
+/// Evaluate `lhs` and `rhs` for all atoms, and combine the corresponding
+/// values with `operation`.
+template <class Operation>
+static bool eval_all_binary(const MathAst& lhs, const MathAst& rhs, const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values, Operation operation) {
+    auto rhs_values = std::vector<double>();
+    if (!lhs->eval_all(frame, atoms, values) || !rhs->eval_all(frame, atoms, rhs_values)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = operation(values[i], rhs_values[i]);
+    }
+    return true;
+}
+
+DistanceBounds Math::distance_bounds() const {
+    // look for `distance(#i, #j) < value` or `value > distance(#i, #j)`
+    const MathExpr* distance = nullptr;
+    const MathExpr* value = nullptr;
+    switch (op_) {
+    case Math::Operator::LESS:
+    case Math::Operator::LESS_EQUAL:
+        distance = lhs_.get();
+        value = rhs_.get();
+        break;
+    case Math::Operator::GREATER:
+    case Math::Operator::GREATER_EQUAL:
+        distance = rhs_.get();
+        value = lhs_.get();
+        break;
+    case Math::Operator::EQUAL:
+    case Math::Operator::NOT_EQUAL:
+        return DistanceBounds();
+    default:
+        unreachable();
+    }
+
+    auto bounds = DistanceBounds();
+    auto variables = distance->distance_variables();
+    auto bound = value->constant();
+    if (variables && bound) {
+        auto max = bound.value();
+        if (std::isnan(max)) {
+            // comparisons with NaN are always false
+            max = -std::numeric_limits<double>::infinity();
+        }
+        bounds.restrict(variables->first, variables->second, max);
+    }
+    return bounds;
+}
+
 NumericValues Add::eval(const Frame& frame, const Match& match) const {
     auto lhs = lhs_->eval(frame, match);
     auto rhs = rhs_->eval(frame, match);
@@ -498,6 +790,12 @@ NumericValues Add::eval(const Frame& frame, const Match& match) const {
     return result;
 }
 
+bool Add::eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const {
+    return eval_all_binary(lhs_, rhs_, frame, atoms, values, [](double left, double right) {
+        return left + right;
+    });
+}
+
 optional<double> Add::optimize() {
     auto lhs_opt = lhs_->optimize();
     auto rhs_opt = rhs_->optimize();
@@ -511,6 +809,14 @@ optional<double> Add::optimize() {
     return nullopt;
 }
 
+MathAst Add::clone() const {
+    return std::make_unique<Add>(lhs_->clone(), rhs_->clone());
+}
+
+bool Add::topology_only() const {
+    return lhs_->topology_only() && rhs_->topology_only();
+}
+
 std::string Add::print() const {
     return fmt::format("({} + {})", lhs_->print(), rhs_->print());
 }
@@ -535,6 +841,12 @@ NumericValues Sub::eval(const Frame& frame, const Match& match) const {
     return result;
 }
 
+bool Sub::eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const {
+    return eval_all_binary(lhs_, rhs_, frame, atoms, values, [](double left, double right) {
+        return left - right;
+    });
+}
+
 optional<double> Sub::optimize() {
     auto lhs_opt = lhs_->optimize();
     auto rhs_opt = rhs_->optimize();
@@ -548,6 +860,14 @@ optional<double> Sub::optimize() {
     return nullopt;
 }
 
+MathAst Sub::clone() const {
+    return std::make_unique<Sub>(lhs_->clone(), rhs_->clone());
+}
+
+bool Sub::topology_only() const {
+    return lhs_->topology_only() && rhs_->topology_only();
+}
+
 std::string Sub::print() const {
     return fmt::format("({} - {})", lhs_->print(), rhs_->print());
 }
@@ -572,6 +892,12 @@ NumericValues Mul::eval(const Frame& frame, const Match& match) const {
     return result;
 }
 
+bool Mul::eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const {
+    return eval_all_binary(lhs_, rhs_, frame, atoms, values, [](double left, double right) {
+        return left * right;
+    });
+}
+
 optional<double> Mul::optimize() {
     auto lhs_opt = lhs_->optimize();
     auto rhs_opt = rhs_->optimize();
@@ -585,6 +911,14 @@ optional<double> Mul::optimize() {
     return nullopt;
 }
 
+MathAst Mul::clone() const {
+    return std::make_unique<Mul>(lhs_->clone(), rhs_->clone());
+}
+
+bool Mul::topology_only() const {
+    return lhs_->topology_only() && rhs_->topology_only();
+}
+
 std::string Mul::print() const {
     return fmt::format("({} * {})", lhs_->print(), rhs_->print());
 }
@@ -609,6 +943,12 @@ NumericValues Div::eval(const Frame& frame, const Match& match) const {
     return result;
 }
 
+bool Div::eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const {
+    return eval_all_binary(lhs_, rhs_, frame, atoms, values, [](double left, double right) {
+        return left / right;
+    });
+}
+
 optional<double> Div::optimize() {
     auto lhs_opt = lhs_->optimize();
     auto rhs_opt = rhs_->optimize();
@@ -622,6 +962,14 @@ optional<double> Div::optimize() {
     return nullopt;
 }
 
+MathAst Div::clone() const {
+    return std::make_unique<Div>(lhs_->clone(), rhs_->clone());
+}
+
+bool Div::topology_only() const {
+    return lhs_->topology_only() && rhs_->topology_only();
+}
+
 std::string Div::print() const {
     return fmt::format("({} / {})", lhs_->print(), rhs_->print());
 }
@@ -646,6 +994,12 @@ NumericValues Pow::eval(const Frame& frame, const Match& match) const {
     return result;
 }
 
+bool Pow::eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const {
+    return eval_all_binary(lhs_, rhs_, frame, atoms, values, [](double left, double right) {
+        return pow(left, right);
+    });
+}
+
 optional<double> Pow::optimize() {
     auto lhs_opt = lhs_->optimize();
     auto rhs_opt = rhs_->optimize();
@@ -659,6 +1013,14 @@ optional<double> Pow::optimize() {
     return nullopt;
 }
 
+MathAst Pow::clone() const {
+    return std::make_unique<Pow>(lhs_->clone(), rhs_->clone());
+}
+
+bool Pow::topology_only() const {
+    return lhs_->topology_only() && rhs_->topology_only();
+}
+
 std::string Pow::print() const {
     return fmt::format("{} ^({})", lhs_->print(), rhs_->print());
 }
@@ -676,6 +1038,16 @@ NumericValues Neg::eval(const Frame& frame, const Match& match) const {
     return result;
 }
 
+bool Neg::eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const {
+    if (!ast_->eval_all(frame, atoms, values)) {
+        return false;
+    }
+    for (auto& value: values) {
+        value = -value;
+    }
+    return true;
+}
+
 optional<double> Neg::optimize() {
     auto optimized = ast_->optimize();
     if (optimized) {
@@ -685,6 +1057,14 @@ optional<double> Neg::optimize() {
     }
 }
 
+MathAst Neg::clone() const {
+    return std::make_unique<Neg>(ast_->clone());
+}
+
+bool Neg::topology_only() const {
+    return ast_->topology_only();
+}
+
 std::string Neg::print() const {
     return fmt::format("(-{})", ast_->print());
 }
@@ -708,6 +1088,12 @@ NumericValues Mod::eval(const Frame& frame, const Match& match) const {
     return result;
 }
 
+bool Mod::eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const {
+    return eval_all_binary(lhs_, rhs_, frame, atoms, values, [](double left, double right) {
+        return fmod(left, right);
+    });
+}
+
 optional<double> Mod::optimize() {
     auto lhs_opt = lhs_->optimize();
     auto rhs_opt = rhs_->optimize();
@@ -721,6 +1107,14 @@ optional<double> Mod::optimize() {
     return nullopt;
 }
 
+MathAst Mod::clone() const {
+    return std::make_unique<Mod>(lhs_->clone(), rhs_->clone());
+}
+
+bool Mod::topology_only() const {
+    return lhs_->topology_only() && rhs_->topology_only();
+}
+
 std::string Mod::print() const {
     return fmt::format("({} % {})", lhs_->print(), rhs_->print());
 }
@@ -738,6 +1132,16 @@ NumericValues Function::eval(const Frame& frame, const Match& match) const {
     return result;
 }
 
+bool Function::eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const {
+    if (!ast_->eval_all(frame, atoms, values)) {
+        return false;
+    }
+    for (auto& value: values) {
+        value = fn_(value);
+    }
+    return true;
+}
+
 optional<double> Function::optimize() {
     auto optimized = ast_->optimize();
     if (optimized) {
@@ -747,6 +1151,14 @@ optional<double> Function::optimize() {
     }
 }
 
+MathAst Function::clone() const {
+    return std::make_unique<Function>(fn_, name_, ast_->clone());
+}
+
+bool Function::topology_only() const {
+    return ast_->topology_only();
+}
+
 std::string Function::print() const {
     return fmt::format("{}({})", name_, ast_->print());
 }
@@ -759,10 +1171,19 @@ NumericValues Number::eval(const Frame& /*unused*/, const Match& /*unused*/) con
     return NumericValues(value_);
 }
 
+bool Number::eval_all(const Frame& /*unused*/, const std::vector<size_t>& atoms, std::vector<double>& values) const {
+    values.assign(atoms.size(), value_);
+    return true;
+}
+
 optional<double> Number::optimize() {
     return value_;
 }
 
+MathAst Number::clone() const {
+    return std::make_unique<Number>(value_);
+}
+
 std::string Number::print() const {
     if (std::round(value_) == value_) {
         return std::to_string(std::lround(value_));
@@ -781,6 +1202,22 @@ NumericValues Distance::eval(const Frame& frame, const Match& match) const {
     return results;
 }
 
+optional<std::pair<Variable, Variable>> Distance::distance_variables() const {
+    if (i_.is_variable() && j_.is_variable()) {
+        return std::make_pair(i_.variable(), j_.variable());
+    }
+    return nullopt;
+}
+
+void Distance::clear() {
+    i_.clear();
+    j_.clear();
+}
+
+MathAst Distance::clone() const {
+    return std::make_unique<Distance>(i_.clone(), j_.clone());
+}
+
 std::string Distance::print() const {
     return fmt::format("distance({}, {})", i_.print(), j_.print());
 }
@@ -797,6 +1234,16 @@ NumericValues selections::Angle::eval(const Frame& frame, const Match& match) co
     return results;
 }
 
+void selections::Angle::clear() {
+    i_.clear();
+    j_.clear();
+    k_.clear();
+}
+
+MathAst selections::Angle::clone() const {
+    return std::make_unique<selections::Angle>(i_.clone(), j_.clone(), k_.clone());
+}
+
 std::string selections::Angle::print() const {
     return fmt::format("angle({}, {}, {})", i_.print(), j_.print(), k_.print());
 }
@@ -815,6 +1262,17 @@ NumericValues selections::Dihedral::eval(const Frame& frame, const Match& match)
     return results;
 }
 
+void selections::Dihedral::clear() {
+    i_.clear();
+    j_.clear();
+    k_.clear();
+    m_.clear();
+}
+
+MathAst selections::Dihedral::clone() const {
+    return std::make_unique<selections::Dihedral>(i_.clone(), j_.clone(), k_.clone(), m_.clone());
+}
+
 std::string selections::Dihedral::print() const {
     return fmt::format("dihedral({}, {}, {}, {})", i_.print(), j_.print(), k_.print(), m_.print());
 }
@@ -833,6 +1291,17 @@ NumericValues OutOfPlane::eval(const Frame& frame, const Match& match) const {
     return results;
 }
 
+void OutOfPlane::clear() {
+    i_.clear();
+    j_.clear();
+    k_.clear();
+    m_.clear();
+}
+
+MathAst OutOfPlane::clone() const {
+    return std::make_unique<OutOfPlane>(i_.clone(), j_.clone(), k_.clone(), m_.clone());
+}
+
 std::string OutOfPlane::print() const {
     return fmt::format("out_of_plane({}, {}, {}, {})", i_.print(), j_.print(), k_.print(), m_.print());
 }
@@ -841,6 +1310,14 @@ NumericValues NumericSelector::eval(const Frame& frame, const Match& match) cons
     return NumericValues(this->value(frame, match[argument_]));
 }
 
+bool NumericSelector::eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const {
+    values.resize(atoms.size());
+    for (size_t i = 0; i < atoms.size(); i++) {
+        values[i] = this->value(frame, atoms[i]);
+    }
+    return true;
+}
+
 optional<double> NumericSelector::optimize() {
     return nullopt;
 }
@@ -849,6 +1326,10 @@ std::string NumericSelector::print() const {
     return fmt::format("{}(#{})", name(), argument_ + 1);
 }
 
+MathAst NumericProperty::clone() const {
+    return std::make_unique<NumericProperty>(property_, argument_);
+}
+
 std::string NumericProperty::name() const {
     if (is_ident(property_)) {
         return "[" + property_ + "]";
@@ -890,6 +1371,10 @@ double NumericProperty::value(const Frame& frame, size_t i) const {
     }
 }
 
+MathAst Index::clone() const {
+    return std::make_unique<Index>(argument_);
+}
+
 std::string Index::name() const {
     return "index";
 }
@@ -898,6 +1383,10 @@ double Index::value(const Frame& /*unused*/, size_t i) const {
     return static_cast<double>(i);
 }
 
+MathAst Resid::clone() const {
+    return std::make_unique<Resid>(argument_);
+}
+
 std::string Resid::name() const {
     return "resid";
 }
@@ -911,6 +1400,10 @@ double Resid::value(const Frame& frame, size_t i) const {
     }
 }
 
+MathAst Mass::clone() const {
+    return std::make_unique<Mass>(argument_);
+}
+
 std::string Mass::name() const {
     return "mass";
 }
@@ -919,6 +1412,10 @@ double Mass::value(const Frame& frame, size_t i) const {
     return frame[i].mass();
 }
 
+MathAst Position::clone() const {
+    return std::make_unique<Position>(argument_, coordinate_);
+}
+
 std::string Position::name() const {
     switch (coordinate_) {
     case Coordinate::X:
@@ -933,9 +1430,36 @@ std::string Position::name() const {
 }
 
 double Position::value(const Frame& frame, size_t i) const {
+    if (frame.storage() == Frame::SOA_FLOAT) {
+        return frame.positions_soa()[i][static_cast<size_t>(coordinate_)];
+    }
     return frame.positions()[i][static_cast<size_t>(coordinate_)];
 }
 
+bool Position::eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const {
+    auto coordinate = static_cast<size_t>(coordinate_);
+    values.resize(atoms.size());
+    if (frame.storage() == Frame::SOA_FLOAT) {
+        // read the single precision component directly
+        const auto& positions = frame.positions_soa();
+        const auto& component = coordinate == 0 ? positions.x : (coordinate == 1 ? positions.y : positions.z);
+        for (size_t i = 0; i < atoms.size(); i++) {
+            values[i] = static_cast<double>(component[atoms[i]]);
+        }
+        return true;
+    }
+
+    const auto& positions = frame.positions();
+    for (size_t i = 0; i < atoms.size(); i++) {
+        values[i] = positions[atoms[i]][coordinate];
+    }
+    return true;
+}
+
+MathAst Velocity::clone() const {
+    return std::make_unique<Velocity>(argument_, coordinate_);
+}
+
 std::string Velocity::name() const {
     switch (coordinate_) {
     case Coordinate::X:
@@ -958,3 +1482,19 @@ double Velocity::value(const Frame& frame, size_t i) const {
         return std::nan("");
     }
 }
+
+bool Velocity::eval_all(const Frame& frame, const std::vector<size_t>& atoms, std::vector<double>& values) const {
+    if (!frame.velocities()) {
+        // use nan so that all comparaison down the line evaluate to false
+        values.assign(atoms.size(), std::nan(""));
+        return true;
+    }
+
+    const auto& velocities = *frame.velocities();
+    auto coordinate = static_cast<size_t>(coordinate_);
+    values.resize(atoms.size());
+    for (size_t i = 0; i < atoms.size(); i++) {
+        values[i] = velocities[atoms[i]][coordinate];
+    }
+    return true;
+}
@@ -2,6 +2,7 @@
 // Copyright (C) Guillaume Fraux and contributors -- BSD license
 
 #include <string>
+#include <vector>
 #include <iostream>
 #include <exception>
 #include <functional>
@@ -17,6 +18,18 @@ static mutex<warning_callback_t> CALLBACK = {[](const std::string& message){ //
     std::cerr << "[chemfiles] " << message << std::endl;
 }};
 
+/// Vector collecting the warnings sent by the current thread, set by
+/// `CollectWarnings`
+static thread_local std::vector<std::string>* COLLECTED_WARNINGS = nullptr;
+
+CollectWarnings::CollectWarnings(std::vector<std::string>& warnings) noexcept: previous_(COLLECTED_WARNINGS) {
+    COLLECTED_WARNINGS = &warnings;
+}
+
+CollectWarnings::~CollectWarnings() {
+    COLLECTED_WARNINGS = previous_;
+}
+
 void chemfiles::set_warning_callback(warning_callback_t callback) {
     auto guard = CALLBACK.lock();
     *guard = std::move(callback);
@@ -24,6 +37,10 @@ void chemfiles::set_warning_callback(warning_callback_t callback) {
 
 void chemfiles::send_warning(const std::string& message) noexcept {
     try {
+        if (COLLECTED_WARNINGS != nullptr) {
+            COLLECTED_WARNINGS->push_back(message);
+            return;
+        }
         auto callback = CALLBACK.lock();
         (*callback)(message);
     } catch (const std::exception& e) {
@@ -1,7 +1,9 @@
 // Chemfiles, a modern library for chemistry file reading and writing
 // Copyright (C) Guillaume Fraux and contributors -- BSD license
 
+#include <cstdio>
 #include <sstream>
+#include <fstream>
 #include <cstring>
 
 #include "catch.hpp"
@@ -71,3 +73,90 @@ TEST_CASE("Warnings") {
     CHECK(buffer == message);
     free(buffer);
 }
+
+TEST_CASE("Frame index files") {
+    auto tmpfile = NamedTempPath(".xyz");
+    std::ofstream(tmpfile.path()) << "1\n\nC 0 0 0\n1\n\nC 1 1 1\n";
+    auto index = tmpfile.path() + ".chfl-idx";
+
+    CHECK_STATUS(chfl_set_frame_index_files(true));
+    CHFL_TRAJECTORY* trajectory = chfl_trajectory_open(tmpfile.path().c_str(), 'r');
+    REQUIRE(trajectory);
+    uint64_t nsteps = 0;
+    CHECK_STATUS(chfl_trajectory_nsteps(trajectory, &nsteps));
+    CHECK(nsteps == 2);
+    chfl_trajectory_close(trajectory);
+    CHECK(std::ifstream(index).good());
+
+    CHECK_STATUS(chfl_set_frame_index_files(false));
+    std::remove(index.c_str());
+}
+
+TEST_CASE("Threaded decompression") {
+    auto tmpfile = NamedTempPath(".xyz.gz");
+    CHFL_TRAJECTORY* trajectory = chfl_trajectory_open(tmpfile.path().c_str(), 'w');
+    REQUIRE(trajectory);
+    CHFL_FRAME* frame = chfl_frame();
+    REQUIRE(frame);
+    CHECK_STATUS(chfl_trajectory_write(trajectory, frame));
+    CHECK_STATUS(chfl_trajectory_write(trajectory, frame));
+    chfl_trajectory_close(trajectory);
+
+    CHECK_STATUS(chfl_set_threaded_decompression(true));
+    trajectory = chfl_trajectory_open(tmpfile.path().c_str(), 'r');
+    REQUIRE(trajectory);
+    uint64_t nsteps = 0;
+    CHECK_STATUS(chfl_trajectory_nsteps(trajectory, &nsteps));
+    CHECK(nsteps == 2);
+    CHECK_STATUS(chfl_trajectory_read(trajectory, frame));
+    chfl_trajectory_close(trajectory);
+    chfl_free(frame);
+
+    CHECK_STATUS(chfl_set_threaded_decompression(false));
+}
+
+TEST_CASE("Memory mapping") {
+    auto tmpfile = NamedTempPath(".xyz");
+    CHFL_TRAJECTORY* trajectory = chfl_trajectory_open(tmpfile.path().c_str(), 'w');
+    REQUIRE(trajectory);
+    CHFL_FRAME* frame = chfl_frame();
+    REQUIRE(frame);
+    CHECK_STATUS(chfl_trajectory_write(trajectory, frame));
+    CHECK_STATUS(chfl_trajectory_write(trajectory, frame));
+    chfl_trajectory_close(trajectory);
+
+    CHECK_STATUS(chfl_set_memory_mapping(true));
+    trajectory = chfl_trajectory_open(tmpfile.path().c_str(), 'r');
+    REQUIRE(trajectory);
+    uint64_t nsteps = 0;
+    CHECK_STATUS(chfl_trajectory_nsteps(trajectory, &nsteps));
+    CHECK(nsteps == 2);
+    CHECK_STATUS(chfl_trajectory_read(trajectory, frame));
+    chfl_trajectory_close(trajectory);
+    chfl_free(frame);
+
+    CHECK_STATUS(chfl_set_memory_mapping(false));
+}
+
+TEST_CASE("Parallel writing") {
+    auto tmpfile = NamedTempPath(".xyz");
+    CHFL_FRAME* frame = chfl_frame();
+    REQUIRE(frame);
+    CHECK_STATUS(chfl_frame_resize(frame, 10000));
+
+    CHECK_STATUS(chfl_set_write_threads(3));
+    CHFL_TRAJECTORY* trajectory = chfl_trajectory_open(tmpfile.path().c_str(), 'w');
+    REQUIRE(trajectory);
+    CHECK_STATUS(chfl_trajectory_write(trajectory, frame));
+    chfl_trajectory_close(trajectory);
+    CHECK_STATUS(chfl_set_write_threads(1));
+
+    trajectory = chfl_trajectory_open(tmpfile.path().c_str(), 'r');
+    REQUIRE(trajectory);
+    CHECK_STATUS(chfl_trajectory_read(trajectory, frame));
+    uint64_t natoms = 0;
+    CHECK_STATUS(chfl_frame_atoms_count(frame, &natoms));
+    CHECK(natoms == 10000);
+    chfl_trajectory_close(trajectory);
+    chfl_free(frame);
+}
@@ -0,0 +1,102 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include "catch.hpp"
+#include "helpers.hpp"
+#include "chemfiles.h"
+
+static CHFL_FRAME* testing_frame();
+
+TEST_CASE("chfl_neighbor_list") {
+    SECTION("Constructors errors") {
+        CHFL_FRAME* frame = testing_frame();
+        REQUIRE(frame);
+
+        fail_next_allocation();
+        CHECK(chfl_neighbor_list(frame, 3.0, 0.0) == nullptr);
+
+        CHECK(chfl_neighbor_list(frame, -3.0, 0.0) == nullptr);
+        CHECK(chfl_neighbor_list(frame, 3.0, -1.0) == nullptr);
+        CHECK(chfl_neighbor_list(nullptr, 3.0, 0.0) == nullptr);
+
+        chfl_free(frame);
+    }
+
+    SECTION("Pairs") {
+        CHFL_FRAME* frame = testing_frame();
+        REQUIRE(frame);
+
+        CHFL_NEIGHBOR_LIST* list = chfl_neighbor_list(frame, 3.0, 0.5);
+        REQUIRE(list);
+
+        uint64_t count = 0;
+        CHECK_STATUS(chfl_neighbor_list_pairs_count(list, &count));
+        CHECK(count == 2);
+
+        uint64_t pairs[2][2] = {{0}};
+        CHECK_STATUS(chfl_neighbor_list_pairs(list, pairs, 2));
+        CHECK(pairs[0][0] == 0);
+        CHECK(pairs[0][1] == 1);
+        CHECK(pairs[1][0] == 0);
+        CHECK(pairs[1][1] == 2);
+
+        double distances[2] = {0};
+        CHECK_STATUS(chfl_neighbor_list_distances(list, distances, 2));
+        CHECK(approx_eq(distances[0], 2.0));
+        CHECK(approx_eq(distances[1], 1.0));
+
+        chfl_vector3d vectors[2] = {{0}};
+        CHECK_STATUS(chfl_neighbor_list_vectors(list, vectors, 2));
+        CHECK(approx_eq(vectors[0][0], 2.0));
+        CHECK(approx_eq(vectors[0][1], 0.0));
+        CHECK(approx_eq(vectors[0][2], 0.0));
+        CHECK(approx_eq(vectors[1][0], -1.0));
+        CHECK(approx_eq(vectors[1][1], 0.0));
+        CHECK(approx_eq(vectors[1][2], 0.0));
+
+        // wrong sizes
+        CHECK(chfl_neighbor_list_pairs(list, pairs, 1) == CHFL_MEMORY_ERROR);
+        CHECK(chfl_neighbor_list_distances(list, distances, 3) == CHFL_MEMORY_ERROR);
+        CHECK(chfl_neighbor_list_vectors(list, vectors, 1) == CHFL_MEMORY_ERROR);
+
+        chfl_free(list);
+        chfl_free(frame);
+    }
+
+    SECTION("Update") {
+        CHFL_FRAME* frame = testing_frame();
+        REQUIRE(frame);
+
+        CHFL_NEIGHBOR_LIST* list = chfl_neighbor_list(frame, 3.0, 0.5);
+        REQUIRE(list);
+
+        chfl_vector3d* positions = nullptr;
+        uint64_t natoms = 0;
+        CHECK_STATUS(chfl_frame_positions(frame, &positions, &natoms));
+        positions[1][0] = 5;
+
+        CHECK_STATUS(chfl_neighbor_list_update(list, frame));
+        uint64_t count = 0;
+        CHECK_STATUS(chfl_neighbor_list_pairs_count(list, &count));
+        CHECK(count == 1);
+
+        chfl_free(list);
+        chfl_free(frame);
+    }
+}
+
+static CHFL_FRAME* testing_frame() {
+    CHFL_FRAME* frame = chfl_frame();
+    chfl_vector3d lengths = {10, 10, 10};
+    CHFL_CELL* cell = chfl_cell(lengths, nullptr);
+    chfl_frame_set_cell(frame, cell);
+    chfl_free(cell);
+
+    CHFL_ATOM* atom = chfl_atom("Ar");
+    chfl_vector3d positions[3] = {{0, 0, 0}, {2, 0, 0}, {9, 0, 0}};
+    for (auto& position: positions) {
+        chfl_frame_add_atom(frame, atom, position, nullptr);
+    }
+    chfl_free(atom);
+    return frame;
+}
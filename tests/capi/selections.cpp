@@ -127,6 +127,40 @@ TEST_CASE("chfl_selection") {
         chfl_free(selection);
         chfl_free(frame);
     }
+
+    SECTION("Cache") {
+        CHECK_STATUS(chfl_selection_cache_clear());
+
+        uint64_t hits = 0, misses = 0, size = 0, capacity = 0;
+        CHECK_STATUS(chfl_selection_cache_stats(&hits, &misses, &size, &capacity));
+        CHECK(hits == 0);
+        CHECK(misses == 0);
+        CHECK(size == 0);
+        CHECK(capacity == 128);
+
+        CHFL_SELECTION* first = chfl_selection("name O");
+        REQUIRE(first);
+        CHFL_SELECTION* second = chfl_selection("name O");
+        REQUIRE(second);
+        CHFL_SELECTION* third = chfl_selection("pairs: name(#1) H");
+        REQUIRE(third);
+
+        CHECK_STATUS(chfl_selection_cache_stats(&hits, &misses, &size, &capacity));
+        CHECK(hits == 1);
+        CHECK(misses == 2);
+        CHECK(size == 2);
+
+        CHECK_STATUS(chfl_selection_cache_resize(1));
+        CHECK_STATUS(chfl_selection_cache_stats(&hits, &misses, &size, &capacity));
+        CHECK(size == 1);
+        CHECK(capacity == 1);
+
+        CHECK_STATUS(chfl_selection_cache_resize(128));
+
+        chfl_free(first);
+        chfl_free(second);
+        chfl_free(third);
+    }
 }
 
 static CHFL_FRAME* testing_frame(void) {
@@ -0,0 +1,28 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <chemfiles.h>
+#include <stdlib.h>
+#include <assert.h>
+
+int main(void) {
+    // [example]
+    CHFL_FRAME* frame = chfl_frame();
+    CHFL_ATOM* atom = chfl_atom("Ar");
+    chfl_frame_add_atom(frame, atom, (chfl_vector3d){0, 0, 0}, NULL);
+    chfl_frame_add_atom(frame, atom, (chfl_vector3d){2, 0, 0}, NULL);
+    chfl_frame_add_atom(frame, atom, (chfl_vector3d){8, 8, 8}, NULL);
+    chfl_free(atom);
+
+    CHFL_NEIGHBOR_LIST* list = chfl_neighbor_list(frame, 3.0, 0.0);
+
+    uint64_t pairs[1][2] = {{0}};
+    chfl_neighbor_list_pairs(list, pairs, 1);
+    assert(pairs[0][0] == 0);
+    assert(pairs[0][1] == 1);
+
+    chfl_free(list);
+    chfl_free(frame);
+    // [example]
+    return 0;
+}
@@ -0,0 +1,23 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <chemfiles.h>
+#include <stdlib.h>
+#include <assert.h>
+
+int main(void) {
+    // [example]
+    CHFL_SELECTION* selection = chfl_selection("name O");
+
+    chfl_selection_cache_clear();
+
+    uint64_t hits = 0, misses = 0, size = 0, capacity = 0;
+    chfl_selection_cache_stats(&hits, &misses, &size, &capacity);
+    assert(hits == 0);
+    assert(misses == 0);
+    assert(size == 0);
+
+    chfl_free(selection);
+    // [example]
+    return 0;
+}
@@ -0,0 +1,27 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <chemfiles.h>
+#include <stdlib.h>
+#include <assert.h>
+
+int main(void) {
+    // [example]
+    // only keep the 2 most recently used selections in the cache
+    chfl_selection_cache_resize(2);
+
+    CHFL_SELECTION* first = chfl_selection("name O");
+    CHFL_SELECTION* second = chfl_selection("name H");
+    CHFL_SELECTION* third = chfl_selection("name C");
+
+    uint64_t hits = 0, misses = 0, size = 0, capacity = 0;
+    chfl_selection_cache_stats(&hits, &misses, &size, &capacity);
+    assert(size == 2);
+    assert(capacity == 2);
+
+    chfl_free(first);
+    chfl_free(second);
+    chfl_free(third);
+    // [example]
+    return 0;
+}
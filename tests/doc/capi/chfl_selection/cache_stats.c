@@ -0,0 +1,26 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <chemfiles.h>
+#include <stdlib.h>
+#include <assert.h>
+
+int main(void) {
+    // [example]
+    chfl_selection_cache_clear();
+
+    CHFL_SELECTION* first = chfl_selection("name O");
+    CHFL_SELECTION* second = chfl_selection("name O");
+
+    uint64_t hits = 0, misses = 0, size = 0, capacity = 0;
+    chfl_selection_cache_stats(&hits, &misses, &size, &capacity);
+    assert(hits == 1);
+    assert(misses == 1);
+    assert(size == 1);
+    assert(capacity == 128);
+
+    chfl_free(first);
+    chfl_free(second);
+    // [example]
+    return 0;
+}
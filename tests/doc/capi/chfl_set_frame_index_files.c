@@ -0,0 +1,25 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <chemfiles.h>
+
+int main(void) {
+    // [example] [no-run]
+    chfl_set_frame_index_files(true);
+
+    /* The first time the trajectory is read, the position of all steps is
+       stored in "water.xtc.chfl-idx" */
+    CHFL_TRAJECTORY* trajectory = chfl_trajectory_open("water.xtc", 'r');
+    uint64_t nsteps = 0;
+    chfl_trajectory_nsteps(trajectory, &nsteps);
+    chfl_trajectory_close(trajectory);
+
+    /* The next times, these positions are loaded from the index file */
+    trajectory = chfl_trajectory_open("water.xtc", 'r');
+    chfl_trajectory_nsteps(trajectory, &nsteps);
+    chfl_trajectory_close(trajectory);
+
+    chfl_set_frame_index_files(false);
+    // [example]
+    return 0;
+}
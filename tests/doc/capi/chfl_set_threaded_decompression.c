@@ -0,0 +1,20 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <chemfiles.h>
+
+int main(void) {
+    // [example] [no-run]
+    chfl_set_threaded_decompression(true);
+
+    /* The file is decompressed in a separate thread while frames are parsed */
+    CHFL_TRAJECTORY* trajectory = chfl_trajectory_open("water.xyz.gz", 'r');
+    CHFL_FRAME* frame = chfl_frame();
+    chfl_trajectory_read(trajectory, frame);
+    chfl_free(frame);
+    chfl_trajectory_close(trajectory);
+
+    chfl_set_threaded_decompression(false);
+    // [example]
+    return 0;
+}
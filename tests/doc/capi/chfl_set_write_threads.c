@@ -0,0 +1,20 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <chemfiles.h>
+
+int main(void) {
+    // [example] [no-run]
+    /* Use 4 threads to format the atoms when writing */
+    chfl_set_write_threads(4);
+
+    CHFL_TRAJECTORY* trajectory = chfl_trajectory_open("water.xyz", 'w');
+    CHFL_FRAME* frame = chfl_frame();
+    chfl_trajectory_write(trajectory, frame);
+    chfl_free(frame);
+    chfl_trajectory_close(trajectory);
+
+    chfl_set_write_threads(1);
+    // [example]
+    return 0;
+}
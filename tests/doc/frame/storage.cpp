@@ -0,0 +1,33 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+
+#undef assert
+#define assert CHECK
+
+TEST_CASE() {
+    // [example]
+    auto frame = Frame();
+    frame.add_atom(Atom("H"), {1.0, 2.0, 3.0});
+    frame.add_atom(Atom("O"), {4.0, 5.0, 6.0});
+    assert(frame.storage() == Frame::AOS_DOUBLE);
+
+    frame.set_storage(Frame::SOA_FLOAT);
+    assert(frame.storage() == Frame::SOA_FLOAT);
+
+    // the x, y and z components are stored in separate arrays
+    auto& positions = frame.positions_soa();
+    assert(positions.x == std::vector<float>({1.0f, 4.0f}));
+    assert(positions.y == std::vector<float>({2.0f, 5.0f}));
+    assert(positions.z == std::vector<float>({3.0f, 6.0f}));
+
+    positions.set(1, {8.0, 2.0, 3.0});
+    assert(frame.distance(0, 1) == 7.0);
+
+    // velocities use the same storage
+    frame.add_velocities();
+    assert(frame.velocities_soa()->size() == 2);
+    // [example]
+}
@@ -0,0 +1,22 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+
+#undef assert
+#define assert CHECK
+
+TEST_CASE() {
+    // [example]
+    auto positions = std::vector<Vector3D>{{0, 0, 0}, {1, 0, 0}, {9, 0, 0}};
+    auto grid = NeighborGrid(UnitCell({10, 10, 10}), positions, 1.5);
+
+    auto neighbors = std::vector<size_t>();
+    grid.foreach_neighbor(1, [&](size_t j, const Vector3D& vector) {
+        assert(vector.norm() < 1.5);
+        neighbors.push_back(j);
+    });
+    assert(neighbors == std::vector<size_t>{0});
+    // [example]
+}
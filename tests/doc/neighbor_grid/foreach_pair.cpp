@@ -0,0 +1,25 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+
+#undef assert
+#define assert CHECK
+
+TEST_CASE() {
+    // [example]
+    auto positions = std::vector<Vector3D>{{0, 0, 0}, {1, 0, 0}, {9, 0, 0}};
+    auto grid = NeighborGrid(UnitCell({10, 10, 10}), positions, 1.5);
+
+    size_t count = 0;
+    grid.foreach_pair([&](size_t i, size_t j, const Vector3D& vector) {
+        // i < j, and the distance between i and j is below 1.5
+        assert(i < j);
+        assert(vector.norm() < 1.5);
+        count += 1;
+    });
+    // (0, 1) and (0, 2) through periodic boundary conditions
+    assert(count == 2);
+    // [example]
+}
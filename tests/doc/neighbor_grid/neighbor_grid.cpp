@@ -0,0 +1,18 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+
+#undef assert
+#define assert CHECK
+
+TEST_CASE() {
+    // [example]
+    auto positions = std::vector<Vector3D>{{0, 0, 0}, {1, 0, 0}, {9, 0, 0}};
+    auto grid = NeighborGrid(UnitCell({10, 10, 10}), positions, 1.5);
+
+    assert(grid.size() == 3);
+    assert(grid.cutoff() == 1.5);
+    // [example]
+}
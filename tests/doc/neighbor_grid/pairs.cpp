@@ -0,0 +1,20 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+
+#undef assert
+#define assert CHECK
+
+TEST_CASE() {
+    // [example]
+    auto positions = std::vector<Vector3D>{{0, 0, 0}, {1, 0, 0}, {9, 0, 0}};
+    auto grid = NeighborGrid(UnitCell({10, 10, 10}), positions, 1.5);
+
+    auto pairs = grid.pairs();
+    assert(pairs.size() == 2);
+    assert(pairs[0] == (std::array<size_t, 2>{{0, 1}}));
+    assert(pairs[1] == (std::array<size_t, 2>{{0, 2}}));
+    // [example]
+}
@@ -0,0 +1,28 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+
+#undef assert
+#define assert CHECK
+
+TEST_CASE() {
+    // [example]
+    auto frame = Frame();
+    frame.add_atom(Atom("Ar"), {0, 0, 0});
+    frame.add_atom(Atom("Ar"), {2, 0, 0});
+    frame.add_atom(Atom("Ar"), {8, 8, 8});
+
+    auto list = NeighborList(frame, 3.0, /* skin */ 1.0);
+    assert(list.cutoff() == 3.0);
+    assert(list.skin() == 1.0);
+
+    for (const auto& pair: list) {
+        assert(pair.first == 0);
+        assert(pair.second == 1);
+        assert(pair.distance == 2.0);
+        assert(pair.vector == Vector3D(2, 0, 0));
+    }
+    // [example]
+}
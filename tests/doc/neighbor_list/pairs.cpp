@@ -0,0 +1,25 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+
+#undef assert
+#define assert CHECK
+
+TEST_CASE() {
+    // [example]
+    auto frame = Frame();
+    frame.add_atom(Atom("Ar"), {0, 0, 0});
+    frame.add_atom(Atom("Ar"), {2, 0, 0});
+    frame.add_atom(Atom("Ar"), {8, 8, 8});
+
+    auto list = NeighborList(frame, 3.0);
+    assert(list.size() == 1);
+
+    auto& pairs = list.pairs();
+    assert(pairs[0].first == 0);
+    assert(pairs[0].second == 1);
+    assert(pairs[0].distance == 2.0);
+    // [example]
+}
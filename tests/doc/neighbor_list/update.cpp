@@ -0,0 +1,34 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+
+#undef assert
+#define assert CHECK
+
+TEST_CASE() {
+    // [example]
+    auto frame = Frame();
+    frame.add_atom(Atom("Ar"), {0, 0, 0});
+    frame.add_atom(Atom("Ar"), {2, 0, 0});
+    frame.add_atom(Atom("Ar"), {8, 8, 8});
+
+    auto list = NeighborList(frame, 3.0, /* skin */ 1.0);
+    assert(list.size() == 1);
+    assert(list.searches() == 1);
+
+    // small displacements only update the distances
+    frame.positions()[1] = {2.4, 0, 0};
+    list.update(frame);
+    assert(list.size() == 1);
+    assert(list.pairs()[0].distance == 2.4);
+    assert(list.searches() == 1);
+
+    // larger displacements run the full neighbor search again
+    frame.positions()[2] = {0, 0, 1};
+    list.update(frame);
+    assert(list.size() == 3);
+    assert(list.searches() == 2);
+    // [example]
+}
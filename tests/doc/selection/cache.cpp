@@ -0,0 +1,28 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+
+#undef assert
+#define assert CHECK
+
+TEST_CASE() {
+    // [example]
+    Selection::clear_cache();
+
+    auto first = Selection("name O");
+    auto second = Selection("name O");
+
+    auto stats = Selection::cache_stats();
+    assert(stats.hits == 1);
+    assert(stats.misses == 1);
+    assert(stats.size == 1);
+    assert(stats.capacity == 128);
+
+    // only keep the most recently used selection in the cache
+    Selection::set_cache_capacity(1);
+    auto third = Selection("name H");
+    assert(Selection::cache_stats().size == 1);
+    // [example]
+}
@@ -0,0 +1,18 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+
+#undef assert
+#define assert CHECK
+
+TEST_CASE() {
+    // [example]
+    auto selection = Selection("pairs: name(#1) O and is_bonded(#1, #2)");
+    assert(selection.topology_only() == true);
+
+    selection = Selection("name O and x < 3.4");
+    assert(selection.topology_only() == false);
+    // [example]
+}
@@ -0,0 +1,27 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+#undef assert
+#define assert CHECK
+
+TEST_CASE() {
+    // [example] [no-run]
+    chemfiles::set_frame_index_files(true);
+
+    // the first time a trajectory is read, the position of all steps is stored
+    // in "water.xtc.chfl-idx"
+    auto trajectory = chemfiles::Trajectory("water.xtc");
+    auto nsteps = trajectory.nsteps();
+    trajectory.close();
+
+    // the next times the trajectory is opened, these positions are loaded
+    // from the index file instead of reading the whole trajectory
+    trajectory = chemfiles::Trajectory("water.xtc");
+    assert(trajectory.nsteps() == nsteps);
+
+    chemfiles::set_frame_index_files(false);
+    // [example]
+}
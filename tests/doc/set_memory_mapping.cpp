@@ -0,0 +1,22 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+#undef assert
+#define assert CHECK
+
+TEST_CASE() {
+    // [example] [no-run]
+    chemfiles::set_memory_mapping(true);
+
+    // the file is memory mapped, and lines are read from the mapping
+    auto trajectory = chemfiles::Trajectory("water.xyz");
+    while (!trajectory.done()) {
+        auto frame = trajectory.read();
+    }
+
+    chemfiles::set_memory_mapping(false);
+    // [example]
+}
@@ -0,0 +1,22 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+#undef assert
+#define assert CHECK
+
+TEST_CASE() {
+    // [example] [no-run]
+    chemfiles::set_threaded_decompression(true);
+
+    // the file is decompressed in a separate thread while frames are parsed
+    auto trajectory = chemfiles::Trajectory("water.xyz.gz");
+    while (!trajectory.done()) {
+        auto frame = trajectory.read();
+    }
+
+    chemfiles::set_threaded_decompression(false);
+    // [example]
+}
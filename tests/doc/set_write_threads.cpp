@@ -0,0 +1,25 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+#undef assert
+#define assert CHECK
+
+TEST_CASE() {
+    // [example] [no-run]
+    // use one thread per CPU core to format the atoms
+    chemfiles::set_write_threads(0);
+
+    auto frame = chemfiles::Frame();
+    for (size_t i = 0; i < 1000000; i++) {
+        frame.add_atom(chemfiles::Atom("Ar"), {0.0, 0.0, static_cast<double>(i)});
+    }
+
+    auto trajectory = chemfiles::Trajectory("argon.xyz", 'w');
+    trajectory.write(frame);
+
+    chemfiles::set_write_threads(1);
+    // [example]
+}
@@ -0,0 +1,33 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+
+#undef assert
+#define assert CHECK
+
+TEST_CASE() {
+    // [example]
+    auto topology = Topology();
+    topology.add_atom(Atom("H"));
+    topology.add_atom(Atom("O"));
+    topology.add_atom(Atom("O"));
+    topology.add_atom(Atom("H"));
+
+    topology.add_bond(0, 1);
+    topology.add_bond(1, 2);
+    topology.add_bond(2, 3);
+
+    const auto& graph = topology.adjacency();
+    assert(graph.size() == 4);
+
+    auto neighbors = graph.neighbors(1);
+    assert(neighbors.size() == 2);
+    assert(neighbors[0] == 0);
+    assert(neighbors[1] == 2);
+
+    assert(graph.neighbors(3).size() == 1);
+    assert(graph.neighbors(3)[0] == 2);
+    // [example]
+}
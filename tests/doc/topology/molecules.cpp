@@ -0,0 +1,33 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+
+#undef assert
+#define assert CHECK
+
+TEST_CASE() {
+    // [example]
+    auto topology = Topology();
+    topology.add_atom(Atom("O"));
+    topology.add_atom(Atom("H"));
+    topology.add_atom(Atom("H"));
+    topology.add_atom(Atom("Na"));
+
+    topology.add_bond(0, 1);
+    topology.add_bond(0, 2);
+
+    const auto& molecules = topology.molecules();
+    assert(molecules.size() == 2);
+
+    assert(molecules.molecule_for_atom(2) == 0);
+    assert(molecules.molecule_for_atom(3) == 1);
+
+    auto water = molecules.atoms(0);
+    assert(water.size() == 3);
+    assert(water[0] == 0);
+    assert(water[1] == 1);
+    assert(water[2] == 2);
+    // [example]
+}
@@ -0,0 +1,24 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+
+#undef assert
+#define assert CHECK
+
+TEST_CASE() {
+    // [example]
+    auto topology = Topology();
+    topology.add_atom(Atom("H"));
+
+    // copies share the same version
+    auto copy = topology;
+    assert(copy.version() == topology.version());
+
+    // modifications change the version
+    auto version = topology.version();
+    topology.add_atom(Atom("O"));
+    assert(topology.version() != version);
+    // [example]
+}
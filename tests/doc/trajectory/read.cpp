@@ -13,9 +13,10 @@ TEST_CASE() {
     auto frame = trajectory.read();
     // Use the frame for awesome science here!
 
-    // This is one way to iterate over all the frames in a trajectory
+    // This is one way to iterate over all the frames in a trajectory,
+    // reading each step in the same frame to reuse its memory
     while (!trajectory.done()) {
-        frame = trajectory.read();
+        trajectory.read(frame);
         // ...
     }
     // [example]
@@ -0,0 +1,19 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+
+TEST_CASE() {
+    // [no-run]
+    // [example]
+    auto trajectory = Trajectory("water.xtc");
+
+    // read the positions of the first 100 steps, using 4 threads
+    auto positions = std::vector<std::vector<Vector3D>>(100);
+    trajectory.read_positions(0, positions, 4);
+
+    // positions[10] now contains the positions of the step 10
+    // [example]
+}
@@ -15,7 +15,7 @@ TEST_CASE() {
 
     // This is one way to iterate over all the frames in a trajectory
     for (size_t i = 0; i < trajectory.nsteps(); i++) {
-        frame = trajectory.read_step(i);
+        trajectory.read_step(i, frame);
         // ...
     }
     // [example]
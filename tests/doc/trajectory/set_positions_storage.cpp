@@ -0,0 +1,23 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+
+TEST_CASE() {
+    // [no-run]
+    // [example]
+    auto trajectory = Trajectory("water.xtc");
+    // store positions in single precision, with separate x, y and z arrays
+    trajectory.set_positions_storage(Frame::SOA_FLOAT);
+
+    auto frame = trajectory.read();
+    const auto& positions = frame.positions_soa();
+    auto mean_x = 0.0;
+    for (auto x: positions.x) {
+        mean_x += static_cast<double>(x);
+    }
+    mean_x /= static_cast<double>(frame.size());
+    // [example]
+}
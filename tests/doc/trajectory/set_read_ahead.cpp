@@ -0,0 +1,20 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+
+TEST_CASE() {
+    // [no-run]
+    // [example]
+    auto trajectory = Trajectory("water.xtc");
+    // read up to 8 frames ahead of time, using 4 threads
+    trajectory.set_read_ahead(8, 4);
+
+    while (!trajectory.done()) {
+        auto frame = trajectory.read();
+        // frames are still read in order
+    }
+    // [example]
+}
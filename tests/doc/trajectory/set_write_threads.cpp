@@ -0,0 +1,18 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <catch.hpp>
+#include <chemfiles.hpp>
+using namespace chemfiles;
+
+TEST_CASE() {
+    // [no-run]
+    // [example]
+    auto trajectory = Trajectory("water.xyz.gz", 'w', "XYZ / PGZ");
+    // format and compress the data with 4 threads
+    trajectory.set_write_threads(4);
+
+    auto frame = Frame();
+    trajectory.write(frame);
+    // [example]
+}
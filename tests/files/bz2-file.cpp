@@ -1,6 +1,8 @@
 // Chemfiles, a modern library for chemistry file reading and writing
 // Copyright (C) Guillaume Fraux and contributors -- BSD license
 
+#include <fstream>
+
 #include "catch.hpp"
 #include "helpers.hpp"
 #include "chemfiles/File.hpp"
@@ -72,6 +74,101 @@ TEST_CASE("Read a text file") {
     }
 }
 
+TEST_CASE("Seek in a bzip2 file") {
+    auto lines = std::vector<std::string>();
+    auto positions = std::vector<uint64_t>();
+    uint64_t position = 0;
+    for (size_t i = 0; i < 200000; i++) {
+        lines.push_back(fmt::format("line {} {} {:.6f}", i, (i * 7919) % 10007, 1.0 / static_cast<double>(i + 1)));
+        positions.push_back(position);
+        position += lines.back().size() + 1;
+    }
+
+    // write the data in two bzip2 streams, each containing multiple blocks
+    auto first = NamedTempPath(".bz2");
+    auto second = NamedTempPath(".bz2");
+    for (auto* path: {&first, &second}) {
+        TextFile file(*path, File::WRITE, File::BZIP2);
+        auto start = path == &first ? size_t(0) : lines.size() / 2;
+        for (size_t i = start; i < start + lines.size() / 2; i++) {
+            file.print("{}\n", lines[i]);
+        }
+    }
+
+    auto filename = NamedTempPath(".bz2");
+    {
+        auto content = read_binary_file(first);
+        auto content_2 = read_binary_file(second);
+        content.insert(content.end(), content_2.begin(), content_2.end());
+        std::ofstream output(filename.path(), std::ios::binary);
+        output.write(reinterpret_cast<const char*>(content.data()), static_cast<std::streamsize>(content.size()));
+    }
+
+    TextFile file(filename, File::READ, File::BZIP2);
+    size_t count = 0;
+    while (!file.eof()) {
+        file.readline();
+        count++;
+    }
+    CHECK(count == lines.size() + 1);
+    CHECK(file.tellpos() == position);
+
+    for (size_t i: {150000u, 3u, 199999u, 99999u, 100000u, 42u, 123456u, 54321u, 0u}) {
+        file.seekpos(positions[i]);
+        CHECK(file.readline() == lines[i]);
+        CHECK(file.readline() == (i + 1 < lines.size() ? lines[i + 1] : ""));
+    }
+
+    // seeking before reading the whole file
+    TextFile other(filename, File::READ, File::BZIP2);
+    for (size_t i: {120000u, 7u, 180000u, 150000u}) {
+        other.seekpos(positions[i]);
+        CHECK(other.readline() == lines[i]);
+    }
+}
+
+TEST_CASE("Block magic inside compressed data") {
+    // bzip2 stores which bytes are used in each block as bitmaps of 16 bits,
+    // after the block header. Using only the bytes marked in 0x3141, 0x5926,
+    // and 0x5359 for the groups of bytes 16-31, 32-47 and 48-63 puts a copy of
+    // the block magic (0x314159265359) in the compressed data of each block.
+    auto alphabet = std::vector<char>();
+    auto bitmaps = std::vector<unsigned>{0x3141, 0x5926, 0x5359};
+    for (size_t group = 0; group < bitmaps.size(); group++) {
+        for (unsigned bit = 0; bit < 16; bit++) {
+            if ((bitmaps[group] >> (15 - bit)) & 1) {
+                alphabet.push_back(static_cast<char>(16 * (group + 1) + bit));
+            }
+        }
+    }
+
+    auto content = std::string();
+    uint64_t state = 42;
+    for (size_t i = 0; i < 2000000; i++) {
+        state = state * 6364136223846793005 + 1442695040888963407;
+        content.push_back(alphabet[static_cast<size_t>(state >> 33) % alphabet.size()]);
+    }
+
+    auto filename = NamedTempPath(".bz2");
+    {
+        auto file = Bz2File(filename, File::WRITE);
+        file.write(content.data(), content.size());
+    }
+
+    auto file = Bz2File(filename, File::READ);
+    auto buffer = std::string(content.size() + 1, '\0');
+    CHECK(file.read(&buffer[0], buffer.size()) == content.size());
+    buffer.resize(content.size());
+    CHECK(buffer == content);
+
+    buffer.resize(100);
+    for (size_t position: {1500000u, 12u, 1999900u, 900000u}) {
+        file.seek(position);
+        CHECK(file.read(&buffer[0], buffer.size()) == buffer.size());
+        CHECK(buffer == content.substr(position, buffer.size()));
+    }
+}
+
 TEST_CASE("Write a bzip2 file") {
     auto filename = NamedTempPath(".bz2");
 
@@ -67,6 +67,71 @@ TEST_CASE("Read a text file") {
     }
 }
 
+TEST_CASE("Seek in a gz file") {
+    auto filename = NamedTempPath(".gz");
+    auto lines = std::vector<std::string>();
+    auto positions = std::vector<uint64_t>();
+    uint64_t position = 0;
+    for (size_t i = 0; i < 200000; i++) {
+        lines.push_back(fmt::format("line {} {} {:.6f}", i, (i * 7919) % 10007, 1.0 / static_cast<double>(i + 1)));
+        positions.push_back(position);
+        position += lines.back().size() + 1;
+    }
+
+    // write the data in two gzip members, each with multiple access points
+    for (auto mode: {File::WRITE, File::APPEND}) {
+        TextFile file(filename, mode, File::GZIP);
+        auto start = mode == File::WRITE ? size_t(0) : lines.size() / 2;
+        for (size_t i = start; i < start + lines.size() / 2; i++) {
+            file.print("{}\n", lines[i]);
+        }
+    }
+
+    TextFile file(filename, File::READ, File::GZIP);
+    // reading everything once, then seeking around the file
+    size_t count = 0;
+    while (!file.eof()) {
+        file.readline();
+        count++;
+    }
+    CHECK(count == lines.size() + 1);
+    CHECK(file.tellpos() == position);
+
+    for (size_t i: {150000u, 3u, 199999u, 99999u, 100000u, 42u, 123456u, 54321u, 0u}) {
+        file.seekpos(positions[i]);
+        CHECK(file.readline() == lines[i]);
+        CHECK(file.readline() == (i + 1 < lines.size() ? lines[i + 1] : ""));
+    }
+
+    // seeking before reading the whole file
+    TextFile other(filename, File::READ, File::GZIP);
+    for (size_t i: {120000u, 7u, 180000u, 150000u}) {
+        other.seekpos(positions[i]);
+        CHECK(other.readline() == lines[i]);
+    }
+}
+
+TEST_CASE("Read a file without gzip header") {
+    // like gzread, uncompressed files are read as-is
+    auto filename = NamedTempPath(".gz");
+    {
+        TextFile file(filename, File::WRITE, File::DEFAULT);
+        file.print("first line\nsecond line\n");
+    }
+
+    TextFile file(filename, File::READ, File::GZIP);
+    CHECK(file.readline() == "first line");
+    auto position = file.tellpos();
+    CHECK(file.readline() == "second line");
+    CHECK(file.readline() == "");
+    CHECK(file.eof());
+
+    file.seekpos(position);
+    CHECK(file.readline() == "second line");
+    file.seekpos(0);
+    CHECK(file.readline() == "first line");
+}
+
 TEST_CASE("Write a gz file") {
     auto filename = NamedTempPath(".gz");
 
@@ -95,6 +160,68 @@ TEST_CASE("Write a gz file") {
     CHECK(file.readline() == "5467");
 }
 
+TEST_CASE("Write a gz file in parallel") {
+    auto filename = NamedTempPath(".gz");
+
+    auto lines = std::vector<std::string>();
+    for (size_t i = 0; i < 200000; i++) {
+        lines.push_back(fmt::format("line {}", i));
+    }
+
+    {
+        TextFile file(filename, File::WRITE, File::GZIP_PARALLEL);
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (i == lines.size() / 2) {
+                // switch to a pool owned by this file while writing
+                file.set_write_threads(2);
+            }
+            file.print("{}\n", lines[i]);
+        }
+    }
+
+    // the file is a standard gzip file, which can be read by zlib
+    auto content = read_binary_file(filename);
+    auto buffer = decompress_gz(reinterpret_cast<const char*>(content.data()), content.size());
+    auto expected = std::string();
+    for (auto& line: lines) {
+        expected += line + "\n";
+    }
+    CHECK(std::string(buffer.data(), buffer.size()) == expected);
+
+    TextFile file(filename, File::READ, File::GZIP);
+    for (auto& line: lines) {
+        CHECK(file.readline() == line);
+    }
+    CHECK(file.readline() == "");
+    CHECK(file.eof());
+
+    file.seekpos(expected.find("line 123456\n"));
+    CHECK(file.readline() == "line 123456");
+
+    // empty files are valid
+    {
+        TextFile empty(filename, File::WRITE, File::GZIP_PARALLEL);
+    }
+    content = read_binary_file(filename);
+    buffer = decompress_gz(reinterpret_cast<const char*>(content.data()), content.size());
+    CHECK(buffer.size() == 0);
+
+    // incompressible data produces compressed chunks larger than the input
+    auto random = std::string(3000000, '\0');
+    uint32_t state = 42;
+    for (auto& c: random) {
+        state = state * 1664525 + 1013904223;
+        c = static_cast<char>(state >> 24);
+    }
+    {
+        TextFile incompressible(filename, File::WRITE, File::GZIP_PARALLEL);
+        incompressible.print("{}", random);
+    }
+    content = read_binary_file(filename);
+    buffer = decompress_gz(reinterpret_cast<const char*>(content.data()), content.size());
+    CHECK(std::string(buffer.data(), buffer.size()) == random);
+}
+
 TEST_CASE("Append to a gz file") {
     auto filename = NamedTempPath(".gz");
 
@@ -115,6 +115,34 @@ TEST_CASE("Write to files in memory") {
         );
     }
 
+    SECTION("Buffered writing") {
+        auto buffer = std::make_shared<MemoryBuffer>(6);
+        auto file = TextFile(buffer, File::WRITE, File::DEFAULT);
+
+        // data printed with compiled format strings is buffered
+        file.print(FMT_COMPILE("{} {:8.3f} {:g}\n"), "He", 1.5, -0.25);
+        CHECK(buffer->size() == 0);
+        CHECK(file.tellpos() == 18);
+
+        file.flush();
+        CHECK(std::string(buffer->data(), buffer->size()) == "He    1.500 -0.25\n");
+
+        // runtime format strings flush the buffer
+        file.print(FMT_COMPILE("{:.2f} "), 3.0);
+        file.print("{}\n", 42);
+        CHECK(std::string(buffer->data(), buffer->size()) == "He    1.500 -0.25\n3.00 42\n");
+        CHECK(file.tellpos() == buffer->size());
+
+        // the destructor flushes the buffer
+        auto other_buffer = std::make_shared<MemoryBuffer>(6);
+        {
+            auto other = TextFile(other_buffer, File::WRITE, File::DEFAULT);
+            other.print(FMT_COMPILE("{:g}\n"), 1e-7);
+            CHECK(other_buffer->size() == 0);
+        }
+        CHECK(std::string(other_buffer->data(), other_buffer->size()) == "1e-07\n");
+    }
+
     SECTION("Writing to a compressed memory file") {
         // This currently is not supported
         auto buffer = std::make_shared<MemoryBuffer>(4096);
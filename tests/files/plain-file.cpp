@@ -6,6 +6,7 @@
 #include "helpers.hpp"
 #include "chemfiles/files/PlainFile.hpp"
 #include "chemfiles/Error.hpp"
+#include "chemfiles/misc.hpp"
 using namespace chemfiles;
 
 TEST_CASE("Read a text file") {
@@ -155,6 +156,85 @@ TEST_CASE("Various line endings") {
     CHECK(plain_file.readline() == "no eol");
 }
 
+TEST_CASE("Memory mapped files") {
+    auto tmpfile = NamedTempPath(".dat");
+    std::ofstream(tmpfile, std::ios_base::binary) << "first\r\n\nthird\nlast";
+
+    // memory mapping is disabled by default
+    CHECK(PlainFile(tmpfile, File::READ).mapped().data() == nullptr);
+
+    chemfiles::set_memory_mapping(true);
+    auto file = PlainFile(tmpfile, File::READ);
+#if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+    CHECK(file.mapped() == "first\r\n\nthird\nlast");
+#endif
+    auto buffer = std::string(32, '\0');
+    file.seek(7);
+    CHECK(file.read(&buffer[0], 32) == 11);
+    CHECK(buffer.substr(0, 11) == "\nthird\nlast");
+    CHECK(file.read(&buffer[0], 32) == 0);
+
+    auto text = TextFile(tmpfile, File::READ, File::DEFAULT);
+    auto first = text.readline();
+    CHECK(first == "first");
+    CHECK(text.tellpos() == 7);
+    CHECK(text.readline() == "");
+    CHECK(text.readline() == "third");
+    CHECK(text.readline() == "last");
+    CHECK(text.eof());
+    CHECK(text.tellpos() == 18);
+    CHECK(text.readline() == "");
+
+    text.rewind();
+    CHECK(text.readline() == "first");
+    text.seekpos(8);
+    CHECK(text.readline() == "third");
+
+    // empty files can not be memory mapped, but can still be read
+    auto empty = NamedTempPath(".dat");
+    std::ofstream(empty, std::ios_base::binary).close();
+    CHECK(PlainFile(empty, File::READ).mapped().data() == nullptr);
+    text = TextFile(empty, File::READ, File::DEFAULT);
+    CHECK(text.readline() == "");
+    CHECK(text.eof());
+
+    chemfiles::set_memory_mapping(false);
+}
+
+TEST_CASE("Read a growing file") {
+    auto tmpfile = NamedTempPath(".dat");
+    std::ofstream(tmpfile, std::ios_base::binary) << "first\nsecond\n";
+
+    auto plain = PlainFile(tmpfile, File::READ);
+    auto buffer = std::string(32, '\0');
+    CHECK(plain.read(&buffer[0], 32) == 13);
+
+    auto file = TextFile(tmpfile, File::READ, File::DEFAULT);
+    CHECK(file.readline() == "first");
+    CHECK(file.readline() == "second");
+    CHECK(file.readline() == "");
+    CHECK(file.eof());
+    auto end = file.tellpos();
+    CHECK(end == 13);
+
+    {
+        auto append = TextFile(tmpfile, File::APPEND, File::DEFAULT);
+        append.print("third\nfourth\n");
+    }
+
+    // data appended after opening the file is visible
+    plain.clear();
+    CHECK(plain.read(&buffer[0], 32) == 13);
+    CHECK(buffer.substr(0, 13) == "third\nfourth\n");
+
+    file.clear();
+    file.seekpos(end);
+    CHECK(file.readline() == "third");
+    CHECK(file.readline() == "fourth");
+    CHECK(file.readline() == "");
+    CHECK(file.eof());
+}
+
 TEST_CASE("Write a text file") {
     auto filename = NamedTempPath(".dat");
 
@@ -0,0 +1,66 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include "catch.hpp"
+#include "helpers.hpp"
+#include "chemfiles/File.hpp"
+#include "chemfiles/misc.hpp"
+#include "chemfiles/files/GzFile.hpp"
+#include "chemfiles/files/ReadAheadFile.hpp"
+#include "chemfiles/Error.hpp"
+using namespace chemfiles;
+
+TEST_CASE("Read a compressed file in a background thread") {
+    auto lines = std::vector<std::string>();
+    auto positions = std::vector<uint64_t>();
+    uint64_t position = 0;
+    for (size_t i = 0; i < 400000; i++) {
+        lines.push_back(fmt::format("line {}", i));
+        positions.push_back(position);
+        position += lines.back().size() + 1;
+    }
+
+    auto filename = NamedTempPath(".gz");
+    {
+        TextFile file(filename, File::WRITE, File::GZIP);
+        for (auto& line: lines) {
+            file.print("{}\n", line);
+        }
+    }
+
+    SECTION("Direct use") {
+        auto file = ReadAheadFile(filename, std::make_unique<GzFile>(filename, File::READ));
+        auto buffer = std::vector<char>(position + 10);
+        CHECK(file.read(buffer.data(), 10) == 10);
+        CHECK(std::string(buffer.data(), 10) == "line 0\nlin");
+        CHECK(file.read(buffer.data() + 10, buffer.size()) == position - 10);
+        CHECK(file.read(buffer.data(), 10) == 0);
+
+        // seek backward, inside the current chunk and far ahead
+        for (size_t i: {3u, 4u, 399999u, 100u, 250000u, 250001u, 300000u}) {
+            file.seek(positions[i]);
+            CHECK(file.read(buffer.data(), lines[i].size()) == lines[i].size());
+            CHECK(std::string(buffer.data(), lines[i].size()) == lines[i]);
+        }
+
+        CHECK_THROWS_WITH(file.write("test", 4), "can not write to a file opened for reading");
+    }
+
+    SECTION("TextFile") {
+        set_threaded_decompression(true);
+        TextFile file(filename, File::READ, File::GZIP);
+        set_threaded_decompression(false);
+
+        for (auto& line: lines) {
+            CHECK(file.readline() == line);
+        }
+        CHECK(file.readline() == "");
+        CHECK(file.eof());
+        CHECK(file.tellpos() == position);
+
+        for (size_t i: {300000u, 3u, 399999u, 199999u, 42u}) {
+            file.seekpos(positions[i]);
+            CHECK(file.readline() == lines[i]);
+        }
+    }
+}
@@ -76,9 +76,11 @@ TEST_CASE("Write an xz file") {
     }
 
     auto content = read_binary_file(filename);
+    // blocks headers contain the compressed and uncompressed size, and the
+    // dictionary size is adjusted to the block size
     auto expected = std::vector<uint8_t> {
         0xfd, 0x37, 0x7a, 0x58, 0x5a, 0x00, 0x00, 0x04, 0xe6, 0xd6, 0xb4, 0x46,
-        0x02, 0x00, 0x21, 0x01, 0x16, 0x00, 0x00, 0x00, 0x74, 0x2f, 0xe5, 0xa3,
+        0x02, 0xc0, 0x0e, 0x0a, 0x21, 0x01, 0x00, 0x00, 0x22, 0x9c, 0xec, 0x82,
         0x01, 0x00, 0x09, 0x54, 0x65, 0x73, 0x74, 0x0a, 0x35, 0x34, 0x36, 0x37,
         0x0a, 0x00, 0x00, 0x00, 0xbd, 0xb5, 0x7a, 0x14, 0x41, 0x54, 0x79, 0xbe,
         0x00, 0x01, 0x22, 0x0a, 0x15, 0x1a, 0xe1, 0x67, 0x1f, 0xb6, 0xf3, 0x7d,
@@ -87,6 +89,48 @@ TEST_CASE("Write an xz file") {
     CHECK(content == expected);
 }
 
+TEST_CASE("Seek in an xz file") {
+    auto lines = std::vector<std::string>();
+    auto positions = std::vector<uint64_t>();
+    uint64_t position = 0;
+    for (size_t i = 0; i < 400000; i++) {
+        lines.push_back(fmt::format("line {}", i));
+        positions.push_back(position);
+        position += lines.back().size() + 1;
+    }
+
+    // the file contains multiple xz blocks
+    auto filename = NamedTempPath(".xz");
+    {
+        TextFile file(filename, File::WRITE, File::LZMA);
+        for (auto& line: lines) {
+            file.print("{}\n", line);
+        }
+    }
+
+    TextFile file(filename, File::READ, File::LZMA);
+    size_t count = 0;
+    while (!file.eof()) {
+        file.readline();
+        count++;
+    }
+    CHECK(count == lines.size() + 1);
+    CHECK(file.tellpos() == position);
+
+    for (size_t i: {300000u, 3u, 399999u, 199999u, 200000u, 42u, 246912u, 54321u, 0u}) {
+        file.seekpos(positions[i]);
+        CHECK(file.readline() == lines[i]);
+        CHECK(file.readline() == (i + 1 < lines.size() ? lines[i + 1] : ""));
+    }
+
+    // seeking before reading the whole file
+    TextFile other(filename, File::READ, File::LZMA);
+    for (size_t i: {240000u, 7u, 360000u, 300000u}) {
+        other.seekpos(positions[i]);
+        CHECK(other.readline() == lines[i]);
+    }
+}
+
 TEST_CASE("In-memory decompression") {
     auto content = std::vector<uint8_t> {
         0xfd, 0x37, 0x7a, 0x58, 0x5a, 0x00, 0x00, 0x04, 0xe6, 0xd6, 0xb4, 0x46,
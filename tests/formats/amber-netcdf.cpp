@@ -120,6 +120,23 @@ TEST_CASE("Write files in NetCDF format") {
         check_frame(file.read());
     }
 
+    SECTION("Read single precision data") {
+        auto tmpfile = NamedTempPath(".nc");
+        {
+            auto file = Trajectory(tmpfile, 'w');
+            file.write(frame);
+        }
+
+        auto file = Trajectory(tmpfile, 'r');
+        file.set_positions_storage(Frame::SOA_FLOAT);
+        auto read = file.read();
+        CHECK(read.storage() == Frame::SOA_FLOAT);
+        CHECK(read.positions_soa()[3] == Vector3D(3, 6, 9));
+        REQUIRE(read.velocities_soa());
+        CHECK((*read.velocities_soa())[3] == Vector3D(-3, -2, -1));
+        check_frame(read);
+    }
+
     SECTION("Append to existing file") {
         auto tmpfile = NamedTempPath(".nc");
 
@@ -475,3 +475,32 @@ TEST_CASE("Append to DCD files") {
         CHECK(approx_eq(positions[2], {-3, 0, 0}, 1e-12));
     }
 }
+
+TEST_CASE("Read single precision positions from DCD files") {
+    auto tmpfile = NamedTempPath(".dcd");
+    {
+        auto file = Trajectory(tmpfile, 'w');
+        auto frame = Frame(UnitCell({50, 50, 50}));
+        for (size_t i = 0; i < 20; i++) {
+            auto x = 0.37 * static_cast<double>(i);
+            frame.add_atom(Atom("A"), {x, -x, 2 * x});
+        }
+        file.write(frame);
+        file.write(frame);
+    }
+
+    auto file = Trajectory(tmpfile);
+    auto expected = file.read();
+
+    file.set_positions_storage(Frame::SOA_FLOAT);
+    auto frame = file.read();
+    CHECK(frame.storage() == Frame::SOA_FLOAT);
+    CHECK(frame.size() == 20);
+
+    const auto& positions = frame.positions_soa();
+    for (size_t i = 0; i < 20; i++) {
+        CHECK(positions.x[i] == static_cast<float>(expected.positions()[i][0]));
+        CHECK(positions.y[i] == static_cast<float>(expected.positions()[i][1]));
+        CHECK(positions.z[i] == static_cast<float>(expected.positions()[i][2]));
+    }
+}
@@ -1,6 +1,7 @@
 // Chemfiles, a modern library for chemistry file reading and writing
 // Copyright (C) Guillaume Fraux and contributors -- BSD license
 #include <cstdlib>
+#include <iostream>
 
 #include "catch.hpp"
 #include "helpers.hpp"
@@ -610,6 +611,102 @@ TEST_CASE("PDB files with big values") {
     }
 }
 
+TEST_CASE("Parallel writing of PDB files") {
+    auto frame = Frame();
+    for (size_t i = 0; i < 10000; i++) {
+        frame.add_atom(Atom("CA", "C"), {0.5 * static_cast<double>(i), 1, -2});
+    }
+
+    // residues with multiple chains and some atoms without residues, to
+    // check TER records and generated residue ids across chunks
+    for (size_t i = 0; i < 10000; i += 10) {
+        if (i % 70 == 0) {
+            continue;
+        }
+        Residue residue("ALA", static_cast<int64_t>(i / 10));
+        residue.set("chainid", std::string(1, static_cast<char>('A' + (i / 1000))));
+        residue.set("composition_type", "L-PEPTIDE LINKING");
+        for (size_t j = i; j < i + 10; j++) {
+            residue.add_atom(j);
+        }
+        frame.add_residue(std::move(residue));
+    }
+    frame.add_bond(4095, 4096);
+    frame.add_bond(8200, 9999);
+
+    auto tmpfile = NamedTempPath(".pdb");
+    Trajectory(tmpfile, 'w').write(frame);
+    auto expected = read_text_file(tmpfile);
+
+    set_write_threads(3);
+    Trajectory(tmpfile, 'w').write(frame);
+    auto content = read_text_file(tmpfile);
+    set_write_threads(1);
+
+    // threads set for a single trajectory
+    {
+        auto file = Trajectory(tmpfile, 'w');
+        file.set_write_threads(3);
+        file.write(frame);
+    }
+    CHECK(read_text_file(tmpfile) == expected);
+
+    set_write_threads(3);
+
+    frame.positions()[9000] = Vector3D(123456789, 2, 3);
+    CHECK_THROWS_WITH(
+        Trajectory(tmpfile, 'w').write(frame),
+        "value in atomic position is too big for representation in PDB format"
+    );
+    set_write_threads(1);
+
+    CHECK(content == expected);
+}
+
+TEST_CASE("Warnings order when writing PDB files in parallel") {
+    auto frame = Frame();
+    for (size_t i = 0; i < 15000; i++) {
+        frame.add_atom(Atom("CA", "C"), {0, 0, 0});
+        frame[i].set("altloc", "AL" + std::to_string(i));
+    }
+
+    // long residue names also send a warning
+    for (size_t i = 0; i < 15000; i += 1000) {
+        Residue residue("RES" + std::to_string(i), static_cast<int64_t>(i));
+        residue.add_atom(i);
+        frame.add_residue(std::move(residue));
+    }
+
+    auto warnings = std::vector<std::string>();
+    set_warning_callback([&](const std::string& message) {
+        warnings.push_back(message);
+    });
+
+    auto expected = std::vector<std::string>();
+    for (size_t i = 0; i < 15000; i++) {
+        expected.push_back("PDB writer: altloc 'AL" + std::to_string(i) + "' is too long, it will be truncated");
+        if (i % 1000 == 0) {
+            expected.push_back("PDB writer: residue 'RES" + std::to_string(i) + "' name is too long, it will be truncated");
+        }
+    }
+
+    auto tmpfile = NamedTempPath(".pdb");
+    Trajectory(tmpfile, 'w').write(frame);
+    CHECK(warnings == expected);
+
+    set_write_threads(3);
+    for (size_t repeat = 0; repeat < 5; repeat++) {
+        warnings.clear();
+        Trajectory(tmpfile, 'w').write(frame);
+        CHECK(warnings == expected);
+    }
+    set_write_threads(1);
+
+    set_warning_callback([](const std::string& message) {
+        std::cerr << "[chemfiles] " << message << std::endl;
+    });
+}
+
 TEST_CASE("Read and write files in memory") {
     SECTION("Reading from memory") {
         auto content = read_text_file("data/pdb/water.pdb");
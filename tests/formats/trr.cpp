@@ -400,3 +400,42 @@ TEST_CASE("Check Errors") {
         file.write(frame),
         "TRR format does not support varying numbers of atoms: expected 1, but got 2");
 }
+
+TEST_CASE("Read single precision positions and velocities") {
+    auto tmpfile = NamedTempPath(".trr");
+    {
+        auto file = Trajectory(tmpfile, 'w');
+        auto frame = Frame(UnitCell({50, 50, 50}));
+        frame.add_velocities();
+        for (size_t i = 0; i < 20; i++) {
+            auto x = 0.37 * static_cast<double>(i);
+            frame.add_atom(Atom("A"), {x, -x, 2 * x}, {-x, 0.5 * x, x});
+        }
+        file.write(frame);
+        file.write(frame);
+    }
+
+    auto file = Trajectory(tmpfile);
+    auto expected = file.read();
+
+    file.set_positions_storage(Frame::SOA_FLOAT);
+    auto frame = file.read();
+    CHECK(frame.storage() == Frame::SOA_FLOAT);
+    CHECK(frame.size() == 20);
+
+    const auto& positions = frame.positions_soa();
+    REQUIRE(frame.velocities_soa());
+    const auto& velocities = *frame.velocities_soa();
+    for (size_t i = 0; i < 20; i++) {
+        CHECK(positions[i] == Vector3D(
+            static_cast<float>(expected.positions()[i][0]),
+            static_cast<float>(expected.positions()[i][1]),
+            static_cast<float>(expected.positions()[i][2])
+        ));
+        CHECK(velocities[i] == Vector3D(
+            static_cast<float>((*expected.velocities())[i][0]),
+            static_cast<float>((*expected.velocities())[i][1]),
+            static_cast<float>((*expected.velocities())[i][2])
+        ));
+    }
+}
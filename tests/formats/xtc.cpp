@@ -501,3 +501,77 @@ TEST_CASE("Large Numbers") {
         CHECK(approx_eq(cell.lengths(), {16777220, 16777220, 16777220}, 1e-4));
     }
 }
+
+static void check_read_positions(size_t natoms) {
+    auto tmpfile = NamedTempPath(".xtc");
+    {
+        auto file = Trajectory(tmpfile, 'w');
+        for (size_t step = 0; step < 37; step++) {
+            auto frame = Frame(UnitCell({50, 50, 50}));
+            for (size_t i = 0; i < natoms; i++) {
+                auto x = static_cast<double>(i) + 0.1 * static_cast<double>(step);
+                frame.add_atom(Atom("A"), {x, -x, 2 * x});
+            }
+            file.write(frame);
+        }
+    }
+
+    auto file = Trajectory(tmpfile);
+    auto expected = std::vector<std::vector<Vector3D>>();
+    while (!file.done()) {
+        auto frame = file.read();
+        auto positions = frame.positions();
+        expected.emplace_back(positions.begin(), positions.end());
+    }
+
+    for (size_t threads: {1u, 3u, 8u, 100u}) {
+        auto positions = std::vector<std::vector<Vector3D>>(expected.size());
+        file.read_positions(0, positions, threads);
+        CHECK(positions == expected);
+
+        positions = std::vector<std::vector<Vector3D>>(10);
+        file.read_positions(20, positions, threads);
+        for (size_t i = 0; i < positions.size(); i++) {
+            CHECK(positions[i] == expected[20 + i]);
+        }
+    }
+}
+
+TEST_CASE("Read positions in parallel") {
+    // compressed coordinates
+    check_read_positions(150);
+    // uncompressed coordinates
+    check_read_positions(7);
+}
+
+TEST_CASE("Read single precision positions") {
+    // compressed and uncompressed coordinates
+    for (size_t natoms: {150u, 7u}) {
+        auto tmpfile = NamedTempPath(".xtc");
+        {
+            auto file = Trajectory(tmpfile, 'w');
+            auto frame = Frame(UnitCell({50, 50, 50}));
+            for (size_t i = 0; i < natoms; i++) {
+                auto x = 0.37 * static_cast<double>(i);
+                frame.add_atom(Atom("A"), {x, -x, 2 * x});
+            }
+            file.write(frame);
+            file.write(frame);
+        }
+
+        auto file = Trajectory(tmpfile);
+        auto expected = file.read();
+
+        file.set_positions_storage(Frame::SOA_FLOAT);
+        auto frame = file.read();
+        CHECK(frame.storage() == Frame::SOA_FLOAT);
+        CHECK(frame.size() == natoms);
+
+        const auto& positions = frame.positions_soa();
+        for (size_t i = 0; i < natoms; i++) {
+            CHECK(positions.x[i] == static_cast<float>(expected.positions()[i][0]));
+            CHECK(positions.y[i] == static_cast<float>(expected.positions()[i][1]));
+            CHECK(positions.z[i] == static_cast<float>(expected.positions()[i][2]));
+        }
+    }
+}
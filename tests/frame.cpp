@@ -1,6 +1,8 @@
 // Chemfiles, a modern library for chemistry file reading and writing
 // Copyright (C) Guillaume Fraux and contributors -- BSD license
 
+#include <thread>
+
 #include <catch.hpp>
 #include "helpers.hpp"
 #include "chemfiles.hpp"
@@ -52,6 +54,54 @@ TEST_CASE("Frame size") {
     CHECK_THROWS_AS(frame.remove(15), OutOfBounds);
 }
 
+TEST_CASE("Remove multiple atoms") {
+    auto frame = Frame();
+    frame.add_velocities();
+    for (size_t i = 0; i < 6; i++) {
+        auto value = static_cast<double>(i);
+        frame.add_atom(Atom(std::to_string(i)), {value, 0, 0}, {0, value, 0});
+    }
+    frame.add_bond(0, 1);
+    frame.add_bond(1, 2, Bond::DOUBLE);
+    frame.add_bond(4, 5, Bond::TRIPLE);
+
+    SECTION("Double precision") {
+        auto indexes = std::vector<size_t>{4, 1, 1};
+        frame.remove(indexes);
+        CHECK(frame.size() == 4);
+        CHECK(frame.topology()[0].name() == "0");
+        CHECK(frame.topology()[1].name() == "2");
+        CHECK(frame.topology()[2].name() == "3");
+        CHECK(frame.topology()[3].name() == "5");
+        CHECK(frame.positions()[3] == Vector3D(5, 0, 0));
+        CHECK((*frame.velocities())[3] == Vector3D(0, 5, 0));
+        CHECK(frame.topology().bonds().empty());
+    }
+
+    SECTION("Single precision") {
+        frame.set_storage(Frame::SOA_FLOAT);
+        auto indexes = std::vector<size_t>{0, 3};
+        frame.remove(indexes);
+        CHECK(frame.size() == 4);
+        CHECK(frame.topology()[0].name() == "1");
+        CHECK(frame.positions_soa()[3] == Vector3D(5, 0, 0));
+        REQUIRE(frame.velocities_soa());
+        CHECK((*frame.velocities_soa())[3] == Vector3D(0, 5, 0));
+        CHECK(frame.topology().bonds() == (std::vector<Bond>{{0, 1}, {2, 3}}));
+        CHECK(frame.topology().bond_orders() == (std::vector<Bond::BondOrder>{Bond::DOUBLE, Bond::TRIPLE}));
+    }
+
+    SECTION("Errors") {
+        auto indexes = std::vector<size_t>{0, 6};
+        CHECK_THROWS_WITH(frame.remove(indexes),
+            "out of bounds atomic index in `Frame::remove`: we have 6 atoms, "
+            "but the index is 6"
+        );
+        CHECK(frame.size() == 6);
+        CHECK(frame.topology().size() == 6);
+    }
+}
+
 TEST_CASE("Positions and velocities") {
     auto frame = Frame();
     frame.resize(15);
@@ -80,6 +130,96 @@ TEST_CASE("Positions and velocities") {
     }
 }
 
+TEST_CASE("Positions and velocities storage") {
+    auto frame = Frame();
+    CHECK(frame.storage() == Frame::AOS_DOUBLE);
+    CHECK_THROWS_WITH(
+        frame.positions_soa(),
+        "this frame does not store positions as single precision structure of arrays"
+    );
+
+    frame.add_atom(Atom("H"), {1, 2, 3});
+    frame.add_atom(Atom("O"), {0.1, 0.2, 0.3});
+    frame.add_velocities();
+    (*frame.velocities())[1] = Vector3D(4, 5, 6);
+
+    frame.set_storage(Frame::SOA_FLOAT);
+    CHECK(frame.storage() == Frame::SOA_FLOAT);
+    CHECK(frame.size() == 2);
+
+    const auto& positions = frame.positions_soa();
+    CHECK(positions.size() == 2);
+    CHECK(positions.x == std::vector<float>{1.0f, 0.1f});
+    CHECK(positions.y == std::vector<float>{2.0f, 0.2f});
+    CHECK(positions.z == std::vector<float>{3.0f, 0.3f});
+    REQUIRE(frame.velocities_soa());
+    CHECK(frame.velocities_soa()->x == std::vector<float>{0.0f, 4.0f});
+
+    // const access gives double precision copies
+    const auto& const_frame = frame;
+    CHECK(const_frame.positions().size() == 2);
+    CHECK(const_frame.positions()[1] == Vector3D(0.1f, 0.2f, 0.3f));
+    REQUIRE(const_frame.velocities());
+    CHECK((*const_frame.velocities())[1] == Vector3D(4, 5, 6));
+
+    // modifications are visible in the double precision copies
+    frame.positions_soa().set(0, {-1, -2, -3});
+    frame.add_atom(Atom("C"), {7, 8, 9}, {1, 1, 1});
+    CHECK(frame.size() == 3);
+    CHECK(const_frame.positions()[0] == Vector3D(-1, -2, -3));
+    CHECK(const_frame.positions()[2] == Vector3D(7, 8, 9));
+    CHECK((*const_frame.velocities())[2] == Vector3D(1, 1, 1));
+    CHECK(frame.storage() == Frame::SOA_FLOAT);
+
+    frame.resize(5);
+    CHECK(frame.size() == 5);
+    CHECK(frame.positions_soa().size() == 5);
+    CHECK(frame.velocities_soa()->size() == 5);
+
+    frame.remove(0);
+    CHECK(frame.size() == 4);
+    CHECK(const_frame.positions()[1] == Vector3D(7, 8, 9));
+    CHECK(approx_eq(frame.distance(1, 2), std::sqrt(194.0)));
+
+    auto clone = frame.clone();
+    CHECK(clone.storage() == Frame::SOA_FLOAT);
+    CHECK(clone.positions_soa().x == frame.positions_soa().x);
+
+    // the double precision copy can be created by multiple threads at once
+    const auto& const_clone = clone;
+    auto errors = std::vector<size_t>(4, 0);
+    auto threads = std::vector<std::thread>();
+    for (size_t thread = 0; thread < 4; thread++) {
+        threads.emplace_back([&, thread]() {
+            if (!(const_clone.positions()[1] == Vector3D(7, 8, 9))) {
+                errors[thread] += 1;
+            }
+            if (!(const_clone.velocities() && (*const_clone.velocities())[1] == Vector3D(1, 1, 1))) {
+                errors[thread] += 1;
+            }
+        });
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    CHECK(errors == std::vector<size_t>(4, 0));
+
+    // mutable access converts the frame back to double precision
+    frame.positions()[3] = Vector3D(1, 2, 3);
+    CHECK(frame.storage() == Frame::AOS_DOUBLE);
+    CHECK(frame.positions()[1] == Vector3D(7, 8, 9));
+    CHECK((*frame.velocities())[1] == Vector3D(1, 1, 1));
+    CHECK(frame.positions()[3] == Vector3D(1, 2, 3));
+
+    clone = Frame();
+    clone.set_storage(Frame::SOA_FLOAT);
+    CHECK_FALSE(clone.velocities_soa());
+    CHECK_FALSE(static_cast<const Frame&>(clone).velocities());
+    clone.resize(3);
+    clone.add_velocities();
+    CHECK(clone.velocities_soa()->size() == 3);
+}
+
 TEST_CASE("Frame step") {
     auto frame = Frame();
     CHECK(frame.step() == 0);
@@ -184,6 +324,20 @@ TEST_CASE("Guess topology") {
         frame.guess_bonds();
         CHECK(frame.topology().bonds() == (std::vector<Bond>{{0, 2}}));
     }
+
+    SECTION("Periodic boundary conditions") {
+        auto frame = Frame(UnitCell({10, 10, 10}));
+        frame.add_atom(Atom("C"), {0.2, 5, 5});
+        frame.add_atom(Atom("C"), {9.0, 5, 5});
+        frame.add_atom(Atom("C"), {5, 5, 5});
+
+        frame.guess_bonds();
+        CHECK(frame.topology().bonds() == (std::vector<Bond>{{0, 1}}));
+
+        frame.set_cell(UnitCell({10, 10, 10}, {90, 90, 60}));
+        frame.guess_bonds();
+        CHECK(frame.topology().bonds() == (std::vector<Bond>{{0, 1}}));
+    }
 }
 
 TEST_CASE("PBC functions") {
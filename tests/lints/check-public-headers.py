@@ -35,6 +35,8 @@ WHITELIST = [
     "new",
     "cstddef",
     "map",
+    "mutex",
+    "atomic",
     # external headers
     "chemfiles/external/span.hpp",
     "chemfiles/external/optional.hpp",
@@ -55,6 +57,8 @@ WHITELIST = [
     "chemfiles/UnitCell.hpp",
     "chemfiles/Trajectory.hpp",
     "chemfiles/Selection.hpp",
+    "chemfiles/NeighborGrid.hpp",
+    "chemfiles/NeighborList.hpp",
     "chemfiles/Connectivity.hpp",
     "chemfiles/FormatMetadata.hpp",
     # chemfiles capi headers
@@ -68,6 +72,7 @@ WHITELIST = [
     "chemfiles/capi/types.h",
     "chemfiles/capi/topology.h",
     "chemfiles/capi/misc.h",
+    "chemfiles/capi/neighbor_list.h",
 ]
 
 
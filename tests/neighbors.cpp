@@ -0,0 +1,182 @@
+// Chemfiles, a modern library for chemistry file reading and writing
+// Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <random>
+
+#include <catch.hpp>
+#include "helpers.hpp"
+#include "chemfiles.hpp"
+using namespace chemfiles;
+
+static std::vector<Vector3D> random_positions(size_t count, double min, double max) {
+    auto generator = std::mt19937(42);
+    auto distribution = std::uniform_real_distribution<double>(min, max);
+    auto positions = std::vector<Vector3D>();
+    for (size_t i = 0; i < count; i++) {
+        positions.emplace_back(
+            distribution(generator), distribution(generator), distribution(generator)
+        );
+    }
+    return positions;
+}
+
+static std::vector<std::array<size_t, 2>> brute_force_pairs(const UnitCell& cell, span<const Vector3D> positions, double cutoff) {
+    auto pairs = std::vector<std::array<size_t, 2>>();
+    for (size_t i = 0; i < positions.size(); i++) {
+        for (size_t j = i + 1; j < positions.size(); j++) {
+            if (cell.wrap(positions[j] - positions[i]).norm() < cutoff) {
+                pairs.push_back({{i, j}});
+            }
+        }
+    }
+    return pairs;
+}
+
+TEST_CASE("NeighborGrid") {
+    SECTION("Errors") {
+        auto positions = std::vector<Vector3D>{{0, 0, 0}};
+        CHECK_THROWS_AS(NeighborGrid(UnitCell(), positions, 0.0), Error);
+        CHECK_THROWS_AS(NeighborGrid(UnitCell(), positions, -2.0), Error);
+
+        auto grid = NeighborGrid(UnitCell(), positions, 1.0);
+        CHECK_THROWS_AS(grid.foreach_neighbor(1, [](size_t, const Vector3D&) {}), OutOfBounds);
+    }
+
+    SECTION("Empty and single point") {
+        auto positions = std::vector<Vector3D>();
+        auto grid = NeighborGrid(UnitCell(), positions, 3.0);
+        CHECK(grid.size() == 0);
+        CHECK(grid.pairs().empty());
+
+        positions.emplace_back(1, 2, 3);
+        grid = NeighborGrid(UnitCell({10, 10, 10}), positions, 3.0);
+        CHECK(grid.size() == 1);
+        CHECK(grid.pairs().empty());
+    }
+
+    SECTION("Infinite cell") {
+        auto positions = random_positions(500, -20, 20);
+        // add an outlier far away from all the other points
+        positions.emplace_back(1e6, 0, 0);
+        auto cell = UnitCell();
+        auto grid = NeighborGrid(cell, positions, 3.5);
+        CHECK(grid.pairs() == brute_force_pairs(cell, positions, 3.5));
+    }
+
+    SECTION("Orthorhombic cell") {
+        auto positions = random_positions(500, -5, 25);
+        auto cell = UnitCell({20, 22, 25});
+        auto grid = NeighborGrid(cell, positions, 3.5);
+        CHECK(grid.pairs() == brute_force_pairs(cell, positions, 3.5));
+
+        // less than 3 cells in some directions
+        cell = UnitCell({5, 9, 25});
+        grid = NeighborGrid(cell, positions, 2.4);
+        CHECK(grid.pairs() == brute_force_pairs(cell, positions, 2.4));
+    }
+
+    SECTION("Triclinic cell") {
+        auto positions = random_positions(500, -5, 25);
+        auto cell = UnitCell({20, 22, 25}, {80, 100, 70});
+        auto grid = NeighborGrid(cell, positions, 3.5);
+        CHECK(grid.pairs() == brute_force_pairs(cell, positions, 3.5));
+    }
+
+    SECTION("Neighbors of a point") {
+        auto positions = random_positions(300, 0, 15);
+        auto cell = UnitCell({15, 15, 15}, {90, 80, 100});
+        auto grid = NeighborGrid(cell, positions, 3.0);
+        auto pairs = brute_force_pairs(cell, positions, 3.0);
+
+        for (size_t i = 0; i < positions.size(); i++) {
+            auto expected = std::vector<size_t>();
+            for (auto& pair: pairs) {
+                if (pair[0] == i) {
+                    expected.push_back(pair[1]);
+                } else if (pair[1] == i) {
+                    expected.push_back(pair[0]);
+                }
+            }
+
+            auto actual = std::vector<size_t>();
+            grid.foreach_neighbor(i, [&](size_t j, const Vector3D& vector) {
+                CHECK(approx_eq(vector, cell.wrap(positions[j] - positions[i]), 1e-9));
+                actual.push_back(j);
+            });
+            std::sort(expected.begin(), expected.end());
+            std::sort(actual.begin(), actual.end());
+            CHECK(actual == expected);
+        }
+    }
+}
+
+TEST_CASE("NeighborList") {
+    SECTION("Errors") {
+        auto frame = Frame();
+        CHECK_THROWS_AS(NeighborList(frame, 0.0), Error);
+        CHECK_THROWS_AS(NeighborList(frame, 3.0, -1.0), Error);
+    }
+
+    SECTION("Pairs") {
+        auto cell = UnitCell({15, 15, 15}, {90, 80, 100});
+        auto frame = Frame(cell);
+        for (auto& position: random_positions(300, 0, 15)) {
+            frame.add_atom(Atom("X"), position);
+        }
+
+        auto list = NeighborList(frame, 3.0);
+        auto expected = brute_force_pairs(cell, frame.positions(), 3.0);
+        REQUIRE(list.size() == expected.size());
+        for (size_t i = 0; i < list.size(); i++) {
+            const auto& pair = list.pairs()[i];
+            CHECK(pair.first == expected[i][0]);
+            CHECK(pair.second == expected[i][1]);
+            CHECK(approx_eq(pair.distance, frame.distance(pair.first, pair.second), 1e-12));
+            CHECK(approx_eq(pair.vector.norm(), pair.distance, 1e-12));
+        }
+    }
+
+    SECTION("Update") {
+        auto cell = UnitCell({15, 15, 15});
+        auto frame = Frame(cell);
+        for (auto& position: random_positions(300, 0, 15)) {
+            frame.add_atom(Atom("X"), position);
+        }
+
+        auto list = NeighborList(frame, 3.0, 1.0);
+        CHECK(list.searches() == 1);
+
+        auto generator = std::mt19937(12);
+        auto distribution = std::uniform_real_distribution<double>(-0.25, 0.25);
+        for (size_t step = 0; step < 10; step++) {
+            for (auto& position: frame.positions()) {
+                position[0] += distribution(generator);
+                position[1] += distribution(generator);
+                position[2] += distribution(generator);
+            }
+            list.update(frame);
+
+            auto expected = brute_force_pairs(cell, frame.positions(), 3.0);
+            auto actual = std::vector<std::array<size_t, 2>>();
+            for (auto& pair: list) {
+                actual.push_back({{pair.first, pair.second}});
+            }
+            CHECK(actual == expected);
+        }
+        // atoms moved by more than half the skin at some point
+        CHECK(list.searches() > 1);
+        CHECK(list.searches() < 11);
+
+        // changing the cell always runs a new search
+        auto searches = list.searches();
+        frame.set_cell(UnitCell({16, 16, 16}));
+        list.update(frame);
+        CHECK(list.searches() == searches + 1);
+
+        // as does changing the number of atoms
+        frame.add_atom(Atom("X"), {0, 0, 0});
+        list.update(frame);
+        CHECK(list.searches() == searches + 2);
+        CHECK(list.size() == brute_force_pairs(frame.cell(), frame.positions(), 3.0).size());
+    }
+}
@@ -1,14 +1,12 @@
 // Chemfiles, a modern library for chemistry file reading and writing
 // Copyright (C) Guillaume Fraux and contributors -- BSD license
+#include <cmath>
+
 #include <catch.hpp>
 
 #include "chemfiles/parse.hpp"
 #include "chemfiles/Error.hpp"
 
-static bool relative_eq(double a, double b) {
-    return fabs((b - a) / a) < 1e-14;
-}
-
 TEST_CASE("String parsing") {
     SECTION("Double") {
         CHECK(chemfiles::parse<double>("12.5") == 12.5);
@@ -37,15 +35,45 @@ TEST_CASE("String parsing") {
         CHECK(chemfiles::parse<double>("+0.0") == 0.0);
         CHECK(chemfiles::parse<double>("-0.0") == 0.0);
 
-        // Some float are not parsed exactly, but up to a 1e-14 RELATIVE error
-        // which is good enough for our purposes
-        CHECK(relative_eq(chemfiles::parse<double>("1.97576e0"), 1.97576e0));
-        CHECK(relative_eq(chemfiles::parse<double>("2.27e-308"), 2.27e-308));
-        CHECK(relative_eq(chemfiles::parse<double>("1.15507e-173"), 1.15507e-173));
-        CHECK(relative_eq(
-            chemfiles::parse<double>("0.000000000000000000000000000000000000783475"),
-            0.000000000000000000000000000000000000783475
-        ));
+        CHECK(std::signbit(chemfiles::parse<double>("-0.0")));
+        CHECK(std::signbit(chemfiles::parse<double>("-0e12")));
+
+        // Values are correctly rounded to the closest double
+        CHECK(chemfiles::parse<double>("1.97576e0") == 1.97576e0);
+        CHECK(chemfiles::parse<double>("2.27e-308") == 2.27e-308);
+        CHECK(chemfiles::parse<double>("1.15507e-173") == 1.15507e-173);
+        CHECK(chemfiles::parse<double>("0.000000000000000000000000000000000000783475") == 0.000000000000000000000000000000000000783475);
+        CHECK(chemfiles::parse<double>("0.1") == 0.1);
+        CHECK(chemfiles::parse<double>("1e23") == 1e23);
+        CHECK(chemfiles::parse<double>("-914.812039125566344") == -914.812039125566344);
+        CHECK(chemfiles::parse<double>("12345678.12345678") == 12345678.12345678);
+        CHECK(chemfiles::parse<double>("1.7976931348623157e308") == 1.7976931348623157e308);
+        CHECK(chemfiles::parse<double>("2.2250738585072014e-308") == 2.2250738585072014e-308);
+        // subnormal values
+        CHECK(chemfiles::parse<double>("4.9406564584124654e-324") == 4.9406564584124654e-324);
+        CHECK(chemfiles::parse<double>("2.2250738585072011e-308") == 2.2250738585072011e-308);
+        // values too small to be represented underflow to zero
+        CHECK(chemfiles::parse<double>("1e-330") == 0.0);
+        CHECK_FALSE(std::signbit(chemfiles::parse<double>("1e-330")));
+        CHECK(chemfiles::parse<double>("-1e-400") == 0.0);
+        CHECK(std::signbit(chemfiles::parse<double>("-1e-400")));
+        CHECK(chemfiles::parse<double>("2.4703282292062327e-324") == 0.0);
+        CHECK(chemfiles::parse<double>("1.0000000000000000000000001e-400") == 0.0);
+
+        // More than 19 significant digits, including exact halfway cases
+        // between two doubles
+        CHECK(chemfiles::parse<double>("123456789012345678901234567890") == 123456789012345678901234567890.0);
+        CHECK(chemfiles::parse<double>("9007199254740993") == 9007199254740992.0);
+        CHECK(chemfiles::parse<double>("9007199254740993.00000000000000000001") == 9007199254740994.0);
+        CHECK(chemfiles::parse<double>("1.00000000000000011102230246251565404236316680908203125") == 1.0);
+        CHECK(chemfiles::parse<double>("1.00000000000000011102230246251565404236316680908203126") == 1.0000000000000002);
+        CHECK(chemfiles::parse<double>("0.0000000000000000000000000000000000000000001") == 1e-43);
+
+        // Round trip of the shortest representation
+        for (auto value: {3.14159265358979, 1.0 / 3.0, 6.02214076e23, 1.602176634e-19, -273.15}) {
+            auto formatted = fmt::format("{}", value);
+            CHECK(chemfiles::parse<double>(formatted) == value);
+        }
 
         CHECK_THROWS_WITH(
             chemfiles::parse<double>(""),
@@ -55,6 +83,10 @@ TEST_CASE("String parsing") {
             chemfiles::parse<double>("3e456782"),
             "3e456782 is out of range for double"
         );
+        CHECK_THROWS_WITH(
+            chemfiles::parse<double>("2e308"),
+            "2e308 is out of range for double"
+        );
         CHECK_THROWS_WITH(
             chemfiles::parse<double>("3.e"),
             "missing exponent in '3.e' to read a double"
@@ -206,6 +238,32 @@ TEST_CASE("scan") {
     );
 }
 
+TEST_CASE("scan_doubles") {
+    auto values = std::vector<double>();
+    chemfiles::scan_doubles("  1.5 -2\t3e2 \n .25", values);
+    CHECK(values == std::vector<double>{1.5, -2.0, 3e2, .25});
+
+    // the vector is cleared before reading
+    chemfiles::scan_doubles("12345678.12345678 1e23", values);
+    CHECK(values == std::vector<double>{12345678.12345678, 1e23});
+
+    chemfiles::scan_doubles("   ", values);
+    CHECK(values.empty());
+
+    CHECK_THROWS_WITH(
+        chemfiles::scan_doubles("1.2 foo 3", values),
+        "error while reading '1.2 foo 3': can not parse 'foo' as a double"
+    );
+    CHECK_THROWS_WITH(
+        chemfiles::scan_doubles("1.2 3.4e", values),
+        "error while reading '1.2 3.4e': missing exponent in '3.4e' to read a double"
+    );
+    CHECK_THROWS_WITH(
+        chemfiles::scan_doubles("1.2 3e500", values),
+        "error while reading '1.2 3e500': 3e500 is out of range for double"
+    );
+}
+
 static void recycle(size_t width, int64_t value, const std::string& hybrid) {
     CHECK(chemfiles::encode_hybrid36(width, value) == hybrid);
     CHECK(chemfiles::decode_hybrid36(width, hybrid) == value);
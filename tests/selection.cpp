@@ -6,6 +6,9 @@
 using namespace chemfiles;
 
 #include <iostream>
+#include <random>
+#include <thread>
+#include <functional>
 
 static Frame testing_frame();
 
@@ -118,6 +121,13 @@ TEST_CASE("Atoms selections") {
         selection = Selection("z >= 10");
         expected = std::vector<size_t>{};
         CHECK(selection.list(frame) == expected);
+
+        // single precision positions
+        frame.set_storage(Frame::SOA_FLOAT);
+        selection = Selection("y != 2");
+        expected = std::vector<size_t>{0, 2, 3};
+        CHECK(selection.list(frame) == expected);
+        CHECK(frame.storage() == Frame::SOA_FLOAT);
     }
 
     SECTION("velocities") {
@@ -487,6 +497,257 @@ TEST_CASE("Multiple selections") {
     }
 }
 
+TEST_CASE("Selection cache") {
+    Selection::clear_cache();
+    auto stats = Selection::cache_stats();
+    CHECK(stats.hits == 0);
+    CHECK(stats.misses == 0);
+    CHECK(stats.size == 0);
+    CHECK(stats.capacity == 128);
+
+    auto frame = testing_frame();
+
+    SECTION("Hits and misses") {
+        auto first = Selection("pairs: name(#1) O and distance(#1, name H) < 2");
+        // the sub-selection is also compiled and cached
+        stats = Selection::cache_stats();
+        CHECK(stats.hits == 0);
+        CHECK(stats.misses == 2);
+        CHECK(stats.size == 2);
+
+        // copying the cached AST does not parse the sub-selection again
+        auto second = Selection("pairs: name(#1) O and distance(#1, name H) < 2");
+        stats = Selection::cache_stats();
+        CHECK(stats.hits == 1);
+        CHECK(stats.misses == 2);
+
+        // both selections give the same results, and do not share cached data
+        auto expected = first.evaluate(frame);
+        CHECK(second.evaluate(frame) == expected);
+        frame.remove(0);
+        CHECK(second.evaluate(frame) != expected);
+        CHECK(second.evaluate(frame) == first.evaluate(frame));
+
+        // errors are not cached
+        CHECK_THROWS_AS(Selection("name O and"), SelectionError);
+        CHECK_THROWS_AS(Selection("name O and"), SelectionError);
+        CHECK(Selection::cache_stats().size == 2);
+    }
+
+    SECTION("Capacity") {
+        Selection::set_cache_capacity(2);
+        auto first = Selection("name O");
+        auto second = Selection("name H");
+        auto third = Selection("name C");
+        stats = Selection::cache_stats();
+        CHECK(stats.size == 2);
+        CHECK(stats.capacity == 2);
+
+        // "name O" was evicted
+        first = Selection("name O");
+        CHECK(Selection::cache_stats().hits == 0);
+        // "name C" is still there
+        third = Selection("name C");
+        CHECK(Selection::cache_stats().hits == 1);
+
+        // disable the cache
+        Selection::set_cache_capacity(0);
+        CHECK(Selection::cache_stats().size == 0);
+        first = Selection("name O");
+        first = Selection("name O");
+        CHECK(Selection::cache_stats().hits == 1);
+        CHECK(Selection::cache_stats().size == 0);
+
+        Selection::set_cache_capacity(128);
+    }
+
+#ifndef __EMSCRIPTEN__
+    SECTION("Multiple threads") {
+        auto selections = std::vector<std::string>{
+            "name O", "name H", "index < 2", "pairs: is_bonded(#1, #2)",
+            "x > 3 or name(#1) H", "distance(#1, name O) < 1.5",
+        };
+
+        auto expected = std::vector<std::vector<Match>>();
+        for (auto& selection: selections) {
+            expected.push_back(Selection(selection).evaluate(frame));
+        }
+
+        auto errors = std::vector<size_t>(4, 0);
+        auto threads = std::vector<std::thread>();
+        for (size_t thread = 0; thread < 4; thread++) {
+            threads.emplace_back([&, thread]() {
+                for (size_t i = 0; i < 100; i++) {
+                    auto index = (i + thread) % selections.size();
+                    if (Selection(selections[index]).evaluate(frame) != expected[index]) {
+                        errors[thread] += 1;
+                    }
+                }
+            });
+        }
+
+        for (auto& thread: threads) {
+            thread.join();
+        }
+        CHECK(errors == std::vector<size_t>(4, 0));
+    }
+#endif
+}
+
+TEST_CASE("Vectorized atoms selections") {
+    auto frame = Frame();
+    frame.add_velocities();
+    auto generator = std::mt19937(42);
+    auto distribution = std::uniform_real_distribution<double>(-10, 10);
+    auto names = std::vector<std::string>{"C", "O", "H", "N"};
+    for (size_t i = 0; i < 100; i++) {
+        frame.add_atom(
+            Atom(names[i % names.size()]),
+            {distribution(generator), distribution(generator), distribution(generator)},
+            {distribution(generator), distribution(generator), distribution(generator)}
+        );
+    }
+
+    auto check_selection = [&](const std::string& string, std::function<bool(size_t)> expected_match) {
+        auto expected = std::vector<size_t>();
+        for (size_t i = 0; i < frame.size(); i++) {
+            if (expected_match(i)) {
+                expected.push_back(i);
+            }
+        }
+        CHECK(Selection(string).list(frame) == expected);
+    };
+
+    auto positions = frame.positions();
+    auto velocities = *frame.velocities();
+    check_selection("mass > 12 and x < 3", [&](size_t i) {
+        return frame[i].mass() > 12 && positions[i][0] < 3;
+    });
+
+    check_selection("not (y >= 2 or vz > 0) or name H", [&](size_t i) {
+        return !(positions[i][1] >= 2 || velocities[i][2] > 0) || frame[i].name() == "H";
+    });
+
+    check_selection("-x + 2 * y^2 % 3 <= sin(z) / 2", [&](size_t i) {
+        return -positions[i][0] + std::fmod(2 * std::pow(positions[i][1], 2), 3) <= std::sin(positions[i][2]) / 2;
+    });
+
+    // mixing vectorized and scalar evaluation
+    check_selection("index % 3 == 1 and distance(#1, index 0) < 10", [&](size_t i) {
+        return i % 3 == 1 && frame.distance(i, 0) < 10;
+    });
+
+    check_selection("none or x > 5", [&](size_t i) {
+        return positions[i][0] > 5;
+    });
+}
+
+TEST_CASE("Distance bounded selections") {
+    // `not distance(...) >= r` is equivalent to `distance(...) < r`, but does
+    // not use the neighbor search, allowing to compare both code paths
+    auto check_selection = [](const Frame& frame, const std::string& bounded, const std::string& dense) {
+        auto expected = Selection(dense).evaluate(frame);
+        CHECK(Selection(bounded).evaluate(frame) == expected);
+        return expected.size();
+    };
+
+    auto frame = Frame(UnitCell({10, 10, 10}, {90, 80, 100}));
+    auto generator = std::mt19937(42);
+    auto distribution = std::uniform_real_distribution<double>(-2, 12);
+    for (size_t i = 0; i < 40; i++) {
+        auto name = i % 3 == 0 ? "O" : "H";
+        frame.add_atom(Atom(name), {distribution(generator), distribution(generator), distribution(generator)});
+    }
+
+    SECTION("Pairs") {
+        auto count = check_selection(frame,
+            "pairs: distance(#1, #2) < 3.5 and name(#1) O",
+            "pairs: not distance(#1, #2) >= 3.5 and name(#1) O"
+        );
+        CHECK(count != 0);
+
+        check_selection(frame, "pairs: 2.5 >= distance(#2, #1)", "pairs: not distance(#1, #2) > 2.5");
+        check_selection(frame,
+            "pairs: distance(#1, #2) < 2 or (distance(#1, #2) < 3 and name(#2) O)",
+            "pairs: not distance(#1, #2) >= 2 or (not distance(#1, #2) >= 3 and name(#2) O)"
+        );
+        check_selection(frame, "pairs: distance(#1, #2) < -1", "pairs: none");
+
+        // partial bounds from `or` can not be used, this falls back to the
+        // evaluation of all pairs
+        check_selection(frame,
+            "pairs: distance(#1, #2) < 2 or name(#2) O",
+            "pairs: not distance(#1, #2) >= 2 or name(#2) O"
+        );
+    }
+
+    SECTION("Three & four") {
+        auto count = check_selection(frame,
+            "three: distance(#1, #2) < 3 and distance(#3, #2) <= 3",
+            "three: not distance(#1, #2) >= 3 and not distance(#3, #2) > 3"
+        );
+        CHECK(count != 0);
+
+        check_selection(frame,
+            "three: distance(#2, #3) < 2 and name(#1) O",
+            "three: not distance(#2, #3) >= 2 and name(#1) O"
+        );
+
+        count = check_selection(frame,
+            "four: distance(#1, #2) < 3 and distance(#1, #3) < 3 and distance(#3, #4) < 2.5",
+            "four: not distance(#1, #2) >= 3 and not distance(#1, #3) >= 3 and not distance(#3, #4) >= 2.5"
+        );
+        CHECK(count != 0);
+    }
+
+    SECTION("Infinite cell") {
+        frame.set_cell(UnitCell());
+        check_selection(frame,
+            "pairs: distance(#1, #2) < 3.5 and name(#1) O",
+            "pairs: not distance(#1, #2) >= 3.5 and name(#1) O"
+        );
+    }
+}
+
+TEST_CASE("Topology only selections") {
+    CHECK(Selection("name O and mass < 3 or resname ALA").topology_only());
+    CHECK(Selection("bonds: is_bonded(#1, name O) and [bool](#2)").topology_only());
+    CHECK(Selection("index % 3 == 1 and sin([numeric]) > 0").topology_only());
+    CHECK_FALSE(Selection("name O and x < 3").topology_only());
+    CHECK_FALSE(Selection("pairs: distance(#1, #2) < 3").topology_only());
+    CHECK_FALSE(Selection("is_bonded(#1, x > 2)").topology_only());
+    CHECK_FALSE(Selection("angle(#1, name O, name H) > 90").topology_only());
+
+    auto frame = testing_frame();
+    auto selection = Selection("name O or is_bonded(#1, name O)");
+    REQUIRE(selection.topology_only());
+    auto expected = std::vector<size_t>{0, 1, 2, 3};
+    CHECK(selection.list(frame) == expected);
+
+    // changing positions does not change the matches
+    frame.positions()[0] = Vector3D(10, 10, 10);
+    CHECK(selection.list(frame) == expected);
+
+    // a copy of the frame shares the same cached matches
+    auto copy = frame.clone();
+    CHECK(copy.topology().version() == frame.topology().version());
+    CHECK(selection.list(copy) == expected);
+
+    // modifying the topology invalidates the cached matches
+    frame.remove_bond(0, 1);
+    expected = {1, 2, 3};
+    CHECK(selection.list(frame) == expected);
+    CHECK(selection.list(copy) == std::vector<size_t>{0, 1, 2, 3});
+
+    frame[2].set_name("N");
+    expected = {1, 2};
+    CHECK(selection.list(frame) == expected);
+
+    frame.remove(0);
+    expected = {0, 1};
+    CHECK(selection.list(frame) == expected);
+}
+
 Frame testing_frame() {
     auto frame = Frame();
     frame.add_atom(Atom("H1", "H"), {0.0, 1.0, 2.0});
@@ -1,6 +1,11 @@
 // Chemfiles, a modern library for chemistry file reading and writing
 // Copyright (C) Guillaume Fraux and contributors -- BSD license
 
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
 #include <catch.hpp>
 #include "chemfiles.hpp"
 using namespace chemfiles;
@@ -183,6 +188,171 @@ TEST_CASE("Connectivity detection") {
         impropers.push_back({12, 19, 16, 18});
         CHECK(topology.impropers() == impropers);
     }
+
+    SECTION("Adjacency graph") {
+        auto topology = Topology();
+        for (size_t i=0; i<10; i++) {
+            topology.add_atom(Atom());
+        }
+
+        CHECK(topology.adjacency().size() == 0);
+        CHECK(topology.adjacency().neighbors(3).size() == 0);
+
+        topology.add_bond(3, 1);
+        topology.add_bond(3, 7);
+        topology.add_bond(3, 5);
+        topology.add_bond(0, 7);
+
+        const auto& graph = topology.adjacency();
+        CHECK(graph.size() == 8);
+        CHECK(graph.neighbors(2).size() == 0);
+        CHECK(graph.neighbors(8).size() == 0);
+
+        auto neighbors = std::vector<size_t>(graph.neighbors(3).begin(), graph.neighbors(3).end());
+        CHECK(neighbors == std::vector<size_t>{1, 5, 7});
+        neighbors = std::vector<size_t>(graph.neighbors(7).begin(), graph.neighbors(7).end());
+        CHECK(neighbors == std::vector<size_t>{0, 3});
+
+        topology.remove_bond(3, 5);
+        neighbors = std::vector<size_t>(topology.adjacency().neighbors(3).begin(), topology.adjacency().neighbors(3).end());
+        CHECK(neighbors == std::vector<size_t>{1, 7});
+        CHECK(topology.adjacency().neighbors(5).size() == 0);
+    }
+
+    SECTION("Molecules") {
+        auto topology = Topology();
+        CHECK(topology.molecules().size() == 0);
+
+        for (size_t i=0; i<8; i++) {
+            topology.add_atom(Atom());
+        }
+
+        // all atoms are separated molecules
+        CHECK(topology.molecules().size() == 8);
+        CHECK(topology.molecules().molecule_for_atom(5) == 5);
+
+        topology.add_bond(6, 1);
+        topology.add_bond(3, 5);
+        topology.add_bond(1, 3);
+        topology.add_bond(4, 2);
+
+        const auto& molecules = topology.molecules();
+        CHECK(molecules.size() == 4);
+        auto molecule_ids = std::vector<size_t>();
+        for (size_t i=0; i<8; i++) {
+            molecule_ids.push_back(molecules.molecule_for_atom(i));
+        }
+        CHECK(molecule_ids == std::vector<size_t>{0, 1, 2, 1, 2, 1, 1, 3});
+
+        auto atoms = std::vector<size_t>(molecules.atoms(1).begin(), molecules.atoms(1).end());
+        CHECK(atoms == std::vector<size_t>{1, 3, 5, 6});
+        atoms = std::vector<size_t>(molecules.atoms(3).begin(), molecules.atoms(3).end());
+        CHECK(atoms == std::vector<size_t>{7});
+
+        CHECK_THROWS_WITH(molecules.molecule_for_atom(8),
+            "out of bounds atomic index in `Molecules::molecule_for_atom`: we have 8 atoms, but the index is 8"
+        );
+        CHECK_THROWS_WITH(molecules.atoms(4),
+            "out of bounds molecule index in `Molecules::atoms`: we have 4 molecules, but the index is 4"
+        );
+
+        // molecules are updated with the atoms and the bonds
+        topology.add_atom(Atom());
+        CHECK(topology.molecules().size() == 5);
+        CHECK(topology.molecules().molecule_for_atom(8) == 4);
+
+        topology.remove_bond(1, 3);
+        CHECK(topology.molecules().size() == 6);
+        CHECK(topology.molecules().molecule_for_atom(5) == 3);
+
+        auto removed = std::vector<size_t>{0, 1};
+        topology.remove(removed);
+        CHECK(topology.molecules().size() == 5);
+        CHECK(topology.molecules().molecule_for_atom(0) == 0);
+        CHECK(topology.molecules().molecule_for_atom(4) == 2);
+
+        // residues in the same molecule are not necessarily linked
+        topology = Topology();
+        topology.resize(6);
+        topology.add_bond(0, 1);
+        topology.add_bond(1, 2);
+        topology.add_bond(2, 3);
+
+        auto first = Residue("A");
+        first.add_atom(0);
+        auto second = Residue("B");
+        second.add_atom(1);
+        second.add_atom(2);
+        auto third = Residue("C");
+        third.add_atom(3);
+        auto fourth = Residue("D");
+        fourth.add_atom(4);
+        fourth.add_atom(5);
+
+        CHECK(topology.are_linked(first, second));
+        CHECK(topology.are_linked(third, second));
+        CHECK_FALSE(topology.are_linked(first, third));
+        CHECK_FALSE(topology.are_linked(first, fourth));
+        CHECK_FALSE(topology.are_linked(first, Residue("E")));
+    }
+
+    SECTION("Independent computations") {
+        auto topology = Topology();
+        for (size_t i=0; i<5; i++) {
+            topology.add_atom(Atom());
+        }
+        topology.add_bond(0, 1);
+        topology.add_bond(1, 2);
+        topology.add_bond(2, 3);
+        topology.add_bond(1, 4);
+
+        // getting one kind of angles does not require the others
+        CHECK(topology.impropers() == std::vector<Improper>{{0, 1, 2, 4}});
+        CHECK(topology.dihedrals() == std::vector<Dihedral>{{0, 1, 2, 3}, {3, 2, 1, 4}});
+
+        topology.add_bond(3, 4);
+        CHECK(topology.dihedrals().size() == 6);
+        CHECK(topology.angles() == std::vector<Angle>{
+            {0, 1, 2}, {0, 1, 4}, {1, 2, 3}, {1, 4, 3}, {2, 1, 4}, {2, 3, 4},
+        });
+        CHECK(topology.impropers() == std::vector<Improper>{{0, 1, 2, 4}});
+    }
+
+    SECTION("Large systems") {
+        // a long chain, with an additional atom bonded to one atom every
+        // hundred atoms. This is large enough to use multiple threads.
+        const size_t natoms = 60000;
+        const size_t branches = 599;
+        auto topology = Topology();
+        topology.resize(natoms + branches);
+
+        auto bonds = std::vector<Bond>();
+        for (size_t i=0; i<natoms - 1; i++) {
+            bonds.emplace_back(i, i + 1);
+        }
+        for (size_t i=1; i<=branches; i++) {
+            bonds.emplace_back(100 * i, natoms + i - 1);
+        }
+        topology.add_bonds(bonds);
+
+        const auto& angles = topology.angles();
+        CHECK(angles.size() == natoms - 2 + 2 * branches);
+        CHECK(std::adjacent_find(angles.begin(), angles.end(), std::greater_equal<Angle>()) == angles.end());
+        CHECK(std::binary_search(angles.begin(), angles.end(), Angle(99, 100, natoms)));
+        CHECK(std::binary_search(angles.begin(), angles.end(), Angle(101, 100, natoms)));
+        CHECK(std::binary_search(angles.begin(), angles.end(), Angle(42, 43, 44)));
+
+        const auto& dihedrals = topology.dihedrals();
+        CHECK(dihedrals.size() == natoms - 3 + 2 * branches);
+        CHECK(std::adjacent_find(dihedrals.begin(), dihedrals.end(), std::greater_equal<Dihedral>()) == dihedrals.end());
+        CHECK(std::binary_search(dihedrals.begin(), dihedrals.end(), Dihedral(98, 99, 100, natoms)));
+        CHECK(std::binary_search(dihedrals.begin(), dihedrals.end(), Dihedral(natoms + 598, 59900, 59901, 59902)));
+
+        const auto& impropers = topology.impropers();
+        CHECK(impropers.size() == branches);
+        CHECK(std::adjacent_find(impropers.begin(), impropers.end(), std::greater_equal<Improper>()) == impropers.end());
+        CHECK(impropers[0] == Improper(99, 100, 101, natoms));
+    }
 }
 
 TEST_CASE("Out of bounds errors") {
@@ -267,6 +437,47 @@ TEST_CASE("Add and remove items in the topology") {
         topology.resize(5);
     }
 
+    SECTION("Multiple bonds") {
+        auto topology = Topology();
+        for (unsigned i=0; i<6; i++) {
+            topology.add_atom(Atom("H"));
+        }
+        topology.add_bond(1, 4, Bond::DOUBLE);
+
+        auto bonds = std::vector<Bond>{{5, 2}, {0, 4}, {4, 1}, {3, 5}, {0, 4}};
+        auto orders = std::vector<Bond::BondOrder>{
+            Bond::TRIPLE, Bond::SINGLE, Bond::SINGLE, Bond::UNKNOWN, Bond::AROMATIC
+        };
+        topology.add_bonds(bonds, orders);
+
+        CHECK(topology.bonds() == (std::vector<Bond>{{0, 4}, {1, 4}, {2, 5}, {3, 5}}));
+        // existing bonds and the first duplicated bond keep their bond order
+        CHECK(topology.bond_orders() == (std::vector<Bond::BondOrder>{
+            Bond::SINGLE, Bond::DOUBLE, Bond::TRIPLE, Bond::UNKNOWN
+        }));
+        CHECK(topology.angles() == (std::vector<Angle>{{0, 4, 1}, {2, 5, 3}}));
+
+        auto more_bonds = std::vector<Bond>{{0, 1}};
+        topology.add_bonds(more_bonds);
+        CHECK(topology.bonds().size() == 5);
+        CHECK(topology.bond_order(0, 1) == Bond::UNKNOWN);
+
+        auto version = topology.version();
+        auto invalid_bonds = std::vector<Bond>{{0, 2}, {3, 6}};
+        CHECK_THROWS_WITH(
+            topology.add_bonds(invalid_bonds),
+            "out of bounds atomic index in `Topology::add_bonds`: we have 6 atoms, "
+            "but the bond indexes are 3 and 6"
+        );
+        auto invalid_orders = std::vector<Bond::BondOrder>{Bond::SINGLE};
+        CHECK_THROWS_WITH(
+            topology.add_bonds(bonds, invalid_orders),
+            "mismatched sizes in `Topology::add_bonds`: got 5 bonds but 1 bond orders"
+        );
+        CHECK(topology.bonds().size() == 5);
+        CHECK(topology.version() == version);
+    }
+
     SECTION("Bonds and atoms") {
         auto topology = Topology();
         for (unsigned i=0; i<4; i++) {
@@ -283,6 +494,41 @@ TEST_CASE("Add and remove items in the topology") {
         CHECK(topology.bonds() == (std::vector<Bond>{{1, 2}}));
         CHECK(topology.bond_orders()[0] == Bond::DOUBLE);
     }
+
+    SECTION("Remove multiple atoms") {
+        auto topology = Topology();
+        for (unsigned i=0; i<6; i++) {
+            topology.add_atom(Atom(std::to_string(i)));
+        }
+        topology.add_bond(0, 1, Bond::SINGLE);
+        topology.add_bond(1, 2, Bond::DOUBLE);
+        topology.add_bond(3, 5, Bond::TRIPLE);
+        topology.add_bond(4, 5, Bond::AROMATIC);
+        CHECK(topology.angles().size() == 2);
+
+        auto indexes = std::vector<size_t>{4, 0, 4};
+        topology.remove(indexes);
+        CHECK(topology.size() == 4);
+        CHECK(topology[0].name() == "1");
+        CHECK(topology[3].name() == "5");
+        CHECK(topology.bonds() == (std::vector<Bond>{{0, 1}, {2, 3}}));
+        CHECK(topology.bond_orders() == (std::vector<Bond::BondOrder>{Bond::DOUBLE, Bond::TRIPLE}));
+        CHECK(topology.angles().empty());
+
+        auto version = topology.version();
+        auto invalid = std::vector<size_t>{1, 4};
+        CHECK_THROWS_WITH(topology.remove(invalid),
+            "out of bounds atomic index in `Topology::remove`: we have 4 atoms, "
+            "but the index is 4"
+        );
+        CHECK(topology.size() == 4);
+        CHECK(topology.version() == version);
+
+        // removing no atoms is not a modification
+        auto empty = std::vector<size_t>();
+        topology.remove(empty);
+        CHECK(topology.version() == version);
+    }
 }
 
 TEST_CASE("Residues in topologies") {
@@ -330,4 +576,162 @@ TEST_CASE("Residues in topologies") {
     CHECK(all_residues[1].contains(8));
     CHECK(!all_residues[1].contains(9));
     CHECK(all_residues[2].size() == 2); // Totally removed
+
+    // the atoms to residue mapping is updated
+    REQUIRE(topology.residue_for_atom(8));
+    CHECK(topology.residue_for_atom(8)->contains(8));
+    CHECK(topology.residue_for_atom(6)->contains(6));
+    CHECK_FALSE(topology.residue_for_atom(9));
+
+    // Remove multiple atoms at once
+    auto indexes = std::vector<size_t>{8, 0, 3};
+    topology.remove(indexes);
+    CHECK(topology.size() == 6);
+    CHECK(topology.residues()[0].size() == 2);
+    CHECK(topology.residues()[0].contains(1));
+    CHECK(topology.residues()[0].contains(4));
+    CHECK(topology.residues()[1].size() == 1);
+    CHECK(topology.residues()[1].contains(0));
+    CHECK(topology.residues()[2].size() == 2);
+    CHECK(topology.residues()[2].contains(2));
+    CHECK(topology.residues()[2].contains(3));
+    CHECK(topology.bonds().empty());
+    CHECK(topology.residue_for_atom(4)->contains(4));
+    CHECK_FALSE(topology.residue_for_atom(5));
+}
+
+TEST_CASE("Topology version") {
+    auto topology = Topology();
+    topology.resize(4);
+    auto version = topology.version();
+
+    auto check_modified = [&]() {
+        CHECK(topology.version() != version);
+        version = topology.version();
+    };
+
+    // const access does not change the version
+    const auto& const_topology = topology;
+    CHECK(const_topology[0].name() == "");
+    CHECK(const_topology.bonds().empty());
+    CHECK(topology.version() == version);
+
+    topology.add_atom(Atom("H"));
+    check_modified();
+    topology.add_bond(0, 1);
+    check_modified();
+    topology.remove_bond(0, 1);
+    check_modified();
+    topology.clear_bonds();
+    check_modified();
+    topology.remove(2);
+    check_modified();
+    topology.resize(6);
+    check_modified();
+    // resizing to the same size is not a modification
+    topology.resize(6);
+    CHECK(topology.version() == version);
+    auto residue = Residue("X");
+    residue.add_atom(0);
+    topology.add_residue(residue);
+    check_modified();
+    topology[1].set_name("O");
+    check_modified();
+
+    // copies have the same version
+    auto copy = topology;
+    CHECK(copy.version() == topology.version());
+    copy.add_atom(Atom("C"));
+    CHECK(copy.version() != topology.version());
+    CHECK(topology.version() == version);
+
+    // moving keeps the version, but changes the one of the moved-from topology
+    auto moved = std::move(topology);
+    CHECK(moved.version() == version);
+    CHECK(topology.version() != version);
+}
+
+TEST_CASE("Copies of topologies") {
+    auto topology = Topology();
+    topology.add_atom(Atom("H"));
+    topology.add_atom(Atom("O"));
+    topology.add_atom(Atom("H"));
+    topology.add_bond(0, 1);
+    topology.add_bond(1, 2);
+
+    SECTION("Modifying copies") {
+        auto copy = topology;
+        CHECK(&copy.bonds() == &topology.bonds());
+
+        copy.add_atom(Atom("Zn"));
+        copy.add_bond(2, 3);
+        CHECK(copy.size() == 4);
+        CHECK(copy.bonds().size() == 3);
+        CHECK(topology.size() == 3);
+        CHECK(topology.bonds().size() == 2);
+
+        copy = topology;
+        topology.remove(0);
+        CHECK(copy.size() == 3);
+        CHECK(copy.bonds() == std::vector<Bond>{{0, 1}, {1, 2}});
+        CHECK(topology.size() == 2);
+        CHECK(topology.bonds() == std::vector<Bond>{{0, 1}});
+
+        copy = topology;
+        copy[0].set_name("Cl");
+        CHECK(copy[0].name() == "Cl");
+        CHECK(topology[0].name() == "O");
+    }
+
+    SECTION("Mutable references") {
+        auto& atom = topology[0];
+        auto copy = topology;
+        CHECK(&copy.bonds() != &topology.bonds());
+
+        atom.set_name("Cl");
+        CHECK(topology[0].name() == "Cl");
+        CHECK(copy[0].name() == "H");
+
+        // the same applies to iterators
+        auto other = Topology();
+        other.add_atom(Atom("C"));
+        auto it = other.begin();
+        copy = other;
+        it->set_name("N");
+        CHECK(other[0].name() == "N");
+        CHECK(copy[0].name() == "C");
+    }
+
+    SECTION("Copies in other threads") {
+        auto sizes = std::vector<size_t>(4, 0);
+        auto threads = std::vector<std::thread>();
+        for (size_t i = 0; i < sizes.size(); i++) {
+            threads.emplace_back([copy = topology, &sizes, i]() mutable {
+                for (size_t j = 0; j < i; j++) {
+                    copy.add_atom(Atom("Zn"));
+                }
+                sizes[i] = copy.size();
+            });
+        }
+        // the copies are destroyed at different times, but the original
+        // topology still makes a private copy before being modified
+        topology.add_atom(Atom("Cl"));
+        for (auto& thread: threads) {
+            thread.join();
+        }
+
+        CHECK(sizes == std::vector<size_t>{3, 4, 5, 6});
+        CHECK(topology.size() == 4);
+        CHECK(topology[3].name() == "Cl");
+    }
+
+    SECTION("Angles") {
+        auto copy = topology;
+        CHECK(copy.angles() == std::vector<Angle>{{0, 1, 2}});
+        CHECK(topology.angles() == std::vector<Angle>{{0, 1, 2}});
+
+        copy.remove_bond(1, 2);
+        CHECK(copy.angles().empty());
+        CHECK(topology.angles() == std::vector<Angle>{{0, 1, 2}});
+    }
 }
@@ -1,6 +1,8 @@
 // Chemfiles, a modern library for chemistry file reading and writing
 // Copyright (C) Guillaume Fraux and contributors -- BSD license
 
+#include <cstdio>
+#include <cstddef>
 #include <fstream>
 #include <thread>
 
@@ -8,6 +10,8 @@
 
 #include "helpers.hpp"
 #include "chemfiles.hpp"
+#include "chemfiles/File.hpp"
+#include "chemfiles/files/GzFile.hpp"
 using namespace chemfiles;
 
 // This file only perform basic testing of the trajectory class. All the
@@ -181,6 +185,19 @@ TEST_CASE("Specify a format parameter") {
     frame = Trajectory(tmpfile, 'r', "XYZ /GZ").read();
     CHECK(frame.size() == 1);
     CHECK(frame[0].name() == "Fe");
+
+    // Parallel gzip compression
+    file = Trajectory(tmpfile, 'w', "XYZ / PGZ");
+    frame.add_atom(Atom("Zn"), {3, 4, 5});
+    file.write(frame);
+    file.write(frame);
+    file.close();
+
+    file = Trajectory(tmpfile, 'r', "XYZ / GZ");
+    CHECK(file.nsteps() == 2);
+    frame = file.read_step(1);
+    CHECK(frame.size() == 2);
+    CHECK(frame[1].name() == "Zn");
 }
 
 TEST_CASE("Guessing format") {
@@ -266,8 +283,369 @@ TEST_CASE("reading a files from multiple threads") {
     read_from_multiple_threads("data/netcdf/water.nc", 297);
 }
 
+static void check_read_ahead(const std::string& extension) {
+    auto tmpfile = NamedTempPath(extension);
+    {
+        auto file = Trajectory(tmpfile, 'w');
+        for (size_t step = 0; step < 25; step++) {
+            auto frame = Frame(UnitCell({20, 20, 20}));
+            for (size_t i = 0; i < 30; i++) {
+                auto x = static_cast<double>(i + step);
+                frame.add_atom(Atom("X"), {x, 2 * x, 0.5 * x});
+            }
+            file.write(frame);
+        }
+    }
+
+    auto expected = std::vector<Frame>();
+    auto file = Trajectory(tmpfile);
+    while (!file.done()) {
+        expected.emplace_back(file.read());
+    }
+
+    auto check_frame = [&](const Frame& frame, size_t step) {
+        CHECK(frame.step() == expected[step].step());
+        CHECK(frame.size() == expected[step].size());
+        for (size_t i = 0; i < frame.size(); i++) {
+            CHECK(frame.positions()[i] == expected[step].positions()[i]);
+        }
+    };
+
+    for (size_t frames: {1u, 3u, 8u, 40u}) {
+        for (size_t threads: {0u, 1u, 4u}) {
+            file = Trajectory(tmpfile);
+            file.set_read_ahead(frames, threads);
+            size_t step = 0;
+            while (!file.done()) {
+                check_frame(file.read(), step);
+                step++;
+            }
+            CHECK(step == expected.size());
+        }
+    }
+
+    // reading into an existing frame, which memory is reused for later steps
+    file = Trajectory(tmpfile);
+    file.set_read_ahead(3, 2);
+    auto reused = Frame();
+    for (size_t step = 0; step < expected.size(); step++) {
+        reused.set("name", "old content");
+        file.read(reused);
+        check_frame(reused, step);
+        CHECK_FALSE(reused.get("name"));
+    }
+
+    // reading out of order
+    file = Trajectory(tmpfile);
+    file.set_read_ahead(4);
+    check_frame(file.read(), 0);
+    check_frame(file.read_step(17), 17);
+    check_frame(file.read(), 17);
+    check_frame(file.read(), 18);
+
+    // topology and cell set on the trajectory are still used
+    auto topology = Topology();
+    topology.resize(30);
+    topology.add_bond(0, 1);
+    file.set_topology(topology);
+    file.set_cell(UnitCell({10, 10, 10}));
+    auto frame = file.read();
+    check_frame(frame, 19);
+    CHECK(frame.topology().bonds().size() == 1);
+    CHECK(frame.cell() == UnitCell({10, 10, 10}));
+
+    // disabling read ahead
+    file.set_read_ahead(0);
+    check_frame(file.read(), 20);
+
+    // closing a trajectory reading ahead of time
+    file.set_read_ahead(10);
+    check_frame(file.read(), 21);
+    file.close();
+}
+
+TEST_CASE("Read frames ahead of time") {
+    check_read_ahead(".xtc");
+    check_read_ahead(".trr");
+    check_read_ahead(".dcd");
+
+    SECTION("Errors") {
+        auto tmpfile = NamedTempPath(".xyz");
+        auto file = Trajectory(tmpfile, 'w');
+        file.write(Frame());
+        CHECK_THROWS_AS(file.set_read_ahead(3), FileError);
+        file.close();
+
+        file = Trajectory(tmpfile, 'r');
+        CHECK_THROWS_AS(file.set_read_ahead(3), FormatError);
+        // disabling read ahead is always possible
+        file.set_read_ahead(0);
+    }
+}
+
+TEST_CASE("Write with multiple threads") {
+    auto frame = Frame();
+    for (size_t i = 0; i < 3 * TextFile::PRINT_CHUNK_SIZE + 17; i++) {
+        auto x = static_cast<double>(i);
+        frame.add_atom(Atom("X"), {x, 2 * x, 0.5 * x});
+    }
+
+    auto expected_path = NamedTempPath(".xyz");
+    Trajectory(expected_path, 'w').write(frame);
+    auto expected = read_text_file(expected_path);
+
+    auto tmpfile = NamedTempPath(".xyz.gz");
+    {
+        auto file = Trajectory(tmpfile, 'w', "XYZ / PGZ");
+        file.set_write_threads(3);
+        file.write(frame);
+        file.write(frame);
+    }
+
+    auto file = Trajectory(tmpfile);
+    CHECK(file.nsteps() == 2);
+    CHECK(file.read_step(1).positions() == frame.positions());
+    file.close();
+
+    auto content = read_binary_file(tmpfile);
+    auto decompressed = decompress_gz(reinterpret_cast<const char*>(content.data()), content.size());
+    CHECK(std::string(decompressed.data(), decompressed.size()) == expected + expected);
+
+    file = Trajectory(tmpfile);
+    CHECK_THROWS_AS(file.set_write_threads(2), FileError);
+}
+
 #endif
 
+TEST_CASE("Read positions of multiple steps") {
+    auto tmpfile = NamedTempPath(".xyz");
+    {
+        auto file = Trajectory(tmpfile, 'w');
+        for (size_t step = 0; step < 10; step++) {
+            auto frame = Frame();
+            for (size_t i = 0; i <= step; i++) {
+                frame.add_atom(Atom("X"), {static_cast<double>(step), static_cast<double>(i), 0});
+            }
+            file.write(frame);
+        }
+    }
+
+    auto file = Trajectory(tmpfile);
+    file.read();
+    file.read();
+
+    auto positions = std::vector<std::vector<Vector3D>>(5);
+    file.read_positions(3, positions);
+    for (size_t i = 0; i < positions.size(); i++) {
+        auto step = 3 + i;
+        REQUIRE(positions[i].size() == step + 1);
+        CHECK(positions[i][step] == Vector3D(static_cast<double>(step), static_cast<double>(step), 0));
+    }
+
+    // this does not change the next step to read
+    auto frame = file.read();
+    CHECK(frame.step() == 2);
+    CHECK(frame.size() == 3);
+    CHECK(frame.positions()[0] == Vector3D(2, 0, 0));
+
+    // reading past the end
+    CHECK_THROWS_AS(file.read_positions(8, positions), FileError);
+    positions.clear();
+    file.read_positions(12, positions);
+}
+
+static void check_frame_index_files(const std::string& extension, const std::string& format) {
+    auto tmpfile = NamedTempPath(extension);
+    auto index = tmpfile.path() + ".chfl-idx";
+    auto write_frames = [&](char mode, size_t count) {
+        auto file = Trajectory(tmpfile, mode);
+        for (size_t step = 0; step < count; step++) {
+            auto frame = Frame(UnitCell({20, 20, 20}));
+            for (size_t i = 0; i < 12; i++) {
+                auto x = static_cast<double>(i + step);
+                frame.add_atom(Atom("X"), {x, 2 * x, 0.5 * x});
+            }
+            file.write(frame);
+        }
+    };
+    write_frames('w', 10);
+
+    auto file = Trajectory(tmpfile);
+    CHECK(file.nsteps() == 10);
+    auto frame = file.read_step(7);
+    file.close();
+    REQUIRE(std::ifstream(index).good());
+    auto content = read_binary_file(index);
+    // the index is keyed on the registered name of the format, stored after
+    // the magic bytes, the trajectory fingerprint and the name length
+    REQUIRE(content.size() > 40 + format.size());
+    CHECK(content[32] == format.size());
+    CHECK(std::string(content.begin() + 40, content.begin() + 40 + static_cast<std::ptrdiff_t>(format.size())) == format);
+
+    // the index is used when opening the file again
+    file = Trajectory(tmpfile);
+    CHECK(file.nsteps() == 10);
+    CHECK(file.read_step(7).positions()[3] == frame.positions()[3]);
+    file.close();
+    CHECK(read_binary_file(index) == content);
+
+    // corrupted index files are ignored and re-created
+    auto corrupted = content;
+    corrupted[corrupted.size() - 12] ^= 0xff;
+    std::ofstream(index, std::ios::binary).write(
+        reinterpret_cast<const char*>(corrupted.data()), static_cast<std::streamsize>(corrupted.size())
+    );
+    file = Trajectory(tmpfile);
+    CHECK(file.nsteps() == 10);
+    CHECK(file.read_step(7).positions()[3] == frame.positions()[3]);
+    file.close();
+    CHECK(read_binary_file(index) == content);
+
+    // index files for a different version of the trajectory are ignored
+    write_frames('a', 5);
+    file = Trajectory(tmpfile);
+    CHECK(file.nsteps() == 15);
+    file.close();
+    CHECK(read_binary_file(index) != content);
+
+    std::remove(index.c_str());
+}
+
+TEST_CASE("Read in an existing frame") {
+    SECTION("Format with topology") {
+        auto tmpfile = NamedTempPath(".xyz");
+        {
+            auto file = Trajectory(tmpfile, 'w');
+            for (size_t step = 0; step < 3; step++) {
+                auto frame = Frame();
+                for (size_t i = 0; i < 4; i++) {
+                    frame.add_atom(Atom("C"), {static_cast<double>(step), static_cast<double>(i), 0});
+                }
+                file.write(frame);
+            }
+        }
+
+        auto file = Trajectory(tmpfile);
+        auto frame = Frame(UnitCell({10, 10, 10}));
+        frame.add_velocities();
+        frame.add_atom(Atom("O"), {1, 2, 3});
+        frame.set("foo", "bar");
+
+        file.read(frame);
+        CHECK(frame.size() == 4);
+        CHECK(frame[0].name() == "C");
+        CHECK(frame.positions()[3] == Vector3D(0, 3, 0));
+        CHECK(frame.step() == 0);
+        CHECK_FALSE(frame.velocities());
+        CHECK_FALSE(frame.get("foo"));
+        CHECK(frame.cell().shape() == UnitCell::INFINITE);
+
+        // the memory for positions is reused
+        const auto* data = frame.positions().data();
+        file.read(frame);
+        CHECK(frame.positions().data() == data);
+        CHECK(frame.size() == 4);
+        CHECK(frame.positions()[3] == Vector3D(1, 3, 0));
+        CHECK(frame.step() == 1);
+
+        file.read_step(0, frame);
+        CHECK(frame.positions()[3] == Vector3D(0, 3, 0));
+        CHECK(frame.step() == 0);
+    }
+
+    SECTION("Format without topology") {
+        auto tmpfile = NamedTempPath(".xtc");
+        {
+            auto file = Trajectory(tmpfile, 'w');
+            for (size_t step = 0; step < 3; step++) {
+                auto frame = Frame();
+                for (size_t i = 0; i < 4; i++) {
+                    frame.add_atom(Atom("C"), {static_cast<double>(step), static_cast<double>(i), 0});
+                }
+                file.write(frame);
+            }
+        }
+
+        auto topology = Topology();
+        for (size_t i = 0; i < 4; i++) {
+            topology.add_atom(Atom("Fe"));
+        }
+        topology.add_bond(0, 1);
+
+        auto file = Trajectory(tmpfile);
+        file.set_topology(topology);
+
+        auto frame = Frame();
+        file.read(frame);
+        CHECK(frame.topology()[0].name() == "Fe");
+        CHECK(frame.topology().bonds().size() == 1);
+        CHECK(approx_eq(frame.positions()[3], Vector3D(0, 3, 0), 1e-6));
+
+        // the topology is kept between steps
+        auto version = frame.topology().version();
+        file.read(frame);
+        CHECK(frame.topology().version() == version);
+        CHECK(frame.topology()[0].name() == "Fe");
+        CHECK(approx_eq(frame.positions()[3], Vector3D(1, 3, 0), 1e-6));
+
+        // a modified topology is replaced by the custom one
+        frame[0].set_name("Zn");
+        file.read_step(0, frame);
+        CHECK(frame.topology()[0].name() == "Fe");
+        CHECK(frame.topology().version() == version);
+        CHECK(approx_eq(frame.positions()[3], Vector3D(0, 3, 0), 1e-6));
+    }
+}
+
+TEST_CASE("Share topologies between steps") {
+    auto tmpfile = NamedTempPath(".xyz");
+    {
+        auto file = Trajectory(tmpfile, 'w');
+        for (auto name: {"C", "C", "N"}) {
+            auto frame = Frame();
+            for (size_t i = 0; i < 4; i++) {
+                frame.add_atom(Atom(name), {0, static_cast<double>(i), 0});
+            }
+            file.write(frame);
+        }
+    }
+
+    auto file = Trajectory(tmpfile);
+    auto first = file.read();
+    auto second = file.read();
+    auto third = file.read();
+
+    // identical topologies share the same data and version
+    CHECK(first.topology().version() == second.topology().version());
+    CHECK(&first.topology().bonds() == &second.topology().bonds());
+    CHECK(third.topology().version() != second.topology().version());
+    CHECK(third[0].name() == "N");
+
+    // modifying one of the frames does not change the others
+    second[0].set_name("O");
+    CHECK(first[0].name() == "C");
+    CHECK(second[0].name() == "O");
+
+    // reading again does not use the modified topology
+    auto again = file.read_step(1);
+    CHECK(again[0].name() == "C");
+}
+
+TEST_CASE("Frame index files") {
+    set_frame_index_files(true);
+    check_frame_index_files(".xtc", "XTC");
+    check_frame_index_files(".trr", "TRR");
+    check_frame_index_files(".xyz", "XYZ");
+    check_frame_index_files(".gro", "GRO");
+    check_frame_index_files(".pdb", "PDB");
+    set_frame_index_files(false);
+
+    auto tmpfile = NamedTempPath(".xyz");
+    Trajectory(tmpfile, 'w').write(Frame());
+    CHECK(Trajectory(tmpfile).nsteps() == 1);
+    CHECK_FALSE(std::ifstream(tmpfile.path() + ".chfl-idx").good());
+}
+
 TEST_CASE("Errors") {
     SECTION("Unknow opening mode") {
         CHECK_THROWS_AS(Trajectory("trajectory.xyz", 'z'), FileError);
@@ -1,7 +1,18 @@
 // Chemfiles, a modern library for chemistry file reading and writing
 // Copyright (C) Guillaume Fraux and contributors -- BSD license
+
+#include <limits>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
 #include <catch.hpp>
+#include <fmt/format.h>
+#include <fmt/compile.h>
+
 #include "chemfiles/utils.hpp"
+#include "chemfiles/float_formatting.hpp"
+#include "chemfiles/ThreadPool.hpp"
 #include "chemfiles/Error.hpp"
 
 TEST_CASE("ASCII utils") {
@@ -129,3 +140,101 @@ TEST_CASE("split") {
     expected = std::vector<std::string_view>{"bla  bla", " jk:fiuks"};
     CHECK(chemfiles::split(",,bla  bla, jk:fiuks", ',') == expected);
 }
+
+TEST_CASE("Float formatting") {
+    auto values = std::vector<double>{
+        0.0, -0.0, 1.0, -1.0, 0.5, 0.125, 2.5, 3.14159265358979, -42.4242,
+        1e-4, 9.9999e-5, 0.00012345678, 999999.4, 999999.5, 1e6, 123456.789,
+        1.0005, 0.0015, 2.675, 1e15, 1e300, 5e-324, 1e-30,
+        std::numeric_limits<double>::infinity(),
+        std::numeric_limits<double>::quiet_NaN(),
+    };
+
+    SECTION("format_fixed") {
+        char buffer[32];
+        for (auto value: values) {
+            for (unsigned precision = 0; precision <= chemfiles::detail::MAX_FIXED_PRECISION; precision++) {
+                auto size = chemfiles::detail::format_fixed(value, precision, buffer);
+                if (size != 0) {
+                    CHECK(std::string(buffer, size) == fmt::format("{:.{}f}", value, precision));
+                }
+            }
+        }
+
+        CHECK(chemfiles::detail::format_fixed(1.5, 3, buffer) == 5);
+        CHECK(chemfiles::detail::format_fixed(1e300, 3, buffer) == 0);
+        CHECK(chemfiles::detail::format_fixed(std::numeric_limits<double>::infinity(), 3, buffer) == 0);
+    }
+
+    SECTION("format_general") {
+        char buffer[32];
+        for (auto value: values) {
+            auto size = chemfiles::detail::format_general(value, buffer);
+            if (size != 0) {
+                CHECK(std::string(buffer, size) == fmt::format("{:g}", value));
+            }
+        }
+
+        CHECK(chemfiles::detail::format_general(-0.0, buffer) == 2);
+        CHECK(chemfiles::detail::format_general(1e-30, buffer) == 0);
+        CHECK(chemfiles::detail::format_general(1e6, buffer) == 0);
+    }
+
+    SECTION("Compiled format strings") {
+        for (auto value: values) {
+            auto arg = chemfiles::detail::fast_format_arg(value);
+            CHECK(fmt::format(FMT_COMPILE("{:8.3f}"), arg) == fmt::format("{:8.3f}", value));
+            CHECK(fmt::format(FMT_COMPILE("{:10g}"), arg) == fmt::format("{:10g}", value));
+            CHECK(fmt::format(FMT_COMPILE("{:g}"), arg) == fmt::format("{:g}", value));
+            CHECK(fmt::format(FMT_COMPILE("{}"), arg) == fmt::format("{}", value));
+            CHECK(fmt::format(FMT_COMPILE("{:08.3f}"), arg) == fmt::format("{:08.3f}", value));
+            CHECK(fmt::format(FMT_COMPILE("{:<8.2f}"), arg) == fmt::format("{:<8.2f}", value));
+            CHECK(fmt::format(FMT_COMPILE("{:+.2e}"), arg) == fmt::format("{:+.2e}", value));
+        }
+
+        auto compiled = FMT_COMPILE("{}");
+        CHECK(chemfiles::detail::is_compiled_format<decltype(compiled)>::value);
+        CHECK_FALSE(chemfiles::detail::is_compiled_format<const char*>::value);
+        CHECK_FALSE(chemfiles::detail::is_compiled_format<char[3]>::value);
+        CHECK_FALSE(chemfiles::detail::is_compiled_format<std::string>::value);
+    }
+}
+
+TEST_CASE("Thread pool") {
+    auto pool = chemfiles::ThreadPool(3);
+    CHECK(pool.size() == 3);
+
+    SECTION("Run chunks") {
+        auto values = std::vector<size_t>(10, 0);
+        pool.run_chunks(values.size(), [&](size_t i) {
+            values[i] = i * i;
+        });
+        for (size_t i = 0; i < values.size(); i++) {
+            CHECK(values[i] == i * i);
+        }
+    }
+
+    SECTION("Errors") {
+        auto done = std::vector<int>(8, 0);
+        CHECK_THROWS_WITH(pool.run_chunks(done.size(), [&](size_t i) {
+            done[i] = 1;
+            if (i == 2 || i == 5) {
+                throw std::runtime_error("error in chunk " + std::to_string(i));
+            }
+        }), "error in chunk 2");
+        // all chunks still run to completion
+        CHECK(done == std::vector<int>(8, 1));
+    }
+
+    SECTION("Nested calls") {
+        auto values = std::vector<size_t>(12, 0);
+        pool.run_chunks(3, [&](size_t i) {
+            pool.run_chunks(4, [&](size_t j) {
+                values[4 * i + j] = 4 * i + j;
+            });
+        });
+        for (size_t i = 0; i < values.size(); i++) {
+            CHECK(values[i] == i);
+        }
+    }
+}